@@ -1,131 +1,191 @@
 #include "Meo3_Device.h"
-#include <ArduinoJson.h>
+#include "esp_random.h"
+#include "esp_wifi.h"
+#include "esp_netif.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "Meo3_JsonReader.h"
+#include "Meo3_JsonWriter.h"
 #include <string.h>
-#include <stdarg.h>
+#include <new>
+#include <utility>
 
-MeoDevice::MeoDevice() {}
+MeoDevice::MeoDevice() {
+    _log.setRing(&_logRing);
+}
 
 void MeoDevice::setLogger(MeoLogFunction logger) {
-    _logger = logger;
+    _log.setSink(logger);
     // Forward logger to submodules
     _mqtt.setLogger(logger);
     _prov.setLogger(logger);
 }
 
 void MeoDevice::setDebugTags(const char* tagsCsv) {
-    if (!tagsCsv) { _debugTags[0] = '\0'; return; }
-    strncpy(_debugTags, tagsCsv, sizeof(_debugTags) - 1);
-    _debugTags[sizeof(_debugTags) - 1] = '\0';
+    _log.setDebugTags(tagsCsv);
     // Forward to submodules
     _mqtt.setDebugTags(tagsCsv);
     _prov.setDebugTags(tagsCsv);
 }
 
+bool MeoDevice::enableDeferredLog(uint16_t depth, BaseType_t core, UBaseType_t priority) {
+    bool ok = _logRing.begin(_log.sink(), depth, core, priority);
+    MEO_LOG_AT(_log, ok ? MEO_LOG_LEVEL_INFO : MEO_LOG_LEVEL_ERROR, DEVICE, "Deferred log %s (depth=%u)",
+               ok ? "enabled" : "failed", depth);
+    return ok;
+}
+
+void MeoDevice::disableDeferredLog() {
+    _logRing.end();   // remaining records are written first
+    MEO_LOGI(_log, DEVICE, "Deferred log disabled");
+}
+
 void MeoDevice::setDeviceInfo(const char* model,
                               const char* manufacturer) {
     _model = model;
     _manufacturer = manufacturer;
-    if (_logger && _debugTagEnabled("DEVICE")) {
-        _logf("DEBUG", "DEVICE", "Device info set: model=%s manufacturer=%s",
-               model ? model : "", manufacturer ? manufacturer : "");
-    }
+    MEO_LOGD(_log, DEVICE, "Device info set: model=%s manufacturer=%s",
+             model ? model : "", manufacturer ? manufacturer : "");
 }
 
 void MeoDevice::beginWifi(const char* ssid, const char* pass) {
     _wifiSsid = ssid;
     _wifiPass = pass;
+    _startWifi(ssid, pass);
+}
+
+void MeoDevice::_startWifi(const char* ssid, const char* pass) {
+    MEO_LOGI(_log, DEVICE, "Connecting WiFi SSID=%s", ssid ? ssid : "");
+    WiFi.mode(WIFI_STA);  // brings up netif + default event loop
+    _registerWifiEvents();
+    WiFi.begin(ssid, pass);
+    // No waiting here: IP_EVENT_STA_GOT_IP flips _wifiReady and loop() starts MQTT
+}
 
-    _logf("INFO", "DEVICE", "Connecting WiFi SSID=%s", ssid ? ssid : "");
-    WiFi.mode(WIFI_STA);
-    WiFi.begin(_wifiSsid, _wifiPass);
+void MeoDevice::_registerWifiEvents() {
+    if (_wifiEventsRegistered) return;
+    esp_err_t e1 = esp_event_handler_instance_register(WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED,
+                                                       &_wifiEventThunk, this, &_wifiDiscHandler);
+    esp_err_t e2 = esp_event_handler_instance_register(IP_EVENT, ESP_EVENT_ANY_ID,
+                                                       &_wifiEventThunk, this, &_ipHandler);
+    _wifiEventsRegistered = (e1 == ESP_OK && e2 == ESP_OK);
+    if (!_wifiEventsRegistered) {
+        MEO_LOGE(_log, DEVICE, "WiFi event registration failed");
+    }
+    // Already associated before we listened (e.g. WiFi brought up by the app)
+    if (WiFi.status() == WL_CONNECTED) {
+        _wifiReady.store(true);
+        _wifiGen.fetch_add(1);
+    }
+}
 
-    uint32_t start = millis();
-    while (WiFi.status() != WL_CONNECTED && (millis() - start) < 15000) {
-        delay(100);
+// Runs on the IDF event task: only touch atomics here
+void MeoDevice::_wifiEventThunk(void* arg, esp_event_base_t base, int32_t id, void* data) {
+    MeoDevice* self = reinterpret_cast<MeoDevice*>(arg);
+    if (!self) return;
+    if (base == IP_EVENT && id == IP_EVENT_STA_GOT_IP) {
+        self->_wifiReady.store(true);
+        self->_wifiGen.fetch_add(1);
+    } else if ((base == IP_EVENT && id == IP_EVENT_STA_LOST_IP) ||
+               (base == WIFI_EVENT && id == WIFI_EVENT_STA_DISCONNECTED)) {
+        self->_wifiReady.store(false);
     }
-    _wifiReady = (WiFi.status() == WL_CONNECTED);
-    _logf(_wifiReady ? "INFO" : "ERROR", "DEVICE", "WiFi %s", _wifiReady ? "connected" : "failed");
 }
 
 void MeoDevice::setGateway(const char* host, uint16_t mqttPort) {
     _gatewayHost = host;
     _mqttPort = mqttPort;
-    _logf("INFO", "DEVICE", "Gateway set: %s:%u", host ? host : "", mqttPort);
+    MEO_LOGI(_log, DEVICE, "Gateway set: %s:%u", host ? host : "", mqttPort);
 }
 
 bool MeoDevice::addFeatureEvent(const char* name) {
     if (!name || !*name || _eventCount >= MEO_MAX_FEATURE_EVENTS) return false;
+    _eventQos[_eventCount] = kQosDefault;
+    _eventSchemas[_eventCount] = nullptr;
     _eventNames[_eventCount++] = name;
-    if (_logger && _debugTagEnabled("DEVICE")) {
-        _logf("DEBUG", "DEVICE", "Feature event added: %s", name);
-    }
+    MEO_LOGD(_log, DEVICE, "Feature event added: %s", name);
     return true;
 }
 
-bool MeoDevice::addFeatureMethod(const char* name, MeoFeatureCallback cb) {
-    if (!name || !*name || !cb || _methodCount >= MEO_MAX_FEATURE_METHODS) return false;
-    _methodNames[_methodCount]    = name;
-    _methodHandlers[_methodCount] = cb;
-    _methodCount++;
-    if (_logger && _debugTagEnabled("DEVICE")) {
-        _logf("DEBUG", "DEVICE", "Feature method added: %s", name);
+bool MeoDevice::_addEventSchema(const MeoEventSchema& schema) {
+    if (!addFeatureEvent(schema.name)) return false;
+    _eventSchemas[_eventCount - 1] = &schema;
+    return true;
+}
+
+bool MeoDevice::setEventQos(const char* name, uint8_t qos) {
+    if (!name || qos > 2) return false;
+    for (uint8_t i = 0; i < _eventCount; ++i) {
+        if (strcmp(_eventNames[i], name) == 0) {
+            _eventQos[i] = qos;
+            return true;
+        }
     }
+    return false;
+}
+
+bool MeoDevice::addFeatureMethod(const char* name, MeoFeatureCallback cb) {
+    if (!cb || !_methods.add(name, cb)) return false; // empty, duplicate or full
+    _invokeCount[_methods.size() - 1] = &_metrics.metric(name, "invoke");
+    MEO_LOGD(_log, DEVICE, "Feature method added: %s", name);
     return true;
 }
 
 bool MeoDevice::start() {
     // Storage
     if (!_storage.begin()) {
-        _log("ERROR", "DEVICE", "Storage init failed");
+        MEO_LOGE(_log, DEVICE, "Storage init failed");
         return false;
     }
 
+    // Kick off WiFi first so association runs while BLE and the app initialize.
+    // If WiFi not configured up-front, try load from storage (set via BLE)
+    if (!_wifiSsid || !_wifiPass) {
+        std::string ssid, pass;
+        if (_storage.loadString("wifi_ssid", ssid) && _storage.loadString("wifi_pass", pass)) {
+            MEO_LOGI(_log, DEVICE, "WiFi creds loaded from storage: SSID=%s", ssid.c_str());
+            _startWifi(ssid.c_str(), pass.c_str());
+        }
+    }
+
     // BLE + Provisioning (model/manufacturer read-only via BLE)
     _ble.begin(_model ? _model : "MEO Device");
-    _prov.setLogger(_logger);
-    _prov.setDebugTags(_debugTags);
+    _prov.setLog(_log);
     _prov.begin(&_ble, &_storage, _model ? _model : "", _manufacturer ? _manufacturer : "");
     _prov.setAutoRebootOnProvision(true, 500);
     _prov.setRuntimeStatus(_wifiReady ? "connected" : "disconnected", "disconnected");
     _prov.startAdvertising();
-    _log("INFO", "DEVICE", "BLE provisioning started");
-
-    // If WiFi not configured up-front, try load from storage (set via BLE)
-    if (!_wifiReady && (!_wifiSsid || !_wifiPass)) {
-        std::string ssid, pass;
-        if (_storage.loadString("wifi_ssid", ssid) && _storage.loadString("wifi_pass", pass)) {
-            _logf("INFO", "DEVICE", "WiFi creds loaded from storage: SSID=%s", ssid.c_str());
-            WiFi.mode(WIFI_STA);
-            WiFi.begin(ssid.c_str(), pass.c_str());
-            uint32_t start = millis();
-            while (WiFi.status() != WL_CONNECTED && (millis() - start) < 15000) {
-                delay(100);
-            }
-            _wifiReady = (WiFi.status() == WL_CONNECTED);
-        }
-    }
+    MEO_LOGI(_log, DEVICE, "BLE provisioning started");
 
     // Load credentials (pre-provisioned via BLE/app)
     _storage.loadString("device_id", _deviceId);
     _storage.loadString("tx_key", _transmitKey);
-    _logf("INFO", "DEVICE", "Credentials %s",
-          hasCredentials() ? "present" : "missing");
+    _topics.setDeviceId(_deviceId.c_str()); // topic prefixes built once here
+    _gateway.setSelfId(_deviceId.c_str());
+    MEO_LOGI(_log, DEVICE, "Credentials %s",
+             hasCredentials() ? "present" : "missing");
 
-    // Only proceed if both WiFi and credentials are ready
-    if (!_wifiReady || !hasCredentials()) {
-        _prov.setRuntimeStatus(_wifiReady ? "connected" : "disconnected", "disconnected");
-        _log("WARN", "DEVICE", "Waiting for WiFi/credentials via BLE provisioning");
+    if (!hasCredentials()) {
+        MEO_LOGW(_log, DEVICE, "Waiting for WiFi/credentials via BLE provisioning");
+        return false;
+    }
+
+    // Route feature invokes; the MQTT client (re)subscribes on every connect
+    if (!_mqtt.subscribe(_topics.invokeFilter(), &_mqttThunk, this, _qos.invokes)) {
+        MEO_LOGE(_log, DEVICE, "Cannot route feature invokes");
         return false;
     }
 
     // PATCH: stop BLE advertising once WiFi is connected (if BLE was already advertising)
     // if (_wifiReady) {
     //     _prov.stopAdvertising();
-    //     _log("INFO", "DEVICE", "WiFi connected; stopped BLE advertising");
+    //     MEO_LOGI(_log, DEVICE, "WiFi connected; stopped BLE advertising");
     // }
 
-    // MQTT connect + declare
-    return _connectMqttAndDeclare();
+    // Returns immediately: loop() connects MQTT as soon as an IP is obtained,
+    // then subscribes and declares once the session is up
+    _downSinceMs = millis();
+    return true;
 }
 
 void MeoDevice::loop() {
@@ -139,87 +199,787 @@ void MeoDevice::loop() {
         _prov.setRuntimeStatus(nowWifi == WL_CONNECTED ? "connected" : "disconnected",
                                _mqtt.isConnected() ? "connected" : "disconnected");
         lastWifi = nowWifi;
-        if (_logger && _debugTagEnabled("DEVICE")) {
-            _logf("DEBUG", "DEVICE", "Status WiFi=%s MQTT=%s",
-                  nowWifi == WL_CONNECTED ? "connected" : "disconnected",
-                  _mqtt.isConnected() ? "connected" : "disconnected");
+        MEO_LOGD(_log, DEVICE, "Status WiFi=%s MQTT=%s",
+                 nowWifi == WL_CONNECTED ? "connected" : "disconnected",
+                 _mqtt.isConnected() ? "connected" : "disconnected");
+    }
+
+    // Time-based batch flush
+    if (_batchBuf && _batchCount && (millis() - _batchStartMs) >= _batchWindowMs) {
+        flushBatch();
+    }
+
+    // Connection state machine: declare on connect, backoff reconnect on loss
+    _serviceLink();
+
+    // Child event batches and child liveness
+    _gateway.loop();
+
+    // Drain store-and-forward backlog at the configured rate
+    if (_linkState == MeoLinkState::Online) {
+        _replayOffline();
+
+        uint32_t now = millis();
+        if (_metricsPeriodMs && (int32_t)(now - _nextMetricsMs) >= 0) {
+            _nextMetricsMs = now + _metricsPeriodMs;
+            publishMetrics();
+            if (_tracing.load(std::memory_order_relaxed)) publishInvokeLatency();
         }
     }
+}
 
-    // Lazy reconnect when WiFi + creds available
-    if (!_mqtt.isConnected() && _wifiReady && hasCredentials()) {
-        _log("WARN", "DEVICE", "MQTT disconnected; attempting reconnect");
-        _connectMqttAndDeclare();
+MeoReconnectStats MeoDevice::reconnectStats() const {
+    MeoReconnectStats st = _reconnect;
+    st.state = _linkState.load();
+    if (_linkState == MeoLinkState::Backoff) {
+        int32_t left = (int32_t)(_nextAttemptMs - millis());
+        st.nextAttemptInMs = left > 0 ? (uint32_t)left : 0;
     }
+    return st;
 }
 
-bool MeoDevice::publishEvent(const char* eventName,
-                             const char* const* keys,
-                             const char* const* values,
-                             uint8_t count) {
-    if (!_mqtt.isConnected()) return false;
-    String topic = String("meo/") + String(_deviceId.c_str()) + "/event/" + eventName;
+bool MeoDevice::subscribe(const char* filter, MeoMqttInbox& inbox, uint8_t qos) {
+    return _mqtt.subscribe(filter, &MeoMqttInbox::handler, &inbox, qos);
+}
 
-    JsonDocument doc;
-    for (uint8_t i = 0; i < count; ++i) {
-        doc[keys[i]] = values[i];
+bool MeoDevice::unsubscribe(const char* filter, MeoMqttInbox& inbox) {
+    return _mqtt.unsubscribe(filter, &MeoMqttInbox::handler, &inbox);
+}
+
+void MeoDevice::_serviceLink() {
+    uint32_t now = millis();
+
+    // Transitions seen by the MQTT task since the last loop, in order. A refused or
+    // dropped attempt ends Connecting right away instead of at connectTimeoutMs.
+    bool attemptFailed = false;
+    MeoMqttStateEvent ev;
+    while (_mqtt.pollState(ev)) {
+        switch (ev.kind) {
+            case MeoMqttStateKind::Connected:
+                MEO_LOGD(_log, DEVICE, "MQTT session %u up", (unsigned)ev.generation);
+                break;
+            case MeoMqttStateKind::Disconnected:
+                MEO_LOGD(_log, DEVICE, "MQTT session %u down", (unsigned)ev.generation);
+                attemptFailed = true;
+                break;
+            case MeoMqttStateKind::Refused:
+                MEO_LOGW(_log, DEVICE, "MQTT connect refused (code 0x%02x)", (unsigned)ev.code);
+                attemptFailed = true;
+                break;
+        }
     }
+    // One snapshot: connected flag and generation from a single load of the link word
+    uint32_t mqttGen;
+    const bool up = _mqtt.linkState(mqttGen);
 
-    char buf[512];
-    size_t len = serializeJson(doc, buf, sizeof(buf));
-    if (len == 0) return false;
+    // New IP lease: don't sit out the remaining backoff, the network is back
+    uint32_t gen = _wifiGen.load();
+    if (gen != _seenWifiGen) {
+        _seenWifiGen = gen;
+        MEO_LOGI(_log, DEVICE, "WiFi connected (IP obtained)");
+        if (_linkState == MeoLinkState::Backoff) {
+            _backoff.reset();
+            _nextAttemptMs = now;
+        }
+    }
+
+    switch (_linkState.load()) {
+        case MeoLinkState::Idle:
+            // start() bailed out earlier; begin as soon as WiFi + credentials exist
+            if (_wifiReady && hasCredentials() && _topics.valid()) {
+                _downSinceMs = now;
+                _connectMqtt();
+            }
+            break;
 
-    if (_logger && _debugTagEnabled("DEVICE")) {
-        _logf("DEBUG", "DEVICE", "Publish event %s len=%u", eventName, (unsigned)len);
+        case MeoLinkState::Online:
+            if (!up) {
+                MEO_LOGW(_log, DEVICE, "MQTT disconnected; scheduling reconnect");
+                _connectedMs += now - _onlineSinceMs;
+                _declared = false;
+                _downSinceMs = now;
+                _backoff.reset();
+                _scheduleReconnect(now);
+                _updateBleStatus();
+            } else if (mqttGen != _mqttGen) {
+                // Dropped and back within one loop: new session, status/declare are stale
+                MEO_LOGW(_log, DEVICE, "MQTT session replaced (%u -> %u)", (unsigned)_mqttGen, (unsigned)mqttGen);
+                _connectedMs += now - _onlineSinceMs;
+                _declared = false;
+                _downSinceMs = now;
+                _onMqttConnected(now, mqttGen);
+            } else if (!_declared && _publishDeclare()) {
+                // Declare failed right after connect (e.g. outbox full): retry every loop
+                _declared = true;
+                _nextReplayMs = now;
+            }
+            break;
+
+        case MeoLinkState::Connecting:
+            if (up) {
+                _onMqttConnected(now, mqttGen);
+            } else if (attemptFailed) {
+                MEO_LOGW(_log, DEVICE, "MQTT connect attempt failed");
+                _scheduleReconnect(now);
+            } else if (now - _attemptStartMs >= _backoff.policy().connectTimeoutMs) {
+                MEO_LOGW(_log, DEVICE, "MQTT connect attempt timed out");
+                _scheduleReconnect(now);
+            }
+            break;
+
+        case MeoLinkState::Backoff:
+            if (up) {
+                _onMqttConnected(now, mqttGen);
+            } else if (_wifiReady && hasCredentials() && (int32_t)(now - _nextAttemptMs) >= 0) {
+                _connectMqtt();
+            }
+            break;
     }
-    return _mqtt.publish(topic.c_str(), (const uint8_t*)buf, len, false);
 }
 
-bool MeoDevice::publishEvent(const char* eventName, const MeoEventPayload& payload) {
-    if (!_mqtt.isConnected()) return false;
-    String topic = String("meo/") + String(_deviceId.c_str()) + "/event/" + eventName;
+void MeoDevice::enableMetrics(uint32_t periodMs) {
+    _metricsPeriodMs = periodMs;
+    _nextMetricsMs = millis() + periodMs;
+    MEO_LOGI(_log, DEVICE, "Metrics every %lums", (unsigned long)periodMs);
+}
+
+// Gauges are sampled from the modules' own counters here, off the hot paths
+void MeoDevice::_refreshMetrics() {
+    uint32_t now = millis();
+    MeoMqttTxStats tx = _mqtt.txStats();
+    MeoPublishStats q = _pubQueue.stats();
+    uint64_t connected = _connectedMs + (_linkState == MeoLinkState::Online ? now - _onlineSinceMs : 0);
 
-    JsonDocument doc;
-    for (const auto& kv : payload) {
-        doc[kv.first] = kv.second;
+    _metrics.metric("up_s").set(now / 1000);
+    _metrics.metric("pub").set(tx.published + tx.storedOffline);
+    _metrics.metric("pub_fail").set(tx.failed + tx.outboxFull + tx.rejected);
+    _metrics.metric("pub_bytes").set(tx.bytes);
+    _metrics.metric("pubq_depth").set(q.depth);
+    _metrics.metric("pubq_drop").set(q.dropped);
+    _metrics.metric("outbox").set((uint32_t)_mqtt.outboxBytes());
+    _metrics.metric("reconnects").set(_reconnect.reconnects);
+    _metrics.metric("connected_s").set((uint32_t)(connected / 1000));
+    _metrics.metric("heap").set((uint32_t)heap_caps_get_free_size(MALLOC_CAP_DEFAULT));
+    _metrics.metric("heap_min").set((uint32_t)heap_caps_get_minimum_free_size(MALLOC_CAP_DEFAULT));
+    if (_gateway.isRunning()) {
+        MeoGatewayStats gw = _gateway.stats();
+        _metrics.metric("online", "children").set(gw.online);
+        _metrics.metric("invokes", "children").set(gw.invokesRouted);
+        _metrics.metric("events", "children").set(gw.eventsIn);
+        _metrics.metric("rejected", "children").set(gw.invokesFailed + gw.rejected);
     }
+}
+
+const MeoDeviceMetrics& MeoDevice::metrics() {
+    _refreshMetrics();
+    return _metrics;
+}
+
+bool MeoDevice::publishMetrics() {
+    if (!_topics.valid() || !_mqtt.isConnected()) return false;
+    _refreshMetrics();
+
+    uint8_t buf[MEO_METRICS_OUT_MAX];
+    size_t need = 0;
+    size_t len = meoEncode(_codec, buf, sizeof(buf), [&](auto& w) {
+        w.beginObject();
+        _metrics.writeFields(w);
+        w.endObject();
+    }, &need);
+    if (!len) {
+        MEO_LOGW(_log, DEVICE, "Metrics need %u bytes (max %u)", (unsigned)need, (unsigned)sizeof(buf));
+        return false;
+    }
+    return _publishRaw(_topics.metrics(), buf, len, _pubOptions(0, false));
+}
+
+void MeoDevice::setInvokeTracing(bool enable) {
+    _tracing.store(enable, std::memory_order_relaxed);
+    MEO_LOGI(_log, DEVICE, "Invoke tracing %s", enable ? "on" : "off");
+}
 
-    char buf[512];
-    size_t len = serializeJson(doc, buf, sizeof(buf));
-    if (len == 0) return false;
+// MQTT task: claim the in-flight slot of a new trace id (0 is never used)
+uint32_t MeoDevice::_traceBegin(uint16_t method, int64_t nowUs) {
+    uint32_t id = _traceSeq.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (!id) id = _traceSeq.fetch_add(1, std::memory_order_relaxed) + 1;
+    TraceSlot& s = _inflight[id % MEO_TRACE_INFLIGHT];
+    s.id.store(0, std::memory_order_relaxed);
+    s.startUs.store((uint32_t)nowUs, std::memory_order_relaxed);
+    s.method.store(method, std::memory_order_relaxed);
+    s.id.store(id, std::memory_order_release);
+    return id;
+}
 
-    if (_logger && _debugTagEnabled("DEVICE")) {
-        _logf("DEBUG", "DEVICE", "Publish event %s len=%u", eventName, (unsigned)len);
+// Any task; false once the slot was reused by a newer invoke
+bool MeoDevice::_traceFind(uint32_t id, uint16_t& method, uint32_t& startUs) const {
+    const TraceSlot& s = _inflight[id % MEO_TRACE_INFLIGHT];
+    if (s.id.load(std::memory_order_acquire) != id) return false;
+    startUs = s.startUs.load(std::memory_order_relaxed);
+    method  = s.method.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return s.id.load(std::memory_order_relaxed) == id;
+}
+
+void MeoDevice::_traceRecord(uint16_t method, MeoTraceStage stage, uint32_t startUs) {
+    if (method >= MEO_MAX_FEATURE_METHODS) return;
+    uint32_t us = (uint32_t)esp_timer_get_time() - startUs;
+    _latency[method][(size_t)stage].record(us);
+}
+
+// Static -> instance adapter (esp-mqtt task)
+void MeoDevice::_deliveryThunk(int /*msgId*/, bool delivered, uint32_t cookie, void* ctx) {
+    MeoDevice* self = reinterpret_cast<MeoDevice*>(ctx);
+    if (!self || !cookie || !delivered) return;
+    uint16_t method;
+    uint32_t startUs;
+    if (self->_traceFind(cookie, method, startUs)) {
+        self->_traceRecord(method, MeoTraceStage::Ack, startUs);
     }
-    return _mqtt.publish(topic.c_str(), (const uint8_t*)buf, len, false);
+}
+
+const MeoLatencyHistogram* MeoDevice::invokeLatency(const char* featureName, MeoTraceStage stage) const {
+    if (!featureName || stage >= MeoTraceStage::Count) return nullptr;
+    int idx = _methods.find(featureName, strlen(featureName));
+    return idx < 0 ? nullptr : &_latency[idx][(size_t)stage];
+}
+
+void MeoDevice::resetInvokeLatency() {
+    for (auto& method : _latency) {
+        for (auto& h : method) h.reset();
+    }
+}
+
+void MeoDevice::dumpInvokeLatency() {
+    for (size_t i = 0; i < _methods.size(); ++i) {
+        for (size_t s = 0; s < (size_t)MeoTraceStage::Count; ++s) {
+            const MeoLatencyHistogram& h = _latency[i][s];
+            if (!h.count()) continue;
+            MEO_LOGI(_log, DEVICE, "Latency %s %s: n=%u p50<%uus p90<%uus p99<%uus max=%uus",
+                     _methods[i].name, meoTraceStageName((MeoTraceStage)s), (unsigned)h.count(),
+                     (unsigned)h.percentileUs(50), (unsigned)h.percentileUs(90),
+                     (unsigned)h.percentileUs(99), (unsigned)h.maxUs());
+        }
+    }
+}
+
+// {"feature":"name","parse":{..},"handler":{..},...}, only features that saw invokes
+bool MeoDevice::publishInvokeLatency() {
+    if (!_topics.valid() || !_mqtt.isConnected()) return false;
+
+    bool ok = true;
+    for (size_t i = 0; i < _methods.size(); ++i) {
+        const MeoLatencyHistogram* hs = _latency[i];
+        if (!hs[(size_t)MeoTraceStage::Parse].count()) continue;
+
+        uint8_t buf[MEO_METRICS_OUT_MAX];
+        size_t len = meoEncode(_codec, buf, sizeof(buf), [&](auto& w) {
+            w.beginObject();
+            w.field("feature", _methods[i].name);
+            for (size_t s = 0; s < (size_t)MeoTraceStage::Count; ++s) {
+                if (!hs[s].count()) continue;
+                w.key(meoTraceStageName((MeoTraceStage)s));
+                hs[s].write(w);
+            }
+            w.endObject();
+        });
+        ok = len && _publishRaw(_topics.latency(), buf, len, _pubOptions(0, false)) && ok;
+    }
+    return ok;
+}
+
+void MeoDevice::_scheduleReconnect(uint32_t now) {
+    uint32_t delayMs = _backoff.next(esp_random());
+    _nextAttemptMs = now + delayMs;
+    _linkState = MeoLinkState::Backoff;
+    MEO_LOGD(_log, DEVICE, "Next MQTT attempt in %lums (attempt %lu)",
+             (unsigned long)delayMs, (unsigned long)_reconnect.attempts + 1);
+}
+
+bool MeoDevice::publishEvent(const char* eventName,
+                             const char* const* keys,
+                             const char* const* values,
+                             uint8_t count) {
+    MeoPayload p;
+    for (uint8_t i = 0; i < count; ++i) {
+        p.set(keys[i], values[i]);
+    }
+    return publishEvent(eventName, p);
+}
+
+bool MeoDevice::publishEvent(const char* eventName, const MeoEventPayload& payload) {
+    return publishEvent(eventName, MeoPayload(payload));
+}
+
+bool MeoDevice::publishEvent(const char* eventName, const MeoPayload& payload) {
+    MeoTopicBuf<> topic;
+    if (!hasCredentials() || !_topics.event(topic, eventName)) return false;
+
+    return _sendEncoded(topic.c_str(), eventName, _pubOptions(_eventQosFor(eventName), true),
+                        [&](auto& w) {
+        payload.encode(w);
+    });
+}
+
+bool MeoDevice::_publishTyped(const MeoEventSchema& schema, const void* ev) {
+    MeoTopicBuf<> topic;
+    if (!hasCredentials() || !_topics.event(topic, schema.name)) return false;
+
+    return _sendEncoded(topic.c_str(), schema.name, _pubOptions(_eventQosFor(schema.name), true),
+                        [&](auto& w) {
+        schema.write(ev, w);
+    });
 }
 
 bool MeoDevice::sendFeatureResponse(const char* featureName,
                                     bool success,
                                     const char* message) {
-    if (!_mqtt.isConnected()) return false;
-    String topic = String("meo/") + String(_deviceId.c_str()) + "/event/feature_response";
+    return _sendResponse(featureName, success, message, nullptr);
+}
+
+// call != nullptr: echo its correlation id and close its trace
+bool MeoDevice::_sendResponse(const char* featureName, bool success, const char* message,
+                              const MeoFeatureCall* call) {
+    if (!_mqtt.isConnected() || !_topics.valid()) return false;
 
-    JsonDocument doc;
-    doc["feature_name"] = featureName;
-    doc["device_id"]    = _deviceId.c_str();
-    doc["success"]      = success;
-    if (message) doc["message"] = message;
+    MEO_LOGD(_log, DEVICE, "Publish feature_response for %s", featureName);
+    MeoPublishOptions opt = _pubOptions(_qos.responses, false);
+    const char* cid = (call && !call->correlationId.empty()) ? call->correlationId.c_str() : nullptr;
+    const uint32_t traceId = call ? call->trace.id : 0;
+    if (traceId && opt.qos > 0) opt.cookie = traceId;   // PUBACK closes the trace
 
-    char buf[512];
-    size_t len = serializeJson(doc, buf, sizeof(buf));
-    if (len == 0) return false;
+    // MQTT 5: routing fields travel as properties (device id is already in the topic)
+    const bool mqtt5 = _mqtt.isMqtt5();
+    MeoUserProperty props[2] = { { "feature_name", featureName ? featureName : "" },
+                                 { "cid", cid } };
+    if (mqtt5) {
+        opt.userProps = props;
+        opt.userPropCount = cid ? 2 : 1;
+    }
+    bool ok = _sendEncoded(_topics.response(), nullptr, opt, [&](auto& w) {
+        w.beginObject();
+        if (!mqtt5) {
+            w.field("feature_name", featureName)
+             .field("device_id", std::string_view(_deviceId));
+            if (cid) w.field("cid", cid);
+        }
+        w.field("success", success);
+        if (message) w.field("message", message);
+        w.endObject();
+    });
+    if (ok && traceId) {
+        _traceRecord(call->trace.method, MeoTraceStage::Response, (uint32_t)call->trace.receivedUs);
+    }
+    return ok;
+}
+
+// An event skips batching/offline and goes straight to the sender queue
+bool MeoDevice::_eventGoesDirect() {
+    if (!_pubQueue.isRunning() || _batchBuf || !_mqtt.isConnected()) return false;
+    return !(_offline.isEnabled() && (!_declared || !_offline.empty() || _outboxCongested()));
+}
+
+// Outbox past 3/4 of its budget: QoS 1 traffic is not being acknowledged fast enough
+bool MeoDevice::_outboxCongested() {
+    return _outboxBudget && _mqtt.outboxBytes() >= _outboxBudget / 4 * 3;
+}
+
+uint8_t MeoDevice::_eventQosFor(const char* eventName) const {
+    for (uint8_t i = 0; i < _eventCount; ++i) {
+        if (_eventQos[i] != kQosDefault && strcmp(_eventNames[i], eventName) == 0) {
+            return _eventQos[i];
+        }
+    }
+    return _qos.events;
+}
+
+uint8_t MeoDevice::_maxEventQos() const {
+    uint8_t q = _qos.events;
+    for (uint8_t i = 0; i < _eventCount; ++i) {
+        if (_eventQos[i] != kQosDefault && _eventQos[i] > q) q = _eventQos[i];
+    }
+    return q;
+}
 
-    if (_logger && _debugTagEnabled("DEVICE")) {
-        _logf("DEBUG", "DEVICE", "Publish feature_response for %s", featureName);
+uint8_t MeoDevice::_qosForTopic(const char* topic) const {
+    // The offline buffer keeps topics only; a batch may mix events, so use the highest
+    if (strcmp(topic, _topics.batch()) == 0) return _maxEventQos();
+    if (strncmp(topic, _topics.eventPrefix(), _topics.eventPrefixLen()) == 0) {
+        return _eventQosFor(topic + _topics.eventPrefixLen());
     }
-    return _mqtt.publish(topic.c_str(), (const uint8_t*)buf, len, false);
+    return _qos.events;
+}
+
+template <typename Fill>
+bool MeoDevice::_sendEncoded(const char* topic, const char* eventName, const MeoPublishOptions& opt,
+                             Fill&& fill) {
+    const char* what = eventName ? eventName : "feature_response";
+    const MeoCodec codec = _codec;   // one snapshot: setCodec() may run on another task
+    bool direct = eventName ? _eventGoesDirect() : _pubQueue.isRunning();
+    size_t need = 0;
+
+    if (direct) {
+        // Serialize in place inside a queue slot: no stack buffer, no extra copy
+        uint8_t slot;
+        size_t cap = 0;
+        uint8_t* dst = _pubQueue.reserve(slot, cap, &_lastEnqueue);
+        if (!dst) {
+            MEO_LOGD(_log, DEVICE, "Async enqueue dropped %s (result=%u)", topic, (unsigned)_lastEnqueue);
+            return false;
+        }
+        size_t len = meoEncode(codec, dst, cap, fill, &need);
+        if (!len) {
+            _pubQueue.drop(slot);   // counted like commit()'s TooLarge
+            _lastEnqueue = MeoEnqueueResult::TooLarge;
+            MEO_LOGW(_log, DEVICE, "%s payload needs %u bytes (max %u)", what,
+                     (unsigned)need, (unsigned)cap);
+            return false;
+        }
+        if (eventName) MEO_LOGD(_log, DEVICE, "Publish event %s len=%u", eventName, (unsigned)len);
+        _lastEnqueue = _pubQueue.commit(slot, topic, len, opt);
+        return _lastEnqueue == MeoEnqueueResult::Queued;
+    }
+
+    uint8_t buf[MEO_JSON_OUT_MAX];
+    size_t len = meoEncode(codec, buf, sizeof(buf), fill, &need);
+    if (!len) {
+        MEO_LOGW(_log, DEVICE, "%s payload needs %u bytes (max %u)", what,
+                 (unsigned)need, (unsigned)sizeof(buf));
+        return false;
+    }
+    if (!eventName) {
+        return _publishRaw(topic, buf, len, opt);
+    }
+    MEO_LOGD(_log, DEVICE, "Publish event %s len=%u", eventName, (unsigned)len);
+    return _emitEvent(eventName, topic, codec, buf, len);
 }
 
 bool MeoDevice::sendFeatureResponse(const MeoFeatureCall& call,
                                     bool success,
                                     const char* message) {
-    return sendFeatureResponse(call.featureName.c_str(), success, message);
+    return _sendResponse(call.featureName.c_str(), success, message, &call);
+}
+
+bool MeoDevice::enableAsyncPublish(uint8_t depth, BaseType_t core, UBaseType_t priority) {
+    bool ok = _pubQueue.begin(&_mqtt, depth, core, priority);
+    MEO_LOG_AT(_log, ok ? MEO_LOG_LEVEL_INFO : MEO_LOG_LEVEL_ERROR, DEVICE, "Async publish %s (depth=%u)",
+               ok ? "enabled" : "failed", depth);
+    return ok;
+}
+
+void MeoDevice::disableAsyncPublish() {
+    _pubQueue.end();
+    MEO_LOGI(_log, DEVICE, "Async publish disabled");
+}
+
+void MeoDevice::setCodec(MeoCodec codec) {
+    if (codec == _codec) return;
+    if (_batchBuf) {
+        flushBatch();   // a batch is framed in one codec; send it with its content type
+        xSemaphoreTake(_batchLock, portMAX_DELAY);
+        _codec = codec;
+        xSemaphoreGive(_batchLock);
+    } else {
+        _codec = codec;
+    }
+    MEO_LOGI(_log, DEVICE, "Event codec: %s", meoCodecName(codec));
+    // Re-declare so the gateway switches decoders
+    if (_linkState == MeoLinkState::Online) _declared = _publishDeclare();
+}
+
+MeoPublishOptions MeoDevice::_pubOptions(uint8_t qos, bool event) {
+    return _pubOptions(qos, event, _codec);
+}
+
+MeoPublishOptions MeoDevice::_pubOptions(uint8_t qos, bool event, MeoCodec codec) {
+    MeoPublishOptions opt;
+    opt.qos = qos;
+    if (_mqtt.isMqtt5()) {
+        opt.contentType = meoCodecContentType(codec);
+        opt.topicAlias  = event;   // one alias per event topic, reused for the session
+    }
+    return opt;
+}
+
+bool MeoDevice::_publishRaw(const char* topic, const uint8_t* payload, size_t len,
+                            const MeoPublishOptions& opt) {
+    if (!_pubQueue.isRunning()) {
+        _lastPublish = _mqtt.publish(topic, payload, len, opt);
+        return _lastPublish == MeoPublishResult::Ok;
+    }
+    _lastEnqueue = _pubQueue.enqueue(topic, payload, len, opt);
+    if (_lastEnqueue != MeoEnqueueResult::Queued) {
+        MEO_LOGD(_log, DEVICE, "Async enqueue dropped %s (result=%u)", topic, (unsigned)_lastEnqueue);
+    }
+    return _lastEnqueue == MeoEnqueueResult::Queued;
+}
+
+bool MeoDevice::enableOfflineBuffer(const MeoOfflineConfig& cfg) {
+    bool ok = _offline.begin(cfg);
+    MeoOfflineStats st = _offline.stats();
+    MEO_LOG_AT(_log, ok ? MEO_LOG_LEVEL_INFO : MEO_LOG_LEVEL_ERROR, DEVICE, "Offline buffer %s (ram=%u flash=%s)",
+               ok ? "enabled" : "failed", (unsigned)_offline.config().ramBytes,
+               st.flashAvailable ? "yes" : "no");
+    return ok;
+}
+
+bool MeoDevice::_publishEventRaw(const char* topic, const uint8_t* payload, size_t len, uint8_t qos,
+                                 MeoCodec codec) {
+    // Keep ordering: once a backlog exists, new events queue behind it
+    if (_offline.isEnabled() &&
+        (!_mqtt.isConnected() || !_declared || !_offline.empty() || _outboxCongested())) {
+        bool ok = _offline.push(topic, payload, len, (uint8_t)codec);
+        MEO_LOGD(_log, DEVICE, "Offline %s %s len=%u", ok ? "stored" : "dropped", topic, (unsigned)len);
+        if (!_pubQueue.isRunning()) _lastPublish = ok ? MeoPublishResult::Ok : MeoPublishResult::Failed;
+        return ok;
+    }
+    // QoS>0 without an offline buffer still rides out the outage in the esp-mqtt outbox
+    if (!_mqtt.isConnected() && qos == 0) {
+        if (!_pubQueue.isRunning()) _lastPublish = MeoPublishResult::NotConnected;
+        return false;
+    }
+    return _publishRaw(topic, payload, len, _pubOptions(qos, true, codec));
+}
+
+void MeoDevice::_replayOffline() {
+    if (!_declared || !_offline.isEnabled() || _offline.empty()) return;
+    if (_outboxCongested()) return;   // let the broker acknowledge what is in flight
+
+    uint32_t now = millis();
+    if ((int32_t)(now - _nextReplayMs) < 0) return;
+    uint16_t rate = _offline.config().replayPerSecond;
+    _nextReplayMs = now + 1000u / (rate ? rate : 1);
+
+    const char* topic;
+    const uint8_t* payload;
+    size_t len;
+    uint8_t codec;   // the codec the record was encoded with, not the current one
+    if (!_offline.peek(topic, payload, len, codec)) return;
+    if (_publishRaw(topic, payload, len, _pubOptions(_qosForTopic(topic), true, (MeoCodec)codec))) {
+        _offline.pop();
+        MEO_LOGD(_log, DEVICE, "Replayed %s len=%u", topic, (unsigned)len);
+    }
+}
+
+bool MeoDevice::enableBatching(uint32_t windowMs, size_t maxBytes) {
+    if (_batchBuf) return true;
+    // Room for at least "[]" plus one small item
+    if (maxBytes < 64) maxBytes = 64;
+    _batchLock  = xSemaphoreCreateMutex();
+    _batchBuf   = new (std::nothrow) char[maxBytes];
+    _batchSpare = new (std::nothrow) char[maxBytes];
+    if (!_batchLock || !_batchBuf || !_batchSpare) {
+        delete[] _batchBuf;
+        _batchBuf = nullptr;
+        delete[] _batchSpare;
+        _batchSpare = nullptr;
+        if (_batchLock) { vSemaphoreDelete(_batchLock); _batchLock = nullptr; }
+        MEO_LOGE(_log, DEVICE, "Batching: out of memory");
+        return false;
+    }
+    _batchMax      = maxBytes;
+    _batchWindowMs = windowMs;
+    _batchLen      = 0;
+    _batchCount    = 0;
+    _batchSpareLen = 0;
+    MEO_LOGI(_log, DEVICE, "Batching enabled (window=%lums max=%u)",
+             (unsigned long)windowMs, (unsigned)maxBytes);
+    return true;
+}
+
+void MeoDevice::disableBatching() {
+    if (!_batchBuf) return;
+    for (;;) {
+        flushBatch();
+        xSemaphoreTake(_batchLock, portMAX_DELAY);
+        // Another task may still be publishing the spare, or have just started a batch
+        bool idle = _batchCount == 0 && _batchSpareLen == 0;
+        if (idle) {
+            delete[] _batchBuf;
+            _batchBuf = nullptr;
+            delete[] _batchSpare;
+            _batchSpare = nullptr;
+        }
+        xSemaphoreGive(_batchLock);
+        if (idle) break;
+        vTaskDelay(1);
+    }
+    vSemaphoreDelete(_batchLock);
+    _batchLock = nullptr;
+}
+
+bool MeoDevice::flushBatch() {
+    if (!_batchBuf) return false;
+    xSemaphoreTake(_batchLock, portMAX_DELAY);
+    bool swapped = _batchCount != 0 && _swapBatchLocked();
+    bool pending = _batchCount != 0;   // previous batch still being published: retried by loop()
+    xSemaphoreGive(_batchLock);
+    if (swapped) return _publishBatchSpare();
+    return !pending;
+}
+
+// Publishing never happens under _batchLock: sendEvent() may run on the esp-mqtt task,
+// which holds the client's API lock while it waits for _batchLock. The pending batch
+// is closed and swapped into _batchSpare instead; the task that swapped it publishes
+// it after releasing the lock. One spare keeps batches in order.
+bool MeoDevice::_swapBatchLocked() {
+    if (_batchSpareLen) return false;
+    // _batchAppend always keeps one byte for the closing ']' / CBOR break
+    _batchBuf[_batchLen] = (_batchCodec == MeoCodec::Cbor) ? (char)0xff : ']';
+    std::swap(_batchBuf, _batchSpare);
+    _batchSpareLen = _batchLen + 1;
+    _batchSpareQos = _batchQos;
+    _batchSpareCodec = _batchCodec;
+    MEO_LOGD(_log, DEVICE, "Flush batch events=%u len=%u", _batchCount, (unsigned)_batchSpareLen);
+    _batchLen   = 0;
+    _batchCount = 0;
+    _batchQos   = 0;
+    return true;
+}
+
+bool MeoDevice::_publishBatchSpare() {
+    // The spare belongs to this task until _batchSpareLen is cleared
+    bool ok = _publishEventRaw(_topics.batch(), (const uint8_t*)_batchSpare, _batchSpareLen, _batchSpareQos,
+                               _batchSpareCodec);
+    xSemaphoreTake(_batchLock, portMAX_DELAY);
+    _batchSpareLen = 0;
+    xSemaphoreGive(_batchLock);
+    return ok;
+}
+
+bool MeoDevice::_emitEvent(const char* eventName, const char* topic, MeoCodec codec,
+                           const uint8_t* data, size_t len) {
+    if (_batchBuf && _batchAppend(eventName, codec, data, len)) return true;
+    return _publishEventRaw(topic, data, len, _eventQosFor(eventName), codec);
+}
+
+bool MeoDevice::_batchAppend(const char* eventName, MeoCodec codec, const uint8_t* data, size_t len) {
+    // Item: {"event":"<name>","ts":<ms>,"payload":<data>}; the head is left open and
+    // the encoded payload plus '}' (CBOR: break) completes it
+    uint8_t head[96];
+    uint32_t now = millis();
+    size_t headLen = 0;
+    const bool cbor = (codec == MeoCodec::Cbor);
+    auto fillHead = [&](auto& w) {
+        w.beginObject().field("event", eventName).field("ts", now).key("payload");
+        headLen = w.overflow() ? 0 : w.required();
+    };
+
+    bool swapped = false;
+    xSemaphoreTake(_batchLock, portMAX_DELAY);
+    // _codec is read under the lock setCodec() takes: data encoded before a switch
+    // is not framed into a batch of the new codec, it goes out alone
+    if (codec != _codec) {
+        xSemaphoreGive(_batchLock);
+        return false;
+    }
+    if (cbor) { MeoCborWriter w(head, sizeof(head)); fillHead(w); }
+    else      { MeoJsonWriter w((char*)head, sizeof(head)); fillHead(w); }
+    // '[' / ',' (CBOR: array start or nothing) + head + payload + '}' and one byte
+    // kept for the closing ']'
+    size_t item = 1 + headLen + len + 1;
+    if (headLen == 0 || item + 1 > _batchMax) {
+        xSemaphoreGive(_batchLock);
+        return false;   // too big to batch: caller publishes it alone
+    }
+    if (_batchCount && (_batchLen + item + 1 > _batchMax || _batchCodec != codec)) {
+        // Size-based flush; while the previous batch is still being published the
+        // event goes out alone instead
+        if (!_swapBatchLocked()) {
+            xSemaphoreGive(_batchLock);
+            return false;
+        }
+        swapped = true;
+    }
+    if (_batchCount == 0) {
+        _batchStartMs = now;
+        _batchCodec   = codec;
+    }
+
+    char* p = _batchBuf + _batchLen;
+    if (_batchCount == 0)  *p++ = cbor ? (char)0x9f : '[';
+    else if (!cbor)        *p++ = ',';
+    memcpy(p, head, headLen);  p += headLen;
+    memcpy(p, data, len);      p += len;
+    *p++ = cbor ? (char)0xff : '}';
+    _batchLen = (size_t)(p - _batchBuf);
+    _batchCount++;
+    uint8_t qos = _eventQosFor(eventName);
+    if (qos > _batchQos) _batchQos = qos;
+    xSemaphoreGive(_batchLock);
+    if (swapped) _publishBatchSpare();
+    return true;
+}
+
+bool MeoDevice::enableInvokeWorkers(uint8_t workers, uint8_t depth, UBaseType_t priority) {
+    bool ok = _invokePool.begin(&_invokeWorkerThunk, this, workers, depth, priority);
+    MEO_LOG_AT(_log, ok ? MEO_LOG_LEVEL_INFO : MEO_LOG_LEVEL_ERROR, DEVICE, "Invoke workers %s (workers=%u depth=%u)",
+               ok ? "enabled" : "failed", workers, depth);
+    return ok;
+}
+
+void MeoDevice::disableInvokeWorkers() {
+    _invokePool.end();
+    MEO_LOGI(_log, DEVICE, "Invoke workers disabled");
+}
+
+bool MeoDevice::enableGateway(MeoChildTransport& transport, const MeoGatewayConfig& cfg) {
+    if (_gateway.isRunning()) return true;
+    _gateway.setLog(_log);
+    _gateway.setSelfId(_deviceId.c_str());
+    if (!_gateway.begin(transport, &_gatewayPublishThunk, this, cfg)) return false;
+
+    // One wildcard subscription for every child; own invokes keep their own route
+    if (!_mqtt.subscribe(MeoTopics::invokeFilterAll(), &_gatewayInvokeThunk, this, _qos.invokes)) {
+        MEO_LOGE(_log, DEVICE, "Cannot route child invokes");
+        _gateway.end();
+        return false;
+    }
+    if (_linkState == MeoLinkState::Online) _declared = _publishDeclare();
+    return true;
+}
+
+void MeoDevice::disableGateway() {
+    if (!_gateway.isRunning()) return;
+    _mqtt.unsubscribe(MeoTopics::invokeFilterAll(), &_gatewayInvokeThunk, this);
+    _gateway.end();
+}
+
+// Static -> instance adapter
+void MeoDevice::_gatewayInvokeThunk(const char* topic, size_t topicLen,
+                                    const uint8_t* payload, size_t length, void* ctx) {
+    MeoDevice* self = reinterpret_cast<MeoDevice*>(ctx);
+    if (!self) return;
+    const char* id;
+    const char* name;
+    size_t idLen, nameLen;
+    if (!MeoTopics::parseAnyInvoke(topic, topicLen, id, idLen, name, nameLen)) return;
+    // Our own invokes also match the wildcard; _mqttThunk handles them
+    if (idLen == self->_deviceId.length() && memcmp(id, self->_deviceId.data(), idLen) == 0) return;
+    self->_gateway.routeInvoke(id, idLen, name, nameLen, payload, length);
+}
+
+// Child payloads are JSON and forwarded as is; QoS/retain follow our own policy
+bool MeoDevice::_gatewayPublishThunk(MeoGatewayPub kind, const char* topic,
+                                     const uint8_t* payload, size_t len, void* ctx) {
+    MeoDevice* self = reinterpret_cast<MeoDevice*>(ctx);
+    if (!self) return false;
+    switch (kind) {
+        case MeoGatewayPub::Event:
+            return self->_publishEventRaw(topic, payload, len, self->_qos.events, MeoCodec::Json);
+        case MeoGatewayPub::Response: {
+            MeoPublishOptions opt = self->_pubOptions(self->_qos.responses, false, MeoCodec::Json);
+            return self->_publishRaw(topic, payload, len, opt);
+        }
+        case MeoGatewayPub::Declare:
+        case MeoGatewayPub::Status: {
+            MeoPublishOptions opt;
+            opt.qos      = self->_qos.control;
+            opt.retained = (kind == MeoGatewayPub::Status);
+            if (self->_mqtt.isMqtt5() && kind == MeoGatewayPub::Declare) opt.contentType = "application/json";
+            return self->_mqtt.publish(topic, payload, len, opt) == MeoPublishResult::Ok;
+        }
+    }
+    return false;
 }
 
 void MeoDevice::_updateBleStatus() {
@@ -228,159 +988,305 @@ void MeoDevice::_updateBleStatus() {
     _prov.setRuntimeStatus(wifi, mqtt);
 }
 
-bool MeoDevice::_connectMqttAndDeclare() {
-    // Configure transport (host/port + credentials)
+bool MeoDevice::_connectMqtt() {
+    // Configure transport (host/port + credentials); unchanged values keep the client config
     _mqtt.configure(_gatewayHost, _mqttPort);
     _mqtt.setCredentials(_deviceId.c_str(), _transmitKey.c_str());
-    _mqtt.setLogger(_logger);
-    _mqtt.setDebugTags(_debugTags);
+    _mqtt.setLog(_log);
+    _mqtt.setAutoReconnect(false); // retries are scheduled by _serviceLink()
+    _mqtt.setDeliveryHandler(&_deliveryThunk, this);
+    _mqtt.setCleanSession(!_persistentSession);
+    _mqtt.setOutboxLimit(_outboxBudget);
 
     // LWT: status offline retained
-    {
-        String willTopic = String("meo/") + String(_deviceId.c_str()) + "/status";
-        _mqtt.setWill(willTopic.c_str(), "offline", 0, false);
-    }
+    _mqtt.setWill(_topics.status(), "offline", _qos.control, false);
 
+    _reconnect.attempts++;
+    uint32_t now = millis();
     if (!_mqtt.connect()) {
-        _log("ERROR", "DEVICE", "MQTT connect failed");
+        MEO_LOGE(_log, DEVICE, "MQTT connect failed");
+        _scheduleReconnect(now);
         return false;
     }
-    _log("INFO", "DEVICE", "MQTT connected");
+    _linkState = MeoLinkState::Connecting;
+    _attemptStartMs = now;
+    return true;
+}
 
-    // Subscribe to feature invokes and wire handler
-    {
-        String topic = String("meo/") + String(_deviceId.c_str()) + "/feature/+/invoke";
-        _mqtt.subscribe(topic.c_str());
-        _mqtt.setMessageHandler(&_mqttThunk, this);
-        if (_logger && _debugTagEnabled("DEVICE")) {
-            _logf("DEBUG", "DEVICE", "Subscribed to %s", topic.c_str());
-        }
+void MeoDevice::_onMqttConnected(uint32_t now, uint32_t mqttGen) {
+    _linkState = MeoLinkState::Online;
+    _mqttGen = mqttGen;
+    _onlineSinceMs = now;
+    _backoff.reset();
+
+    uint32_t downMs = now - _downSinceMs;
+    if (_everOnline) {
+        _reconnect.reconnects++;
+        _reconnect.lastTimeToReconnectMs = downMs;
+        if (downMs > _reconnect.maxTimeToReconnectMs) _reconnect.maxTimeToReconnectMs = downMs;
     }
+    _everOnline = true;
+    MEO_LOGI(_log, DEVICE, "MQTT connected (%lums after link loss/start)", (unsigned long)downMs);
+
+    // Invoke route was registered in start(); the client resubscribed it on connect
 
     // Publish online status
-    {
-        String statusTopic = String("meo/") + String(_deviceId.c_str()) + "/status";
-        _mqtt.publish(statusTopic.c_str(), "online", true);
-    }
+    _mqtt.publish(_topics.status(), "online", true, _qos.control);
+
+    // Declare; backlog replay starts only after the gateway knows us again
+    _declared = _publishDeclare();
+    _nextReplayMs = now;
 
-    // Declare
-    _publishDeclare();
+    // Children re-announce themselves on the new session
+    _gateway.onConnected();
 
     _updateBleStatus();
-    return true;
 }
 
 bool MeoDevice::_publishDeclare() {
-    if (!_mqtt.isConnected()) return false;
+    if (!_mqtt.isConnected() || !_topics.valid()) return false;
 
-    String topic = String("meo/") + String(_deviceId.c_str()) + "/declare";
-    JsonDocument doc;
+    char buf[1024];
+    MeoJsonWriter w(buf, sizeof(buf));
+    w.beginObject();
 
-    JsonObject info = doc["device_info"].to<JsonObject>();
-    info["model"]        = _model ? _model : "";
-    info["manufacturer"] = _manufacturer ? _manufacturer : "";
-    info["connection"]   = "LAN";
+    w.key("device_info").beginObject()
+     .field("model", _model ? _model : "")
+     .field("manufacturer", _manufacturer ? _manufacturer : "")
+     .field("connection", "LAN")
+     .endObject();
 
-    JsonArray events = doc["events"].to<JsonArray>();
+    w.key("events").beginArray();
+    bool typed = false;
     for (uint8_t i = 0; i < _eventCount; ++i) {
-        events.add(_eventNames[i]);
+        w.value(_eventNames[i]);
+        typed |= (_eventSchemas[i] != nullptr);
     }
+    w.endArray();
 
-    JsonArray methods = doc["methods"].to<JsonArray>();
-    for (uint8_t i = 0; i < _methodCount; ++i) {
-        methods.add(_methodNames[i]);
+    if (typed) {
+        w.key("event_schemas").beginObject();
+        for (uint8_t i = 0; i < _eventCount; ++i) {
+            if (!_eventSchemas[i]) continue;
+            w.key(_eventNames[i]);
+            _eventSchemas[i]->schema(w);
+        }
+        w.endObject();
     }
 
-    char buf[1024];
-    size_t len = serializeJson(doc, buf, sizeof(buf));
-    if (len == 0) return false;
+    w.key("methods").beginArray();
+    for (size_t i = 0; i < _methods.size(); ++i) {
+        w.value(std::string_view(_methods[i].name, _methods[i].len));
+    }
+    w.endArray();
 
-    if (_logger && _debugTagEnabled("DEVICE")) {
-        _logf("DEBUG", "DEVICE", "Publish declare len=%u", (unsigned)len);
+    if (_batchBuf) {
+        w.field("batch_topic", _topics.batch());
+    }
+    if (_metricsPeriodMs) {
+        w.field("metrics_topic", _topics.metrics());
     }
-    return _mqtt.publish(topic.c_str(), (const uint8_t*)buf, len, false);
+    if (_gateway.isRunning()) {
+        w.field("gateway", true);
+    }
+    w.field("codec", meoCodecName(_codec));
+    w.endObject();
+
+    if (!w.ok()) {
+        MEO_LOGE(_log, DEVICE, "Declare needs %u bytes (max %u)",
+                 (unsigned)w.required(), (unsigned)sizeof(buf));
+        return false;
+    }
+    size_t len = w.length();
+
+    MEO_LOGD(_log, DEVICE, "Publish declare len=%u", (unsigned)len);
+    MeoPublishOptions opt;
+    opt.qos = _qos.control;
+    if (_mqtt.isMqtt5()) opt.contentType = "application/json";  // declare is always JSON
+    return _mqtt.publish(_topics.declare(), (const uint8_t*)buf, len, opt) == MeoPublishResult::Ok;
 }
 
 // Static -> instance adapter
-void MeoDevice::_mqttThunk(const char* topic, const uint8_t* payload, unsigned int length, void* ctx) {
+void MeoDevice::_mqttThunk(const char* topic, size_t topicLen,
+                           const uint8_t* payload, size_t length, void* ctx) {
     MeoDevice* self = reinterpret_cast<MeoDevice*>(ctx);
     if (!self) return;
-    self->_dispatchInvoke(topic, payload, length);
+    self->_dispatchInvoke(topic, topicLen, payload, length);
 }
 
-void MeoDevice::_dispatchInvoke(const char* topic, const uint8_t* payload, unsigned int length) {
-    // Expect "meo/{device_id}/feature/{featureName}/invoke"
-    const char* featureMarker = strstr(topic, "/feature/");
-    const char* invokeMarker  = strstr(topic, "/invoke");
-    if (!featureMarker || !invokeMarker || invokeMarker <= featureMarker) return;
+void MeoDevice::_dispatchInvoke(const char* topic, size_t topicLen, const uint8_t* payload, size_t length) {
+    const int64_t nowUs = _tracing.load(std::memory_order_relaxed) ? esp_timer_get_time() : 0;
 
-    featureMarker += 9; // strlen("/feature/")
-    size_t nameLen = (size_t)(invokeMarker - featureMarker);
-    if (nameLen == 0 || nameLen >= 64) return;
+    // Expect "meo/{device_id}/feature/{featureName}/invoke"; name stays a view into topic
+    const char* name;
+    size_t nameLen;
+    if (!_topics.parseInvoke(topic, topicLen, name, nameLen)) return;
 
-    char featureName[64];
-    memcpy(featureName, featureMarker, nameLen);
-    featureName[nameLen] = '\0';
+    // O(1) hashed lookup, no copy of the feature name
+    int idx = _methods.find(name, nameLen);
+    if (idx < 0) {
+        // No handler: negative response
+        char featureName[64];
+        snprintf(featureName, sizeof(featureName), "%.*s", (int)nameLen, name);
+        sendFeatureResponse(featureName, false, "No handler registered");
+        return;
+    }
 
-    // Parse minimal JSON
-    JsonDocument doc;
-    DeserializationError err = deserializeJson(doc, payload, length);
-    if (err) return;
+    const uint32_t traceId = nowUs ? _traceBegin((uint16_t)idx, nowUs) : 0;
+    if (!_invokePool.isRunning()) {
+        _runInvoke((uint16_t)idx, payload, length, traceId);
+        return;
+    }
+
+    MeoSubmitResult r = _invokePool.submit((uint16_t)idx, payload, length, traceId);
+    if (r == MeoSubmitResult::NotRunning) {
+        // Workers stopped since the isRunning() check
+        _runInvoke((uint16_t)idx, payload, length, traceId);
+        return;
+    }
+    // A payload larger than a worker slot is rejected too: running it here would block
+    // the MQTT task, which is what the workers were enabled to avoid
+    if (r != MeoSubmitResult::Queued) {
+        MEO_LOGW(_log, DEVICE, "Invoke %s rejected (%s)", _methods[idx].name,
+                 r == MeoSubmitResult::Full ? "queue full" : "payload too large");
+        sendFeatureResponse(_methods[idx].name, false,
+                            r == MeoSubmitResult::Full ? "Busy: invoke queue full" : "Payload too large");
+    }
+}
+
+void MeoDevice::_invokeWorkerThunk(uint16_t method, const uint8_t* payload, size_t len, uint32_t tag, void* ctx) {
+    MeoDevice* self = reinterpret_cast<MeoDevice*>(ctx);
+    if (!self) return;
+    self->_runInvoke(method, payload, len, tag);
+}
+
+void MeoDevice::_runInvoke(uint16_t idx, const uint8_t* payload, size_t length, uint32_t traceId) {
+    const auto& method = _methods[idx];
+    _invokeCount[idx]->inc();
 
     // Build MeoFeatureCall
     MeoFeatureCall call;
     call.deviceId = _deviceId;
-    call.featureName = featureName;
+    call.featureName.assign(method.name, method.len);
 
-    if (doc["params"].is<JsonObject>()) {
-        for (JsonPair kv : doc["params"].as<JsonObject>()) {
-            // Sửa dòng 337 thành:
-call.params[kv.key().c_str()] = kv.value().as<const char*>();
-        }
+    // Trace still in the in-flight table (not overwritten by newer invokes)
+    uint16_t traced;
+    uint32_t startUs;
+    if (traceId && _traceFind(traceId, traced, startUs) && traced == idx) {
+        const int64_t nowUs = esp_timer_get_time();
+        call.trace.id         = traceId;
+        call.trace.method     = idx;
+        call.trace.receivedUs = nowUs - (uint32_t)((uint32_t)nowUs - startUs);
     }
 
-    // Dispatch to registered handler
-    for (uint8_t i = 0; i < _methodCount; ++i) {
-        if (strcmp(featureName, _methodNames[i]) == 0) {
-            if (_logger && _debugTagEnabled("DEVICE")) {
-                _logf("DEBUG", "DEVICE", "Invoke %s with %u params", featureName, (unsigned)call.params.size());
-            }
-            if (_methodHandlers[i]) {
-                _methodHandlers[i](call);
-            }
-            return;
+    // Escaped JSON strings / nested CBOR values are decoded into this arena
+    char arena[MEO_INVOKE_UNESCAPE_MAX];
+    size_t arenaUsed = 0;
+
+    // Either codec, whatever setCodec() says: the gateway may not have switched yet
+    const bool cbor = meoIsCborMap(payload, length);
+    bool ok = cbor ? _readParams(MeoCborView::parse(payload, length), call.params, arena, sizeof(arena), arenaUsed)
+                   : _readParams(MeoJsonView::parse((const char*)payload, length), call.params,
+                                 arena, sizeof(arena), arenaUsed);
+    if (!ok) {
+        MEO_LOGW(_log, DEVICE, "Invoke %s: invalid %s", method.name, cbor ? "CBOR" : "JSON");
+        sendFeatureResponse(method.name, false, cbor ? "Invalid CBOR" : "Invalid JSON");
+        return;
+    }
+
+    // Correlation id for the gateway; numbers are kept as their decimal text
+    if (const MeoValue* cid = call.params.get("cid")) {
+        if (cid->type == MeoValueType::String) {
+            std::string_view s = cid->asString();
+            call.correlationId.assign(s.data(), s.size());
+        } else if (cid->type == MeoValueType::Int) {
+            char num[24];
+            snprintf(num, sizeof(num), "%lld", (long long)cid->i);
+            call.correlationId = num;
         }
     }
 
-    // No handler: optionally negative response
-    sendFeatureResponse(call, false, "No handler registered");
+    MEO_LOGD(_log, DEVICE, "Invoke %s with %u params", method.name, (unsigned)call.params.size());
+    if (!call.trace.id) {
+        method.handler(call);
+        return;
+    }
+    _traceRecord(idx, MeoTraceStage::Parse, startUs);
+    const uint32_t handlerUs = (uint32_t)esp_timer_get_time();
+    method.handler(call);
+    _traceRecord(idx, MeoTraceStage::Handler, handlerUs);
 }
 
-bool MeoDevice::_debugTagEnabled(const char* tag) const {
-    if (!_debugTags[0]) return false; // no debug tags -> no DEBUG logs
-    // simple substring match in CSV
-    const char* p = strstr(_debugTags, tag);
-    if (!p) return false;
-    // ensure token boundary (start or preceded by comma) and followed by comma or end
-    bool leftOk  = (p == _debugTags) || (*(p - 1) == ',');
-    const char* end = p + strlen(tag);
-    bool rightOk = (*end == '\0') || (*end == ',');
-    return leftOk && rightOk;
-}
+// Tokenize in place: views point into payload, which outlives the handler call
+bool MeoDevice::_readParams(const MeoJsonView& root, MeoPayload& params,
+                            char* arena, size_t arenaCap, size_t& arenaUsed) {
+    if (!root.isObject()) return false;
 
-void MeoDevice::_log(const char* level, const char* tag, const char* msg) const {
-    if (!_logger) return;
-    char buf[256];
-    snprintf(buf, sizeof(buf), "[%s] %s", tag ? tag : "DEVICE", msg ? msg : "");
-    _logger(level, buf);
+    MeoJsonIterator it(root["params"]);
+    while (it.next()) {
+        std::string_view key = it.key();
+        const MeoJsonView& v = it.value();
+        switch (v.type()) {
+            case MeoJsonType::Bool:
+                params.set(key, v.asBool());
+                break;
+            case MeoJsonType::Number:
+                if (v.isInteger()) params.set(key, v.asInt());
+                else               params.set(key, v.asDouble());
+                break;
+            case MeoJsonType::String: {
+                // If the arena runs out the string stays raw (escaped)
+                size_t n = 0;
+                if (v.needsUnescape() &&
+                    v.unescape(arena + arenaUsed, arenaCap - arenaUsed, n)) {
+                    params.set(key, std::string_view(arena + arenaUsed, n));
+                    arenaUsed += n;
+                } else {
+                    params.set(key, v.asString());
+                }
+                break;
+            }
+            case MeoJsonType::Object:
+            case MeoJsonType::Array:
+                params.setRaw(key, v.raw());
+                break;
+            default:
+                params.setNull(key);
+        }
+    }
+    return true;
 }
 
-void MeoDevice::_logf(const char* level, const char* tag, const char* fmt, ...) const {
-    if (!_logger) return;
-    char msg[192];
-    va_list ap;
-    va_start(ap, fmt);
-    vsnprintf(msg, sizeof(msg), fmt, ap);
-    va_end(ap);
-    _log(level, tag, msg);
-}
\ No newline at end of file
+// CBOR strings need no decoding; nested maps/arrays become JSON text in the arena so
+// Raw values look the same to handlers whatever the wire codec
+bool MeoDevice::_readParams(const MeoCborView& root, MeoPayload& params,
+                            char* arena, size_t arenaCap, size_t& arenaUsed) {
+    if (!root.isMap()) return false;
+
+    MeoCborIterator it(root["params"]);
+    while (it.next()) {
+        std::string_view key = it.key();
+        const MeoCborView& v = it.value();
+        switch (v.type()) {
+            case MeoCborType::Bool:   params.set(key, v.asBool()); break;
+            case MeoCborType::Int:    params.set(key, v.asInt()); break;
+            case MeoCborType::Float:  params.set(key, v.asDouble()); break;
+            case MeoCborType::String:
+            case MeoCborType::Bytes:  params.set(key, v.asString()); break;
+            case MeoCborType::Map:
+            case MeoCborType::Array: {
+                MeoJsonWriter w(arena + arenaUsed, arenaCap - arenaUsed);
+                if (meoCborToJson(v, w) && w.ok()) {
+                    params.setRaw(key, std::string_view(arena + arenaUsed, w.length()));
+                    arenaUsed += w.length();
+                } else {
+                    params.setNull(key);   // does not fit the arena
+                }
+                break;
+            }
+            default:
+                params.setNull(key);
+        }
+    }
+    return true;
+}
@@ -2,20 +2,101 @@
 
 #include <Arduino.h>
 #include <WiFi.h>
+#include <atomic>
 #include <string>
 
+#include "esp_event.h"
 #include "Meo3_Type.h"   // MeoFeatureCall, MeoEventPayload, MeoFeatureCallback, MeoConnectionType, MeoLogFunction
+#include "Meo3_Log.h"    // MeoLog, MEO_LOGx
+#include "Meo3_Topic.h"             // MeoTopics, MeoTopicBuf
+#include "Meo3_Dispatch.h"          // MeoDispatchTable
+#include "Meo3_Codec.h"             // MeoCodec: JSON / CBOR wire encoding
+#include "Meo3_Event.h"             // MEO_EVENT typed events
+#include "Meo3_Backoff.h"           // MeoBackoffPolicy, MeoBackoff
+#include "Meo3_Metrics.h"           // MeoMetrics registry
+#include "Meo3_Trace.h"             // MeoLatencyHistogram
 #include "Meo3_Storage.h"
 #include "Meo3_Ble.h"
 #include "Meo3_BleProvision.h"
 #include "Meo3_Mqtt.h"              // MeoMqttClient transport
+#include "Meo3_MqttInbox.h"         // MeoMqttInbox: lock-free handoff to loop()
+#include "Meo3_PublishQueue.h"      // Async publish (opt-in)
+#include "Meo3_OfflineBuffer.h"     // Store-and-forward while MQTT is down (opt-in)
+#include "Meo3_InvokePool.h"        // Feature handlers off the MQTT task (opt-in)
+#include "Meo3_Gateway.h"           // Child devices behind this connection (opt-in)
+
+class MeoJsonView;
 
 #ifndef MEO_MAX_FEATURE_EVENTS
 #define MEO_MAX_FEATURE_EVENTS 8
 #endif
+// Method lookup is a hash table, so this can be raised to hundreds; it only bounds
+// RAM, about 340 B per method on ESP32: ~290 B of invoke latency histograms (one
+// per trace stage, MEO_TRACE_BUCKETS + 2 words each), the table entry with its
+// handler (~28 B), two index slots and an invoke counter with its metric entry.
 #ifndef MEO_MAX_FEATURE_METHODS
 #define MEO_MAX_FEATURE_METHODS 8
 #endif
+// Device / gateway gauges (15 today, the rest is headroom); the metrics table adds
+// one invoke counter per feature method on top
+#ifndef MEO_DEVICE_METRICS_BASE
+#define MEO_DEVICE_METRICS_BASE 24
+#endif
+using MeoDeviceMetrics = MeoMetricsTable<MEO_DEVICE_METRICS_BASE + MEO_MAX_FEATURE_METHODS>;
+// Stack buffer for events/responses (either codec) when not serialized in place into a queue slot
+#ifndef MEO_JSON_OUT_MAX
+#define MEO_JSON_OUT_MAX 512
+#endif
+// Scratch for decoding escaped string params of one invoke (on the handler's stack)
+#ifndef MEO_INVOKE_UNESCAPE_MAX
+#define MEO_INVOKE_UNESCAPE_MAX 256
+#endif
+// Upper bound of one batch message; must fit the async queue / offline slots
+#ifndef MEO_BATCH_MAX_BYTES
+#define MEO_BATCH_MAX_BYTES MEO_PUBQ_PAYLOAD_MAX
+#endif
+
+// Invokes whose trace is kept until their response is acknowledged (power of 2)
+#ifndef MEO_TRACE_INFLIGHT
+#define MEO_TRACE_INFLIGHT 16
+#endif
+
+// esp-mqtt outbox budget (QoS>0 messages waiting to be sent or acknowledged)
+#ifndef MEO_OUTBOX_BUDGET
+#define MEO_OUTBOX_BUDGET 16384
+#endif
+
+// Encoded metrics snapshot
+#ifndef MEO_METRICS_OUT_MAX
+#define MEO_METRICS_OUT_MAX 768
+#endif
+
+// MQTT QoS per message class. QoS 1 messages outlive a short link loss in the
+// esp-mqtt outbox and are resent after reconnect; QoS 0 ones are dropped.
+struct MeoQosPolicy {
+    uint8_t events    = 0;  // telemetry, unless overridden per event (setEventQos)
+    uint8_t responses = 1;  // feature_response: the app is waiting for it
+    uint8_t control   = 1;  // online status, declare, last will
+    uint8_t invokes   = 1;  // invoke subscription; with a persistent session the
+                            // broker keeps invokes sent while we were offline
+};
+
+// MQTT link state driven from loop()
+enum class MeoLinkState : uint8_t {
+    Idle = 0,     // start() not reached MQTT yet (no WiFi/credentials)
+    Backoff,      // waiting for the next reconnect attempt
+    Connecting,   // attempt in flight (esp-mqtt is async)
+    Online        // connected, subscribed and declared
+};
+
+struct MeoReconnectStats {
+    uint32_t attempts              = 0;  // connect()/reconnect requests issued
+    uint32_t reconnects            = 0;  // successful sessions after the first one
+    uint32_t lastTimeToReconnectMs = 0;  // link down -> Online, last outage
+    uint32_t maxTimeToReconnectMs  = 0;
+    uint32_t nextAttemptInMs       = 0;  // only meaningful in Backoff
+    MeoLinkState state             = MeoLinkState::Idle;
+};
 
 class MeoDevice {
 public:
@@ -25,12 +106,20 @@ public:
     void setLogger(MeoLogFunction logger);
     // CSV of tags to enable DEBUG logs for (e.g. "DEVICE,MQTT,PROV")
     void setDebugTags(const char* tagsCsv);
+    // Deferred logging (opt-in): log calls only copy a compact record into a lock-free
+    // ring; a low-priority task formats it and calls the logger. Set the logger first.
+    bool enableDeferredLog(uint16_t depth = MEO_LOG_RING_DEPTH,
+                           BaseType_t core = tskNO_AFFINITY,
+                           UBaseType_t priority = 1);
+    void disableDeferredLog();
+    MeoLogRingStats logStats() const { return _logRing.stats(); }
 
     // Device info for declare and BLE RO fields
     void setDeviceInfo(const char* model,
                        const char* manufacturer);
 
-    // Optional: provide WiFi upfront; otherwise BLE provisioning can set it
+    // Optional: provide WiFi upfront; otherwise BLE provisioning can set it.
+    // Non-blocking: connection progress arrives via IDF WiFi/IP events.
     void beginWifi(const char* ssid, const char* pass);
 
     // MQTT broker (gateway)
@@ -38,18 +127,137 @@ public:
 
     // Features (simple API)
     bool addFeatureEvent(const char* name);
+    // Typed event (see MEO_EVENT): registered under its event name, with its field
+    // schema advertised in the declare as "event_schemas"
+    template <typename T>
+    bool addFeatureEvent() { return _addEventSchema(meoEventSchema<T>()); }
+    // Per-event QoS override for an event added with addFeatureEvent()
+    bool setEventQos(const char* name, uint8_t qos);
     bool addFeatureMethod(const char* name, MeoFeatureCallback cb);
 
     // Lifecycle
-    bool start();    // Load creds; BLE provisioning if needed; MQTT connect; declare
-    void loop();     // BLE status, MQTT loop, lazy reconnect
+    bool start();    // Load creds; start WiFi + BLE provisioning; returns without waiting
+    void loop();     // BLE status, MQTT link state machine (declare, backoff reconnect)
+
+    // Reconnect scheduling: exponential backoff with jitter, reusing the MQTT client handle
+    void setReconnectPolicy(const MeoBackoffPolicy& policy) { _backoff.setPolicy(policy); }
+    MeoReconnectStats reconnectStats() const;
+
+    // Largest inbound message (e.g. bulk config / schedule invokes) reassembled from
+    // esp-mqtt fragments; bigger ones are dropped and counted in inboundStats()
+    void setMaxInboundSize(size_t bytes) { _mqtt.setMaxMessageSize(bytes); }
+    MeoMqttRxStats inboundStats() const { return _mqtt.rxStats(); }
+
+    // Delivery guarantees. Set before start(); the session/outbox settings apply
+    // on the next connect.
+    void setQosPolicy(const MeoQosPolicy& policy) { _qos = policy; }
+    const MeoQosPolicy& qosPolicy() const { return _qos; }
+    // Persistent session (default on): the broker keeps our subscriptions and
+    // QoS 1 messages across reconnects. The client id is stable either way.
+    void setPersistentSession(bool enable) { _persistentSession = enable; }
+    // Cap on outbox memory. Above 3/4 of it, offline replay pauses and new events
+    // go to the offline buffer (if enabled); at the cap, QoS>0 publishes fail.
+    void setOutboxBudget(size_t bytes) { _outboxBudget = bytes; }
+    size_t outboxBytes() { return _mqtt.outboxBytes(); }
+    MeoMqttTxStats transportStats() const { return _mqtt.txStats(); }
+
+    // Wire encoding of events and feature responses (default JSON). The declare
+    // (always JSON) advertises it as "codec"; invokes are accepted in JSON or CBOR
+    // whatever is set here. Switching flushes a pending batch.
+    void setCodec(MeoCodec codec);
+    MeoCodec codec() const { return _codec; }
+
+    // MQTT 5 transport (needs CONFIG_MQTT_PROTOCOL_5; returns false otherwise).
+    // Event topics get a topic alias after their first QoS 0 publish on a session,
+    // messages carry their content-type (JSON / CBOR), and
+    // feature_response moves feature_name into a user property: its payload is
+    // just {"success":..,"message":..}. Applies from the next connect.
+    bool setMqtt5(bool enable) { return _mqtt.setProtocolVersion(enable ? 5 : 4); }
 
     // Publish helpers
     bool publishEvent(const char* eventName,
                       const char* const* keys,
                       const char* const* values,
                       uint8_t count);
-    bool publishEvent(const char* eventName, const MeoEventPayload& payload);
+    bool publishEvent(const char* eventName, const MeoPayload& payload);
+    bool publishEvent(const char* eventName, const MeoEventPayload& payload);  // legacy map
+    // Typed event: no allocation, no format strings, and the message size is bounded
+    // at compile time so it can never be truncated
+    template <typename T, typename = typename std::enable_if<MeoEventTraits<T>::defined>::type>
+    bool publishEvent(const T& ev) {
+        static_assert(MeoEvent<T>::maxSize() <= MEO_JSON_OUT_MAX && MeoEvent<T>::maxSize() <= MEO_PUBQ_PAYLOAD_MAX,
+                      "Event can exceed MEO_JSON_OUT_MAX / MEO_PUBQ_PAYLOAD_MAX: raise them or split the event");
+        return _publishTyped(meoEventSchema<T>(), &ev);
+    }
+
+    // Async publish (opt-in): publishEvent/sendFeatureResponse only copy the
+    // message into a pre-allocated queue; a pinned sender task does the publish.
+    bool enableAsyncPublish(uint8_t depth = MEO_PUBQ_DEFAULT_DEPTH,
+                            BaseType_t core = tskNO_AFFINITY,
+                            UBaseType_t priority = 5);
+    void disableAsyncPublish();
+    bool isAsyncPublish() const { return _pubQueue.isRunning(); }
+    MeoEnqueueResult lastEnqueueResult() const { return _lastEnqueue; }
+    // Why the last direct publish (async publish off) of an event or feature_response
+    // failed, e.g. Rejected by the broker's MQTT 5 limits. Ok once stored offline.
+    MeoPublishResult lastPublishResult() const { return _lastPublish; }
+    MeoPublishStats  publishStats() const { return _pubQueue.stats(); }
+
+    // Store-and-forward (opt-in): events published while MQTT is down are kept in a
+    // RAM ring (spilling to the "meo_spool" flash partition) and replayed in order,
+    // at cfg.replayPerSecond, once the connection and declare are back.
+    bool enableOfflineBuffer(const MeoOfflineConfig& cfg = MeoOfflineConfig());
+    MeoOfflineStats offlineStats() const { return _offline.stats(); }
+
+    // Batching (opt-in): events are coalesced into one message on meo/{id}/event/batch
+    // as [{"event":..,"ts":<uptime ms>,"payload":{..}}, ...] (a CBOR array with the
+    // same items when the codec is CBOR). A batch is flushed when
+    // it reaches maxBytes, when windowMs has elapsed since its first event (checked
+    // in loop()), or on flushBatch(). The declare advertises the batch topic.
+    // Two buffers of maxBytes are allocated: events keep filling one while the other
+    // is published. flushBatch() returns false while the previous batch is in flight.
+    bool enableBatching(uint32_t windowMs = 1000, size_t maxBytes = MEO_BATCH_MAX_BYTES);
+    void disableBatching();   // flushes what is pending
+    bool flushBatch();
+    bool isBatching() const { return _batchBuf != nullptr; }
+
+    // Invoke workers (opt-in): feature handlers run on a pool of worker tasks instead
+    // of the esp-mqtt task. Invokes of one feature are serialized on the same worker;
+    // when the queue is full, or the payload exceeds MEO_INVOKE_PAYLOAD_MAX, the invoke
+    // is rejected with a negative feature_response.
+    bool enableInvokeWorkers(uint8_t workers = 2, uint8_t depth = 8, UBaseType_t priority = 5);
+    void disableInvokeWorkers();
+    MeoInvokePoolStats invokeStats() const { return _invokePool.stats(); }
+
+    // Metrics: publishes, failures, bytes, queue depth, invokes per feature, reconnects,
+    // connected time, free / minimum heap and outbox size. Counters are relaxed atomics,
+    // always on. With periodMs > 0, loop() publishes a snapshot on meo/{id}/metrics
+    // (current codec, QoS 0); the declare advertises it as "metrics_topic".
+    void enableMetrics(uint32_t periodMs = 60000);
+    bool publishMetrics();
+    // Local pull: refreshes the gauges and returns the registry (call from the loop task)
+    const MeoDeviceMetrics& metrics();
+
+    // Invoke latency tracing (opt-in): timestamps at MQTT_EVENT_DATA, params parsed,
+    // handler start/end, feature_response queued and its PUBACK feed one log-scale
+    // histogram per feature and MeoTraceStage. An invoke's "cid" is echoed in its
+    // feature_response. Histograms are published on meo/{id}/latency (one message per
+    // feature) together with the metrics, or on demand.
+    void setInvokeTracing(bool enable);
+    const MeoLatencyHistogram* invokeLatency(const char* featureName, MeoTraceStage stage) const;
+    void resetInvokeLatency();
+    void dumpInvokeLatency();    // one INFO log line per feature and stage
+    bool publishInvokeLatency();
+
+    // Gateway mode (opt-in): this device's MQTT session also carries the child devices
+    // attached through `transport` (e.g. UART). Invokes on meo/+/feature/+/invoke are
+    // routed to the child by device id; child events are coalesced per child every
+    // cfg.batchWindowMs; child status/declare/responses go out under the child's own
+    // topics. The broker ACL must allow this client on its children's topics.
+    // `transport` must outlive the gateway.
+    bool enableGateway(MeoChildTransport& transport, const MeoGatewayConfig& cfg = MeoGatewayConfig());
+    void disableGateway();
+    MeoGatewayStats gatewayStats() const { return _gateway.stats(); }
 
     // Send feature response
     bool sendFeatureResponse(const char* featureName,
@@ -61,7 +269,16 @@ public:
 
     // Status
     bool hasCredentials() const { return _deviceId.length() && _transmitKey.length(); }
-    bool isMqttConnected() { return _mqtt.isConnected(); }
+    // Safe from any task/core. mqttGeneration() changes on every new MQTT session.
+    bool isMqttConnected() const { return _mqtt.isConnected(); }
+    uint32_t mqttGeneration() const { return _mqtt.generation(); }
+    MeoLinkState linkState() const { return _linkState.load(std::memory_order_acquire); }
+
+    // Application subscriptions: messages are copied into `inbox` on the esp-mqtt task and
+    // consumed from the loop task with inbox.peek()/release(), without locks. The filter
+    // is kept and resubscribed on every connect; `inbox` must outlive the subscription.
+    bool subscribe(const char* filter, MeoMqttInbox& inbox, uint8_t qos = 0);
+    bool unsubscribe(const char* filter, MeoMqttInbox& inbox);
 
 private:
     // Config
@@ -76,39 +293,154 @@ private:
     // Identity (from BLE/app)
     std::string  _deviceId;
     std::string  _transmitKey;
+    MeoTopics    _topics;      // meo/{id}/... built once when credentials load
 
     // Registries (simple arrays)
     const char* _eventNames[MEO_MAX_FEATURE_EVENTS];
+    uint8_t     _eventQos[MEO_MAX_FEATURE_EVENTS];   // kQosDefault = use _qos.events
+    const MeoEventSchema* _eventSchemas[MEO_MAX_FEATURE_EVENTS];  // nullptr for untyped events
     uint8_t     _eventCount = 0;
 
-    const char*        _methodNames[MEO_MAX_FEATURE_METHODS];
-    MeoFeatureCallback _methodHandlers[MEO_MAX_FEATURE_METHODS];
-    uint8_t            _methodCount = 0;
+    MeoDispatchTable<MeoFeatureCallback, MEO_MAX_FEATURE_METHODS> _methods;
 
     // Modules
     MeoStorage      _storage;
     MeoBle          _ble;
     MeoBleProvision _prov;
     MeoMqttClient   _mqtt;
+    MeoPublishQueue _pubQueue;
+    MeoOfflineBuffer _offline;
+    MeoInvokePool   _invokePool;
+    MeoGateway      _gateway;
+
+    // State (WiFi flags are written by the IDF event task)
+    std::atomic<bool>     _wifiReady{false};
+    std::atomic<uint32_t> _wifiGen{0};      // bumped on every IP_EVENT_STA_GOT_IP
+    uint32_t              _seenWifiGen = 0;
+    bool                  _wifiEventsRegistered = false;
+    esp_event_handler_instance_t _wifiDiscHandler = nullptr;
+    esp_event_handler_instance_t _ipHandler = nullptr;
+    MeoEnqueueResult _lastEnqueue = MeoEnqueueResult::NotRunning;
+    MeoPublishResult _lastPublish = MeoPublishResult::Ok;
+    bool     _declared     = false;  // declare went out on the current session
+    uint32_t _nextReplayMs = 0;
+
+    // Delivery
+    static const uint8_t kQosDefault = 0xFF;
+    MeoQosPolicy _qos;
+    MeoCodec     _codec = MeoCodec::Json;
+    bool         _persistentSession = true;
+    size_t       _outboxBudget      = MEO_OUTBOX_BUDGET;
 
-    // State
-    bool _wifiReady = false;
+    // Reconnect state machine (loop task writes; linkState() may read from any core)
+    std::atomic<MeoLinkState> _linkState{MeoLinkState::Idle};
+    uint32_t     _mqttGen         = 0;   // MQTT session generation we went Online with
+    MeoBackoff   _backoff;
+    uint32_t     _nextAttemptMs   = 0;
+    uint32_t     _attemptStartMs  = 0;
+    uint32_t     _downSinceMs     = 0;
+    bool         _everOnline      = false;
+    MeoReconnectStats _reconnect;
+
+    // Metrics
+    MeoDeviceMetrics _metrics;
+    MeoMetric*  _invokeCount[MEO_MAX_FEATURE_METHODS] = {};
+    uint32_t    _metricsPeriodMs = 0;
+    uint32_t    _nextMetricsMs   = 0;
+    uint32_t    _onlineSinceMs   = 0;
+    uint64_t    _connectedMs     = 0;   // closed sessions only
+
+    // Invoke tracing
+    struct TraceSlot {
+        std::atomic<uint32_t> id{0};       // 0 while being written
+        std::atomic<uint32_t> startUs{0};  // low 32 bits of esp_timer time
+        std::atomic<uint16_t> method{0};
+    };
+    std::atomic<bool>     _tracing{false};
+    std::atomic<uint32_t> _traceSeq{0};
+    TraceSlot             _inflight[MEO_TRACE_INFLIGHT];
+    MeoLatencyHistogram   _latency[MEO_MAX_FEATURE_METHODS][(size_t)MeoTraceStage::Count];
+
+    // Batching
+    char*             _batchBuf      = nullptr;   // being filled
+    char*             _batchSpare    = nullptr;   // swapped out, being published
+    size_t            _batchMax      = 0;
+    size_t            _batchLen      = 0;   // bytes used, without the closing ']'
+    size_t            _batchSpareLen = 0;   // != 0 while the spare is being published
+    uint16_t          _batchCount    = 0;
+    uint8_t           _batchQos      = 0;   // highest QoS of the pending events
+    uint8_t           _batchSpareQos = 0;
+    MeoCodec          _batchCodec    = MeoCodec::Json;   // framing of the pending batch
+    MeoCodec          _batchSpareCodec = MeoCodec::Json;
+    uint32_t          _batchWindowMs = 0;
+    uint32_t          _batchStartMs  = 0;
+    SemaphoreHandle_t _batchLock     = nullptr;
 
     // Logging
-    MeoLogFunction _logger = nullptr;
-    char           _debugTags[96] = {0}; // CSV list of enabled DEBUG tags
+    MeoLog _log;   // sink + DEBUG tag bitmask, shared with _mqtt / _prov
+    MeoLogRing _logRing;  // used by every copy of _log while running
 
     // Internals
+    void _startWifi(const char* ssid, const char* pass);
+    void _registerWifiEvents();
+    static void _wifiEventThunk(void* arg, esp_event_base_t base, int32_t id, void* data);
     void _updateBleStatus();
-    bool _connectMqttAndDeclare();
+    void _serviceLink();
+    bool _connectMqtt();                 // configure + connect/reconnect request
+    void _onMqttConnected(uint32_t now, uint32_t mqttGen); // online status, declare
+    void _scheduleReconnect(uint32_t now);
+    void _refreshMetrics();
+    uint32_t _traceBegin(uint16_t method, int64_t nowUs);
+    bool _traceFind(uint32_t id, uint16_t& method, uint32_t& startUs) const;
+    void _traceRecord(uint16_t method, MeoTraceStage stage, uint32_t startUs);
+    static void _deliveryThunk(int msgId, bool delivered, uint32_t cookie, void* ctx);
+    bool _sendResponse(const char* featureName, bool success, const char* message,
+                       const MeoFeatureCall* call);
     bool _publishDeclare();
+    // Single exit for event/response publishes: async queue if enabled, else direct
+    bool _publishRaw(const char* topic, const uint8_t* payload, size_t len, const MeoPublishOptions& opt);
+    // QoS + MQTT 5 properties (content-type, alias for event topics) of an encoded message;
+    // without a codec the current one is assumed
+    MeoPublishOptions _pubOptions(uint8_t qos, bool event);
+    MeoPublishOptions _pubOptions(uint8_t qos, bool event, MeoCodec codec);
+    // Event path: goes to the offline buffer while disconnected, while a backlog is
+    // pending or while the outbox is congested. codec = how payload was encoded
+    bool _publishEventRaw(const char* topic, const uint8_t* payload, size_t len, uint8_t qos,
+                          MeoCodec codec);
+    void _replayOffline();
+    // Event payload (already encoded) -> batch or single publish
+    bool _emitEvent(const char* eventName, const char* topic, MeoCodec codec, const uint8_t* data, size_t len);
+    // Serialize with fill(auto& writer) in the current codec, straight into a
+    // sender-queue slot when the message would go there anyway, else into a stack
+    // buffer. eventName == nullptr means a feature response.
+    template <typename Fill>
+    bool _sendEncoded(const char* topic, const char* eventName, const MeoPublishOptions& opt, Fill&& fill);
+    bool _eventGoesDirect();
+    bool _addEventSchema(const MeoEventSchema& schema);
+    bool _publishTyped(const MeoEventSchema& schema, const void* ev);
+    bool _outboxCongested();
+    uint8_t _eventQosFor(const char* eventName) const;
+    uint8_t _maxEventQos() const;
+    uint8_t _qosForTopic(const char* topic) const;   // offline replay
+    bool _batchAppend(const char* eventName, MeoCodec codec, const uint8_t* data, size_t len);
+    bool _swapBatchLocked();
+    bool _publishBatchSpare();
 
     // MQTT message adapter: parse invoke and dispatch MeoFeatureCall
-    static void _mqttThunk(const char* topic, const uint8_t* payload, unsigned int length, void* ctx);
-    void _dispatchInvoke(const char* topic, const uint8_t* payload, unsigned int length);
-
-    // Logging helpers
-    bool _debugTagEnabled(const char* tag) const;
-    void _log(const char* level, const char* tag, const char* msg) const;
-    void _logf(const char* level, const char* tag, const char* fmt, ...) const;
+    static void _mqttThunk(const char* topic, size_t topicLen,
+                           const uint8_t* payload, size_t length, void* ctx);
+    void _dispatchInvoke(const char* topic, size_t topicLen, const uint8_t* payload, size_t length);
+    // Parse params and call the handler of method idx (MQTT task or invoke worker)
+    void _runInvoke(uint16_t idx, const uint8_t* payload, size_t length, uint32_t traceId);
+    // invoke {"params":{..}} -> typed params; false if the payload is malformed
+    static bool _readParams(const MeoJsonView& root, MeoPayload& params,
+                            char* arena, size_t arenaCap, size_t& arenaUsed);
+    static bool _readParams(const MeoCborView& root, MeoPayload& params,
+                            char* arena, size_t arenaCap, size_t& arenaUsed);
+    static void _invokeWorkerThunk(uint16_t method, const uint8_t* payload, size_t len, uint32_t tag, void* ctx);
+    // Gateway mode: invokes for other device ids, and publishes on behalf of children
+    static void _gatewayInvokeThunk(const char* topic, size_t topicLen,
+                                    const uint8_t* payload, size_t length, void* ctx);
+    static bool _gatewayPublishThunk(MeoGatewayPub kind, const char* topic,
+                                     const uint8_t* payload, size_t len, void* ctx);
 };
\ No newline at end of file
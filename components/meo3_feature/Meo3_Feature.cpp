@@ -1,13 +1,9 @@
 #include "Meo3_Feature.h"
 #include "esp_log.h"
 #include <cstdio>
-#include <cstdlib>
 
 static const char* TAG = "MeoFeature";
 
-// Kích thước buffer tạm thời nếu cần, hoặc giới hạn tham số
-#define MAX_PARAMS 10
-
 MeoFeature::MeoFeature() {
     // Constructor
 }
@@ -20,28 +16,23 @@ void MeoFeature::attach(MeoMqttClient* transport, const char* deviceId) {
     _mqtt = transport;
     if (deviceId) {
         _deviceId = deviceId; // std::string tự copy dữ liệu
+        _topics.setDeviceId(deviceId); // Dựng sẵn các topic một lần
     }
-
-    if (_mqtt) {
-        // Đăng ký hàm static làm callback, truyền 'this' làm context
-        _mqtt->setMessageHandler(&MeoFeature::onRawMessage, this);
-    }
+    // Handler được gắn theo route trong beginFeatureSubscribe(), không ghi đè handler của module khác
 }
 
 bool MeoFeature::beginFeatureSubscribe(FeatureCallback cb, void* ctx) {
-    if (!_mqtt || !_mqtt->isConnected() || _deviceId.empty()) {
-        ESP_LOGW(TAG, "Cannot subscribe: MQTT not connected or DeviceID missing");
+    if (!_mqtt || !_topics.valid()) {
+        ESP_LOGW(TAG, "Cannot subscribe: MQTT transport or DeviceID missing");
         return false;
     }
 
     _cb = cb;
     _cbCtx = ctx;
 
-    // Topic: meo/{device_id}/feature/+/invoke
-    std::string topic = "meo/" + _deviceId + "/feature/+/invoke";
-    
-    ESP_LOGI(TAG, "Subscribing to feature invoke: %s", topic.c_str());
-    return _mqtt->subscribe(topic.c_str());
+    // Topic: meo/{device_id}/feature/+/invoke (route giữ lại, tự subscribe lại khi reconnect)
+    ESP_LOGI(TAG, "Subscribing to feature invoke: %s", _topics.invokeFilter());
+    return _mqtt->subscribe(_topics.invokeFilter(), &MeoFeature::onRawMessage, this);
 }
 
 bool MeoFeature::publishEvent(const char* eventName,
@@ -50,146 +41,111 @@ bool MeoFeature::publishEvent(const char* eventName,
                               uint8_t count) {
     if (!_mqtt || !_mqtt->isConnected() || _deviceId.empty()) return false;
 
-    std::string topic = "meo/" + _deviceId + "/event/" + eventName;
-
-    // Tạo đối tượng JSON
-    cJSON* root = cJSON_CreateObject();
-    if (root == NULL) return false;
+    MeoTopicBuf<> topic;
+    if (!_topics.event(topic, eventName)) return false;
 
-    for (uint8_t i = 0; i < count; ++i) {
-        // cJSON_AddStringToObject tự động copy chuỗi
-        cJSON_AddStringToObject(root, keys[i], values[i]);
-    }
-
-    // Serialize ra chuỗi (Unformatted để tiết kiệm dung lượng)
-    char* jsonStr = cJSON_PrintUnformatted(root);
-    if (jsonStr == NULL) {
-        cJSON_Delete(root);
+    // Ghi thẳng vào buffer trên stack theo codec đã chọn
+    uint8_t buf[MEO_FEATURE_JSON_MAX];
+    size_t need = 0;
+    size_t len = meoEncode(_codec, buf, sizeof(buf), [&](auto& w) {
+        w.beginObject();
+        for (uint8_t i = 0; i < count; ++i) {
+            w.field(keys[i], values[i]);
+        }
+        w.endObject();
+    }, &need);
+    if (!len) {
+        ESP_LOGW(TAG, "Event %s needs %u bytes (max %u)", eventName,
+                 (unsigned)need, (unsigned)sizeof(buf));
         return false;
     }
 
-    // Gửi MQTT
-    // Giả định hàm publish của MeoMqttClient nhận (topic, payload, len, retained)
-    bool res = _mqtt->publish(topic.c_str(), (const uint8_t*)jsonStr, strlen(jsonStr), false);
-
-    // Giải phóng bộ nhớ
-    free(jsonStr);     // cJSON_PrintUnformatted cấp phát bằng malloc
-    cJSON_Delete(root); // Xóa object JSON
-
-    return res;
+    return _mqtt->publish(topic.c_str(), buf, len, false);
 }
 
 bool MeoFeature::sendFeatureResponse(const char* featureName,
                                      bool success,
                                      const char* message) {
-    if (!_mqtt || !_mqtt->isConnected() || _deviceId.empty()) return false;
-
-    std::string topic = "meo/" + _deviceId + "/event/feature_response";
-
-    cJSON* root = cJSON_CreateObject();
-    if (root == NULL) return false;
-
-    cJSON_AddStringToObject(root, "feature_name", featureName);
-    cJSON_AddStringToObject(root, "device_id", _deviceId.c_str());
-    cJSON_AddBoolToObject(root, "success", success);
-    if (message) {
-        cJSON_AddStringToObject(root, "message", message);
-    }
-
-    char* jsonStr = cJSON_PrintUnformatted(root);
-    if (jsonStr == NULL) {
-        cJSON_Delete(root);
+    if (!_mqtt || !_mqtt->isConnected() || !_topics.valid()) return false;
+
+    uint8_t buf[MEO_FEATURE_JSON_MAX];
+    size_t need = 0;
+    size_t len = meoEncode(_codec, buf, sizeof(buf), [&](auto& w) {
+        w.beginObject()
+         .field("feature_name", featureName)
+         .field("device_id", std::string_view(_deviceId))
+         .field("success", success);
+        if (message) {
+            w.field("message", message);
+        }
+        w.endObject();
+    }, &need);
+    if (!len) {
+        ESP_LOGW(TAG, "Feature response needs %u bytes (max %u)",
+                 (unsigned)need, (unsigned)sizeof(buf));
         return false;
     }
 
-    bool res = _mqtt->publish(topic.c_str(), (const uint8_t*)jsonStr, strlen(jsonStr), false);
-
-    free(jsonStr);
-    cJSON_Delete(root);
-
-    return res;
+    return _mqtt->publish(_topics.response(), buf, len, false);
 }
 
 bool MeoFeature::publishStatus(const char* status) {
-    if (!_mqtt || !_mqtt->isConnected() || _deviceId.empty()) return false;
+    if (!_mqtt || !_mqtt->isConnected() || !_topics.valid() || !status) return false;
 
-    std::string topic = "meo/" + _deviceId + "/status";
-    
     // Status thường dùng retain = true
-    return _mqtt->publish(topic.c_str(), (const uint8_t*)status, strlen(status), true);
+    return _mqtt->publish(_topics.status(), (const uint8_t*)status, strlen(status), true);
 }
 
 // Hàm tĩnh (Static)
-void MeoFeature::onRawMessage(const char* topic, const uint8_t* payload, unsigned int length, void* ctx) {
+void MeoFeature::onRawMessage(const char* topic, size_t topicLen,
+                              const uint8_t* payload, size_t length, void* ctx) {
     MeoFeature* self = reinterpret_cast<MeoFeature*>(ctx);
     if (!self) return;
 
     // Chuyển payload sang const char* để xử lý nội bộ
-    self->_dispatchFeatureInvoke(topic, (const char*)payload, (int)length);
+    self->_dispatchFeatureInvoke(topic, topicLen, (const char*)payload, length);
 }
 
-void MeoFeature::_dispatchFeatureInvoke(const char* topic, const char* payload, int length) {
+void MeoFeature::_dispatchFeatureInvoke(const char* topic, size_t topicLen, const char* payload, size_t length) {
     if (!_cb || _deviceId.empty()) return;
 
-    // Phân tích Topic: "meo/{device_id}/feature/{featureName}/invoke"
-    const char* featureMarker = strstr(topic, "/feature/");
-    const char* invokeMarker  = strstr(topic, "/invoke");
-
-    // Kiểm tra tính hợp lệ cơ bản của topic
-    if (!featureMarker || !invokeMarker || invokeMarker <= featureMarker) return;
-
-    featureMarker += 9; // độ dài của "/feature/"
-    size_t nameLen = (size_t)(invokeMarker - featureMarker);
-    
-    if (nameLen == 0 || nameLen >= 64) return; // Giới hạn độ dài tên feature
+    // Topic "meo/{device_id}/feature/{featureName}/invoke" (view, không có '\0')
+    const char* name;
+    size_t nameLen;
+    if (!_topics.parseInvoke(topic, topicLen, name, nameLen)) return;
+    if (nameLen >= 64) return; // Giới hạn độ dài tên feature
 
     char featureName[64];
-    memcpy(featureName, featureMarker, nameLen);
+    memcpy(featureName, name, nameLen);
     featureName[nameLen] = '\0';
 
-    // Chuẩn bị buffer cho JSON (cần null-terminated để parse an toàn)
-    // Nếu payload không chắc chắn có null ở cuối, ta cần copy ra buffer tạm.
-    char* jsonBuf = (char*)malloc(length + 1);
-    if (!jsonBuf) {
-        ESP_LOGE(TAG, "OOM parsing JSON");
+    // Invoke CBOR: chuyển params sang JSON trên stack, callback giữ nguyên kiểu MeoJsonView
+    if (meoIsCborMap((const uint8_t*)payload, length)) {
+        MeoCborView root = MeoCborView::parse((const uint8_t*)payload, length);
+        if (!root.isMap()) {
+            ESP_LOGW(TAG, "Invalid CBOR format");
+            return;
+        }
+        char json[MEO_FEATURE_JSON_MAX];
+        MeoJsonWriter w(json, sizeof(json));
+        MeoCborView params = root["params"];
+        if (params.valid() && (!meoCborToJson(params, w) || !w.ok())) {
+            ESP_LOGW(TAG, "CBOR params need %u bytes as JSON (max %u)",
+                     (unsigned)w.required(), (unsigned)sizeof(json));
+            return;
+        }
+        MeoJsonView view = params.valid() ? MeoJsonView::parse(json, w.length()) : MeoJsonView();
+        _cb(featureName, _deviceId.c_str(), view, _cbCtx);
         return;
     }
-    memcpy(jsonBuf, payload, length);
-    jsonBuf[length] = '\0';
-
-    // Parse JSON
-    cJSON* root = cJSON_Parse(jsonBuf);
-    free(jsonBuf); // Xong việc với buffer raw string
 
-    if (root == NULL) {
+    // Tokenize ngay trên buffer của esp-mqtt: không cần '\0', không malloc/copy
+    MeoJsonView root = MeoJsonView::parse(payload, length);
+    if (!root.isObject()) {
         ESP_LOGW(TAG, "Invalid JSON format");
         return;
     }
 
-    // Chuẩn bị mảng params
-    const char* keys[MAX_PARAMS];
-    const char* values[MAX_PARAMS];
-    uint8_t count = 0;
-
-    cJSON* params = cJSON_GetObjectItem(root, "params");
-    if (params && cJSON_IsObject(params)) {
-        cJSON* item = NULL;
-        cJSON_ArrayForEach(item, params) {
-            if (count >= MAX_PARAMS) break;
-
-            // Chỉ chấp nhận value là string để đơn giản hóa (giống logic cũ)
-            if (cJSON_IsString(item)) {
-                keys[count]   = item->string;       // Tên key
-                values[count] = item->valuestring;  // Giá trị
-                count++;
-            }
-            // Nếu cần hỗ trợ số/bool, cần convert sang string ở đây
-        }
-    }
-
-    // Gọi callback người dùng
-    _cb(featureName, _deviceId.c_str(), keys, values, count, _cbCtx);
-
-    // Dọn dẹp cJSON
-    cJSON_Delete(root);
-}
\ No newline at end of file
+    // Gọi callback người dùng với toàn bộ params (mọi kiểu, không giới hạn số lượng)
+    _cb(featureName, _deviceId.c_str(), root["params"], _cbCtx);
+}
@@ -3,23 +3,32 @@
 #include <cstdint>
 #include <cstring>
 #include <string>
-#include "cJSON.h"      // Thư viện JSON chuẩn của ESP-IDF
 #include "Meo3_Mqtt.h"  // Class MQTT đã sửa ở bước trước
+#include "Meo3_Topic.h" // MeoTopics, MeoTopicBuf (không cấp phát khi publish)
+#include "Meo3_JsonReader.h" // MeoJsonView: đọc JSON tại chỗ, không malloc
+#include "Meo3_JsonWriter.h" // MeoJsonWriter: ghi JSON thẳng vào buffer
+#include "Meo3_Codec.h"      // MeoCodec: JSON / CBOR
+
+// Buffer (trên stack) cho event / feature response, và cho params của invoke CBOR
+// (được chuyển sang JSON để callback vẫn nhận MeoJsonView)
+#ifndef MEO_FEATURE_JSON_MAX
+#define MEO_FEATURE_JSON_MAX 512
+#endif
 
 /**
  * MeoFeature: Lớp xử lý logic Feature/Event trên nền tảng ESP-IDF
- * - Sử dụng cJSON thay cho ArduinoJson.
+ * - Đọc/ghi JSON trực tiếp trên buffer, không cấp phát trên heap.
  * - Sử dụng std::string để quản lý bộ nhớ chuỗi an toàn.
  */
 class MeoFeature {
 public:
-    // Callback giữ nguyên logic cũ
+    // params là view vào payload MQTT gốc (object "params", Invalid nếu không có),
+    // chỉ hợp lệ trong lúc callback chạy. Không giới hạn số param, giữ nguyên kiểu
+    // number/bool/string/object: params["speed"].asInt(), params["name"].asString()...
     typedef void (*FeatureCallback)(
         const char* featureName,
         const char* deviceId,
-        const char* const* keys,   // param keys
-        const char* const* values, // param values
-        uint8_t count,
+        const MeoJsonView& params,
         void* ctx
     );
 
@@ -32,6 +41,10 @@ public:
     // Đăng ký nhận lệnh invoke
     bool beginFeatureSubscribe(FeatureCallback cb, void* ctx);
 
+    // Mã hóa event / feature response (mặc định JSON). Invoke nhận cả JSON lẫn CBOR.
+    void setCodec(MeoCodec codec) { _codec = codec; }
+    MeoCodec codec() const { return _codec; }
+
     // Gửi Event (Dùng mảng keys/values)
     bool publishEvent(const char* eventName,
                       const char* const* keys,
@@ -47,16 +60,19 @@ public:
     bool publishStatus(const char* status);
 
     // Hàm tĩnh để nhận dữ liệu từ MeoMqttClient
-    static void onRawMessage(const char* topic, const uint8_t* payload, unsigned int length, void* ctx);
+    static void onRawMessage(const char* topic, size_t topicLen,
+                             const uint8_t* payload, size_t length, void* ctx);
 
 private:
     MeoMqttClient* _mqtt = nullptr;
     std::string    _deviceId; // Dùng std::string an toàn hơn char*
+    MeoTopics      _topics;   // meo/{id}/... dựng một lần trong attach()
+    MeoCodec       _codec = MeoCodec::Json;
 
     // Callback và Context
     FeatureCallback _cb = nullptr;
     void*           _cbCtx = nullptr;
 
     // Hàm nội bộ xử lý logic
-    void _dispatchFeatureInvoke(const char* topic, const char* payload, int length);
+    void _dispatchFeatureInvoke(const char* topic, size_t topicLen, const char* payload, size_t length);
 };
\ No newline at end of file
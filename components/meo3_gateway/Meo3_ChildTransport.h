@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Loại message giữa gateway và thiết bị con (giá trị cố định: đi trên dây)
+enum class MeoChildMsgType : uint8_t {
+    Declare   = 1,  // con -> gw: payload = JSON declare, gửi lên meo/{id}/declare
+    Event     = 2,  // con -> gw: name = tên event, payload = JSON event
+    Response  = 3,  // con -> gw: payload = JSON feature_response
+    Status    = 4,  // con -> gw: payload "online" / "offline"; cũng dùng làm heartbeat
+    Invoke    = 5,  // gw -> con: name = tên feature, payload = JSON invoke
+    Redeclare = 6   // gw -> con (deviceId rỗng = mọi con): gửi lại Declare + Status
+};
+
+// Một message; mọi chuỗi là view (không có '\0'), chỉ hợp lệ trong lúc gọi
+struct MeoChildMessage {
+    MeoChildMsgType type = MeoChildMsgType::Event;
+    const char*    deviceId = nullptr;
+    uint8_t        idLen    = 0;
+    const char*    name     = nullptr;
+    uint8_t        nameLen  = 0;
+    const uint8_t* payload  = nullptr;
+    size_t         len      = 0;
+};
+
+/**
+ * MeoChildTransport: đường nối tới các thiết bị con của gateway (UART, RS-485, ...).
+ * - begin(): transport tự chạy phần nhận (task riêng / ISR + task) và gọi rx cho
+ *   từng message hoàn chỉnh. rx có thể publish MQTT: không gọi nó từ ISR.
+ * - send(): gọi từ task esp-mqtt (invoke) và từ loop() (redeclare) -> phải thread-safe,
+ *   không được block lâu; false nếu không gửi được (quá lớn, hàng đợi đầy, link chết).
+ */
+class MeoChildTransport {
+public:
+    typedef void (*ReceiveFn)(const MeoChildMessage& msg, void* ctx);
+
+    virtual ~MeoChildTransport() {}
+
+    virtual bool begin(ReceiveFn rx, void* ctx) = 0;
+    virtual void end() = 0;
+    virtual bool send(const MeoChildMessage& msg) = 0;
+};
@@ -0,0 +1,470 @@
+#include "Meo3_Gateway.h"
+#include "Meo3_Topic.h"
+#include "Meo3_JsonWriter.h"
+#include "esp_timer.h"
+#include <cstring>
+#include <new>
+#include <utility>
+
+namespace {
+struct GatewayLock {
+    SemaphoreHandle_t h;
+    explicit GatewayLock(SemaphoreHandle_t m) : h(m) { xSemaphoreTake(h, portMAX_DELAY); }
+    ~GatewayLock() { xSemaphoreGive(h); }
+};
+}
+
+MeoGateway::MeoGateway() {}
+
+MeoGateway::~MeoGateway() {
+    end();
+}
+
+bool MeoGateway::begin(MeoChildTransport& transport, PublishFn publish, void* ctx,
+                       const MeoGatewayConfig& cfg) {
+    if (_transport) return true;
+    if (!publish) return false;
+
+    _cfg = cfg;
+    // Một record nhỏ nhất + "[]" phải vừa
+    if (_cfg.batchBytes < 128) _cfg.batchBytes = 128;
+    _lock    = xSemaphoreCreateMutex();
+    _pubLock = xSemaphoreCreateMutex();
+    _arena   = new (std::nothrow) uint8_t[_cfg.batchBytes];
+    _spare   = new (std::nothrow) uint8_t[_cfg.batchBytes];
+    _tx      = new (std::nothrow) char[_cfg.batchBytes];
+    if (!_lock || !_pubLock || !_arena || !_spare || !_tx) {
+        MEO_LOGE(_log, GATEWAY, "Out of memory");
+        end();
+        return false;
+    }
+    _arenaLen = 0;
+    _spareLen = 0;
+    _publish  = publish;
+    _ctx      = ctx;
+    _transport = &transport;
+
+    if (!transport.begin(&_rxThunk, this)) {
+        MEO_LOGE(_log, GATEWAY, "Child transport failed to start");
+        end();
+        return false;
+    }
+    MEO_LOGI(_log, GATEWAY, "Gateway started (window=%lums batch=%u children<=%u)",
+             (unsigned long)_cfg.batchWindowMs, (unsigned)_cfg.batchBytes,
+             (unsigned)MEO_GATEWAY_MAX_CHILDREN);
+    return true;
+}
+
+void MeoGateway::end() {
+    if (_transport) {
+        _transport->end();   // không còn callback rx sau khi trả về
+        flush();
+        _transport = nullptr;
+    }
+    delete[] _arena;
+    _arena = nullptr;
+    delete[] _spare;
+    _spare = nullptr;
+    delete[] _tx;
+    _tx = nullptr;
+    if (_lock) { vSemaphoreDelete(_lock); _lock = nullptr; }
+    if (_pubLock) { vSemaphoreDelete(_pubLock); _pubLock = nullptr; }
+}
+
+uint32_t MeoGateway::_nowMs() {
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+// Id / tên đi vào topic: không rỗng, không có ký tự điều khiển của topic MQTT
+bool MeoGateway::_validLevel(const char* s, size_t n) {
+    if (!s || n == 0) return false;
+    for (size_t i = 0; i < n; ++i) {
+        char c = s[i];
+        if (c == '/' || c == '+' || c == '#' || c == '\0') return false;
+    }
+    return true;
+}
+
+// Static -> instance adapter
+void MeoGateway::_rxThunk(const MeoChildMessage& msg, void* ctx) {
+    MeoGateway* self = reinterpret_cast<MeoGateway*>(ctx);
+    if (!self) return;
+    self->_onChildMessage(msg);
+}
+
+// Task của transport
+void MeoGateway::_onChildMessage(const MeoChildMessage& msg) {
+    if (!_validLevel(msg.deviceId, msg.idLen) || msg.idLen >= MEO_GATEWAY_ID_MAX ||
+        (_selfId && strlen(_selfId) == msg.idLen && memcmp(_selfId, msg.deviceId, msg.idLen) == 0)) {
+        _rejected.fetch_add(1, std::memory_order_relaxed);
+        MEO_LOGW(_log, GATEWAY, "Rejected message from child id %.*s", (int)msg.idLen,
+                 msg.deviceId ? msg.deviceId : "");
+        return;
+    }
+
+    // Cập nhật trạng thái dưới khóa; publish sau khi nhả (xem lock order trong header)
+    char id[MEO_GATEWAY_ID_MAX];
+    bool nameOk  = msg.type != MeoChildMsgType::Event || _validLevel(msg.name, msg.nameLen);
+    bool queued  = false;
+    bool swapped = false;
+    {
+        GatewayLock g(_lock);
+        int child = _childLocked(msg.deviceId, msg.idLen, true);
+        if (child < 0) {
+            _rejected.fetch_add(1, std::memory_order_relaxed);
+            MEO_LOGW(_log, GATEWAY, "Child table full, %.*s ignored", (int)msg.idLen, msg.deviceId);
+            return;
+        }
+        Child& c = _children[child];
+        c.lastSeenMs = _nowMs();
+        memcpy(id, c.id, msg.idLen + 1);
+
+        if (msg.type == MeoChildMsgType::Status) {
+            bool online = !(msg.len == 7 && memcmp(msg.payload, "offline", 7) == 0);
+            if (online != c.online) _setOnlineLocked((uint8_t)child, online);
+        } else if (msg.type == MeoChildMsgType::Declare || msg.type == MeoChildMsgType::Response ||
+                   msg.type == MeoChildMsgType::Event) {
+            if (!c.online) _setOnlineLocked((uint8_t)child, true);
+        }
+        if (msg.type == MeoChildMsgType::Event) {
+            _eventsIn.fetch_add(1, std::memory_order_relaxed);
+            if (nameOk && _cfg.batchWindowMs) {
+                queued = _queueEventLocked((uint8_t)child, msg.name, msg.nameLen, msg.payload, msg.len, swapped);
+            }
+        }
+    }
+
+    // Status trước message của con (con vừa online), batch đầy trước event mới
+    _publishStatuses();
+    if (swapped) {
+        GatewayLock p(_pubLock);
+        _publishSpare();
+    }
+
+    bool ok = true;
+    switch (msg.type) {
+        case MeoChildMsgType::Status:
+            return;
+        case MeoChildMsgType::Declare:
+            ok = _publishTo(MeoGatewayPub::Declare, id, "/declare", nullptr, 0, msg.payload, msg.len);
+            break;
+        case MeoChildMsgType::Response:
+            ok = _publishTo(MeoGatewayPub::Response, id, "/event/feature_response", nullptr, 0,
+                            msg.payload, msg.len);
+            break;
+        case MeoChildMsgType::Event:
+            if (!nameOk) { ok = false; break; }
+            if (queued) return;
+            ok = _publishTo(MeoGatewayPub::Event, id, "/event/", msg.name, msg.nameLen, msg.payload, msg.len);
+            break;
+        default:
+            ok = false;   // Invoke / Redeclare chỉ đi xuống con
+            break;
+    }
+    if (!ok) _rejected.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Slot của một con; create = thêm nếu chưa có. -1 nếu không có / bảng đầy
+int MeoGateway::_childLocked(const char* id, size_t idLen, bool create) {
+    int i = _index.find(id, idLen);
+    if (i >= 0 || !create) return i >= 0 ? _index[i].handler : -1;
+
+    size_t n = _index.size();
+    if (n >= MEO_GATEWAY_MAX_CHILDREN) return -1;
+    Child& c = _children[n];
+    memcpy(c.id, id, idLen);
+    c.id[idLen] = '\0';
+    c.online = false;
+    c.statusDirty = false;
+    c.lastSeenMs = _nowMs();
+    if (!_index.add(c.id, (uint8_t)n)) return -1;
+    MEO_LOGI(_log, GATEWAY, "Child %s attached (%u/%u)", c.id, (unsigned)(n + 1),
+             (unsigned)MEO_GATEWAY_MAX_CHILDREN);
+    return (int)n;
+}
+
+// Chỉ đánh dấu; _publishStatuses() gửi sau khi nhả _lock
+void MeoGateway::_setOnlineLocked(uint8_t child, bool online) {
+    Child& c = _children[child];
+    c.online = online;
+    c.statusDirty = true;
+    _statusPending.store(true, std::memory_order_relaxed);
+    MEO_LOGI(_log, GATEWAY, "Child %s %s", c.id, online ? "online" : "offline");
+}
+
+// Task transport / loop, không giữ _lock. Dưới _pubLock nên status của một con được
+// publish đúng thứ tự; trả về sau khi mọi status đã đánh dấu trước đó đã được gửi.
+void MeoGateway::_publishStatuses() {
+    if (!_statusPending.load(std::memory_order_relaxed)) return;
+    GatewayLock p(_pubLock);
+    size_t i = 0;
+    for (;;) {
+        char id[MEO_GATEWAY_ID_MAX];
+        bool online = false;
+        {
+            GatewayLock g(_lock);
+            while (i < _index.size() && !_children[i].statusDirty) i++;
+            if (i >= _index.size()) {
+                _statusPending.store(false, std::memory_order_relaxed);
+                return;
+            }
+            Child& c = _children[i];
+            c.statusDirty = false;
+            online = c.online;
+            memcpy(id, c.id, sizeof(id));
+        }
+        const char* s = online ? "online" : "offline";
+        _publishTo(MeoGatewayPub::Status, id, "/status", nullptr, 0, (const uint8_t*)s, strlen(s));
+    }
+}
+
+bool MeoGateway::_publishTo(MeoGatewayPub kind, const char* id, const char* suffix, const char* name,
+                            size_t nameLen, const uint8_t* payload, size_t len) {
+    MeoTopicBuf<> t;
+    t.append("meo/").append(id).append(suffix).append(name, nameLen);
+    if (!t.ok()) return false;
+    return _publish(kind, t.c_str(), payload, len, _ctx);
+}
+
+// Task esp-mqtt
+void MeoGateway::routeInvoke(const char* id, size_t idLen, const char* name, size_t nameLen,
+                             const uint8_t* payload, size_t len) {
+    if (!_transport) return;
+
+    char childId[MEO_GATEWAY_ID_MAX];
+    bool online = false;
+    int child = -1;
+    if (idLen < MEO_GATEWAY_ID_MAX) {
+        GatewayLock g(_lock);
+        child = _childLocked(id, idLen, false);
+        if (child >= 0) {
+            online = _children[child].online;
+            memcpy(childId, _children[child].id, idLen + 1);
+        }
+    }
+    // Con chưa từng thấy: có thể thuộc gateway khác cùng ACL, không trả lời thay
+    if (child < 0) {
+        MEO_LOGD(_log, GATEWAY, "Invoke for unknown device %.*s ignored", (int)idLen, id);
+        return;
+    }
+    if (!online) {
+        _invokesFailed.fetch_add(1, std::memory_order_relaxed);
+        _respondOffline(childId, idLen, name, nameLen, "Device offline");
+        return;
+    }
+
+    MeoChildMessage m;
+    m.type     = MeoChildMsgType::Invoke;
+    m.deviceId = childId;
+    m.idLen    = (uint8_t)idLen;
+    m.name     = name;
+    m.nameLen  = nameLen > 255 ? 255 : (uint8_t)nameLen;
+    m.payload  = payload;
+    m.len      = len;
+    if (nameLen > 255 || !_transport->send(m)) {
+        _invokesFailed.fetch_add(1, std::memory_order_relaxed);
+        MEO_LOGW(_log, GATEWAY, "Invoke %.*s for %s not delivered", (int)nameLen, name, childId);
+        _respondOffline(childId, idLen, name, nameLen, "Busy: child link");
+        return;
+    }
+    _invokesRouted.fetch_add(1, std::memory_order_relaxed);
+    MEO_LOGD(_log, GATEWAY, "Invoke %.*s -> %s len=%u", (int)nameLen, name, childId, (unsigned)len);
+}
+
+// Negative feature_response on behalf of a child that cannot take the invoke
+void MeoGateway::_respondOffline(const char* id, size_t idLen, const char* name, size_t nameLen,
+                                 const char* message) {
+    char buf[160];
+    MeoJsonWriter w(buf, sizeof(buf));
+    w.beginObject()
+     .field("feature_name", std::string_view(name, nameLen))
+     .field("device_id", std::string_view(id, idLen))
+     .field("success", false)
+     .field("message", message)
+     .endObject();
+    if (!w.ok()) return;
+    _publishTo(MeoGatewayPub::Response, id, "/event/feature_response", nullptr, 0,
+               (const uint8_t*)buf, w.length());
+}
+
+// swapped: arena đầy đã được đổi sang _spare, người gọi publish nó sau khi nhả _lock
+bool MeoGateway::_queueEventLocked(uint8_t child, const char* name, size_t nameLen,
+                                   const uint8_t* payload, size_t len, bool& swapped) {
+    const size_t rec = sizeof(Record) + nameLen + len;
+    if (len > UINT16_MAX || rec > _cfg.batchBytes) return false;   // publish riêng
+    if (_arenaLen + rec > _cfg.batchBytes) {
+        // Flush theo kích thước; batch trước vẫn đang được publish -> event này đi riêng
+        if (!_swapLocked()) return false;
+        swapped = true;
+    }
+
+    uint32_t now = _nowMs();
+    if (_arenaLen == 0) _batchStartMs = now;
+    Record r;
+    r.child    = child;
+    r.nameLen  = (uint8_t)nameLen;
+    r.done     = 0;
+    r.reserved = 0;
+    r.len      = (uint16_t)len;
+    r.ts       = now;
+    uint8_t* p = _arena + _arenaLen;
+    memcpy(p, &r, sizeof(r));
+    memcpy(p + sizeof(r), name, nameLen);
+    if (len) memcpy(p + sizeof(r) + nameLen, payload, len);
+    _arenaLen += rec;
+    return true;
+}
+
+// Arena đang gom -> _spare; false nếu _spare còn batch chưa publish xong
+bool MeoGateway::_swapLocked() {
+    if (_arenaLen == 0) return true;
+    if (_spareLen) return false;
+    std::swap(_arena, _spare);
+    _spareLen = _arenaLen;
+    _arenaLen = 0;
+    return true;
+}
+
+bool MeoGateway::flush() {
+    if (!_lock) return false;
+    GatewayLock p(_pubLock);
+    bool ok = _publishSpare();
+    {
+        GatewayLock g(_lock);
+        _swapLocked();   // chỉ trượt khi task khác vừa đổi: batch đó nằm ở _spare
+    }
+    return _publishSpare() && ok;
+}
+
+// Giữ _pubLock, không giữ _lock: publish batch ở _spare (nếu có) rồi trả buffer
+bool MeoGateway::_publishSpare() {
+    uint8_t* arena;
+    size_t   len;
+    {
+        GatewayLock g(_lock);
+        arena = _spare;
+        len   = _spareLen;
+    }
+    if (!len) return true;
+
+    bool ok = true;
+    // Con theo thứ tự event đầu tiên của nó; trong mỗi con giữ thứ tự đến
+    for (size_t off = 0; off < len; ) {
+        Record r;
+        memcpy(&r, arena + off, sizeof(r));
+        if (!r.done) ok = _flushChild(r.child, arena, len, off) && ok;
+        off += sizeof(r) + r.nameLen + r.len;
+    }
+
+    GatewayLock g(_lock);
+    _spareLen = 0;
+    return ok;
+}
+
+// Giữ _pubLock. Id của con đọc ngoài _lock: slot chỉ được thêm, id không đổi sau đó
+bool MeoGateway::_flushChild(uint8_t child, uint8_t* arena, size_t arenaLen, size_t from) {
+    const char* id = _children[child].id;
+    bool ok = true;
+    size_t count = 0;
+    const uint8_t* first = nullptr;
+    MeoJsonWriter w(_tx, _cfg.batchBytes);
+
+    auto publishChunk = [&]() {
+        if (count == 1) {
+            // Một event: topic riêng của nó, không bọc batch
+            Record r;
+            memcpy(&r, first, sizeof(r));
+            const char* name = (const char*)first + sizeof(r);
+            ok = _publishTo(MeoGatewayPub::Event, id, "/event/", name, r.nameLen,
+                            (const uint8_t*)name + r.nameLen, r.len) && ok;
+        } else if (count > 1) {
+            w.endArray();
+            ok = w.ok() && _publishTo(MeoGatewayPub::Event, id, "/event/batch", nullptr, 0,
+                                      (const uint8_t*)_tx, w.length()) && ok;
+            _batches.fetch_add(1, std::memory_order_relaxed);
+        }
+        count = 0;
+        w = MeoJsonWriter(_tx, _cfg.batchBytes);
+    };
+
+    for (size_t off = from; off < arenaLen; ) {
+        uint8_t* p = arena + off;
+        Record r;
+        memcpy(&r, p, sizeof(r));
+        off += sizeof(r) + r.nameLen + r.len;
+        if (r.child != child || r.done) continue;
+        p[offsetof(Record, done)] = 1;
+
+        const char* name = (const char*)p + sizeof(r);
+        // Ghi thử item (tên được escape); không vừa kể cả ']' đóng mảng thì publish phần
+        // trước rồi ghi lại. Một item không vừa một mình đi riêng qua topic của nó.
+        for (;;) {
+            MeoJsonWriter mark = w;
+            if (count == 0) w.beginArray();
+            w.beginObject()
+             .field("event", std::string_view(name, r.nameLen))
+             .field("ts", r.ts)
+             .key("payload").raw(name + r.nameLen, r.len)
+             .endObject();
+            if (count == 0 || (!w.overflow() && w.required() + 1 <= _cfg.batchBytes)) break;
+            w = mark;
+            publishChunk();
+        }
+        if (count == 0) first = p;
+        count++;
+    }
+    publishChunk();
+    if (!ok) _rejected.fetch_add(1, std::memory_order_relaxed);
+    return ok;
+}
+
+void MeoGateway::loop() {
+    if (!_transport) return;
+    uint32_t now = _nowMs();
+
+    bool due;
+    {
+        GatewayLock g(_lock);
+        due = _arenaLen && now - _batchStartMs >= _cfg.batchWindowMs;
+        for (size_t i = 0; _cfg.childTimeoutMs && i < _index.size(); ++i) {
+            Child& c = _children[i];
+            if (c.online && now - c.lastSeenMs >= _cfg.childTimeoutMs) {
+                MEO_LOGW(_log, GATEWAY, "Child %s silent for %lums", c.id, (unsigned long)(now - c.lastSeenMs));
+                _setOnlineLocked((uint8_t)i, false);
+            }
+        }
+    }
+    if (due) flush();
+    _publishStatuses();
+}
+
+void MeoGateway::onConnected() {
+    if (!_transport) return;
+    {
+        GatewayLock g(_lock);
+        for (size_t i = 0; i < _index.size(); ++i) {
+            if (_children[i].online) _setOnlineLocked((uint8_t)i, true);
+        }
+    }
+    _publishStatuses();
+    // Declare không được giữ ở gateway: mỗi con tự gửi lại (tiết kiệm RAM cho N con)
+    MeoChildMessage m;
+    m.type = MeoChildMsgType::Redeclare;
+    m.deviceId = "";
+    if (!_transport->send(m)) MEO_LOGW(_log, GATEWAY, "Redeclare request not sent");
+}
+
+MeoGatewayStats MeoGateway::stats() const {
+    MeoGatewayStats st;
+    if (_lock) {
+        GatewayLock g(_lock);
+        st.children = (uint32_t)_index.size();
+        for (size_t i = 0; i < _index.size(); ++i) st.online += _children[i].online ? 1 : 0;
+    }
+    st.invokesRouted = _invokesRouted.load(std::memory_order_relaxed);
+    st.invokesFailed = _invokesFailed.load(std::memory_order_relaxed);
+    st.eventsIn      = _eventsIn.load(std::memory_order_relaxed);
+    st.batches       = _batches.load(std::memory_order_relaxed);
+    st.rejected      = _rejected.load(std::memory_order_relaxed);
+    return st;
+}
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#include "Meo3_ChildTransport.h"
+#include "Meo3_Dispatch.h"   // MeoDispatchTable: child id -> slot
+#include "Meo3_Log.h"
+
+// Số thiết bị con tối đa và độ dài device id của chúng
+#ifndef MEO_GATEWAY_MAX_CHILDREN
+#define MEO_GATEWAY_MAX_CHILDREN 32
+#endif
+#ifndef MEO_GATEWAY_ID_MAX
+#define MEO_GATEWAY_ID_MAX 40
+#endif
+// Buffer gom event của mọi con giữa hai lần flush. Cấp 3 buffer cỡ này: đang gom,
+// chờ publish (đổi khi flush) và buffer dựng message batch
+#ifndef MEO_GATEWAY_BATCH_BYTES
+#define MEO_GATEWAY_BATCH_BYTES 2048
+#endif
+
+struct MeoGatewayConfig {
+    uint32_t batchWindowMs  = 500;     // 0 = publish từng event ngay khi nhận
+    size_t   batchBytes     = MEO_GATEWAY_BATCH_BYTES;
+    uint32_t childTimeoutMs = 60000;   // không nghe gì trong khoảng này -> offline
+};
+
+struct MeoGatewayStats {
+    uint32_t children       = 0;  // đã từng thấy (slot đã dùng)
+    uint32_t online         = 0;
+    uint32_t invokesRouted  = 0;  // invoke chuyển xuống con thành công
+    uint32_t invokesFailed  = 0;  // con không rõ / offline / transport từ chối
+    uint32_t eventsIn       = 0;  // event nhận từ con
+    uint32_t batches        = 0;  // message batch đã publish
+    uint32_t rejected       = 0;  // message không hợp lệ / bảng con đầy / publish lỗi
+};
+
+// Cách MeoDevice publish thay cho con (QoS / retain / offline buffer do MeoDevice chọn)
+enum class MeoGatewayPub : uint8_t {
+    Event = 0,  // meo/{id}/event/{name} và meo/{id}/event/batch
+    Response,   // meo/{id}/event/feature_response
+    Declare,    // meo/{id}/declare
+    Status      // meo/{id}/status (retained)
+};
+
+/**
+ * MeoGateway: một phiên MQTT mang N thiết bị con (id riêng, gắn qua MeoChildTransport).
+ * - Invoke trên meo/+/feature/+/invoke được chuyển xuống con theo device id (bảng hash);
+ *   con không rõ / offline -> gateway trả feature_response âm thay cho nó.
+ * - Event của mọi con vào chung một buffer; mỗi batchWindowMs, event được gom theo con:
+ *   một event -> meo/{id}/event/{name}, nhiều event -> meo/{id}/event/batch với cùng
+ *   format batch của MeoDevice ([{"event":..,"ts":..,"payload":{..}}, ...]).
+ * - Payload của con là JSON và được chuyển nguyên văn (không parse lại).
+ * - Status online/offline của con do gateway publish (retained); LWT chỉ phủ gateway.
+ * - Slot con không bị thu hồi: id mới khi bảng đầy bị từ chối.
+ * - Không publish khi giữ _lock: task esp-mqtt giữ khóa API của nó khi gọi routeInvoke
+ *   (cần _lock), nên publish dưới _lock từ task khác sẽ deadlock. Trạng thái được chốt
+ *   dưới _lock (status đánh dấu dirty, batch đổi sang buffer thứ hai) rồi publish sau.
+ */
+class MeoGateway {
+public:
+    typedef bool (*PublishFn)(MeoGatewayPub kind, const char* topic,
+                              const uint8_t* payload, size_t len, void* ctx);
+
+    MeoGateway();
+    ~MeoGateway();
+
+    void setLog(const MeoLog& log) { _log = log; }
+    // Id của chính gateway: con không được dùng trùng
+    void setSelfId(const char* id) { _selfId = id; }
+
+    bool begin(MeoChildTransport& transport, PublishFn publish, void* ctx,
+               const MeoGatewayConfig& cfg = MeoGatewayConfig());
+    void end();
+    bool isRunning() const { return _transport != nullptr; }
+
+    // Task esp-mqtt: invoke của một con (id/name là view vào topic)
+    void routeInvoke(const char* id, size_t idLen, const char* name, size_t nameLen,
+                     const uint8_t* payload, size_t len);
+
+    // Loop task: flush theo batch window, đánh dấu con im lặng là offline
+    void loop();
+    // Phiên MQTT mới: publish lại status, yêu cầu mọi con declare lại
+    void onConnected();
+    bool flush();
+
+    MeoGatewayStats stats() const;
+
+private:
+    struct Child {
+        char     id[MEO_GATEWAY_ID_MAX];
+        bool     online;
+        bool     statusDirty;   // online đổi, status chưa publish
+        uint32_t lastSeenMs;
+    };
+    // Bản ghi trong _arena: header + name + payload
+    struct Record {
+        uint8_t  child;
+        uint8_t  nameLen;
+        uint8_t  done;      // đã nằm trong message của lần flush này
+        uint8_t  reserved;
+        uint16_t len;
+        uint32_t ts;
+    };
+
+    MeoChildTransport* _transport = nullptr;
+    PublishFn          _publish   = nullptr;
+    void*              _ctx       = nullptr;
+    MeoGatewayConfig   _cfg;
+    const char*        _selfId    = nullptr;
+
+    SemaphoreHandle_t  _lock = nullptr;   // bảng con + arena (task transport, esp-mqtt, loop)
+    // Giữ khi publish status / batch (task transport, loop; không bao giờ từ task esp-mqtt):
+    // giữ thứ tự status, và _spare / _tx chỉ có một người dùng. Thứ tự khóa: _pubLock -> _lock
+    SemaphoreHandle_t  _pubLock = nullptr;
+    Child              _children[MEO_GATEWAY_MAX_CHILDREN];
+    MeoDispatchTable<uint8_t, MEO_GATEWAY_MAX_CHILDREN> _index;
+
+    uint8_t*  _arena      = nullptr;      // đang gom (dưới _lock)
+    size_t    _arenaLen   = 0;
+    uint8_t*  _spare      = nullptr;      // đã đổi ra, chờ publish (_spareLen != 0)
+    size_t    _spareLen   = 0;
+    uint32_t  _batchStartMs = 0;
+    char*     _tx         = nullptr;      // message batch của một con (dưới _pubLock)
+
+    std::atomic<bool>     _statusPending{false};   // có con statusDirty (xóa dưới _lock)
+    std::atomic<uint32_t> _invokesRouted{0};
+    std::atomic<uint32_t> _invokesFailed{0};
+    std::atomic<uint32_t> _eventsIn{0};
+    std::atomic<uint32_t> _batches{0};
+    std::atomic<uint32_t> _rejected{0};
+
+    MeoLog _log;
+
+    // Static -> instance adapter (task của transport)
+    static void _rxThunk(const MeoChildMessage& msg, void* ctx);
+    void _onChildMessage(const MeoChildMessage& msg);
+
+    int  _childLocked(const char* id, size_t idLen, bool create);
+    void _setOnlineLocked(uint8_t child, bool online);
+    bool _queueEventLocked(uint8_t child, const char* name, size_t nameLen,
+                           const uint8_t* payload, size_t len, bool& spareFull);
+    bool _swapLocked();
+    void _publishStatuses();
+    bool _publishSpare();
+    bool _flushChild(uint8_t child, uint8_t* arena, size_t arenaLen, size_t from);
+    bool _publishTo(MeoGatewayPub kind, const char* id, const char* suffix, const char* name,
+                    size_t nameLen, const uint8_t* payload, size_t len);
+    void _respondOffline(const char* id, size_t idLen, const char* name, size_t nameLen,
+                         const char* message);
+
+    static bool     _validLevel(const char* s, size_t n);
+    static uint32_t _nowMs();
+};
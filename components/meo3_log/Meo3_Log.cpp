@@ -0,0 +1,69 @@
+#include "Meo3_Log.h"
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+
+static const char* const kTagNames[(uint8_t)MeoLogTag::Count] = { "DEVICE", "MQTT", "PROV", "GATEWAY", "UART" };
+static const char* const kLevelNames[] = { "DEBUG", "INFO", "WARN", "ERROR" };
+
+const char* meoLogTagName(MeoLogTag tag) {
+    return (uint8_t)tag < (uint8_t)MeoLogTag::Count ? kTagNames[(uint8_t)tag] : "?";
+}
+
+const char* meoLogLevelName(int level) {
+    return (level >= MEO_LOG_LEVEL_DEBUG && level <= MEO_LOG_LEVEL_ERROR) ? kLevelNames[level] : "INFO";
+}
+
+void MeoLog::setDebugTags(const char* tagsCsv) {
+    _mask = 0;
+    if (!tagsCsv) return;
+
+    const char* p = tagsCsv;
+    while (*p) {
+        while (*p == ',' || *p == ' ') ++p;
+        const char* tok = p;
+        while (*p && *p != ',') ++p;
+        size_t n = (size_t)(p - tok);
+        while (n && tok[n - 1] == ' ') --n;
+        if (!n) continue;
+
+        if (n == 1 && tok[0] == '*') {
+            _mask = (1u << (uint8_t)MeoLogTag::Count) - 1;
+            continue;
+        }
+        for (uint8_t i = 0; i < (uint8_t)MeoLogTag::Count; ++i) {
+            if (strlen(kTagNames[i]) == n && memcmp(kTagNames[i], tok, n) == 0) {
+                _mask |= 1u << i;
+                break;
+            }
+        }
+    }
+}
+
+void MeoLog::printf(int level, MeoLogTag tag, const char* fmt, ...) const {
+    va_list ap;
+    va_start(ap, fmt);
+    _vprint(level, tag, fmt, ap);
+    va_end(ap);
+}
+
+void MeoLog::_emit(int level, MeoLogTag tag, const char* fmt, ...) const {
+    va_list ap;
+    va_start(ap, fmt);
+    _vprint(level, tag, fmt, ap);
+    va_end(ap);
+}
+
+void MeoLog::_vprint(int level, MeoLogTag tag, const char* fmt, va_list ap) const {
+    if (!_sink) return;
+
+    // "[TAG] " + message formatted once into the same buffer
+    char buf[MEO_LOG_LINE_MAX];
+    int n = snprintf(buf, sizeof(buf), "[%s] ", meoLogTagName(tag));
+    if (n < 0) return;
+    if ((size_t)n >= sizeof(buf)) n = sizeof(buf) - 1;
+
+    vsnprintf(buf + n, sizeof(buf) - n, fmt, ap);
+
+    _sink(meoLogLevelName(level), buf);
+}
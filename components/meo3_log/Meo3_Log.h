@@ -0,0 +1,114 @@
+#ifndef MEO3_LOG_H
+#define MEO3_LOG_H
+
+#include <cstdarg>
+#include <cstdint>
+#include "Meo3_Type.h"   // MeoLogFunction
+#include "Meo3_LogRing.h"
+
+#define MEO_LOG_LEVEL_DEBUG 0
+#define MEO_LOG_LEVEL_INFO  1
+#define MEO_LOG_LEVEL_WARN  2
+#define MEO_LOG_LEVEL_ERROR 3
+#define MEO_LOG_LEVEL_NONE  4
+
+// Mức thấp nhất được biên dịch vào firmware; call site dưới mức này thành code chết
+// và bị compiler loại bỏ cùng chuỗi format (vd -DMEO_LOG_MIN_LEVEL=MEO_LOG_LEVEL_INFO)
+#ifndef MEO_LOG_MIN_LEVEL
+#define MEO_LOG_MIN_LEVEL MEO_LOG_LEVEL_DEBUG
+#endif
+
+// Một dòng log, gồm cả tiền tố "[TAG] "
+#ifndef MEO_LOG_LINE_MAX
+#define MEO_LOG_LINE_MAX 192
+#endif
+
+// Tag cho DEBUG; tên enum trùng token trong setDebugTags("DEVICE,MQTT,PROV,GATEWAY,UART")
+enum class MeoLogTag : uint8_t {
+    DEVICE = 0,
+    MQTT,
+    PROV,
+    GATEWAY,
+    UART,
+    Count
+};
+
+const char* meoLogTagName(MeoLogTag tag);
+const char* meoLogLevelName(int level);
+
+/**
+ * MeoLog: sink + bitmask tag DEBUG, dùng chung cho Device / MQTT / BLE provisioning.
+ * - setDebugTags() parse CSV một lần thành bitmask ("*" = tất cả tag); kiểm tra tag
+ *   trên hot path chỉ còn một phép AND.
+ * - printf() định dạng một lần thẳng vào một buffer trên stack rồi gọi sink.
+ * - Gọi qua MEO_LOGD/I/W/E để mức dưới MEO_LOG_MIN_LEVEL biến mất lúc biên dịch.
+ * - setRing(): chế độ trì hoãn, call site chỉ đẩy record vào MeoLogRing, task của ring
+ *   định dạng và gọi sink. Bản copy của MeoLog (Device -> MQTT / PROV) dùng chung ring.
+ */
+class MeoLog {
+public:
+    void setSink(MeoLogFunction sink) { _sink = sink; }
+    const MeoLogFunction& sink() const { return _sink; }
+
+    // CSV tag list; unknown tokens are ignored
+    void     setDebugTags(const char* tagsCsv);
+    void     setDebugMask(uint32_t mask) { _mask = mask; }
+    uint32_t debugMask() const { return _mask; }
+
+    bool enabled() const { return (bool)_sink; }
+    bool debug(MeoLogTag tag) const {
+        return MEO_LOG_MIN_LEVEL <= MEO_LOG_LEVEL_DEBUG && (_mask & (1u << (uint8_t)tag)) && _sink;
+    }
+
+    // Deferred mode while the ring is running (nullptr = synchronous)
+    void        setRing(MeoLogRing* ring) { _ring = ring; }
+    MeoLogRing* ring() const { return _ring; }
+
+    // Synchronous: format now and call the sink
+    void printf(int level, MeoLogTag tag, const char* fmt, ...) const
+        __attribute__((format(printf, 4, 5)));
+
+    // What MEO_LOGx expands to: ring if running, else printf(); fmt must be a literal
+    template <typename... A>
+    void write(int level, MeoLogTag tag, const char* fmt, A... a) const {
+        // Ring dừng giữa chừng (disableDeferredLog trên task khác): ghi đồng bộ thay vì mất dòng
+        if (_ring && _ring->isRunning()
+            && (_ring->push(level, (uint8_t)tag, fmt, a...) || _ring->isRunning())) {
+            return;
+        }
+        _emit(level, tag, fmt, a...);
+    }
+
+private:
+    MeoLogFunction _sink = nullptr;
+    uint32_t       _mask = 0;
+    MeoLogRing*    _ring = nullptr;
+
+    void _emit(int level, MeoLogTag tag, const char* fmt, ...) const;
+    void _vprint(int level, MeoLogTag tag, const char* fmt, va_list ap) const;
+};
+
+// Never defined: only lets the compiler check MEO_LOGx formats against their arguments
+int meoLogCheckFormat(const char* fmt, ...) __attribute__((format(printf, 1, 2)));
+
+// Level known at the call site (may be a runtime expression, e.g. ok ? INFO : ERROR)
+#define MEO_LOG_AT(log, level, tag, ...)                                               \
+    do {                                                                               \
+        if ((level) >= MEO_LOG_MIN_LEVEL && (log).enabled()) {                         \
+            (void)sizeof(meoLogCheckFormat(__VA_ARGS__));                              \
+            (log).write((level), MeoLogTag::tag, __VA_ARGS__);                         \
+        }                                                                              \
+    } while (0)
+
+#define MEO_LOGD(log, tag, ...)                                                        \
+    do {                                                                               \
+        if ((log).debug(MeoLogTag::tag)) {                                             \
+            (void)sizeof(meoLogCheckFormat(__VA_ARGS__));                              \
+            (log).write(MEO_LOG_LEVEL_DEBUG, MeoLogTag::tag, __VA_ARGS__);             \
+        }                                                                              \
+    } while (0)
+#define MEO_LOGI(log, tag, ...) MEO_LOG_AT(log, MEO_LOG_LEVEL_INFO, tag, __VA_ARGS__)
+#define MEO_LOGW(log, tag, ...) MEO_LOG_AT(log, MEO_LOG_LEVEL_WARN, tag, __VA_ARGS__)
+#define MEO_LOGE(log, tag, ...) MEO_LOG_AT(log, MEO_LOG_LEVEL_ERROR, tag, __VA_ARGS__)
+
+#endif // MEO3_LOG_H
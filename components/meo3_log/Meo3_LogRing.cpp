@@ -0,0 +1,317 @@
+#include "Meo3_LogRing.h"
+#include "Meo3_Log.h"   // meoLogTagName, meoLogLevelName
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include "esp_timer.h"
+
+void MeoLogRecord::_str(const char* s, int limit) {
+    if (!s) s = "(null)";
+    // Có precision thì không đọc quá giới hạn: "%.*s" thường trỏ vào topic / payload không có NUL
+    size_t n = limit < 0 ? strlen(s) : strnlen(s, (size_t)limit);
+    if ((size_t)used + 1 >= sizeof(args)) { truncated = true; argc = MEO_LOG_RECORD_MAX_ARGC; return; }
+    size_t room = sizeof(args) - used - 1;
+    if (n > room) { n = room; truncated = true; }
+    if (n > 255) n = 255;
+    args[used++] = (uint8_t)n;
+    memcpy(args + used, s, n);
+    used += n;
+    types[argc++] = Str;
+}
+
+void MeoLogRecord::scanPrecision(const char* fmt, int16_t (&prec)[MEO_LOG_RECORD_MAX_ARGC]) {
+    for (int16_t& p : prec) p = kNoPrec;
+    size_t slot = 0;
+    const char* f = fmt ? fmt : "";
+    while (*f && slot < MEO_LOG_RECORD_MAX_ARGC) {
+        if (*f++ != '%') continue;
+        if (*f == '%') { f++; continue; }
+        while (*f && strchr("-+ #0", *f)) f++;
+        if (*f == '*') { f++; slot++; }                 // width lấy từ tham số
+        else while (*f >= '0' && *f <= '9') f++;
+        int16_t p = kNoPrec;
+        if (*f == '.') {
+            f++;
+            if (*f == '*') { f++; slot++; p = kStarPrec; }
+            else {
+                int v = 0;
+                while (*f >= '0' && *f <= '9') { if (v < 1000) v = v * 10 + (*f - '0'); f++; }
+                p = (int16_t)v;
+            }
+        }
+        while (*f && strchr("hlLqjzt", *f)) f++;
+        if (!*f) break;
+        if (*f++ == 's' && slot < MEO_LOG_RECORD_MAX_ARGC) prec[slot] = p;
+        slot++;
+    }
+}
+
+MeoLogRing::~MeoLogRing() {
+    end();
+}
+
+bool MeoLogRing::begin(MeoLogFunction sink, uint16_t depth, BaseType_t core,
+                       UBaseType_t priority, uint32_t stackSize) {
+    if (_taskAlive.load(std::memory_order_acquire)) return true;
+    if (!sink || depth < 2 || (depth & (depth - 1)) != 0) return false;
+
+    _cells = new (std::nothrow) Cell[depth];
+    if (!_cells) return false;
+    for (uint16_t i = 0; i < depth; ++i) {
+        _cells[i].seq.store(i, std::memory_order_relaxed);
+    }
+    _mask = depth - 1;
+    _tail = 0;
+    _head.store(0, std::memory_order_relaxed);
+    _sink = sink;
+
+    _stop.store(false, std::memory_order_relaxed);
+    _taskAlive.store(true, std::memory_order_release);
+    if (xTaskCreatePinnedToCore(&MeoLogRing::_taskEntry, "meo_log", stackSize,
+                                this, priority, &_task, core) != pdPASS) {
+        _taskAlive.store(false, std::memory_order_release);
+        _task = nullptr;
+        _release();
+        return false;
+    }
+    _running.store(true, std::memory_order_release);
+    return true;
+}
+
+void MeoLogRing::end() {
+    if (_taskAlive.load(std::memory_order_acquire)) {
+        // Ngừng nhận record mới và chờ push() đang chạy publish xong; task ghi nốt ring rồi thoát
+        _running.store(false, std::memory_order_seq_cst);
+        while (_inFlight.load(std::memory_order_seq_cst) > 0) {
+            vTaskDelay(pdMS_TO_TICKS(1));
+        }
+        _stop.store(true, std::memory_order_release);
+        while (_taskAlive.load(std::memory_order_acquire)) {
+            vTaskDelay(pdMS_TO_TICKS(5));
+        }
+        _task = nullptr;
+    }
+    _release();
+}
+
+// Producer: giành ô kế tiếp bằng CAS trên _head (ô còn chứa record chưa đọc -> đầy)
+MeoLogRing::Cell* MeoLogRing::_claim(uint32_t& pos) {
+    pos = _head.load(std::memory_order_relaxed);
+    for (;;) {
+        Cell* c = &_cells[pos & _mask];
+        uint32_t seq = c->seq.load(std::memory_order_acquire);
+        int32_t diff = (int32_t)(seq - pos);
+        if (diff == 0) {
+            if (_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) return c;
+        } else if (diff < 0) {
+            return nullptr;
+        } else {
+            pos = _head.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void MeoLogRing::_publish(Cell* c, uint32_t pos) {
+    c->seq.store(pos + 1, std::memory_order_release);
+    _pushed.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Consumer (chỉ task định dạng): ô ở _tail đã được publish chưa
+bool MeoLogRing::_drainOne() {
+    Cell* c = &_cells[_tail & _mask];
+    if (c->seq.load(std::memory_order_acquire) != _tail + 1) return false;
+
+    char line[MEO_LOG_LINE_MAX];
+    format(c->rec, line, sizeof(line));
+    int level = c->rec.level;
+    c->seq.store(_tail + _mask + 1, std::memory_order_release);   // trả ô cho producer
+    _tail++;
+
+    _sink(meoLogLevelName(level), line);
+    _written.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+uint32_t MeoLogRing::_nowMs() {
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+MeoLogRingStats MeoLogRing::stats() const {
+    MeoLogRingStats st;
+    st.pushed  = _pushed.load(std::memory_order_relaxed);
+    st.dropped = _dropped.load(std::memory_order_relaxed);
+    st.written = _written.load(std::memory_order_relaxed);
+    return st;
+}
+
+// Static -> instance adapter
+void MeoLogRing::_taskEntry(void* arg) {
+    reinterpret_cast<MeoLogRing*>(arg)->_run();
+}
+
+void MeoLogRing::_run() {
+    uint32_t reported = 0;
+    for (;;) {
+        bool stopping = _stop.load(std::memory_order_acquire);
+        while (_drainOne()) {}
+
+        uint32_t dropped = _dropped.load(std::memory_order_relaxed);
+        if (dropped != reported) {
+            char line[48];
+            snprintf(line, sizeof(line), "[LOG] %u records dropped (ring full)",
+                     (unsigned)(dropped - reported));
+            _sink("WARN", line);
+            reported = dropped;
+        }
+
+        if (stopping) break;
+        vTaskDelay(pdMS_TO_TICKS(MEO_LOG_DRAIN_MS));
+    }
+
+    _taskAlive.store(false, std::memory_order_release);
+    vTaskDelete(NULL);
+}
+
+void MeoLogRing::_release() {
+    delete[] _cells;
+    _cells = nullptr;
+    _mask  = 0;
+    _sink  = nullptr;
+}
+
+// ---- formatter: printf lại từng conversion với tham số đã chụp
+
+namespace {
+
+struct ArgReader {
+    const MeoLogRecord& r;
+    uint8_t idx = 0;
+    size_t  off = 0;
+
+    bool more() const { return idx < r.argc; }
+    uint8_t type() const { return more() ? r.types[idx] : 0; }
+    // Tham số 8 byte (int64 / con trỏ / double); còn lại chụp từ kiểu <= 4 byte
+    bool wide() const {
+        uint8_t t = type();
+        return t == MeoLogRecord::I64 || t == MeoLogRecord::U64 || t == MeoLogRecord::Ptr || t == MeoLogRecord::F64;
+    }
+
+    int64_t asInt() {
+        int64_t v = 0;
+        switch (type()) {
+            case MeoLogRecord::I32: { int32_t x;  memcpy(&x, r.args + off, 4); v = x; off += 4; break; }
+            case MeoLogRecord::U32: { uint32_t x; memcpy(&x, r.args + off, 4); v = x; off += 4; break; }
+            case MeoLogRecord::I64:
+            case MeoLogRecord::U64: { memcpy(&v, r.args + off, 8); off += 8; break; }
+            case MeoLogRecord::F64: { double d;   memcpy(&d, r.args + off, 8); v = (int64_t)d; off += 8; break; }
+            case MeoLogRecord::Ptr: { uintptr_t p; memcpy(&p, r.args + off, sizeof(p)); v = (int64_t)p; off += sizeof(p); break; }
+            case MeoLogRecord::Str: { off += 1 + r.args[off]; break; }
+            default: return 0;
+        }
+        idx++;
+        return v;
+    }
+    double asDouble() {
+        if (type() != MeoLogRecord::F64) return (double)asInt();
+        double d;
+        memcpy(&d, r.args + off, 8);
+        off += 8;
+        idx++;
+        return d;
+    }
+    // Chuỗi trong record không kết thúc bằng NUL: trả về độ dài qua n
+    const char* asStr(size_t& n) {
+        if (type() != MeoLogRecord::Str) { asInt(); n = 1; return "?"; }
+        n = r.args[off];
+        const char* s = (const char*)(r.args + off + 1);
+        off += 1 + n;
+        idx++;
+        return s;
+    }
+};
+
+} // namespace
+
+size_t MeoLogRing::format(const MeoLogRecord& r, char* buf, size_t cap) {
+    if (!buf || cap == 0) return 0;
+    size_t len = 0;
+    auto room = [&]() -> size_t { return len < cap ? cap - len : 0; };
+    auto adv  = [&](int n) { if (n > 0) len += (size_t)n; if (len >= cap) len = cap - 1; };
+
+    adv(snprintf(buf, cap, "(%u) [%s] ", (unsigned)r.timeMs, meoLogTagName((MeoLogTag)r.tag)));
+
+    ArgReader a{r};
+    const char* f = r.fmt ? r.fmt : "";
+    while (*f && room() > 1) {
+        if (*f != '%') { buf[len++] = *f++; continue; }
+        if (f[1] == '%') { buf[len++] = '%'; f += 2; continue; }
+
+        // %[flags][width][.prec][length]conv -> spec; length modifier chọn lại theo kiểu đã chụp
+        char spec[40];
+        size_t s = 0;
+        spec[s++] = *f++;
+        while (*f && strchr("-+ #0", *f) && s < 8) spec[s++] = *f++;
+        for (int part = 0; part < 2; ++part) {
+            if (part == 1) {
+                if (*f != '.') break;
+                spec[s++] = *f++;
+            }
+            if (*f == '*') {
+                f++;
+                s += (size_t)snprintf(spec + s, sizeof(spec) - s, "%d", (int)a.asInt());
+            } else {
+                while (*f >= '0' && *f <= '9' && s < 18) spec[s++] = *f++;
+            }
+        }
+        // Giữ h / hh cho số 32 bit: "%hhx" của int8_t -1 phải ra "ff" như printf
+        char lenMod[2];
+        size_t m = 0;
+        while (*f && strchr("hlLqjzt", *f)) {
+            if (*f == 'h' && m < 2) lenMod[m++] = 'h';
+            f++;
+        }
+        char conv = *f ? *f++ : 's';
+
+        int n;
+        if (!a.more()) {
+            n = snprintf(buf + len, room(), "?");   // argument did not fit the record
+        } else if (strchr("diouxX", conv) && a.wide()) {
+            spec[s++] = 'l'; spec[s++] = 'l'; spec[s++] = conv; spec[s] = '\0';
+            n = (conv == 'd' || conv == 'i') ? snprintf(buf + len, room(), spec, (long long)a.asInt())
+                                             : snprintf(buf + len, room(), spec, (unsigned long long)a.asInt());
+        } else if (strchr("diouxX", conv)) {
+            // Chụp từ kiểu <= 4 byte: in ở độ rộng 32 bit, không sign-extend lên 64
+            for (size_t i = 0; i < m; ++i) spec[s++] = lenMod[i];
+            spec[s++] = conv; spec[s] = '\0';
+            uint32_t v = (uint32_t)a.asInt();
+            n = (conv == 'd' || conv == 'i') ? snprintf(buf + len, room(), spec, (int)(int32_t)v)
+                                             : snprintf(buf + len, room(), spec, (unsigned)v);
+        } else if (strchr("feEgGaA", conv) || conv == 'F') {
+            spec[s++] = conv; spec[s] = '\0';
+            n = snprintf(buf + len, room(), spec, a.asDouble());
+        } else if (conv == 'c') {
+            spec[s++] = 'c'; spec[s] = '\0';
+            n = snprintf(buf + len, room(), spec, (int)a.asInt());
+        } else if (conv == 'p') {
+            n = snprintf(buf + len, room(), "%p", (void*)(uintptr_t)a.asInt());
+        } else {
+            // %s: độ dài thật được giới hạn bằng precision "%.*s"
+            size_t sn;
+            const char* str = a.asStr(sn);
+            spec[s] = '\0';
+            int prec = -1;
+            const char* dot = strchr(spec, '.');
+            if (dot) prec = atoi(dot + 1);
+            if (prec >= 0 && (size_t)prec < sn) sn = (size_t)prec;
+            char head[24];
+            memcpy(head, spec, dot ? (size_t)(dot - spec) : s);
+            head[dot ? (size_t)(dot - spec) : s] = '\0';
+            strncat(head, ".*s", sizeof(head) - strlen(head) - 1);
+            n = snprintf(buf + len, room(), head, (int)sn, str);
+        }
+        adv(n);
+    }
+    if (r.truncated && room() > 4) adv(snprintf(buf + len, room(), " ..."));
+    buf[len] = '\0';
+    return len;
+}
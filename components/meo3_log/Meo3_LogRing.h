@@ -0,0 +1,205 @@
+#ifndef MEO3_LOG_RING_H
+#define MEO3_LOG_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "Meo3_Type.h"   // MeoLogFunction
+
+// Số record trong ring (luỹ thừa của 2)
+#ifndef MEO_LOG_RING_DEPTH
+#define MEO_LOG_RING_DEPTH 32
+#endif
+// Vùng tham số của một record: số 4/8 byte, chuỗi = 1 byte độ dài + nội dung (cắt bớt)
+#ifndef MEO_LOG_RECORD_ARGS
+#define MEO_LOG_RECORD_ARGS 48
+#endif
+#ifndef MEO_LOG_RECORD_MAX_ARGC
+#define MEO_LOG_RECORD_MAX_ARGC 8
+#endif
+#ifndef MEO_LOG_DRAIN_MS
+#define MEO_LOG_DRAIN_MS 20
+#endif
+#ifndef MEO_LOG_TASK_STACK
+#define MEO_LOG_TASK_STACK 3072
+#endif
+
+// Một lời gọi log chưa định dạng
+struct MeoLogRecord {
+    enum ArgType : uint8_t { I32 = 1, U32, I64, U64, F64, Str, Ptr };
+
+    uint32_t    timeMs;
+    const char* fmt;     // chuỗi hằng của call site, không copy
+    uint8_t     level;
+    uint8_t     tag;
+    uint8_t     argc;
+    uint8_t     used;    // byte đã dùng trong args
+    bool        truncated;
+    uint8_t     types[MEO_LOG_RECORD_MAX_ARGC];
+    uint8_t     args[MEO_LOG_RECORD_ARGS];
+
+    // Tham số chuỗi không có precision -> strlen
+    static constexpr int16_t kNoPrec   = -1;
+    // "%.*s": giới hạn là tham số int ngay trước chuỗi
+    static constexpr int16_t kStarPrec = -2;
+
+    // Precision của từng vị trí tham số trong fmt (kNoPrec nếu không phải %s có precision),
+    // để chuỗi "%.*s" / "%.Ns" chỉ được đọc tới giới hạn đó như printf (view không có NUL)
+    static void scanPrecision(const char* fmt, int16_t (&prec)[MEO_LOG_RECORD_MAX_ARGC]);
+
+    // prec: giá trị từ scanPrecision cho vị trí này; star: int gần nhất đã chụp
+    template <typename T>
+    void pack(T v, int16_t prec, int& star) {
+        if (argc >= MEO_LOG_RECORD_MAX_ARGC) { truncated = true; return; }
+        if constexpr (std::is_same<T, const char*>::value || std::is_same<T, char*>::value) {
+            _str(v, prec == kStarPrec ? star : prec);
+        } else if constexpr (std::is_pointer<T>::value) {
+            uintptr_t p = (uintptr_t)v;
+            _put(Ptr, &p, sizeof(p));
+        } else if constexpr (std::is_floating_point<T>::value) {
+            double d = v;
+            _put(F64, &d, sizeof(d));
+        } else if constexpr (std::is_integral<T>::value || std::is_enum<T>::value) {
+            if constexpr (sizeof(T) <= 4) {
+                star = (int)v;
+                uint32_t u = (uint32_t)v;
+                _put(std::is_signed<T>::value ? I32 : U32, &u, 4);
+            } else {
+                uint64_t u = (uint64_t)v;
+                _put(std::is_signed<T>::value ? I64 : U64, &u, 8);
+            }
+        } else {
+            static_assert(sizeof(T) == 0, "Unsupported log argument type");
+        }
+    }
+
+private:
+    void _put(ArgType t, const void* p, size_t n) {
+        if (used + n > sizeof(args)) { truncated = true; argc = MEO_LOG_RECORD_MAX_ARGC; return; }
+        memcpy(args + used, p, n);
+        used += n;
+        types[argc++] = t;
+    }
+    void _str(const char* s, int limit);   // limit < 0: tới NUL
+};
+
+// Bộ đếm đọc được từ bất kỳ task nào
+struct MeoLogRingStats {
+    uint32_t pushed  = 0;
+    uint32_t dropped = 0;   // ring đầy lúc push
+    uint32_t written = 0;   // đã định dạng và chuyển cho sink
+};
+
+/**
+ * MeoLogRing: log trì hoãn.
+ * - Call site chỉ chụp timestamp, level, tag, con trỏ format và tham số (chuỗi được
+ *   copy) vào một record cố định trong ring MPSC lock-free (Vyukov bounded queue):
+ *   một CAS + memcpy, không format, không I/O, không mutex.
+ * - Một task ưu tiên thấp định dạng record và gọi sink (Serial, MQTT, flash...) nên
+ *   tốc độ UART không còn kìm MQTT task / publish path.
+ * - Ring đầy -> record bị drop và đếm; task báo số record bị drop qua sink.
+ * - Format phải là chuỗi hằng (MEO_LOGx luôn truyền literal).
+ */
+class MeoLogRing {
+public:
+    MeoLogRing() {}
+    ~MeoLogRing();
+
+    // Cấp phát ring và khởi động task định dạng; sink được copy, đặt nó trước begin()
+    bool begin(MeoLogFunction sink,
+               uint16_t depth = MEO_LOG_RING_DEPTH,
+               BaseType_t core = tskNO_AFFINITY,
+               UBaseType_t priority = 1,
+               uint32_t stackSize = MEO_LOG_TASK_STACK);
+
+    // Ngừng nhận record, chờ các push() đang chạy xong, ghi nốt ring rồi dừng task
+    void end();
+
+    bool isRunning() const { return _running.load(std::memory_order_acquire); }
+
+    // Non-blocking, gọi được từ nhiều task cùng lúc; false nếu ring đầy hoặc đã dừng
+    template <typename... A>
+    bool push(int level, uint8_t tag, const char* fmt, A... a) {
+        if (!_enter()) return false;
+        uint32_t pos;
+        Cell* c = _claim(pos);
+        if (!c) {
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            _leave();
+            return false;
+        }
+        MeoLogRecord& r = c->rec;
+        r.timeMs    = _nowMs();
+        r.fmt       = fmt;
+        r.level     = (uint8_t)level;
+        r.tag       = tag;
+        r.argc      = 0;
+        r.used      = 0;
+        r.truncated = false;
+        int16_t prec[MEO_LOG_RECORD_MAX_ARGC];
+        if constexpr ((_isStr<A>() || ...)) {
+            MeoLogRecord::scanPrecision(fmt, prec);
+        } else {
+            for (int16_t& p : prec) p = MeoLogRecord::kNoPrec;
+        }
+        [[maybe_unused]] int star = -1;
+        (r.pack(a, prec[r.argc < MEO_LOG_RECORD_MAX_ARGC ? r.argc : 0], star), ...);
+        _publish(c, pos);
+        _leave();
+        return true;
+    }
+
+    MeoLogRingStats stats() const;
+
+    // Định dạng một record thành "(ms) [TAG] message"; trả về độ dài
+    static size_t format(const MeoLogRecord& r, char* buf, size_t cap);
+
+private:
+    struct Cell {
+        std::atomic<uint32_t> seq;
+        MeoLogRecord          rec;
+    };
+
+    template <typename T>
+    static constexpr bool _isStr() {
+        return std::is_same<T, const char*>::value || std::is_same<T, char*>::value;
+    }
+
+    Cell*          _cells = nullptr;
+    uint32_t       _mask  = 0;
+    uint32_t       _tail  = 0;   // chỉ task định dạng đọc/ghi
+    MeoLogFunction _sink  = nullptr;
+    TaskHandle_t   _task  = nullptr;
+
+    std::atomic<uint32_t> _head{0};
+    std::atomic<bool>     _running{false};
+    std::atomic<bool>     _stop{false};
+    std::atomic<bool>     _taskAlive{false};
+    std::atomic<uint16_t> _inFlight{0};   // push() đang chạm vào _cells
+    std::atomic<uint32_t> _pushed{0};
+    std::atomic<uint32_t> _dropped{0};
+    std::atomic<uint32_t> _written{0};
+
+    // Cặp seq_cst với end(): hoặc end() thấy _inFlight > 0 và chờ, hoặc push() thấy _running == false
+    bool _enter() {
+        _inFlight.fetch_add(1, std::memory_order_seq_cst);
+        if (_running.load(std::memory_order_seq_cst)) return true;
+        _leave();
+        return false;
+    }
+    void  _leave() { _inFlight.fetch_sub(1, std::memory_order_release); }
+    Cell* _claim(uint32_t& pos);
+    void  _publish(Cell* c, uint32_t pos);
+    bool  _drainOne();
+    static uint32_t _nowMs();
+    static void _taskEntry(void* arg);
+    void _run();
+    void _release();
+};
+
+#endif // MEO3_LOG_RING_H
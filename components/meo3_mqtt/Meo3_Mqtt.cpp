@@ -1,14 +1,23 @@
 #include "Meo3_Mqtt.h" 
 #include <cstdio>
-#include <cstdarg>
 #include <cstring>
+#include <new>
 #include "esp_log.h"
-#include "esp_random.h" 
-
-MeoMqttClient* MeoMqttClient::_self = nullptr;
+#include "esp_mac.h"
+
+namespace {
+struct RouterLock {
+    SemaphoreHandle_t h;
+    explicit RouterLock(SemaphoreHandle_t m) : h(m) { if (h) xSemaphoreTake(h, portMAX_DELAY); }
+    ~RouterLock() { if (h) xSemaphoreGive(h); }
+};
+}
 
 MeoMqttClient::MeoMqttClient() {
-    _self = this;
+    _routerLock = xSemaphoreCreateMutex();
+#ifdef CONFIG_MQTT_PROTOCOL_5
+    _pubLock = xSemaphoreCreateMutex();
+#endif
     //config
     _bufferSize = 1024;
     _keepAlive = 15;
@@ -17,82 +26,135 @@ MeoMqttClient::MeoMqttClient() {
 
 MeoMqttClient::~MeoMqttClient() {
     disconnect();
+    _rxReset();
+    if (_routerLock) vSemaphoreDelete(_routerLock);
+#ifdef CONFIG_MQTT_PROTOCOL_5
+    if (_pubLock) vSemaphoreDelete(_pubLock);
+#endif
 }
 
 void MeoMqttClient::setLogger(MeoLogFunction logger) {
-    _logger = logger;
+    _log.setSink(logger);
 }
 
 void MeoMqttClient::setDebugTags(const char* tagsCsv) {
-    if (!tagsCsv) { _debugTags[0] = '\0'; return; }
-    strncpy(_debugTags, tagsCsv, sizeof(_debugTags) - 1);
-    _debugTags[sizeof(_debugTags) - 1] = '\0';
+    _log.setDebugTags(tagsCsv);
 }
 
 void MeoMqttClient::configure(const char* host, uint16_t port) {
     // Lưu vào std::string để an toàn bộ nhớ
-    _host = host ? host : "";
+    const char* h = host ? host : "";
+    if (_host != h || _port != port) _configDirty = true;
+    _host = h;
     _port = port;
     
-    if (_logger && _debugTagEnabled("MQTT")) {
-        _logf("DEBUG", "MQTT", "Configured broker %s:%u", _host.c_str(), _port);
-    }
+    MEO_LOGD(_log, MQTT, "Configured broker %s:%u", _host.c_str(), _port);
 }
 
 void MeoMqttClient::setCredentials(const char* deviceId, const char* transmitKey) {
-    _deviceId = deviceId ? deviceId : "";
-    _txKey = transmitKey ? transmitKey : "";
+    const char* id  = deviceId ? deviceId : "";
+    const char* key = transmitKey ? transmitKey : "";
+    if (_deviceId != id || _txKey != key) _configDirty = true;
+    _deviceId = id;
+    _txKey = key;
     
-    if (_logger && _debugTagEnabled("MQTT")) {
-        _logf("DEBUG", "MQTT", "Credentials set: deviceId=%s", _deviceId.c_str());
-    }
+    MEO_LOGD(_log, MQTT, "Credentials set: deviceId=%s", _deviceId.c_str());
 }
 
 void MeoMqttClient::setBufferSize(uint16_t bytes) {
+    if (_bufferSize != bytes) _configDirty = true;
     _bufferSize = bytes;
 }
 void MeoMqttClient::setKeepAlive(uint16_t seconds) {
+    if (_keepAlive != seconds) _configDirty = true;
     _keepAlive = seconds;
 }
 void MeoMqttClient::setSocketTimeout(uint16_t seconds) {
+    if (_networkTimeout != seconds * 1000) _configDirty = true;
     _networkTimeout = seconds * 1000; // Đổi sang ms cho IDF
 }
+void MeoMqttClient::setAutoReconnect(bool enable) {
+    if (_autoReconnect != enable) _configDirty = true;
+    _autoReconnect = enable;
+}
+
+void MeoMqttClient::setCleanSession(bool clean) {
+    if (_cleanSession != clean) _configDirty = true;
+    _cleanSession = clean;
+}
+
+void MeoMqttClient::setOutboxLimit(size_t bytes) {
+    if (_outboxLimit != bytes) _configDirty = true;
+    _outboxLimit = bytes;
+}
+
+size_t MeoMqttClient::outboxBytes() {
+    if (!_client) return 0;
+    int n = esp_mqtt_client_get_outbox_size(_client);
+    return n > 0 ? (size_t)n : 0;
+}
+
+MeoMqttTxStats MeoMqttClient::txStats() const {
+    MeoMqttTxStats st;
+    st.published     = _txPublished.load(std::memory_order_relaxed);
+    st.storedOffline = _txStoredOffline.load(std::memory_order_relaxed);
+    st.outboxFull    = _txOutboxFull.load(std::memory_order_relaxed);
+    st.failed        = _txFailed.load(std::memory_order_relaxed);
+    st.rejected      = _txRejected.load(std::memory_order_relaxed);
+    st.aliased       = _txAliased.load(std::memory_order_relaxed);
+    st.bytes         = _txBytes.load(std::memory_order_relaxed);
+    return st;
+}
+
+bool MeoMqttClient::setProtocolVersion(uint8_t version) {
+#ifdef CONFIG_MQTT_PROTOCOL_5
+    if (version != 4 && version != 5) return false;
+#else
+    if (version != 4) return false;
+#endif
+    if (_protocol != version) _configDirty = true;
+    _protocol = version;
+    return true;
+}
+
+void MeoMqttClient::setDeliveryHandler(MeoDeliveryFn fn, void* ctx) {
+    _onDelivery = fn;
+    _onDeliveryCtx = ctx;
+}
 
 void MeoMqttClient::setWill(const char* topic, const char* payload, uint8_t qos, bool retain) {
-    _willTopic = topic ? topic : "";
-    _willPayload = payload ? payload : "";
+    if (!_hasWill || strcmp(_willTopic, topic ? topic : "") != 0 ||
+        strcmp(_willPayload, payload ? payload : "") != 0 ||
+        _willQos != qos || _willRetain != retain) {
+        _configDirty = true;
+    }
+    snprintf(_willTopic, sizeof(_willTopic), "%s", topic ? topic : "");
+    snprintf(_willPayload, sizeof(_willPayload), "%s", payload ? payload : "");
     _willQos = qos;
     _willRetain = retain;
     _hasWill = true;
 }
 
-bool MeoMqttClient::connect() {
-    if (_client != NULL) {
-        // Nếu client đã tồn tại, kiểm tra xem có đang nối không
-        if (_connected) return true;
-        // Nếu không, có thể cần destroy đi tạo lại hoặc reconnect, ở đây ta chọn destroy cho sạch
-        esp_mqtt_client_stop(_client);
-        esp_mqtt_client_destroy(_client);
-        _client = NULL;
-    }
-
-    // 1. Tạo Client ID nếu chưa có (Thay cho millis())
-    std::string finalClientId;
+bool MeoMqttClient::_buildConfig(esp_mqtt_client_config_t& mqtt_cfg, char* uri, size_t uriLen,
+                                 std::string& finalClientId) {
+    // 1. Client ID ổn định (bắt buộc cho persistent session): theo deviceId, nếu chưa có thì theo MAC
     if (!_deviceId.empty()) {
         finalClientId = "meo-" + _deviceId;
     } else {
+        uint8_t mac[6] = {0};
+        esp_efuse_mac_get_default(mac);
         char buf[32];
-        snprintf(buf, sizeof(buf), "meo-device-%lu", (unsigned long)esp_random());
+        snprintf(buf, sizeof(buf), "meo-device-%02x%02x%02x%02x%02x%02x",
+                 mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
         finalClientId = buf;
     }
 
     // 2. Tạo URI string (Bắt buộc cho IDF Client)
-    char uri[256];
     if (_host.empty()) return false;
-    snprintf(uri, sizeof(uri), "mqtt://%s:%d", _host.c_str(), _port);
+    snprintf(uri, uriLen, "mqtt://%s:%d", _host.c_str(), _port);
 
     // 3. Cấu hình Config Struct (ESP-IDF v5.x)
-    esp_mqtt_client_config_t mqtt_cfg = {};
+    mqtt_cfg = {};
     
     // Broker info
     mqtt_cfg.broker.address.uri = uri;
@@ -109,23 +171,66 @@ bool MeoMqttClient::connect() {
     // Timing & Buffer
     mqtt_cfg.session.keepalive = _keepAlive;
     mqtt_cfg.network.timeout_ms = _networkTimeout;
+    mqtt_cfg.network.disable_auto_reconnect = !_autoReconnect;
     mqtt_cfg.buffer.size = _bufferSize;
+
+    // Session & outbox
+    mqtt_cfg.session.disable_clean_session = !_cleanSession;
+    mqtt_cfg.outbox.limit = _outboxLimit;
+#ifdef CONFIG_MQTT_PROTOCOL_5
+    if (_protocol == 5) mqtt_cfg.session.protocol_ver = MQTT_PROTOCOL_V_5;
+#endif
     
     // Last Will
     if (_hasWill) {
-        mqtt_cfg.session.last_will.topic = _willTopic.c_str();
-        mqtt_cfg.session.last_will.msg = _willPayload.c_str();
+        mqtt_cfg.session.last_will.topic = _willTopic;
+        mqtt_cfg.session.last_will.msg = _willPayload;
         mqtt_cfg.session.last_will.qos = _willQos;
         mqtt_cfg.session.last_will.retain = _willRetain;
-        mqtt_cfg.session.last_will.msg_len = _willPayload.length();
+        mqtt_cfg.session.last_will.msg_len = strlen(_willPayload);
+    }
+    return true;
+}
+
+bool MeoMqttClient::connect() {
+    if (_client != NULL && isConnected()) return true;
+
+    // esp-mqtt copy toàn bộ chuỗi trong config nên các buffer này chỉ cần sống trong hàm
+    char uri[256];
+    std::string finalClientId;
+    esp_mqtt_client_config_t mqtt_cfg;
+
+    if (_client != NULL) {
+        // Tái sử dụng handle: không destroy/init lại (tránh churn heap mỗi lần reconnect)
+        if (_configDirty) {
+            if (!_buildConfig(mqtt_cfg, uri, sizeof(uri), finalClientId)) return false;
+            if (esp_mqtt_set_config(_client, &mqtt_cfg) != ESP_OK) {
+                MEO_LOGE(_log, MQTT, "Failed to update client config");
+                return false;
+            }
+#ifdef CONFIG_MQTT_PROTOCOL_5
+            _applyConnectProperties();
+#endif
+            _configDirty = false;
+        }
+        esp_err_t err = esp_mqtt_client_reconnect(_client);
+        if (err == ESP_OK) MEO_LOGD(_log, MQTT, "Reconnect request sent");
+        else               MEO_LOGE(_log, MQTT, "Reconnect request rejected");
+        return err == ESP_OK;
     }
 
+    if (!_buildConfig(mqtt_cfg, uri, sizeof(uri), finalClientId)) return false;
+
     // 4. Khởi tạo Client
     _client = esp_mqtt_client_init(&mqtt_cfg);
     if (_client == NULL) {
-        _log("ERROR", "MQTT", "Failed to init client memory");
+        MEO_LOGE(_log, MQTT, "Failed to init client memory");
         return false;
     }
+#ifdef CONFIG_MQTT_PROTOCOL_5
+    _applyConnectProperties();
+#endif
+    _configDirty = false;
 
     // 5. Đăng ký Event Callback (Thay cho setCallback cũ)
     // Truyền 'this' vào arg cuối cùng để dùng trong static function
@@ -136,10 +241,15 @@ bool MeoMqttClient::connect() {
     esp_err_t err = esp_mqtt_client_start(_client);
     
     bool started = (err == ESP_OK);
-    _log(started ? "INFO" : "ERROR", "MQTT", started ? "Client task started" : "Start failed");
+    MEO_LOG_AT(_log, started ? MEO_LOG_LEVEL_INFO : MEO_LOG_LEVEL_ERROR, MQTT, started ? "Client task started" : "Start failed");
+    if (!started) {
+        // Handle chưa chạy thì không reconnect được: bỏ đi để lần sau init lại
+        esp_mqtt_client_destroy(_client);
+        _client = NULL;
+    }
     
     // Lưu ý: IDF connect là Async. Hàm này trả về true nghĩa là Task đã chạy, 
-    // chưa chắc đã Connect thành công ngay lập tức. Trạng thái _connected sẽ update trong event handler.
+    // chưa chắc đã Connect thành công ngay lập tức. Trạng thái _link sẽ update trong event handler.
     return started;
 }
 
@@ -148,7 +258,8 @@ void MeoMqttClient::disconnect() {
         esp_mqtt_client_stop(_client);
         esp_mqtt_client_destroy(_client);
         _client = NULL;
-        _connected = false;
+        // Task esp-mqtt đã dừng: không còn ai ghi _link; giữ generation, chỉ xoá cờ
+        _link.fetch_and(~1u, std::memory_order_acq_rel);
     }
 }
 
@@ -157,46 +268,239 @@ void MeoMqttClient::loop() {
     // Empty
 }
 
-bool MeoMqttClient::isConnected() {
-    return _connected;
+bool MeoMqttClient::publish(const char* topic, const uint8_t* payload, size_t len, bool retained, uint8_t qos) {
+    MeoPublishOptions opt;
+    opt.qos = qos;
+    opt.retained = retained;
+    return publish(topic, payload, len, opt) == MeoPublishResult::Ok;
 }
 
-bool MeoMqttClient::publish(const char* topic, const uint8_t* payload, size_t len, bool retained) {
-    if (!_client || !_connected) return false;
-    
-    if (_logger && _debugTagEnabled("MQTT")) {
-        _logf("DEBUG", "MQTT", "Publish %s len=%u retained=%d", topic ? topic : "", (unsigned)len, retained);
+bool MeoMqttClient::publish(const char* topic, const char* payload, bool retained, uint8_t qos) {
+    // Gọi hàm overload trên
+    return publish(topic, (const uint8_t*)payload, payload ? strlen(payload) : 0, retained, qos);
+}
+
+MeoPublishResult MeoMqttClient::publish(const char* topic, const uint8_t* payload, size_t len,
+                                        const MeoPublishOptions& opt, int* msgId) {
+    uint8_t qos = opt.qos > 2 ? 2 : opt.qos;
+    if (msgId) *msgId = -1;
+    // Một ảnh chụp cho cả lần publish: chọn publish/enqueue và đếm thống kê theo cùng trạng thái
+    const bool connected = isConnected();
+    // QoS 0 khi mất kết nối sẽ không bao giờ được gửi: báo lỗi ngay
+    if (!_client || (!connected && qos == 0)) {
+        _txFailed.fetch_add(1, std::memory_order_relaxed);
+        return MeoPublishResult::NotConnected;
     }
     
-    // esp_mqtt_client_publish trả về message_id (-1 là lỗi, khác -1 là đã đưa vào hàng đợi)
-    // qos=0 (có thể đổi nếu muốn), retain flag chuyển thành int (0 hoặc 1)
-    int msg_id = esp_mqtt_client_publish(_client, topic, (const char*)payload, len, 0, retained ? 1 : 0);
-    return (msg_id != -1);
+    MEO_LOGD(_log, MQTT, "Publish %s len=%u qos=%u retained=%d", topic ? topic : "",
+             (unsigned)len, qos, opt.retained);
+    
+    int msg_id;
+#ifdef CONFIG_MQTT_PROTOCOL_5
+    if (_protocol == 5) {
+        msg_id = _publish5(topic, payload, len, opt, qos, connected);
+    } else
+#endif
+    msg_id = _send(topic, payload, len, qos, opt.retained, connected);
+
+    if (msg_id == -2) {
+        _txOutboxFull.fetch_add(1, std::memory_order_relaxed);
+        MEO_LOGD(_log, MQTT, "Outbox full (%u/%u bytes), %s rejected",
+                 (unsigned)outboxBytes(), (unsigned)_outboxLimit, topic ? topic : "");
+        return MeoPublishResult::OutboxFull;
+    }
+    if (msg_id < 0) {
+        // MQTT 5: esp-mqtt từ chối trước khi gửi khi QoS vượt Maximum QoS hoặc retain khi
+        // broker báo Retain Available = 0 trong CONNACK (alias vượt giới hạn đã được gửi lại
+        // ở _publish5). Message QoS 0 không retain thì không chạm giới hạn nào: lỗi khác
+        if (_protocol == 5 && connected && (qos > 0 || opt.retained)) {
+            _txRejected.fetch_add(1, std::memory_order_relaxed);
+            MEO_LOGW(_log, MQTT, "Publish %s rejected by broker limits (qos=%u retained=%d len=%u)",
+                     topic ? topic : "", qos, opt.retained, (unsigned)len);
+            return MeoPublishResult::Rejected;
+        }
+        _txFailed.fetch_add(1, std::memory_order_relaxed);
+        return MeoPublishResult::Failed;
+    }
+    (connected ? _txPublished : _txStoredOffline).fetch_add(1, std::memory_order_relaxed);
+    _txBytes.fetch_add((uint32_t)len, std::memory_order_relaxed);
+    if (opt.cookie && msg_id > 0) _rememberCookie(msg_id, opt.cookie);
+    if (msgId) *msgId = msg_id;
+    return MeoPublishResult::Ok;
 }
 
-bool MeoMqttClient::publish(const char* topic, const char* payload, bool retained) {
-    // Gọi hàm overload trên
-    return publish(topic, (const uint8_t*)payload, payload ? strlen(payload) : 0, retained);
+// Ghi từ task publish, đọc từ task esp-mqtt. PUBACK tới trước khi kịp ghi (hiếm)
+// thì ack đó được báo với cookie 0.
+void MeoMqttClient::_rememberCookie(int msgId, uint32_t cookie) {
+    PendingCookie& c = _cookies[(unsigned)msgId % MEO_MQTT_COOKIES];
+    c.msgId.store(-1, std::memory_order_relaxed);
+    c.cookie.store(cookie, std::memory_order_relaxed);
+    c.msgId.store(msgId, std::memory_order_release);
 }
 
-bool MeoMqttClient::subscribe(const char* topic, uint8_t qos) {
-    if (!_client || !_connected) return false;
-    
-    int msg_id = esp_mqtt_client_subscribe(_client, topic, qos);
-    bool ok = (msg_id != -1);
+uint32_t MeoMqttClient::_takeCookie(int msgId) {
+    PendingCookie& c = _cookies[(unsigned)msgId % MEO_MQTT_COOKIES];
+    if (c.msgId.load(std::memory_order_acquire) != msgId) return 0;
+    uint32_t cookie = c.cookie.load(std::memory_order_relaxed);
+    int expected = msgId;
+    // Slot reused meanwhile: the cookie read above may belong to another message
+    if (!c.msgId.compare_exchange_strong(expected, -1, std::memory_order_acq_rel)) return 0;
+    return cookie;
+}
 
-    if (_logger && _debugTagEnabled("MQTT")) {
-        _logf(ok ? "DEBUG" : "ERROR", "MQTT", "%s subscribe %s",
-              ok ? "OK" : "FAIL", topic ? topic : "");
+// esp_mqtt_client_publish trả về message_id (-1 lỗi, -2 outbox đầy).
+// Khi mất kết nối, esp_mqtt_client_enqueue giữ message QoS>0 trong outbox để gửi lại.
+int MeoMqttClient::_send(const char* topic, const uint8_t* payload, size_t len, uint8_t qos, bool retained,
+                         bool connected) {
+    if (connected) {
+        return esp_mqtt_client_publish(_client, topic, (const char*)payload, len, qos, retained ? 1 : 0);
     }
+    return esp_mqtt_client_enqueue(_client, topic, (const char*)payload, len, qos, retained ? 1 : 0, true);
+}
+
+#ifdef CONFIG_MQTT_PROTOCOL_5
+// Topic alias chỉ dùng cho QoS 0 khi đang kết nối: message QoS>0 có thể được gửi lại
+// từ outbox sau reconnect, khi broker đã quên alias của kết nối cũ.
+int MeoMqttClient::_publish5(const char* topic, const uint8_t* payload, size_t len,
+                             const MeoPublishOptions& opt, uint8_t qos, bool connected) {
+    esp_mqtt5_publish_property_config_t prop = {};
+    prop.content_type = opt.contentType;
+
+    RouterLock lock(_pubLock);
+
+    if (opt.userProps && opt.userPropCount) {
+        esp_mqtt5_user_property_item_t items[MEO_MQTT5_MAX_USER_PROPS];
+        uint8_t n = opt.userPropCount < MEO_MQTT5_MAX_USER_PROPS ? opt.userPropCount : MEO_MQTT5_MAX_USER_PROPS;
+        for (uint8_t i = 0; i < n; ++i) {
+            items[i].key   = opt.userProps[i].key;
+            items[i].value = opt.userProps[i].value;
+        }
+        esp_mqtt5_client_set_user_property(&prop.user_property, items, n);
+    }
+
+    const char* wireTopic = topic;
+    bool newAlias = false;
+    if (opt.topicAlias && qos == 0 && connected && topic) {
+        for (uint8_t i = 0; i < _aliasCount; ++i) {
+            if (strcmp(_aliasTopics[i], topic) == 0) {
+                prop.topic_alias = i + 1;
+                wireTopic = "";   // broker đã biết alias: chỉ gửi số
+                break;
+            }
+        }
+        if (!prop.topic_alias && _aliasCount < _aliasLimit && strlen(topic) < MEO_TOPIC_MAX) {
+            prop.topic_alias = _aliasCount + 1;   // lần đầu: gửi topic kèm alias để broker ghi nhớ
+            newAlias = true;
+        }
+    }
+
+    esp_mqtt5_client_set_publish_property(_client, &prop);
+    int msg_id = _send(wireTopic, payload, len, qos, opt.retained, connected);
+
+    if (newAlias) {
+        if (msg_id >= 0) {
+            strcpy(_aliasTopics[_aliasCount++], topic);
+        } else if (msg_id == -1) {
+            // Broker cho phép ít alias hơn: dừng cấp alias mới, gửi lại bằng topic đầy đủ
+            _aliasLimit = _aliasCount;
+            prop.topic_alias = 0;
+            esp_mqtt5_client_set_publish_property(_client, &prop);
+            msg_id = _send(topic, payload, len, qos, opt.retained, connected);
+        }
+    } else if (prop.topic_alias && msg_id >= 0) {
+        _txAliased.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (prop.user_property) esp_mqtt5_client_delete_user_property(prop.user_property);
+    return msg_id;
+}
+
+void MeoMqttClient::_applyConnectProperties() {
+    esp_mqtt5_connection_property_config_t cp = {};
+    // MQTT 5 giữ session sau khi ngắt kết nối chỉ khi session expiry > 0
+    cp.session_expiry_interval = _cleanSession ? 0 : MEO_MQTT5_SESSION_EXPIRY_S;
+    esp_mqtt5_client_set_connect_property(_client, &cp);
+}
+
+// Alias chỉ có hiệu lực trong một kết nối
+void MeoMqttClient::_aliasReset() {
+    RouterLock lock(_pubLock);
+    _aliasCount = 0;
+    _aliasLimit = MEO_MQTT5_TOPIC_ALIASES;
+}
+#endif
+
+bool MeoMqttClient::subscribe(const char* filter, OnMessageFn fn, void* ctx, uint8_t qos) {
+    int idx;
+    {
+        RouterLock g(_routerLock);
+        idx = _router.add(filter, fn, ctx, qos);
+    }
+    if (idx < 0) {
+        MEO_LOGE(_log, MQTT, "Cannot route %s (invalid filter or router full)", filter ? filter : "");
+        return false;
+    }
+    // Chưa kết nối: MQTT_EVENT_CONNECTED sẽ subscribe toàn bộ route
+    if (!_client || !isConnected()) return true;
+
+    int msg_id = esp_mqtt_client_subscribe(_client, filter, qos);
+    bool ok = (msg_id != -1);
+
+    if (ok) MEO_LOGD(_log, MQTT, "OK subscribe %s", filter);
+    else    MEO_LOGE(_log, MQTT, "FAIL subscribe %s", filter);
     return ok;
 }
 
+bool MeoMqttClient::subscribe(const char* filter, uint8_t qos) {
+    return subscribe(filter, nullptr, nullptr, qos);
+}
+
+bool MeoMqttClient::unsubscribe(const char* filter, OnMessageFn fn, void* ctx) {
+    bool stillUsed;
+    {
+        RouterLock g(_routerLock);
+        if (!_router.remove(filter, fn, ctx)) return false;
+        stillUsed = _router.hasFilter(filter);
+    }
+    // Filter còn route khác dùng thì giữ subscription trên broker
+    if (!stillUsed && _client && isConnected()) {
+        esp_mqtt_client_unsubscribe(_client, filter);
+    }
+    return true;
+}
+
+void MeoMqttClient::_resubscribeAll() {
+    RouterLock g(_routerLock);
+    for (size_t i = 0; i < MeoTopicRouter::capacity(); ++i) {
+        const MeoTopicRouter::Route& r = _router.route(i);
+        if (!r.used) continue;
+        // Nhiều route chung filter chỉ cần một SUBSCRIBE
+        bool dup = false;
+        for (size_t j = 0; j < i && !dup; ++j) {
+            dup = _router.route(j).used && strcmp(_router.route(j).filter, r.filter) == 0;
+        }
+        if (dup) continue;
+        int msg_id = esp_mqtt_client_subscribe(_client, r.filter, r.qos);
+        if (msg_id != -1) MEO_LOGD(_log, MQTT, "Resubscribe %s OK", r.filter);
+        else              MEO_LOGE(_log, MQTT, "Resubscribe %s FAIL", r.filter);
+    }
+}
+
 void MeoMqttClient::setMessageHandler(OnMessageFn fn, void* ctx) {
+    RouterLock g(_routerLock);
     _onMessage = fn;
     _onMessageCtx = ctx;
 }
 
+// Task esp-mqtt là producer duy nhất của _states
+void MeoMqttClient::_pushState(MeoMqttStateKind kind, uint8_t code) {
+    MeoMqttStateEvent ev;
+    ev.kind = kind;
+    ev.code = code;
+    ev.generation = generation();
+    if (!_states.push(ev)) MEO_LOGW(_log, MQTT, "State queue full, transition dropped");
+}
+
 // --- STATIC EVENT HANDLER ---
 // Đây là hàm thay thế cho _pubsubThunk và cơ chế callback cũ
 void MeoMqttClient::_mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_t event_id, void *event_data) {
@@ -211,24 +515,48 @@ void MeoMqttClient::_handleEvent(int32_t event_id, void *event_data) {
 
     switch ((esp_mqtt_event_id_t)event_id) {
         case MQTT_EVENT_CONNECTED:
-            _connected = true;
-            _log("INFO", "MQTT", "Event: Connected");
+#ifdef CONFIG_MQTT_PROTOCOL_5
+            _aliasReset();
+#endif
+            // Báo connected trước khi resubscribe: subscribe() chen giữa sẽ tự gửi SUBSCRIBE
+            // (trùng thì vô hại) thay vì chỉ lưu route và bị bỏ sót
+            _link.store(((generation() + 1) << 1) | 1u, std::memory_order_release);
+            MEO_LOGI(_log, MQTT, "Event: Connected (gen %u)", (unsigned)generation());
+            _resubscribeAll();
+            _pushState(MeoMqttStateKind::Connected);
             break;
             
         case MQTT_EVENT_DISCONNECTED:
-            _connected = false;
-            _log("WARN", "MQTT", "Event: Disconnected");
+            _link.fetch_and(~1u, std::memory_order_acq_rel);
+            if (_rxBuf) {
+                _rxStats.dropped++;  // phần còn lại sẽ không bao giờ tới
+                _rxReset();
+            }
+            MEO_LOGW(_log, MQTT, "Event: Disconnected");
+            _pushState(MeoMqttStateKind::Disconnected);
             break;
 
         case MQTT_EVENT_DATA:
-            // Xử lý dữ liệu nhận được
-            // Lưu ý: event->topic KHÔNG có null-terminated, phải xử lý thủ công
-            _invokeMessageHandler(event->topic, event->topic_len, event->data, event->data_len);
+            _handleData(event);
+            break;
+
+        case MQTT_EVENT_PUBLISHED:
+            if (_onDelivery) _onDelivery(event->msg_id, true, _takeCookie(event->msg_id), _onDeliveryCtx);
+            break;
+
+        case MQTT_EVENT_DELETED:
+            // Hết hạn trong outbox, không bao giờ được xác nhận
+            if (_onDelivery) _onDelivery(event->msg_id, false, _takeCookie(event->msg_id), _onDeliveryCtx);
             break;
 
         case MQTT_EVENT_ERROR:
             if (event->error_handle->error_type == MQTT_ERROR_TYPE_TCP_TRANSPORT) {
-                 _log("ERROR", "MQTT", "Transport Error");
+                 MEO_LOGE(_log, MQTT, "Transport Error");
+            } else if (event->error_handle->error_type == MQTT_ERROR_TYPE_CONNECTION_REFUSED) {
+                // MQTT 5: reason code của CONNACK (vd 0x86 sai user/password, 0x87 không có quyền)
+                MEO_LOGE(_log, MQTT, "Connection refused (code 0x%02x)",
+                         (unsigned)event->error_handle->connect_return_code);
+                _pushState(MeoMqttStateKind::Refused, (uint8_t)event->error_handle->connect_return_code);
             }
             break;
         default:
@@ -236,50 +564,108 @@ void MeoMqttClient::_handleEvent(int32_t event_id, void *event_data) {
     }
 }
 
-void MeoMqttClient::_invokeMessageHandler(const char* topic, int topic_len, const char* data, int data_len) {
-    if (_onMessage) {
-        // Cần copy topic ra buffer tạm để thêm ký tự '\0' kết thúc chuỗi
-        // vì thư viện IDF trả về pointer + độ dài chứ không phải C-string chuẩn.
-        char t_buf[128]; 
-        int t_len_safe = (topic_len < (int)sizeof(t_buf) - 1) ? topic_len : ((int)sizeof(t_buf) - 1);
-        
-        memcpy(t_buf, topic, t_len_safe);
-        t_buf[t_len_safe] = '\0'; // Quan trọng!
+// Payload lớn hơn buffer.size được esp-mqtt giao thành nhiều MQTT_EVENT_DATA:
+// fragment đầu có topic và current_data_offset == 0, các fragment sau chỉ có data.
+void MeoMqttClient::_handleData(esp_mqtt_event_handle_t event) {
+    const size_t total  = event->total_data_len > 0 ? (size_t)event->total_data_len : 0;
+    const size_t offset = event->current_data_offset > 0 ? (size_t)event->current_data_offset : 0;
+    const size_t len    = event->data_len > 0 ? (size_t)event->data_len : 0;
+
+    // Message trọn vẹn: giao thẳng, topic là view vào buffer của esp-mqtt
+    if (offset == 0 && len >= total) {
+        if (_rxBuf) { _rxStats.dropped++; _rxReset(); }
+        _invokeMessageHandler(event->topic, (size_t)event->topic_len, (const uint8_t*)event->data, len);
+        return;
+    }
 
-        if (_logger && _debugTagEnabled("MQTT")) {
-            _logf("DEBUG", "MQTT", "Incoming %s len=%d", t_buf, data_len);
+    if (offset == 0) {
+        // Fragment đầu của message mới
+        if (_rxBuf) { _rxStats.dropped++; _rxReset(); }
+        size_t topicLen = event->topic_len > 0 ? (size_t)event->topic_len : 0;
+        if (total > _rxMax || topicLen == 0 || topicLen >= sizeof(_rxTopic)) {
+            _rxStats.tooLarge++;
+            MEO_LOGW(_log, MQTT, "Drop fragmented message: %u bytes (max %u)",
+                     (unsigned)total, (unsigned)_rxMax);
+            return;
         }
-        
-        // Gọi callback của user
-        _onMessage(t_buf, (const uint8_t*)data, (unsigned int)data_len, _onMessageCtx);
+        _rxBuf = new (std::nothrow) uint8_t[total];
+        if (!_rxBuf) {
+            _rxStats.dropped++;
+            MEO_LOGE(_log, MQTT, "No memory to reassemble %u bytes", (unsigned)total);
+            return;
+        }
+        _rxTotal = total;
+        _rxGot   = 0;
+        memcpy(_rxTopic, event->topic, topicLen);
+        _rxTopic[topicLen] = '\0';
+        _rxTopicLen = topicLen;
+        _rxStats.bufferBytes += (uint32_t)total;
+        if (_rxStats.bufferBytes > _rxStats.peakBytes) _rxStats.peakBytes = _rxStats.bufferBytes;
+    } else if (!_rxBuf) {
+        return;  // phần tiếp của message đã bị bỏ
     }
-}
 
-// --- LOGGING & UTILS (Giữ nguyên logic của bạn) ---
+    // Fragment phải liền mạch và thuộc đúng message đang ghép
+    if (offset != _rxGot || total != _rxTotal || offset + len > _rxTotal) {
+        _rxStats.dropped++;
+        MEO_LOGW(_log, MQTT, "Fragment out of sequence, message dropped");
+        _rxReset();
+        return;
+    }
+    memcpy(_rxBuf + offset, event->data, len);
+    _rxGot += len;
 
-bool MeoMqttClient::_debugTagEnabled(const char* tag) const {
-    if (!_debugTags[0]) return false;
-    const char* p = strstr(_debugTags, tag);
-    if (!p) return false;
-    bool leftOk  = (p == _debugTags) || (*(p - 1) == ',');
-    const char* end = p + strlen(tag);
-    bool rightOk = (*end == '\0') || (*end == ',');
-    return leftOk && rightOk;
+    if (_rxGot == _rxTotal) {
+        _rxStats.reassembled++;
+        _invokeMessageHandler(_rxTopic, _rxTopicLen, _rxBuf, _rxTotal);
+        _rxReset();
+    }
 }
 
-void MeoMqttClient::_log(const char* level, const char* tag, const char* msg) const {
-    if (!_logger) return;
-    char buf[256];
-    snprintf(buf, sizeof(buf), "[%s] %s", tag ? tag : "MQTT", msg ? msg : "");
-    _logger(level, buf);
+void MeoMqttClient::_rxReset() {
+    if (_rxBuf) {
+        delete[] _rxBuf;
+        _rxBuf = nullptr;
+        _rxStats.bufferBytes -= (uint32_t)_rxTotal;
+    }
+    _rxTotal = 0;
+    _rxGot   = 0;
+    _rxTopicLen = 0;
 }
 
-void MeoMqttClient::_logf(const char* level, const char* tag, const char* fmt, ...) const {
-    if (!_logger) return;
-    char msg[192];
-    va_list ap;
-    va_start(ap, fmt);
-    vsnprintf(msg, sizeof(msg), fmt, ap);
-    va_end(ap);
-    _log(level, tag, msg);
-}
\ No newline at end of file
+void MeoMqttClient::_invokeMessageHandler(const char* topic, size_t topic_len, const uint8_t* data, size_t data_len) {
+    _rxStats.messages++;
+
+    // esp-mqtt không kết thúc topic bằng '\0': chuyển nguyên view cho handler, không copy
+    MEO_LOGD(_log, MQTT, "Incoming %.*s len=%u", (int)topic_len, topic ? topic : "", (unsigned)data_len);
+
+    // Lấy handler dưới khóa rồi gọi ngoài khóa (handler được phép subscribe/unsubscribe)
+    struct Target { OnMessageFn fn; void* ctx; };
+    Target targets[MEO_ROUTER_MAX_ROUTES];
+    Target fallback;
+    size_t n = 0;
+    {
+        RouterLock g(_routerLock);
+        fallback = Target{ _onMessage, _onMessageCtx };
+        int8_t idx[MEO_ROUTER_MAX_ROUTES];
+        size_t found = _router.match(topic, topic_len, idx, MEO_ROUTER_MAX_ROUTES);
+        if (found > MEO_ROUTER_MAX_ROUTES) found = MEO_ROUTER_MAX_ROUTES;
+        for (size_t i = 0; i < found; ++i) {
+            const MeoTopicRouter::Route& r = _router.route(idx[i]);
+            OnMessageFn fn = r.fn ? r.fn : _onMessage;
+            void* ctx = r.fn ? r.ctx : _onMessageCtx;
+            // Route không handler trùng nhau thì handler mặc định chỉ nhận một lần
+            bool seen = false;
+            for (size_t j = 0; j < n && !seen; ++j) seen = (targets[j].fn == fn && targets[j].ctx == ctx);
+            if (fn && !seen) targets[n++] = Target{ fn, ctx };
+        }
+    }
+
+    if (n == 0) {
+        if (fallback.fn) fallback.fn(topic, topic_len, data, data_len, fallback.ctx);
+        return;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        targets[i].fn(topic, topic_len, data, data_len, targets[i].ctx);
+    }
+}
@@ -1,15 +1,121 @@
 #pragma once
 
+#include <atomic>
 #include <string>
 #include <cstring>
 #include "esp_log.h"
 #include "esp_event.h"
 #include <mqtt_client.h>
+#ifdef CONFIG_MQTT_PROTOCOL_5
+#include <mqtt5_client.h>
+#endif
 #include "Meo3_Type.h"   
+#include "Meo3_Log.h"
+#include "Meo3_Topic.h"   // MEO_TOPIC_MAX
+#include "Meo3_TopicRouter.h"
+#include "Meo3_Spsc.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#ifndef MEO_WILL_PAYLOAD_MAX
+#define MEO_WILL_PAYLOAD_MAX 64
+#endif
+// Giới hạn mặc định cho một message nhận về bị esp-mqtt chia nhỏ (ghép lại trên heap)
+#ifndef MEO_MQTT_RX_MAX_DEFAULT
+#define MEO_MQTT_RX_MAX_DEFAULT 8192
+#endif
+
+// MQTT 5 (cần CONFIG_MQTT_PROTOCOL_5): số topic alias client tự cấp cho mỗi kết nối,
+// số user property tối đa mỗi message, session expiry khi dùng persistent session
+#ifndef MEO_MQTT5_TOPIC_ALIASES
+#define MEO_MQTT5_TOPIC_ALIASES 8
+#endif
+#ifndef MEO_MQTT5_MAX_USER_PROPS
+#define MEO_MQTT5_MAX_USER_PROPS 4
+#endif
+#ifndef MEO_MQTT5_SESSION_EXPIRY_S
+#define MEO_MQTT5_SESSION_EXPIRY_S 3600
+#endif
+
+// User property MQTT 5 (view, chỉ cần sống trong lúc publish)
+struct MeoUserProperty {
+    const char* key;
+    const char* value;
+};
+
+// Tuỳ chọn publish; các trường MQTT 5 bị bỏ qua khi kết nối MQTT 3.1.1
+struct MeoPublishOptions {
+    uint8_t     qos        = 0;
+    bool        retained   = false;
+    bool        topicAlias = false;      // MQTT 5, chỉ cho QoS 0 khi đang kết nối
+    const char* contentType = nullptr;   // MQTT 5, vd "application/json"
+    const MeoUserProperty* userProps = nullptr;   // MQTT 5
+    uint8_t     userPropCount = 0;
+    uint32_t    cookie = 0;              // QoS > 0: trả lại cho MeoDeliveryFn khi có ack
+};
+
+// Kết quả publish trả về cho caller
+enum class MeoPublishResult : uint8_t {
+    Ok = 0,
+    NotConnected,   // QoS 0 khi mất kết nối / chưa có client
+    OutboxFull,     // vượt setOutboxLimit()
+    Rejected,       // MQTT 5: QoS / retain vượt giới hạn broker báo trong CONNACK
+    Failed
+};
+
+// Kết quả giao message QoS>0: delivered=true khi có PUBACK/PUBCOMP,
+// false khi esp-mqtt bỏ message khỏi outbox (hết hạn). cookie = MeoPublishOptions::cookie
+// (0 nếu không đặt, hoặc đã bị ghi đè khi có quá nhiều message chờ ack)
+typedef void (*MeoDeliveryFn)(int msgId, bool delivered, uint32_t cookie, void* ctx);
+
+// Số message QoS>0 có cookie được nhớ cùng lúc (luỹ thừa của 2)
+#ifndef MEO_MQTT_COOKIES
+#define MEO_MQTT_COOKIES 16
+#endif
+
+// Số chuyển trạng thái kết nối chờ MeoDevice đọc (luỹ thừa của 2)
+#ifndef MEO_MQTT_STATE_QUEUE
+#define MEO_MQTT_STATE_QUEUE 8
+#endif
+
+// Chuyển trạng thái do task esp-mqtt báo, đọc qua pollState()
+enum class MeoMqttStateKind : uint8_t {
+    Connected = 0,
+    Disconnected,
+    Refused        // CONNACK từ chối; code = reason code
+};
+struct MeoMqttStateEvent {
+    MeoMqttStateKind kind = MeoMqttStateKind::Disconnected;
+    uint8_t  code = 0;
+    uint32_t generation = 0;   // generation() tại thời điểm sự kiện
+};
+
+// Thống kê chiều nhận (chỉ task esp-mqtt ghi)
+struct MeoMqttRxStats {
+    uint32_t messages    = 0;  // message đã giao cho handler
+    uint32_t reassembled = 0;  // trong số đó, số message ghép từ nhiều fragment
+    uint32_t tooLarge    = 0;  // bỏ vì vượt maxMessageSize / topic quá dài
+    uint32_t dropped     = 0;  // bỏ vì fragment lệch thứ tự, thiếu hoặc hết bộ nhớ
+    uint32_t bufferBytes = 0;  // bộ nhớ ghép fragment đang giữ
+    uint32_t peakBytes   = 0;  // bufferBytes lớn nhất từng ghi nhận
+};
+
+// Thống kê chiều gửi (publish được gọi từ nhiều task)
+struct MeoMqttTxStats {
+    uint32_t published     = 0;  // esp-mqtt đã nhận khi đang kết nối
+    uint32_t storedOffline = 0;  // QoS>0 đưa vào outbox khi đang mất kết nối
+    uint32_t outboxFull    = 0;  // bị từ chối vì outbox vượt ngân sách
+    uint32_t rejected      = 0;  // MQTT 5: broker không chấp nhận tham số message
+    uint32_t aliased       = 0;  // MQTT 5: gửi bằng topic alias (không kèm topic)
+    uint32_t failed        = 0;  // lỗi khác / QoS 0 khi mất kết nối
+    uint32_t bytes         = 0;  // payload của published + storedOffline
+};
 
 class MeoMqttClient {
 public:
-    typedef void (*OnMessageFn)(const char* topic, const uint8_t* payload, unsigned int length, void* ctx);
+    // topic là view (không có '\0') vào buffer của esp-mqtt; payload luôn là message
+    // hoàn chỉnh. Cả hai chỉ hợp lệ trong lúc callback chạy.
+    typedef MeoMessageFn OnMessageFn;
 
     MeoMqttClient();
     ~MeoMqttClient(); 
@@ -17,6 +123,7 @@ public:
     // Logging
     void setLogger(MeoLogFunction logger);
     void setDebugTags(const char* tagsCsv);
+    void setLog(const MeoLog& log) { _log = log; }
 
     // Cấu hình Broker
     void configure(const char* host, uint16_t port = 1883);
@@ -29,10 +136,41 @@ public:
     void setKeepAlive(uint16_t seconds);    // Mặc định 120s trong IDF
     void setSocketTimeout(uint16_t seconds);// Network timeout
 
+    // Message lớn hơn buffer.size đến thành nhiều MQTT_EVENT_DATA; chúng được ghép
+    // lại vào một buffer cấp phát riêng, tối đa `bytes` (0 = bỏ mọi message bị chia nhỏ)
+    void setMaxMessageSize(size_t bytes) { _rxMax = bytes; }
+    size_t maxMessageSize() const { return _rxMax; }
+    MeoMqttRxStats rxStats() const { return _rxStats; }
+
+    // Persistent session: clean=false giữ subscription + message QoS>0 trên broker giữa
+    // các lần kết nối (client ID luôn ổn định: meo-{deviceId} hoặc theo MAC)
+    void setCleanSession(bool clean);
+    // Ngân sách bộ nhớ outbox của esp-mqtt (byte, 0 = không giới hạn). Khi vượt,
+    // publish QoS>0 bị từ chối thay vì chiếm thêm heap.
+    void setOutboxLimit(size_t bytes);
+    size_t outboxLimit() const { return _outboxLimit; }
+    // Số byte đang nằm trong outbox (chờ gửi / chờ PUBACK) - dùng để back-pressure
+    size_t outboxBytes();
+    MeoMqttTxStats txStats() const;
+
+    // Phiên bản giao thức: 4 (MQTT 3.1.1, mặc định) hoặc 5. Trả về false nếu esp-mqtt
+    // được build không có CONFIG_MQTT_PROTOCOL_5. Áp dụng từ lần connect sau.
+    bool setProtocolVersion(uint8_t version);
+    uint8_t protocolVersion() const { return _protocol; }
+    bool isMqtt5() const { return _protocol == 5; }
+
+    // Callback khi message QoS>0 được broker xác nhận hoặc bị bỏ (chạy trên task esp-mqtt).
+    // Đặt trước connect(): cặp fn/ctx không được đổi khi client đang chạy.
+    void setDeliveryHandler(MeoDeliveryFn fn, void* ctx);
+
+    // Tự reconnect của esp-mqtt (mặc định bật). MeoDevice tắt để tự lập lịch backoff + jitter.
+    void setAutoReconnect(bool enable);
+
     // LWT (Last Will and Testament)
     void setWill(const char* topic, const char* payload, uint8_t qos = 0, bool retain = true);
 
-    // Kết nối (Khởi động MQTT Task)
+    // Kết nối (Khởi động MQTT Task). Client handle được giữ lại giữa các lần gọi:
+    // lần sau chỉ cập nhật config (nếu đổi) và yêu cầu esp-mqtt reconnect.
     bool connect();
     
     // Ngắt kết nối
@@ -41,14 +179,38 @@ public:
     // Trong IDF, loop() không cần làm gì về mạng, nhưng giữ lại để tương thích logic cũ
     void loop();
 
-    bool isConnected();
+    // Đọc được từ mọi task/core: một word atomic gồm cờ connected + generation
+    bool isConnected() const { return _link.load(std::memory_order_acquire) & 1u; }
+    // Tăng mỗi lần MQTT_EVENT_CONNECTED: generation khác = phiên đã đổi (kể cả khi
+    // mất và có lại kết nối giữa hai lần kiểm tra, isConnected() vẫn true)
+    uint32_t generation() const { return _link.load(std::memory_order_acquire) >> 1; }
+    // Cả hai từ cùng một lần đọc: gọi isConnected() rồi generation() có thể thấy hai phiên khác nhau
+    bool linkState(uint32_t& generation) const {
+        uint32_t v = _link.load(std::memory_order_acquire);
+        generation = v >> 1;
+        return v & 1u;
+    }
+    // Consumer duy nhất (MeoDevice::loop): lấy chuyển trạng thái kế tiếp theo đúng thứ tự
+    bool pollState(MeoMqttStateEvent& ev) { return _states.pop(ev); }
+    uint32_t stateEventsDropped() const { return _states.dropped(); }
 
     // Publish / Subscribe
-    bool publish(const char* topic, const uint8_t* payload, size_t len, bool retained = false);
-    bool publish(const char* topic, const char* payload, bool retained = false);
-    bool subscribe(const char* topic, uint8_t qos = 0);
+    // QoS>0 khi mất kết nối: message vào outbox, gửi khi kết nối lại
+    bool publish(const char* topic, const uint8_t* payload, size_t len, bool retained = false, uint8_t qos = 0);
+    bool publish(const char* topic, const char* payload, bool retained = false, uint8_t qos = 0);
+    // Đầy đủ: tuỳ chọn MQTT 5 và lý do thất bại; msgId (nếu có) nhận message id để
+    // đối chiếu với MeoDeliveryFn (0 cho QoS 0)
+    MeoPublishResult publish(const char* topic, const uint8_t* payload, size_t len,
+                             const MeoPublishOptions& opt, int* msgId = nullptr);
+    // Đăng ký filter (có thể chứa '+'/'#') kèm handler riêng. Route được giữ lại và
+    // tự subscribe lại mỗi khi kết nối; khi chưa kết nối thì chỉ lưu route.
+    bool subscribe(const char* filter, OnMessageFn fn, void* ctx, uint8_t qos = 0);
+    // Không có handler riêng: message đi tới handler mặc định (setMessageHandler)
+    bool subscribe(const char* filter, uint8_t qos = 0);
+    bool unsubscribe(const char* filter, OnMessageFn fn = nullptr, void* ctx = nullptr);
 
-    // Set callback xử lý tin nhắn
+    // Handler mặc định: cho route không có handler và topic không khớp route nào.
+    // Đổi được khi đang chạy: cặp fn/ctx được thay dưới khoá router.
     void setMessageHandler(OnMessageFn fn, void* ctx);
 
     // Accessors
@@ -63,9 +225,9 @@ private:
     std::string _deviceId; // Username
     std::string _txKey;    // Password
     
-    // LWT
-    std::string _willTopic;
-    std::string _willPayload;
+    // LWT (buffer cố định: setWill được gọi lại mỗi lần reconnect, không cấp phát heap)
+    char        _willTopic[MEO_TOPIC_MAX] = {0};
+    char        _willPayload[MEO_WILL_PAYLOAD_MAX] = {0};
     uint8_t     _willQos = 0;
     bool        _willRetain = false;
     bool        _hasWill = false;
@@ -74,29 +236,89 @@ private:
     int         _keepAlive = 120;
     int         _networkTimeout = 10;
     int         _bufferSize = 1024;
+    bool        _autoReconnect = true;
+    bool        _cleanSession = true;
+    size_t      _outboxLimit = 0;
+    uint8_t     _protocol = 4;
+    bool        _configDirty = true;   // config đổi từ lần init/set_config trước
 
     // --- IDF Handles ---
     esp_mqtt_client_handle_t _client = NULL;
-    bool _connected = false;
+    // bit 0 = connected, bit 1.. = generation; task esp-mqtt ghi, mọi task đọc
+    std::atomic<uint32_t> _link{0};
+    // task esp-mqtt -> MeoDevice::loop()
+    MeoSpscQueue<MeoMqttStateEvent, MEO_MQTT_STATE_QUEUE> _states;
 
-    // Callbacks
+    // Callbacks (_onMessage/_onMessageCtx: chỉ đọc/ghi dưới _routerLock)
     OnMessageFn  _onMessage = nullptr;
     void*        _onMessageCtx = nullptr;
 
+    MeoDeliveryFn _onDelivery = nullptr;
+    void*         _onDeliveryCtx = nullptr;
+
+    // msg_id -> cookie of QoS>0 publishes awaiting ack, slot = msg_id % MEO_MQTT_COOKIES
+    struct PendingCookie {
+        std::atomic<int>      msgId{-1};
+        std::atomic<uint32_t> cookie{0};
+    };
+    PendingCookie _cookies[MEO_MQTT_COOKIES];
+
+#ifdef CONFIG_MQTT_PROTOCOL_5
+    // Publish property được esp-mqtt giữ trong client cho lần publish kế tiếp:
+    // set property + publish phải đi liền nhau giữa các task
+    SemaphoreHandle_t _pubLock = nullptr;
+    // Topic alias của kết nối hiện tại: alias = chỉ số + 1
+    char          _aliasTopics[MEO_MQTT5_TOPIC_ALIASES][MEO_TOPIC_MAX];
+    uint8_t       _aliasCount = 0;
+    uint8_t       _aliasLimit = MEO_MQTT5_TOPIC_ALIASES;  // hạ xuống nếu broker từ chối alias
+#endif
+
+    // Subscription router (app task thêm/bớt route, task esp-mqtt dispatch)
+    MeoTopicRouter    _router;
+    SemaphoreHandle_t _routerLock = nullptr;
+
+    // Ghép fragment (chỉ chạy trên task esp-mqtt nên không cần khóa)
+    size_t         _rxMax = MEO_MQTT_RX_MAX_DEFAULT;
+    uint8_t*       _rxBuf = nullptr;
+    size_t         _rxTotal = 0;
+    size_t         _rxGot = 0;
+    char           _rxTopic[MEO_TOPIC_MAX];
+    size_t         _rxTopicLen = 0;
+    MeoMqttRxStats _rxStats;
+
+    std::atomic<uint32_t> _txPublished{0};
+    std::atomic<uint32_t> _txStoredOffline{0};
+    std::atomic<uint32_t> _txOutboxFull{0};
+    std::atomic<uint32_t> _txFailed{0};
+    std::atomic<uint32_t> _txRejected{0};
+    std::atomic<uint32_t> _txAliased{0};
+    std::atomic<uint32_t> _txBytes{0};
+
     // Logging
-    MeoLogFunction _logger = nullptr;
-    char           _debugTags[96] = {0};
+    MeoLog         _log;
 
     // Static Event Handler (Bắt buộc cho IDF C-style callback)
     static void _mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_t event_id, void *event_data);
     
     // Internal Helper
     void _handleEvent(int32_t event_id, void *event_data);
-    void _invokeMessageHandler(const char* topic, int topic_len, const char* data, int data_len);
+    void _handleData(esp_mqtt_event_handle_t event);
+    void _rxReset();
+    void _invokeMessageHandler(const char* topic, size_t topic_len, const uint8_t* data, size_t data_len);
+    void _resubscribeAll();
+    void _pushState(MeoMqttStateKind kind, uint8_t code = 0);
+
+    int  _send(const char* topic, const uint8_t* payload, size_t len, uint8_t qos, bool retained,
+               bool connected);
+    void     _rememberCookie(int msgId, uint32_t cookie);
+    uint32_t _takeCookie(int msgId);
+#ifdef CONFIG_MQTT_PROTOCOL_5
+    int  _publish5(const char* topic, const uint8_t* payload, size_t len,
+                   const MeoPublishOptions& opt, uint8_t qos, bool connected);
+    void _applyConnectProperties();
+    void _aliasReset();
+#endif
 
-    bool _debugTagEnabled(const char* tag) const;
-    void _log(const char* level, const char* tag, const char* msg) const;
-    void _logf(const char* level, const char* tag, const char* fmt, ...) const;
+    bool _buildConfig(esp_mqtt_client_config_t& cfg, char* uri, size_t uriLen, std::string& clientId);
 
-    static MeoMqttClient* _self;
 };
\ No newline at end of file
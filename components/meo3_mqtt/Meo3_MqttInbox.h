@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "Meo3_Spsc.h"
+#include "Meo3_TopicRouter.h"   // MeoMessageFn, MEO_TOPIC_MAX
+
+// Số message chờ và kích thước payload tối đa của mỗi slot (luỹ thừa của 2 cho depth)
+#ifndef MEO_MQTT_INBOX_DEPTH
+#define MEO_MQTT_INBOX_DEPTH 8
+#endif
+#ifndef MEO_MQTT_INBOX_PAYLOAD_MAX
+#define MEO_MQTT_INBOX_PAYLOAD_MAX 256
+#endif
+
+// Một message đã copy khỏi buffer của esp-mqtt (topic có '\0')
+struct MeoInboxMessage {
+    char     topic[MEO_TOPIC_MAX];
+    uint16_t topicLen = 0;
+    uint16_t len = 0;
+    uint8_t  payload[MEO_MQTT_INBOX_PAYLOAD_MAX];
+};
+
+/**
+ * MeoMqttInbox: chuyển message từ task esp-mqtt sang loop() của ứng dụng, không khoá.
+ *
+ *   MeoMqttInbox inbox;
+ *   meo.subscribe("home/+/cmd", inbox);
+ *   ...
+ *   while (const MeoInboxMessage* m = inbox.peek()) { ...; inbox.release(); }
+ *
+ * - handler() chạy trên task esp-mqtt (producer duy nhất); peek()/release() chỉ từ một task.
+ * - Đầy hoặc message quá lớn: bỏ message và đếm, task esp-mqtt không bao giờ chờ.
+ */
+class MeoMqttInbox {
+public:
+    // Dùng làm MeoMessageFn với ctx = &inbox
+    static void handler(const char* topic, size_t topicLen,
+                        const uint8_t* payload, size_t length, void* ctx) {
+        static_cast<MeoMqttInbox*>(ctx)->_push(topic, topicLen, payload, length);
+    }
+
+    const MeoInboxMessage* peek() const { return _q.peek(); }
+    void release() { _q.release(); }
+    // Copy ra ngoài; tiện hơn peek() khi message được xử lý sau
+    bool pop(MeoInboxMessage& out) { return _q.pop(out); }
+
+    size_t   pending()  const { return _q.size(); }
+    uint32_t dropped()  const { return _q.dropped(); }
+    uint32_t tooLarge() const { return _tooLarge.load(std::memory_order_relaxed); }
+
+private:
+    MeoSpscQueue<MeoInboxMessage, MEO_MQTT_INBOX_DEPTH> _q;
+    std::atomic<uint32_t> _tooLarge{0};
+
+    void _push(const char* topic, size_t topicLen, const uint8_t* payload, size_t length) {
+        if (topicLen >= MEO_TOPIC_MAX || length > MEO_MQTT_INBOX_PAYLOAD_MAX) {
+            _tooLarge.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        MeoInboxMessage* m = _q.reserve();
+        if (!m) return;
+        memcpy(m->topic, topic, topicLen);
+        m->topic[topicLen] = '\0';
+        m->topicLen = (uint16_t)topicLen;
+        if (length) memcpy(m->payload, payload, length);
+        m->len = (uint16_t)length;
+        _q.publish();
+    }
+};
@@ -0,0 +1,197 @@
+#include "Meo3_TopicRouter.h"
+#include <cstring>
+
+namespace {
+// Level [pos, end) of s; returns end (index of '/' or len)
+size_t levelEnd(const char* s, size_t len, size_t pos) {
+    const void* slash = memchr(s + pos, '/', len - pos);
+    return slash ? (size_t)((const char*)slash - s) : len;
+}
+}
+
+void MeoTopicRouter::clear() {
+    for (size_t i = 0; i < MEO_ROUTER_MAX_ROUTES; ++i) {
+        _routes[i].used = false;
+        _routes[i].next = -1;
+        _routes[i].filter[0] = '\0';
+    }
+    _nodeCount = 0;
+    _newNode("", 0);  // root
+}
+
+bool MeoTopicRouter::validFilter(const char* filter) {
+    if (!filter || !*filter) return false;
+    size_t len = strlen(filter);
+    if (len >= MEO_TOPIC_MAX) return false;
+    for (size_t pos = 0;;) {
+        size_t end = levelEnd(filter, len, pos);
+        for (size_t i = pos; i < end; ++i) {
+            char c = filter[i];
+            if ((c == '+' || c == '#') && end - pos != 1) return false;
+        }
+        if (end - pos == 1 && filter[pos] == '#' && end != len) return false;
+        if (end == len) return true;
+        pos = end + 1;
+    }
+}
+
+int8_t MeoTopicRouter::_newNode(const char* seg, uint8_t len) {
+    if (_nodeCount >= MEO_ROUTER_MAX_NODES) return -1;
+    Node& n = _nodes[_nodeCount];
+    n.seg = seg;
+    n.segLen = len;
+    n.exact = n.multi = n.plus = n.child = n.sibling = -1;
+    return _nodeCount++;
+}
+
+bool MeoTopicRouter::_insert(int8_t routeIdx) {
+    Route& r = _routes[routeIdx];
+    const char* f = r.filter;
+    const size_t len = strlen(f);
+    int8_t node = 0;
+
+    for (size_t pos = 0;;) {
+        size_t end = levelEnd(f, len, pos);
+        size_t segLen = end - pos;
+
+        if (segLen == 1 && f[pos] == '#') {
+            r.next = _nodes[node].multi;
+            _nodes[node].multi = routeIdx;
+            return true;
+        }
+
+        int8_t next;
+        if (segLen == 1 && f[pos] == '+') {
+            next = _nodes[node].plus;
+            if (next < 0) {
+                next = _newNode(f + pos, 1);
+                if (next < 0) return false;
+                _nodes[node].plus = next;
+            }
+        } else {
+            next = _nodes[node].child;
+            while (next >= 0 && !(_nodes[next].segLen == segLen &&
+                                  memcmp(_nodes[next].seg, f + pos, segLen) == 0)) {
+                next = _nodes[next].sibling;
+            }
+            if (next < 0) {
+                next = _newNode(f + pos, (uint8_t)segLen);
+                if (next < 0) return false;
+                _nodes[next].sibling = _nodes[node].child;
+                _nodes[node].child = next;
+            }
+        }
+        node = next;
+
+        if (end == len) {
+            r.next = _nodes[node].exact;
+            _nodes[node].exact = routeIdx;
+            return true;
+        }
+        pos = end + 1;
+    }
+}
+
+void MeoTopicRouter::_rebuild() {
+    _nodeCount = 0;
+    _newNode("", 0);
+    for (size_t i = 0; i < MEO_ROUTER_MAX_ROUTES; ++i) {
+        _routes[i].next = -1;
+        // Đủ node cho các route này lúc add(), nên rebuild luôn thành công
+        if (_routes[i].used) _insert((int8_t)i);
+    }
+}
+
+int MeoTopicRouter::add(const char* filter, MeoMessageFn fn, void* ctx, uint8_t qos) {
+    if (!validFilter(filter)) return -1;
+
+    int free = -1;
+    for (size_t i = 0; i < MEO_ROUTER_MAX_ROUTES; ++i) {
+        Route& r = _routes[i];
+        if (!r.used) {
+            if (free < 0) free = (int)i;
+            continue;
+        }
+        if (r.fn == fn && r.ctx == ctx && strcmp(r.filter, filter) == 0) {
+            r.qos = qos;
+            return (int)i;
+        }
+    }
+    if (free < 0) return -1;
+
+    Route& r = _routes[free];
+    memcpy(r.filter, filter, strlen(filter) + 1);
+    r.fn   = fn;
+    r.ctx  = ctx;
+    r.qos  = qos;
+    r.used = true;
+    r.next = -1;
+    if (!_insert((int8_t)free)) {
+        // Hết node: bỏ route và dựng lại trie (xóa các node đã thêm dở)
+        r.used = false;
+        _rebuild();
+        return -1;
+    }
+    return free;
+}
+
+bool MeoTopicRouter::remove(const char* filter, MeoMessageFn fn, void* ctx) {
+    if (!filter) return false;
+    for (size_t i = 0; i < MEO_ROUTER_MAX_ROUTES; ++i) {
+        Route& r = _routes[i];
+        if (r.used && r.fn == fn && r.ctx == ctx && strcmp(r.filter, filter) == 0) {
+            r.used = false;
+            _rebuild();
+            return true;
+        }
+    }
+    return false;
+}
+
+bool MeoTopicRouter::hasFilter(const char* filter) const {
+    if (!filter) return false;
+    for (size_t i = 0; i < MEO_ROUTER_MAX_ROUTES; ++i) {
+        if (_routes[i].used && strcmp(_routes[i].filter, filter) == 0) return true;
+    }
+    return false;
+}
+
+size_t MeoTopicRouter::match(const char* topic, size_t topicLen, int8_t* out, size_t maxOut) const {
+    if (!topic || topicLen == 0) return 0;
+    MatchCtx m{ topic, topicLen, out, maxOut, 0 };
+    _match(0, 0, false, m);
+    return m.count;
+}
+
+void MeoTopicRouter::_collect(int8_t head, MatchCtx& m) const {
+    for (int8_t r = head; r >= 0; r = _routes[r].next) {
+        if (m.count < m.maxOut) m.out[m.count] = r;
+        m.count++;
+    }
+}
+
+void MeoTopicRouter::_match(int8_t node, size_t pos, bool atEnd, MatchCtx& m) const {
+    const Node& n = _nodes[node];
+    if (atEnd) {
+        _collect(n.exact, m);
+        _collect(n.multi, m);   // "a/#" cũng khớp "a"
+        return;
+    }
+
+    // Topic hệ thống ($SYS/...) không khớp wildcard ở level đầu
+    const bool wild = !(node == 0 && m.topic[0] == '$');
+    if (wild) _collect(n.multi, m);
+
+    size_t end = levelEnd(m.topic, m.len, pos);
+    size_t segLen = end - pos;
+    size_t nextPos = end + 1;
+    bool   nextEnd = (end == m.len);
+
+    for (int8_t c = n.child; c >= 0; c = _nodes[c].sibling) {
+        if (_nodes[c].segLen == segLen && memcmp(_nodes[c].seg, m.topic + pos, segLen) == 0) {
+            _match(c, nextPos, nextEnd, m);
+            break;  // literal con là duy nhất
+        }
+    }
+    if (wild && n.plus >= 0) _match(n.plus, nextPos, nextEnd, m);
+}
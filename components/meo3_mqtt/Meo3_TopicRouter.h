@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Meo3_Topic.h"   // MEO_TOPIC_MAX
+
+// Số subscription và số node trie tối đa (cấp phát tĩnh trong router)
+#ifndef MEO_ROUTER_MAX_ROUTES
+#define MEO_ROUTER_MAX_ROUTES 8
+#endif
+#ifndef MEO_ROUTER_MAX_NODES
+#define MEO_ROUTER_MAX_NODES 48
+#endif
+
+// Handler cho một message; topic là view (không có '\0')
+typedef void (*MeoMessageFn)(const char* topic, size_t topicLen,
+                             const uint8_t* payload, size_t length, void* ctx);
+
+/**
+ * MeoTopicRouter: ánh xạ topic filter MQTT (có '+' và '#') tới handler.
+ * - Filter được biên dịch thành trie theo level lúc add(); match() đi một lượt
+ *   theo topic, chỉ rẽ nhánh ở node '+', nên chi phí tỉ lệ với độ dài topic.
+ * - Nhiều route có thể dùng chung một filter (vd. hai module cùng nghe invoke).
+ * - Topic bắt đầu bằng '$' không khớp wildcard ở level đầu (theo chuẩn MQTT).
+ * - Không tự khóa: MeoMqttClient giữ mutex khi gọi.
+ */
+class MeoTopicRouter {
+public:
+    struct Route {
+        char         filter[MEO_TOPIC_MAX];
+        MeoMessageFn fn;
+        void*        ctx;
+        uint8_t      qos;
+        bool         used;
+        int8_t       next;   // route kế tiếp kết thúc ở cùng node
+    };
+
+    MeoTopicRouter() { clear(); }
+
+    void clear();
+
+    // '+' và '#' phải chiếm trọn một level, '#' chỉ ở cuối
+    static bool validFilter(const char* filter);
+
+    // Chỉ số route, hoặc -1 (filter sai / hết chỗ). Cùng filter + fn + ctx thì cập nhật qos.
+    int  add(const char* filter, MeoMessageFn fn, void* ctx, uint8_t qos);
+    bool remove(const char* filter, MeoMessageFn fn, void* ctx);
+
+    // Ghi chỉ số các route khớp vào out (tối đa maxOut); trả về số route khớp
+    size_t match(const char* topic, size_t topicLen, int8_t* out, size_t maxOut) const;
+
+    // Còn route nào khác dùng filter này không
+    bool hasFilter(const char* filter) const;
+
+    const Route& route(size_t i) const { return _routes[i]; }
+    static constexpr size_t capacity() { return MEO_ROUTER_MAX_ROUTES; }
+
+private:
+    struct Node {
+        const char* seg;       // view vào Route::filter
+        uint8_t     segLen;
+        int8_t      exact;     // route kết thúc tại node này
+        int8_t      multi;     // route có '#' ngay sau node này
+        int8_t      plus;      // node con '+'
+        int8_t      child;     // node con literal đầu tiên
+        int8_t      sibling;
+    };
+    static_assert(MEO_ROUTER_MAX_NODES < 127 && MEO_ROUTER_MAX_ROUTES < 127,
+                  "MeoTopicRouter uses int8_t indices");
+
+    Route  _routes[MEO_ROUTER_MAX_ROUTES];
+    Node   _nodes[MEO_ROUTER_MAX_NODES];
+    int8_t _nodeCount = 0;
+
+    int8_t _newNode(const char* seg, uint8_t len);
+    bool   _insert(int8_t routeIdx);
+    void   _rebuild();
+
+    struct MatchCtx {
+        const char* topic;
+        size_t      len;
+        int8_t*     out;
+        size_t      maxOut;
+        size_t      count;
+    };
+    void _collect(int8_t head, MatchCtx& m) const;
+    void _match(int8_t node, size_t pos, bool atEnd, MatchCtx& m) const;
+};
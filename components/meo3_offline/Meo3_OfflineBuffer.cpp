@@ -0,0 +1,313 @@
+#include "Meo3_OfflineBuffer.h"
+#include <cstring>
+#include <new>
+
+namespace {
+// Giữ mutex trong phạm vi một hàm
+struct LockGuard {
+    SemaphoreHandle_t h;
+    explicit LockGuard(SemaphoreHandle_t m) : h(m) { xSemaphoreTake(h, portMAX_DELAY); }
+    ~LockGuard() { xSemaphoreGive(h); }
+};
+}
+
+MeoOfflineBuffer::MeoOfflineBuffer() {}
+
+MeoOfflineBuffer::~MeoOfflineBuffer() {
+    end();
+}
+
+bool MeoOfflineBuffer::begin(const MeoOfflineConfig& cfg) {
+    if (_ram) return true;
+
+    _cfg = cfg;
+    // RAM phải chứa được ít nhất một bản ghi lớn nhất
+    const size_t minRam = RAM_HDR + MEO_SPOOL_TOPIC_MAX + MEO_SPOOL_PAYLOAD_MAX;
+    if (_cfg.ramBytes < minRam) _cfg.ramBytes = minRam;
+
+    _lock    = xSemaphoreCreateMutex();
+    _ram     = new (std::nothrow) uint8_t[_cfg.ramBytes];
+    _scratch = new (std::nothrow) uint8_t[MEO_SPOOL_TOPIC_MAX + 1 + MEO_SPOOL_PAYLOAD_MAX];
+    if (_cfg.useFlash) {
+        _spillBuf = new (std::nothrow) uint8_t[MEO_SPOOL_TOPIC_MAX + MEO_SPOOL_PAYLOAD_MAX];
+    }
+    if (!_lock || !_ram || !_scratch || (_cfg.useFlash && !_spillBuf)) {
+        end();
+        return false;
+    }
+
+    _part = nullptr;
+    if (_cfg.useFlash) {
+        const esp_partition_t* p = esp_partition_find_first(
+            ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)MEO_SPOOL_PARTITION_SUBTYPE,
+            MEO_SPOOL_PARTITION_LABEL);
+        size_t sector = (p && p->erase_size) ? p->erase_size : 4096;
+        // Cần tối thiểu 2 sector để log vòng hoạt động
+        if (p && p->size >= 2 * sector) {
+            _part   = p;
+            _sector = sector;
+        }
+    }
+
+    _ramHead = _ramTail = _ramUsed = 0;
+    _ramCount = 0;
+    _flashRead = _flashWrite = 0;
+    _flashCount = 0;
+    _peeked = false;
+    return true;
+}
+
+void MeoOfflineBuffer::end() {
+    delete[] _ram;
+    delete[] _scratch;
+    delete[] _spillBuf;
+    _ram = nullptr;
+    _scratch = nullptr;
+    _spillBuf = nullptr;
+    _part = nullptr;
+    if (_lock) {
+        vSemaphoreDelete(_lock);
+        _lock = nullptr;
+    }
+}
+
+bool MeoOfflineBuffer::push(const char* topic, const uint8_t* payload, size_t len, uint8_t tag) {
+    if (!_ram || !topic) return false;
+    size_t tlen = strlen(topic);
+    if (tlen == 0 || tlen > MEO_SPOOL_TOPIC_MAX || len > MEO_SPOOL_PAYLOAD_MAX) return false;
+
+    LockGuard g(_lock);
+    const size_t need = RAM_HDR + tlen + len;
+
+    while (_cfg.ramBytes - _ramUsed < need) {
+        if (_part && _spillOldestToFlash()) continue;
+        if (_cfg.dropPolicy == MeoDropPolicy::DropNewest) {
+            _dropped++;
+            return false;
+        }
+        _ramDropOldest();
+        _dropped++;
+        if (!_peekFlash) _peeked = false;   // bản ghi đã peek không còn nữa
+    }
+
+    uint16_t hdr[3] = { (uint16_t)tlen, (uint16_t)len, tag };
+    _ramWrite(hdr, RAM_HDR);
+    _ramWrite(topic, tlen);
+    if (len) _ramWrite(payload, len);
+    _ramCount++;
+    _stored++;
+    return true;
+}
+
+bool MeoOfflineBuffer::peek(const char*& topic, const uint8_t*& payload, size_t& len, uint8_t& tag) {
+    if (!_ram) return false;
+    LockGuard g(_lock);
+
+    uint16_t tlen = 0, plen = 0, rtag = 0;
+    if (_flashCount > 0 && _flashPeekHeader(tlen, plen, rtag)) {
+        if (esp_partition_read(_part, _flashRead + FLASH_HDR, _scratch, tlen) != ESP_OK ||
+            (plen && esp_partition_read(_part, _flashRead + FLASH_HDR + tlen,
+                                        _scratch + tlen + 1, plen) != ESP_OK)) {
+            return false;
+        }
+        _peekFlash = true;
+        _peekSize  = _flashRecordSize(tlen, plen);
+    } else if (_ramCount > 0 && _ramPeekHeader(tlen, plen, rtag)) {
+        _ramRead(_ramHead + RAM_HDR, _scratch, tlen);
+        _ramRead(_ramHead + RAM_HDR + tlen, _scratch + tlen + 1, plen);
+        _peekFlash = false;
+        _peekSize  = RAM_HDR + tlen + plen;
+    } else {
+        return false;
+    }
+
+    _scratch[tlen] = '\0';
+    topic   = (const char*)_scratch;
+    payload = _scratch + tlen + 1;
+    len     = plen;
+    tag     = (uint8_t)rtag;
+    _peeked = true;
+    return true;
+}
+
+void MeoOfflineBuffer::pop() {
+    if (!_ram) return;
+    LockGuard g(_lock);
+    // Bản ghi đã peek có thể vừa bị spill/drop bởi push(); khi đó không pop nhầm bản ghi khác
+    if (!_peeked) return;
+    _peeked = false;
+
+    if (_peekFlash) {
+        if (_flashCount == 0) return;
+        _flashRead += _peekSize;
+        if (_flashRead >= _part->size / _sector * _sector) _flashRead = 0;
+        if (--_flashCount == 0) _flashRead = _flashWrite;
+    } else {
+        if (_ramCount == 0) return;
+        _ramHead = (_ramHead + _peekSize) % _cfg.ramBytes;
+        _ramUsed -= _peekSize;
+        _ramCount--;
+    }
+    _replayed++;
+}
+
+bool MeoOfflineBuffer::empty() const {
+    return _ramCount == 0 && _flashCount == 0;
+}
+
+MeoOfflineStats MeoOfflineBuffer::stats() const {
+    MeoOfflineStats st;
+    if (!_lock) return st;
+    LockGuard g(_lock);
+    st.stored   = _stored;
+    st.replayed = _replayed;
+    st.spilled  = _spilled;
+    st.dropped  = _dropped;
+    st.ramRecords   = _ramCount;
+    st.flashRecords = _flashCount;
+    st.flashAvailable = (_part != nullptr);
+    return st;
+}
+
+// --- RAM ring ---
+
+void MeoOfflineBuffer::_ramWrite(const void* src, size_t n) {
+    const uint8_t* s = (const uint8_t*)src;
+    size_t first = _cfg.ramBytes - _ramTail;
+    if (first > n) first = n;
+    memcpy(_ram + _ramTail, s, first);
+    memcpy(_ram, s + first, n - first);
+    _ramTail = (_ramTail + n) % _cfg.ramBytes;
+    _ramUsed += n;
+}
+
+void MeoOfflineBuffer::_ramRead(size_t off, void* dst, size_t n) const {
+    uint8_t* d = (uint8_t*)dst;
+    off %= _cfg.ramBytes;
+    size_t first = _cfg.ramBytes - off;
+    if (first > n) first = n;
+    memcpy(d, _ram + off, first);
+    memcpy(d + first, _ram, n - first);
+}
+
+bool MeoOfflineBuffer::_ramPeekHeader(uint16_t& tlen, uint16_t& plen, uint16_t& tag) const {
+    if (_ramCount == 0) return false;
+    uint16_t hdr[3];
+    _ramRead(_ramHead, hdr, RAM_HDR);
+    tlen = hdr[0];
+    plen = hdr[1];
+    tag  = hdr[2];
+    return true;
+}
+
+void MeoOfflineBuffer::_ramDropOldest() {
+    uint16_t tlen, plen, tag;
+    if (!_ramPeekHeader(tlen, plen, tag)) return;
+    size_t n = RAM_HDR + tlen + plen;
+    _ramHead = (_ramHead + n) % _cfg.ramBytes;
+    _ramUsed -= n;
+    _ramCount--;
+}
+
+// --- Flash log vòng ---
+// Bản ghi không vắt qua ranh giới sector; phần dư cuối sector để nguyên 0xFF (đã erase).
+
+size_t MeoOfflineBuffer::_flashRecordSize(uint16_t tlen, uint16_t plen) const {
+    return (FLASH_HDR + tlen + plen + 3) & ~(size_t)3;
+}
+
+bool MeoOfflineBuffer::_flashPeekHeader(uint16_t& tlen, uint16_t& plen, uint16_t& tag) {
+    const size_t total = _part->size / _sector * _sector;
+    // Tối đa đi qua mỗi sector một lần để bỏ phần dư cuối sector
+    for (size_t guard = 0; guard <= total / _sector; ++guard) {
+        size_t inSector = _flashRead % _sector;
+        if (_sector - inSector >= FLASH_HDR) {
+            uint16_t hdr[4];
+            if (esp_partition_read(_part, _flashRead, hdr, FLASH_HDR) != ESP_OK) return false;
+            if (hdr[0] == FLASH_MAGIC) {
+                tlen = hdr[1];
+                plen = hdr[2];
+                tag  = hdr[3];
+                return true;
+            }
+        }
+        _flashRead = (_flashRead - inSector + _sector) % total;
+    }
+    // Log hỏng: bỏ toàn bộ phần trên flash
+    _dropped += _flashCount;
+    _flashCount = 0;
+    _flashRead = _flashWrite;
+    return false;
+}
+
+void MeoOfflineBuffer::_flashDropSector(size_t sectorStart) {
+    const size_t total = _part->size / _sector * _sector;
+    size_t off = _flashRead;
+    while (_flashCount > 0 && off - sectorStart + FLASH_HDR <= _sector) {
+        uint16_t hdr[4];
+        if (esp_partition_read(_part, off, hdr, FLASH_HDR) != ESP_OK || hdr[0] != FLASH_MAGIC) break;
+        off += _flashRecordSize(hdr[1], hdr[2]);
+        _flashCount--;
+        _dropped++;
+    }
+    _flashRead = (sectorStart + _sector) % total;
+    if (_flashCount == 0) _flashRead = _flashWrite;
+    if (_peekFlash) _peeked = false;
+}
+
+bool MeoOfflineBuffer::_flashAppend(const uint8_t* rec, uint16_t tlen, uint16_t plen, uint16_t tag) {
+    const size_t total = _part->size / _sector * _sector;
+    const size_t n = _flashRecordSize(tlen, plen);
+    const size_t savedWrite = _flashWrite;
+
+    size_t inSector = _flashWrite % _sector;
+    if (inSector != 0 && inSector + n > _sector) {
+        _flashWrite = (_flashWrite - inSector + _sector) % total;
+        inSector = 0;
+    }
+
+    if (inSector == 0) {
+        // Sector mới: nếu reader còn dữ liệu trong sector này thì flash đã đầy
+        if (_flashCount > 0 && _flashRead / _sector == _flashWrite / _sector) {
+            if (_cfg.dropPolicy == MeoDropPolicy::DropNewest) {
+                _flashWrite = savedWrite;
+                return false;
+            }
+            _flashDropSector(_flashWrite);
+        }
+        if (esp_partition_erase_range(_part, _flashWrite, _sector) != ESP_OK) {
+            _flashWrite = savedWrite;
+            return false;
+        }
+    }
+
+    uint16_t hdr[4] = { FLASH_MAGIC, tlen, plen, tag };
+    if (esp_partition_write(_part, _flashWrite, hdr, FLASH_HDR) != ESP_OK ||
+        esp_partition_write(_part, _flashWrite + FLASH_HDR, rec, tlen + plen) != ESP_OK) {
+        return false;
+    }
+
+    if (_flashCount == 0) _flashRead = _flashWrite;
+    _flashWrite = (_flashWrite + n) % total;
+    _flashCount++;
+    return true;
+}
+
+bool MeoOfflineBuffer::_spillOldestToFlash() {
+    uint16_t tlen, plen, tag;
+    if (!_ramPeekHeader(tlen, plen, tag)) return false;
+
+    // topic + payload liền nhau; buffer riêng để không đè lên bản ghi đang peek
+    _ramRead(_ramHead + RAM_HDR, _spillBuf, (size_t)tlen + plen);
+    if (!_flashAppend(_spillBuf, tlen, plen, tag)) return false;
+
+    _ramDropOldest();
+    _spilled++;
+    // Bản ghi RAM đã peek là đầu RAM (flash rỗng lúc peek) nên nó là bản ghi flash cũ nhất:
+    // chuyển peek theo để pop() bỏ đúng nó thay vì no-op rồi phát lại lần nữa
+    if (_peeked && !_peekFlash) {
+        _peekFlash = true;
+        _peekSize  = _flashRecordSize(tlen, plen);
+    }
+    return true;
+}
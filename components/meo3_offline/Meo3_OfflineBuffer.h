@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_partition.h"
+
+// Giới hạn kích thước một bản ghi (topic + payload)
+#ifndef MEO_SPOOL_TOPIC_MAX
+#define MEO_SPOOL_TOPIC_MAX 128
+#endif
+#ifndef MEO_SPOOL_PAYLOAD_MAX
+#define MEO_SPOOL_PAYLOAD_MAX 512
+#endif
+#ifndef MEO_SPOOL_PARTITION_LABEL
+#define MEO_SPOOL_PARTITION_LABEL "meo_spool"
+#endif
+#ifndef MEO_SPOOL_PARTITION_SUBTYPE
+#define MEO_SPOOL_PARTITION_SUBTYPE 0x40
+#endif
+
+// Chính sách khi buffer (RAM + flash) đã đầy
+enum class MeoDropPolicy : uint8_t {
+    DropOldest = 0,  // Bỏ bản ghi cũ nhất để nhận bản ghi mới
+    DropNewest       // Từ chối bản ghi mới
+};
+
+struct MeoOfflineConfig {
+    size_t        ramBytes        = 4096;   // Dung lượng ring buffer trong RAM
+    bool          useFlash        = true;   // Tràn xuống partition MEO_SPOOL_PARTITION_LABEL
+    MeoDropPolicy dropPolicy      = MeoDropPolicy::DropOldest;
+    uint16_t      replayPerSecond = 10;     // Tốc độ phát lại sau khi có kết nối
+};
+
+struct MeoOfflineStats {
+    uint32_t stored   = 0;  // Số bản ghi đã nhận vào buffer
+    uint32_t replayed = 0;  // Số bản ghi đã phát lại thành công
+    uint32_t spilled  = 0;  // Số bản ghi chuyển từ RAM xuống flash
+    uint32_t dropped  = 0;  // Số bản ghi bị bỏ theo dropPolicy
+    uint32_t ramRecords   = 0;
+    uint32_t flashRecords = 0;
+    bool     flashAvailable = false;
+};
+
+/**
+ * MeoOfflineBuffer: store-and-forward cho event khi MQTT mất kết nối.
+ * - Bản ghi mới vào ring buffer RAM; khi RAM đầy, bản ghi cũ nhất được chuyển
+ *   xuống partition flash (log vòng theo sector) nên thứ tự luôn được giữ.
+ * - peek()/pop() luôn trả bản ghi cũ nhất: flash trước, rồi tới RAM.
+ * - Flash chỉ làm vùng tràn trong một lần chạy, dữ liệu không được khôi phục sau reboot.
+ */
+class MeoOfflineBuffer {
+public:
+    MeoOfflineBuffer();
+    ~MeoOfflineBuffer();
+
+    bool begin(const MeoOfflineConfig& cfg);
+    void end();
+    bool isEnabled() const { return _ram != nullptr; }
+
+    const MeoOfflineConfig& config() const { return _cfg; }
+
+    // Lưu một message; trả về false nếu bị từ chối (quá lớn / DropNewest khi đầy).
+    // tag: giá trị tuỳ ý của caller đi cùng bản ghi (MeoDevice: codec của payload)
+    bool push(const char* topic, const uint8_t* payload, size_t len, uint8_t tag = 0);
+
+    // Xem bản ghi cũ nhất; con trỏ trỏ vào scratch nội bộ, hợp lệ tới lần gọi peek/pop kế tiếp
+    bool peek(const char*& topic, const uint8_t*& payload, size_t& len, uint8_t& tag);
+    // Bỏ bản ghi cũ nhất (gọi sau khi publish bản ghi peek() thành công)
+    void pop();
+
+    bool empty() const;
+    MeoOfflineStats stats() const;
+
+private:
+    // Header bản ghi trong RAM: [topicLen u16][payloadLen u16][tag u16]
+    static const size_t   RAM_HDR    = 6;
+    // Header bản ghi trên flash: [magic u16][topicLen u16][payloadLen u16][tag u16]
+    static const size_t   FLASH_HDR  = 8;
+    static const uint16_t FLASH_MAGIC = 0x4D53; // "MS"
+
+    MeoOfflineConfig _cfg;
+    SemaphoreHandle_t _lock = nullptr;
+
+    // RAM ring
+    uint8_t* _ram      = nullptr;
+    size_t   _ramHead  = 0;  // đọc
+    size_t   _ramTail  = 0;  // ghi
+    size_t   _ramUsed  = 0;
+    uint32_t _ramCount = 0;
+
+    // Flash log vòng
+    const esp_partition_t* _part = nullptr;
+    size_t   _sector     = 4096;
+    size_t   _flashRead  = 0;
+    size_t   _flashWrite = 0;
+    uint32_t _flashCount = 0;
+
+    // Scratch cho peek (topic + '\0' + payload)
+    uint8_t* _scratch  = nullptr;
+    bool     _peeked   = false;
+    bool     _peekFlash = false;
+    size_t   _peekSize = 0;   // kích thước bản ghi đã peek (để pop)
+    uint8_t* _spillBuf = nullptr;
+
+    uint32_t _stored = 0, _replayed = 0, _spilled = 0, _dropped = 0;
+
+    // RAM helpers
+    void   _ramWrite(const void* src, size_t n);
+    void   _ramRead(size_t off, void* dst, size_t n) const;
+    bool   _ramPeekHeader(uint16_t& tlen, uint16_t& plen, uint16_t& tag) const;
+    void   _ramDropOldest();
+
+    // Flash helpers
+    bool   _flashAppend(const uint8_t* rec, uint16_t tlen, uint16_t plen, uint16_t tag);
+    bool   _flashPeekHeader(uint16_t& tlen, uint16_t& plen, uint16_t& tag);
+    void   _flashDropSector(size_t sectorStart);
+    size_t _flashRecordSize(uint16_t tlen, uint16_t plen) const;
+
+    bool   _spillOldestToFlash();
+};
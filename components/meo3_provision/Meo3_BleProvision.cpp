@@ -1,22 +1,18 @@
 #include "Meo3_BleProvision.h"
-#include <stdarg.h>
 
 MeoBleProvision::MeoBleProvision() : _ble(nullptr), _storage(nullptr), _svc(nullptr),
     _chSsid(nullptr), _chPass(nullptr), _chModel(nullptr), _chManuf(nullptr),
     _chDevId(nullptr), _chTxKey(nullptr), _chProg(nullptr), _autoReboot(true),
     _rebootDelayMs(300), _ssidWritten(false), _passWritten(false),
-    _rebootScheduled(false), _rebootAtMs(0), _logger(nullptr) {
-    _debugTags[0] = '\0';
+    _rebootScheduled(false), _rebootAtMs(0) {
     _statusBuf[0] = '\0';
 }
 
 void MeoBleProvision::setLogger(MeoLogFunction logger) {
-    _logger = logger;
+    _log.setSink(logger);
 }
 void MeoBleProvision::setDebugTags(const char* tagsCsv) {
-    if (!tagsCsv) { _debugTags[0] = '\0'; return; }
-    strncpy(_debugTags, tagsCsv, sizeof(_debugTags) - 1);
-    _debugTags[sizeof(_debugTags) - 1] = '\0';
+    _log.setDebugTags(tagsCsv);
 }
 
 bool MeoBleProvision::begin(MeoBle* ble, MeoStorage* storage,
@@ -31,7 +27,7 @@ bool MeoBleProvision::begin(MeoBle* ble, MeoStorage* storage,
     _svc->start();
     _loadInitialValues();
     _updateStatus();
-    _logger("INFO", "BLE Provisioning service started");
+    MEO_LOGI(_log, PROV, "BLE Provisioning service started");
     return true;
 }
 
@@ -70,7 +66,7 @@ void MeoBleProvision::loop() {
     }
     // Execute scheduled reboot
     if (_autoReboot && _rebootScheduled && millis() >= _rebootAtMs) {
-        _logger("INFO", "Reboot now");
+        MEO_LOGI(_log, PROV, "Reboot now");
         delay(100);
         ESP.restart();
     }
@@ -99,7 +95,7 @@ void MeoBleProvision::_scheduleRebootIfReady() {
     if (_ssidWritten && _passWritten && !_rebootScheduled) {
         _rebootScheduled = true;
         _rebootAtMs = millis() + _rebootDelayMs;
-        _logger("INFO", "Provisioning complete; scheduling reboot");
+        MEO_LOGI(_log, PROV, "Provisioning complete; scheduling reboot");
     }
 }
 
@@ -116,25 +112,25 @@ void MeoBleProvision::_onWrite(BLECharacteristic* ch) {
     if (uuid.equals(BLEUUID(CH_UUID_WIFI_SSID))) {
         _storage->saveString("wifi_ssid", std::string(s.c_str()));
         _ssidWritten = true;
-        _logger("INFO", "SSID updated");
+        MEO_LOGI(_log, PROV, "SSID updated");
         _scheduleRebootIfReady();
         return;
     }
     if (uuid.equals(BLEUUID(CH_UUID_WIFI_PASS))) {
         _storage->saveString("wifi_pass", std::string(s.c_str()));
         _passWritten = true;
-        _logger("INFO", "PASS updated");
+        MEO_LOGI(_log, PROV, "PASS updated");
         _scheduleRebootIfReady();
         return;
     }
     if (uuid.equals(BLEUUID(CH_UUID_DEV_ID))) {
         _storage->saveString("device_id", std::string(s.c_str()));
-        _logger("INFO", "Device ID updated");
+        MEO_LOGI(_log, PROV, "Device ID updated");
         return;
     }
     if (uuid.equals(BLEUUID(CH_UUID_TX_KEY))) {
         _storage->saveString("tx_key", std::string(s.c_str()));
-        _logger("INFO", "Transmit Key updated");
+        MEO_LOGI(_log, PROV, "Transmit Key updated");
         return;
     }
 }
@@ -147,17 +143,5 @@ void MeoBleProvision::_updateStatus() {
         _chProg->setValue(_statusBuf);
         _chProg->notify();
     }
-    if (_logger && _debugTagEnabled("PROV")) {
-        _logger("DEBUG", _statusBuf);
-    }
+    MEO_LOGD(_log, PROV, "%s", _statusBuf);
 }
-
-bool MeoBleProvision::_debugTagEnabled(const char* tag) const {
-    if (!_debugTags[0]) return false;
-    const char* p = strstr(_debugTags, tag);
-    if (!p) return false;
-    bool leftOk  = (p == _debugTags) || (*(p - 1) == ',');
-    const char* end = p + strlen(tag);
-    bool rightOk = (*end == '\0') || (*end == ',');
-    return leftOk && rightOk;
-}
\ No newline at end of file
@@ -6,6 +6,7 @@
 #include "Meo3_Storage.h"
 #include "Meo3_Ble.h" // Giả sử class này wrap việc init NimBLE
 #include "Meo3_Type.h"
+#include "Meo3_Log.h"
 
 // Arduino BLE includes
 #include <BLEDevice.h>
@@ -29,6 +30,7 @@ public:
 
     void setLogger(MeoLogFunction logger);
     void setDebugTags(const char* tagsCsv);
+    void setLog(const MeoLog& log) { _log = log; }
 
     bool begin(MeoBle* ble, MeoStorage* storage,
                const char* devModel, const char* devManufacturer);
@@ -75,8 +77,7 @@ private:
     uint32_t            _rebootAtMs = 0;
 
     // Logging
-    MeoLogFunction _logger = nullptr;
-    char           _debugTags[96] = {0};
+    MeoLog _log;
 
     // Internal methods
     bool _createServiceAndCharacteristics();
@@ -86,6 +87,4 @@ private:
     void _onWrite(BLECharacteristic* ch);
     void _updateStatus();
     void _scheduleRebootIfReady();
-    bool _debugTagEnabled(const char* tag) const;
-    void _log(const char* level, const char* tag, const char* msg) const;
 };
\ No newline at end of file
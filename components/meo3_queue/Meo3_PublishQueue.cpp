@@ -0,0 +1,231 @@
+#include "Meo3_PublishQueue.h"
+#include <cstring>
+#include <new>
+
+MeoPublishQueue::MeoPublishQueue() {}
+
+MeoPublishQueue::~MeoPublishQueue() {
+    end();
+}
+
+bool MeoPublishQueue::begin(MeoMqttClient* mqtt, uint8_t depth, BaseType_t core,
+                            UBaseType_t priority, uint32_t stackSize) {
+    if (_taskAlive.load(std::memory_order_acquire)) return true;
+    if (!mqtt || depth == 0 || depth >= STOP_TOKEN) return false;
+
+    _mqtt  = mqtt;
+    _depth = depth;
+
+    // Cấp phát một lần duy nhất, không cấp phát thêm trên hot path
+    _slots  = new (std::nothrow) Slot[depth];
+    _freeQ  = xQueueCreate(depth, sizeof(uint8_t));
+    _readyQ = xQueueCreate(depth + 1, sizeof(uint8_t)); // +1 cho STOP_TOKEN
+    if (!_slots || !_freeQ || !_readyQ) {
+        _release();
+        return false;
+    }
+
+    for (uint8_t i = 0; i < depth; ++i) {
+        xQueueSend(_freeQ, &i, 0);
+    }
+
+    _taskAlive.store(true, std::memory_order_release);
+    if (xTaskCreatePinnedToCore(&MeoPublishQueue::_taskEntry, "meo_pubq", stackSize,
+                                this, priority, &_task, core) != pdPASS) {
+        _taskAlive.store(false, std::memory_order_release);
+        _task = nullptr;
+        _release();
+        return false;
+    }
+    _running.store(true, std::memory_order_release);
+    return true;
+}
+
+void MeoPublishQueue::end() {
+    if (_taskAlive.load(std::memory_order_acquire)) {
+        // Ngừng nhận message mới và chờ producer đã qua _enter() rời đi: sau đó không còn
+        // ai chạm vào _freeQ/_slots, và mọi commit() đều nằm trước STOP_TOKEN nên được gửi nốt
+        _running.store(false, std::memory_order_seq_cst);
+        while (_inFlight.load(std::memory_order_seq_cst) > 0) {
+            vTaskDelay(pdMS_TO_TICKS(1));
+        }
+        uint8_t stop = STOP_TOKEN;
+        xQueueSend(_readyQ, &stop, portMAX_DELAY);
+        while (_taskAlive.load(std::memory_order_acquire)) {
+            vTaskDelay(pdMS_TO_TICKS(5));
+        }
+        _task = nullptr;
+    }
+    _release();
+}
+
+// Đăng ký producer trước khi chạm vào slot; false nếu queue đã/đang dừng.
+// Cặp seq_cst với end(): hoặc end() thấy _inFlight > 0 và chờ, hoặc producer thấy _running == false.
+bool MeoPublishQueue::_enter() {
+    _inFlight.fetch_add(1, std::memory_order_seq_cst);
+    if (_running.load(std::memory_order_seq_cst)) return true;
+    _leave();
+    return false;
+}
+
+// Topic + tuỳ chọn vào slot; false nếu topic / user property không vừa
+bool MeoPublishQueue::_fill(Slot& s, const char* topic, size_t len, const MeoPublishOptions& opt) {
+    size_t topicLen = topic ? strlen(topic) : 0;
+    if (topicLen == 0 || topicLen >= MEO_PUBQ_TOPIC_MAX || len > MEO_PUBQ_PAYLOAD_MAX) return false;
+
+    const uint8_t count = opt.userProps ? opt.userPropCount : 0;
+    size_t used = 0;
+    for (uint8_t i = 0; i < count; ++i) {
+        size_t k = strlen(opt.userProps[i].key) + 1;
+        size_t v = strlen(opt.userProps[i].value) + 1;
+        if (used + k + v > MEO_PUBQ_PROPS_MAX) return false;
+        memcpy(s.props + used, opt.userProps[i].key, k);   used += k;
+        memcpy(s.props + used, opt.userProps[i].value, v); used += v;
+    }
+
+    memcpy(s.topic, topic, topicLen + 1);
+    s.len         = (uint16_t)len;
+    s.retained    = opt.retained;
+    s.qos         = opt.qos;
+    s.topicAlias  = opt.topicAlias;
+    s.contentType = opt.contentType;
+    s.cookie      = opt.cookie;
+    s.propCount   = count;
+    return true;
+}
+
+MeoEnqueueResult MeoPublishQueue::enqueue(const char* topic, const uint8_t* payload,
+                                          size_t len, const MeoPublishOptions& opt) {
+    if (!_enter()) return MeoEnqueueResult::NotRunning;
+
+    uint8_t idx;
+    if (xQueueReceive(_freeQ, &idx, 0) != pdTRUE) {
+        _dropped.fetch_add(1, std::memory_order_relaxed);
+        _leave();
+        return MeoEnqueueResult::Full;
+    }
+
+    Slot& s = _slots[idx];
+    if (!_fill(s, topic, len, opt)) {
+        xQueueSend(_freeQ, &idx, 0);
+        _dropped.fetch_add(1, std::memory_order_relaxed);
+        _leave();
+        return MeoEnqueueResult::TooLarge;
+    }
+    if (len) memcpy(s.payload, payload, len);
+
+    _markReady(idx);
+    _leave();
+    return MeoEnqueueResult::Queued;
+}
+
+uint8_t* MeoPublishQueue::reserve(uint8_t& slot, size_t& capacity, MeoEnqueueResult* why) {
+    MeoEnqueueResult r = MeoEnqueueResult::Queued;
+    uint8_t idx = 0;
+    if (!_enter()) {
+        r = MeoEnqueueResult::NotRunning;
+    } else if (xQueueReceive(_freeQ, &idx, 0) != pdTRUE) {
+        _dropped.fetch_add(1, std::memory_order_relaxed);
+        _leave();
+        r = MeoEnqueueResult::Full;
+    }
+    if (why) *why = r;
+    if (r != MeoEnqueueResult::Queued) return nullptr;
+
+    // Giữ chỗ trong _inFlight cho tới commit()/cancel()
+
+    slot     = idx;
+    capacity = MEO_PUBQ_PAYLOAD_MAX;
+    return _slots[idx].payload;
+}
+
+MeoEnqueueResult MeoPublishQueue::commit(uint8_t slot, const char* topic, size_t len,
+                                         const MeoPublishOptions& opt) {
+    if (slot >= _depth) return MeoEnqueueResult::NotRunning;
+
+    if (!_fill(_slots[slot], topic, len, opt)) {
+        drop(slot);
+        return MeoEnqueueResult::TooLarge;
+    }
+
+    _markReady(slot);
+    _leave();
+    return MeoEnqueueResult::Queued;
+}
+
+void MeoPublishQueue::cancel(uint8_t slot) {
+    if (slot >= _depth) return;
+    xQueueSend(_freeQ, &slot, 0);
+    _leave();
+}
+
+void MeoPublishQueue::drop(uint8_t slot) {
+    if (slot >= _depth) return;
+    _dropped.fetch_add(1, std::memory_order_relaxed);
+    cancel(slot);
+}
+
+void MeoPublishQueue::_markReady(uint8_t idx) {
+    xQueueSend(_readyQ, &idx, 0); // luôn còn chỗ vì số slot == độ sâu hàng đợi
+    _enqueued.fetch_add(1, std::memory_order_relaxed);
+
+    uint16_t depth = (uint16_t)uxQueueMessagesWaiting(_readyQ);
+    uint16_t hw = _highWater.load(std::memory_order_relaxed);
+    while (depth > hw && !_highWater.compare_exchange_weak(hw, depth, std::memory_order_relaxed)) {}
+}
+
+MeoPublishStats MeoPublishQueue::stats() const {
+    MeoPublishStats st;
+    st.enqueued  = _enqueued.load(std::memory_order_relaxed);
+    st.sent      = _sent.load(std::memory_order_relaxed);
+    st.failed    = _failed.load(std::memory_order_relaxed);
+    st.dropped   = _dropped.load(std::memory_order_relaxed);
+    st.depth     = _readyQ ? (uint16_t)uxQueueMessagesWaiting(_readyQ) : 0;
+    st.highWater = _highWater.load(std::memory_order_relaxed);
+    return st;
+}
+
+// Static -> instance adapter
+void MeoPublishQueue::_taskEntry(void* arg) {
+    reinterpret_cast<MeoPublishQueue*>(arg)->_run();
+}
+
+void MeoPublishQueue::_run() {
+    uint8_t idx;
+    for (;;) {
+        if (xQueueReceive(_readyQ, &idx, portMAX_DELAY) != pdTRUE) continue;
+        if (idx == STOP_TOKEN) break;
+
+        Slot& s = _slots[idx];
+        MeoUserProperty props[MEO_MQTT5_MAX_USER_PROPS];
+        MeoPublishOptions opt;
+        opt.qos           = s.qos;
+        opt.retained      = s.retained;
+        opt.topicAlias    = s.topicAlias;
+        opt.contentType   = s.contentType;
+        opt.cookie        = s.cookie;
+        opt.userProps     = props;
+        opt.userPropCount = 0;
+        const char* p = s.props;
+        for (uint8_t i = 0; i < s.propCount && i < MEO_MQTT5_MAX_USER_PROPS; ++i) {
+            props[i].key   = p; p += strlen(p) + 1;
+            props[i].value = p; p += strlen(p) + 1;
+            opt.userPropCount++;
+        }
+        bool ok = _mqtt->publish(s.topic, s.payload, s.len, opt) == MeoPublishResult::Ok;
+        (ok ? _sent : _failed).fetch_add(1, std::memory_order_relaxed);
+
+        xQueueSend(_freeQ, &idx, 0);
+    }
+
+    _taskAlive.store(false, std::memory_order_release);
+    vTaskDelete(NULL);
+}
+
+void MeoPublishQueue::_release() {
+    if (_readyQ) { vQueueDelete(_readyQ); _readyQ = nullptr; }
+    if (_freeQ)  { vQueueDelete(_freeQ);  _freeQ  = nullptr; }
+    delete[] _slots;
+    _slots = nullptr;
+    _depth = 0;
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "Meo3_Mqtt.h"
+
+// Kích thước mỗi slot được cấp phát sẵn (topic + payload)
+#ifndef MEO_PUBQ_TOPIC_MAX
+#define MEO_PUBQ_TOPIC_MAX 128
+#endif
+#ifndef MEO_PUBQ_PAYLOAD_MAX
+#define MEO_PUBQ_PAYLOAD_MAX 512
+#endif
+// MQTT 5 user property của một message, đóng gói key\0value\0...
+#ifndef MEO_PUBQ_PROPS_MAX
+#define MEO_PUBQ_PROPS_MAX 64
+#endif
+#ifndef MEO_PUBQ_DEFAULT_DEPTH
+#define MEO_PUBQ_DEFAULT_DEPTH 8
+#endif
+#ifndef MEO_PUBQ_TASK_STACK
+#define MEO_PUBQ_TASK_STACK 4096
+#endif
+
+// Kết quả enqueue trả về ngay cho caller (không bao giờ block)
+enum class MeoEnqueueResult : uint8_t {
+    Queued = 0,
+    Full,        // Hết slot trống -> message bị drop
+    TooLarge,    // Topic hoặc payload vượt kích thước slot
+    NotRunning   // Sender task chưa chạy
+};
+
+// Bộ đếm hoàn thành / drop, đọc được từ bất kỳ task nào
+struct MeoPublishStats {
+    uint32_t enqueued  = 0;
+    uint32_t sent      = 0;  // esp_mqtt_client_publish chấp nhận
+    uint32_t failed    = 0;  // publish bị từ chối (mất kết nối, outbox đầy...)
+    uint32_t dropped   = 0;  // Full / TooLarge lúc enqueue
+    uint16_t depth     = 0;  // Số message đang chờ
+    uint16_t highWater = 0;  // Độ sâu lớn nhất từng ghi nhận
+};
+
+/**
+ * MeoPublishQueue: hàng đợi publish bất đồng bộ.
+ * - Toàn bộ slot được cấp phát một lần trong begin(), hot path không malloc.
+ * - Caller copy message vào slot trống rồi trả về ngay.
+ * - Một sender task (pin vào core chỉ định) lấy message ra và gọi MeoMqttClient::publish.
+ */
+class MeoPublishQueue {
+public:
+    MeoPublishQueue();
+    ~MeoPublishQueue();
+
+    // Cấp phát slot và khởi động sender task
+    bool begin(MeoMqttClient* mqtt,
+               uint8_t depth = MEO_PUBQ_DEFAULT_DEPTH,
+               BaseType_t core = tskNO_AFFINITY,
+               UBaseType_t priority = 5,
+               uint32_t stackSize = MEO_PUBQ_TASK_STACK);
+
+    // Dừng nhận message mới, chờ các producer đang enqueue / giữ slot reserve() xong,
+    // gửi nốt hàng đợi rồi giải phóng slot
+    void end();
+
+    bool isRunning() const { return _running.load(std::memory_order_acquire); }
+
+    // Non-blocking: copy topic + payload (+ user property) vào slot trống.
+    // opt.contentType chỉ được giữ con trỏ: phải là chuỗi hằng.
+    MeoEnqueueResult enqueue(const char* topic, const uint8_t* payload, size_t len,
+                             const MeoPublishOptions& opt);
+
+    // Zero-copy: mượn buffer payload của một slot trống để serialize trực tiếp vào đó,
+    // sau đó commit() (đưa vào hàng gửi) hoặc cancel() (trả slot). nullptr nếu hết slot.
+    // Slot đã reserve phải được commit()/cancel(): end() chờ cho tới lúc đó.
+    uint8_t* reserve(uint8_t& slot, size_t& capacity, MeoEnqueueResult* why = nullptr);
+    MeoEnqueueResult commit(uint8_t slot, const char* topic, size_t len, const MeoPublishOptions& opt);
+    void cancel(uint8_t slot);
+    // Như cancel() nhưng message bị bỏ (vd serialize không vừa slot): tính vào stats().dropped
+    void drop(uint8_t slot);
+
+    MeoPublishStats stats() const;
+
+private:
+    struct Slot {
+        char     topic[MEO_PUBQ_TOPIC_MAX];
+        uint8_t  payload[MEO_PUBQ_PAYLOAD_MAX];
+        uint16_t len;
+        bool     retained;
+        uint8_t  qos;
+        bool     topicAlias;
+        uint8_t  propCount;
+        const char* contentType;
+        uint32_t cookie;
+        char     props[MEO_PUBQ_PROPS_MAX];
+    };
+
+    static const uint8_t STOP_TOKEN = 0xFF;
+
+    MeoMqttClient* _mqtt  = nullptr;
+    Slot*          _slots = nullptr;
+    uint8_t        _depth = 0;
+
+    QueueHandle_t  _freeQ  = nullptr;  // chỉ số slot trống
+    QueueHandle_t  _readyQ = nullptr;  // chỉ số slot chờ gửi
+    TaskHandle_t   _task   = nullptr;
+
+    std::atomic<bool>     _running{false};   // còn nhận enqueue
+    std::atomic<bool>     _taskAlive{false}; // sender task chưa thoát
+    std::atomic<uint16_t> _inFlight{0};      // producer đang trong enqueue() hoặc giữ slot reserve()
+    std::atomic<uint32_t> _enqueued{0};
+    std::atomic<uint32_t> _sent{0};
+    std::atomic<uint32_t> _failed{0};
+    std::atomic<uint32_t> _dropped{0};
+    std::atomic<uint16_t> _highWater{0};
+
+    bool _enter();
+    void _leave() { _inFlight.fetch_sub(1, std::memory_order_release); }
+    static bool _fill(Slot& s, const char* topic, size_t len, const MeoPublishOptions& opt);
+    void _markReady(uint8_t idx);
+    static void _taskEntry(void* arg);
+    void _run();
+    void _release();
+};
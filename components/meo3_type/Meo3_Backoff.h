@@ -0,0 +1,42 @@
+#ifndef MEO3_BACKOFF_H
+#define MEO3_BACKOFF_H
+
+#include <cstdint>
+
+// Reconnect timing. Delays grow from initialMs by `multiplier` up to maxMs;
+// jitterPct of each delay is randomized so a fleet does not retry in lockstep
+// (100 = full jitter, 0 = deterministic).
+struct MeoBackoffPolicy {
+    uint32_t initialMs        = 1000;
+    uint32_t maxMs            = 60000;
+    uint8_t  multiplier       = 2;
+    uint8_t  jitterPct        = 50;
+    uint32_t connectTimeoutMs = 15000;  // an attempt that is not up by then counts as failed
+};
+
+class MeoBackoff {
+public:
+    void setPolicy(const MeoBackoffPolicy& p) { _policy = p; reset(); }
+    const MeoBackoffPolicy& policy() const { return _policy; }
+
+    void reset() { _ceilMs = _policy.initialMs; }
+
+    // Next delay in ms; `rnd` is a uniform 32-bit random value (esp_random()).
+    uint32_t next(uint32_t rnd) {
+        uint32_t ceil = _ceilMs ? _ceilMs : 1;
+        uint32_t jitterSpan = (uint32_t)((uint64_t)ceil * (_policy.jitterPct > 100 ? 100 : _policy.jitterPct) / 100);
+        uint32_t delay = ceil - (uint32_t)(((uint64_t)jitterSpan * rnd) >> 32);
+
+        uint64_t grown = (uint64_t)ceil * (_policy.multiplier ? _policy.multiplier : 1);
+        _ceilMs = grown > _policy.maxMs ? _policy.maxMs : (uint32_t)grown;
+        return delay;
+    }
+
+    uint32_t currentCeilMs() const { return _ceilMs; }
+
+private:
+    MeoBackoffPolicy _policy;
+    uint32_t         _ceilMs = 1000;
+};
+
+#endif // MEO3_BACKOFF_H
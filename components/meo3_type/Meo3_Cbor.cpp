@@ -0,0 +1,491 @@
+#include "Meo3_Cbor.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#include "Meo3_JsonReader.h"
+
+static_assert(MEO_CBOR_MAX_DEPTH <= 32, "MeoCborWriter tracks depth in a 32-bit mask");
+
+// ---------------------------------------------------------------- writer
+
+void MeoCborWriter::_put(const void* p, size_t n) {
+    if (n == 0) return;
+    if (_len + n <= _cap) {
+        memcpy(_buf + _len, p, n);
+    } else {
+        if (_len < _cap) memcpy(_buf + _len, p, _cap - _len);
+        _overflow = true;
+    }
+    _len += n;
+}
+
+// Initial byte + argument in the shortest form
+void MeoCborWriter::_head(uint8_t major, uint64_t v) {
+    uint8_t m = (uint8_t)(major << 5);
+    if (v < 24) {
+        _put((uint8_t)(m | v));
+        return;
+    }
+    uint8_t b[9];
+    size_t n;
+    if (v <= 0xff)            { b[0] = m | 24; n = 1; }
+    else if (v <= 0xffff)     { b[0] = m | 25; n = 2; }
+    else if (v <= 0xffffffff) { b[0] = m | 26; n = 4; }
+    else                      { b[0] = m | 27; n = 8; }
+    for (size_t i = 0; i < n; ++i) b[n - i] = (uint8_t)(v >> (8 * i));
+    _put(b, n + 1);
+}
+
+// A value may start here: top level (once), after a key, or inside an array
+void MeoCborWriter::_item() {
+    if (_depth == 0) {
+        if (_len > 0) _invalid = true;  // second top-level value
+        return;
+    }
+    bool map = _isMap & (1u << (_depth - 1));
+    if (map && !_afterKey) _invalid = true;
+    _afterKey = false;
+}
+
+void MeoCborWriter::_open(uint8_t b, bool map) {
+    _item();
+    if (_depth >= MEO_CBOR_MAX_DEPTH) {
+        _invalid = true;
+        return;
+    }
+    _put(b);
+    _depth++;
+    uint32_t bit = 1u << (_depth - 1);
+    if (map) _isMap |= bit; else _isMap &= ~bit;
+}
+
+void MeoCborWriter::_close(bool map) {
+    if (_depth == 0 || _afterKey || ((_isMap & (1u << (_depth - 1))) != 0) != map) {
+        _invalid = true;
+        return;
+    }
+    _put((uint8_t)0xff);  // break
+    _depth--;
+}
+
+void MeoCborWriter::_text(std::string_view s) {
+    _head(3, s.size());
+    _put(s.data(), s.size());
+}
+
+MeoCborWriter& MeoCborWriter::key(std::string_view k) {
+    if (_afterKey || _depth == 0 || !(_isMap & (1u << (_depth - 1)))) _invalid = true;
+    _text(k);
+    _afterKey = true;
+    return *this;
+}
+
+MeoCborWriter& MeoCborWriter::value(std::string_view v) {
+    _item();
+    _text(v);
+    return *this;
+}
+
+MeoCborWriter& MeoCborWriter::value(bool v) {
+    _item();
+    _put((uint8_t)(v ? 0xf5 : 0xf4));
+    return *this;
+}
+
+MeoCborWriter& MeoCborWriter::value(float v) {
+    uint32_t bits;
+    memcpy(&bits, &v, 4);
+    uint8_t b[5] = { 0xfa, (uint8_t)(bits >> 24), (uint8_t)(bits >> 16), (uint8_t)(bits >> 8), (uint8_t)bits };
+    _item();
+    _put(b, 5);
+    return *this;
+}
+
+MeoCborWriter& MeoCborWriter::value(double v) {
+    // float32 when it round-trips (most sensor values do)
+    if (std::isnan(v) || (double)(float)v == v) return value((float)v);
+    uint64_t bits;
+    memcpy(&bits, &v, 8);
+    uint8_t b[9];
+    b[0] = 0xfb;
+    for (int i = 0; i < 8; ++i) b[8 - i] = (uint8_t)(bits >> (8 * i));
+    _item();
+    _put(b, 9);
+    return *this;
+}
+
+MeoCborWriter& MeoCborWriter::null() {
+    _item();
+    _put((uint8_t)0xf6);
+    return *this;
+}
+
+// JSON (already validated by MeoJsonView) -> CBOR
+struct MeoCborTranscode {
+    static void json(MeoCborWriter& w, const MeoJsonView& v) {
+        switch (v.type()) {
+            case MeoJsonType::Null:   w.null(); break;
+            case MeoJsonType::Bool:   w.value(v.asBool()); break;
+            case MeoJsonType::Number:
+                if (v.isInteger()) w.value(v.asInt());
+                else               w.value(v.asDouble());
+                break;
+            case MeoJsonType::String: string(w, v); break;
+            case MeoJsonType::Object: {
+                w.beginObject();
+                MeoJsonIterator it(v);
+                while (it.next()) {
+                    key(w, it.key());
+                    json(w, it.value());
+                }
+                w.endObject();
+                break;
+            }
+            case MeoJsonType::Array: {
+                w.beginArray();
+                MeoJsonIterator it(v);
+                while (it.next()) json(w, it.value());
+                w.endArray();
+                break;
+            }
+            default:
+                w._invalid = true;
+        }
+    }
+
+    // Object keys come back raw; escaped ones are rare enough to decode via a small buffer
+    static void key(MeoCborWriter& w, std::string_view raw) {
+        if (!memchr(raw.data(), '\\', raw.size())) {
+            w.key(raw);
+            return;
+        }
+        char quoted[66];
+        char out[64];
+        size_t n = 0;
+        if (raw.size() + 2 > sizeof(quoted)) { w._invalid = true; return; }
+        quoted[0] = '"';
+        memcpy(quoted + 1, raw.data(), raw.size());
+        quoted[raw.size() + 1] = '"';
+        MeoJsonView k = MeoJsonView::parse(quoted, raw.size() + 2);
+        if (!k.unescape(out, sizeof(out), n)) { w._invalid = true; return; }
+        w.key(std::string_view(out, n));
+    }
+
+    // Escaped strings are decoded straight into the output. The head is sized for the
+    // escaped length (decoded text is never longer); a non-minimal length is valid CBOR.
+    static void string(MeoCborWriter& w, const MeoJsonView& v) {
+        std::string_view s = v.asString();
+        if (!v.needsUnescape()) {
+            w.value(s);
+            return;
+        }
+        w._item();
+        const size_t n = s.size();
+        const size_t hw = n < 24 ? 1 : n <= 0xff ? 2 : n <= 0xffff ? 3 : 5;
+        const size_t at = w._len;
+        if (at + hw + n > w._cap) {
+            w._overflow = true;
+            w._len += hw + n;   // upper bound
+            return;
+        }
+        size_t out = 0;
+        if (!v.unescape((char*)w._buf + at + hw, n, out)) {
+            w._invalid = true;
+            return;
+        }
+        uint8_t* h = w._buf + at;
+        switch (hw) {
+            case 1: h[0] = (uint8_t)(0x60 | out); break;
+            case 2: h[0] = 0x78; h[1] = (uint8_t)out; break;
+            case 3: h[0] = 0x79; h[1] = (uint8_t)(out >> 8); h[2] = (uint8_t)out; break;
+            default:
+                h[0] = 0x7a;
+                h[1] = (uint8_t)(out >> 24); h[2] = (uint8_t)(out >> 16);
+                h[3] = (uint8_t)(out >> 8);  h[4] = (uint8_t)out;
+        }
+        w._len = at + hw + out;
+    }
+};
+
+MeoCborWriter& MeoCborWriter::raw(const char* json, size_t len) {
+    if (!json || len == 0) return null();
+    MeoJsonView v = MeoJsonView::parse(json, len);
+    if (!v.valid()) {
+        _invalid = true;
+        return *this;
+    }
+    MeoCborTranscode::json(*this, v);
+    return *this;
+}
+
+// ---------------------------------------------------------------- reader
+
+struct MeoCborScan {
+    // Initial byte + argument. info 31 = indefinite length (val unused).
+    static bool head(const uint8_t*& p, const uint8_t* end, uint8_t& major, uint8_t& info, uint64_t& val) {
+        if (p >= end) return false;
+        major = *p >> 5;
+        info  = *p & 0x1f;
+        ++p;
+        if (info < 24) { val = info; return true; }
+        if (info == 31) { val = 0; return true; }
+        if (info > 27) return false;
+        size_t n = (size_t)1 << (info - 24);
+        if ((size_t)(end - p) < n) return false;
+        val = 0;
+        for (size_t i = 0; i < n; ++i) val = (val << 8) | p[i];
+        p += n;
+        return true;
+    }
+
+    static void skipTags(const uint8_t*& p, const uint8_t* end) {
+        uint8_t major, info;
+        uint64_t val;
+        const uint8_t* q = p;
+        while (q < end && (*q >> 5) == 6 && head(q, end, major, info, val) && info != 31) p = q;
+    }
+
+    // Validate and step over one item (not a break). Tags are stepped over in a loop:
+    // a run of them must not cost stack, only nested maps/arrays count as depth.
+    static bool skip(const uint8_t*& p, const uint8_t* end, int depth) {
+        uint8_t major, info;
+        uint64_t val;
+        if (!head(p, end, major, info, val)) return false;
+        while (major == 6) {
+            if (info == 31 || !head(p, end, major, info, val)) return false;
+        }
+        switch (major) {
+            case 0: case 1:
+                return info != 31;
+            case 2: case 3:
+                if (info == 31 || val > (uint64_t)(end - p)) return false;  // no chunked strings
+                p += val;
+                return true;
+            case 4: case 5: {
+                if (depth >= MEO_CBOR_MAX_DEPTH) return false;
+                const int per = (major == 5) ? 2 : 1;
+                if (info == 31) {
+                    for (;;) {
+                        if (p >= end) return false;
+                        if (*p == 0xff) { ++p; return true; }
+                        for (int i = 0; i < per; ++i) {
+                            if (!skip(p, end, depth + 1)) return false;
+                        }
+                    }
+                }
+                if (val > (uint64_t)(end - p)) return false;  // every item takes >= 1 byte
+                for (uint64_t n = 0; n < val * per; ++n) {
+                    if (!skip(p, end, depth + 1)) return false;
+                }
+                return true;
+            }
+            default:  // 7: simple values / floats
+                return info != 31 && info != 28 && info != 29 && info != 30;
+        }
+    }
+
+    static MeoCborType typeOf(const uint8_t* p) {
+        uint8_t major = *p >> 5, info = *p & 0x1f;
+        switch (major) {
+            case 0: case 1: return MeoCborType::Int;
+            case 2:         return MeoCborType::Bytes;
+            case 3:         return MeoCborType::String;
+            case 4:         return MeoCborType::Array;
+            case 5:         return MeoCborType::Map;
+            case 7:
+                if (info == 20 || info == 21) return MeoCborType::Bool;
+                if (info == 22 || info == 23) return MeoCborType::Null;  // null / undefined
+                if (info >= 25 && info <= 27) return MeoCborType::Float;
+                return MeoCborType::Invalid;
+            default:        return MeoCborType::Invalid;
+        }
+    }
+
+    // View of the (validated) item at p, advancing p past it
+    static MeoCborView item(const uint8_t*& p, const uint8_t* end) {
+        MeoCborView v;
+        skipTags(p, end);
+        const uint8_t* start = p;
+        if (!skip(p, end, 0)) return v;
+        v._p = start;
+        v._n = (size_t)(p - start);
+        v._type = typeOf(start);
+        return v;
+    }
+
+    static double half(uint16_t h) {
+        int e = (h >> 10) & 0x1f, m = h & 0x3ff;
+        double v = (e == 0)  ? std::ldexp(m, -24)
+                 : (e == 31) ? (m ? NAN : INFINITY)
+                 : std::ldexp(m + 1024, e - 25);
+        return (h & 0x8000) ? -v : v;
+    }
+};
+
+MeoCborView MeoCborView::parse(const uint8_t* buf, size_t len) {
+    if (!buf || len == 0) return MeoCborView();
+    const uint8_t* p = buf;
+    const uint8_t* end = buf + len;
+    MeoCborView v = MeoCborScan::item(p, end);
+    if (p != end) return MeoCborView();  // trailing bytes
+    return v;
+}
+
+int64_t MeoCborView::asInt(int64_t def) const {
+    if (_type == MeoCborType::Bool) return (_p[0] & 0x1f) == 21 ? 1 : 0;
+    if (_type == MeoCborType::Float) {
+        double d = asDouble();
+        if (!(d > -9.2e18 && d < 9.2e18)) return def;
+        return (int64_t)d;
+    }
+    if (_type != MeoCborType::Int) return def;
+    const uint8_t* p = _p;
+    uint8_t major = 0, info = 0;
+    uint64_t val = 0;
+    MeoCborScan::head(p, _p + _n, major, info, val);
+    if (val > (uint64_t)INT64_MAX) return major == 0 ? INT64_MAX : INT64_MIN;
+    return major == 0 ? (int64_t)val : -1 - (int64_t)val;
+}
+
+double MeoCborView::asDouble(double def) const {
+    if (_type == MeoCborType::Int) {
+        const uint8_t* p = _p;
+        uint8_t major = 0, info = 0;
+        uint64_t val = 0;
+        MeoCborScan::head(p, _p + _n, major, info, val);
+        return major == 0 ? (double)val : -1.0 - (double)val;
+    }
+    if (_type != MeoCborType::Float) return def;
+    const uint8_t* p = _p;
+    uint8_t major = 0, info = 0;
+    uint64_t bits = 0;
+    MeoCborScan::head(p, _p + _n, major, info, bits);
+    if (info == 25) return MeoCborScan::half((uint16_t)bits);
+    if (info == 26) {
+        uint32_t b = (uint32_t)bits;
+        float f;
+        memcpy(&f, &b, 4);
+        return f;
+    }
+    double d;
+    memcpy(&d, &bits, 8);
+    return d;
+}
+
+bool MeoCborView::asBool(bool def) const {
+    if (_type == MeoCborType::Bool) return (_p[0] & 0x1f) == 21;
+    if (_type == MeoCborType::Int)  return asInt() != 0;
+    return def;
+}
+
+std::string_view MeoCborView::asString() const {
+    if (_type != MeoCborType::String && _type != MeoCborType::Bytes) return std::string_view();
+    const uint8_t* p = _p;
+    uint8_t major = 0, info = 0;
+    uint64_t val = 0;
+    MeoCborScan::head(p, _p + _n, major, info, val);
+    return std::string_view((const char*)p, (size_t)val);
+}
+
+MeoCborView MeoCborView::get(std::string_view key) const {
+    if (_type != MeoCborType::Map) return MeoCborView();
+    MeoCborIterator it(*this);
+    while (it.next()) {
+        if (it.keyItem().isString() && it.key() == key) return it.value();
+    }
+    return MeoCborView();
+}
+
+size_t MeoCborView::size() const {
+    if (_type != MeoCborType::Map && _type != MeoCborType::Array) return 0;
+    if ((_p[0] & 0x1f) != 31) {
+        const uint8_t* p = _p;
+        uint8_t major = 0, info = 0;
+        uint64_t val = 0;
+        MeoCborScan::head(p, _p + _n, major, info, val);
+        return (size_t)val;
+    }
+    size_t n = 0;
+    MeoCborIterator it(*this);
+    while (it.next()) ++n;
+    return n;
+}
+
+MeoCborIterator::MeoCborIterator(const MeoCborView& c) {
+    if (!c.isMap() && !c.isArray()) return;
+    const uint8_t* p = c._p;
+    uint8_t major = 0, info = 0;
+    uint64_t val = 0;
+    MeoCborScan::head(p, c._p + c._n, major, info, val);
+    _pos = p;
+    _end = c._p + c._n;
+    _map = c.isMap();
+    _indefinite = (info == 31);
+    _left = val;
+}
+
+bool MeoCborIterator::next() {
+    if (!_pos || _pos >= _end) return false;
+    if (_indefinite ? (*_pos == 0xff) : (_left == 0)) {
+        _pos = nullptr;
+        return false;
+    }
+    if (!_indefinite) --_left;
+    if (_map) {
+        _keyItem = MeoCborScan::item(_pos, _end);
+        _key = _keyItem.isString() ? _keyItem.asString() : std::string_view();
+    }
+    _value = MeoCborScan::item(_pos, _end);
+    if (_value.byteLength() == 0) {  // not from a validated view
+        _pos = nullptr;
+        return false;
+    }
+    return true;
+}
+
+bool meoCborToJson(const MeoCborView& v, MeoJsonWriter& w) {
+    switch (v.type()) {
+        case MeoCborType::Bool:   w.value(v.asBool()); break;
+        case MeoCborType::Int:
+            if ((v.data()[0] >> 5) == 0 && v.asInt() == INT64_MAX) w.value(v.asDouble());
+            else                                                   w.value(v.asInt());
+            break;
+        case MeoCborType::Float:  w.value(v.asDouble()); break;
+        case MeoCborType::String: w.value(v.asString()); break;
+        case MeoCborType::Map: {
+            w.beginObject();
+            MeoCborIterator it(v);
+            char num[24];
+            while (it.next()) {
+                const MeoCborView& k = it.keyItem();
+                if (k.isString()) {
+                    w.key(it.key());
+                } else if (k.isInt()) {
+                    int n = snprintf(num, sizeof(num), "%lld", (long long)k.asInt());
+                    w.key(std::string_view(num, (size_t)n));
+                } else {
+                    return false;
+                }
+                if (!meoCborToJson(it.value(), w)) return false;
+            }
+            w.endObject();
+            break;
+        }
+        case MeoCborType::Array: {
+            w.beginArray();
+            MeoCborIterator it(v);
+            while (it.next()) {
+                if (!meoCborToJson(it.value(), w)) return false;
+            }
+            w.endArray();
+            break;
+        }
+        case MeoCborType::Invalid:
+            return false;
+        default:
+            w.null();   // null, undefined, byte strings
+    }
+    return !w.overflow();
+}
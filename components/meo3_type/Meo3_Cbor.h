@@ -0,0 +1,178 @@
+#ifndef MEO3_CBOR_H
+#define MEO3_CBOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+
+#include "Meo3_JsonWriter.h"
+
+// Deepest map/array nesting the writer and reader accept
+#ifndef MEO_CBOR_MAX_DEPTH
+#define MEO_CBOR_MAX_DEPTH 16
+#endif
+
+/**
+ * MeoCborWriter: ghi CBOR (RFC 8949) tuần tự thẳng vào buffer của caller, cùng API với
+ * MeoJsonWriter để code serialize viết một lần cho cả hai (fill(auto& w)).
+ * - Map/array dùng độ dài không xác định (0xbf/0x9f ... 0xff): không cần biết trước
+ *   số phần tử, đổi lại tốn 1 byte mỗi container.
+ * - Số nguyên dùng đầu mục ngắn nhất; float giữ 4 byte, double chỉ 8 byte khi float32
+ *   làm mất độ chính xác.
+ * - raw() nhận JSON text (giá trị Raw của MeoPayload) và chuyển sang CBOR.
+ * - Tràn buffer: như MeoJsonWriter, ngừng ghi nhưng vẫn đếm required().
+ */
+class MeoCborWriter {
+public:
+    MeoCborWriter(uint8_t* buf, size_t cap) : _buf(buf), _cap(buf ? cap : 0) {}
+    MeoCborWriter(char* buf, size_t cap) : MeoCborWriter((uint8_t*)buf, cap) {}
+
+    MeoCborWriter& beginObject() { _open(0xbf, true); return *this; }
+    MeoCborWriter& endObject()   { _close(true); return *this; }
+    MeoCborWriter& beginArray()  { _open(0x9f, false); return *this; }
+    MeoCborWriter& endArray()    { _close(false); return *this; }
+
+    MeoCborWriter& key(std::string_view k);
+
+    MeoCborWriter& value(std::string_view v);
+    MeoCborWriter& value(const char* v) { return v ? value(std::string_view(v)) : null(); }
+    MeoCborWriter& value(bool v);
+    MeoCborWriter& value(float v);
+    MeoCborWriter& value(double v);
+
+    template <typename T,
+              typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value, int>::type = 0>
+    MeoCborWriter& value(T v) {
+        _item();
+        if (std::is_signed<T>::value && (int64_t)v < 0) _head(1, ~(uint64_t)(int64_t)v);
+        else                                            _head(0, (uint64_t)v);
+        return *this;
+    }
+
+    MeoCborWriter& null();
+
+    // JSON text value, transcoded (invalid JSON marks the writer invalid)
+    MeoCborWriter& raw(const char* json, size_t len);
+
+    template <typename T>
+    MeoCborWriter& field(std::string_view k, const T& v) { return key(k).value(v); }
+
+    bool   ok()       const { return !_overflow && !_invalid && _depth == 0 && _len > 0; }
+    bool   overflow() const { return _overflow; }
+    size_t length()   const { return _overflow ? 0 : _len; }
+    size_t required() const { return _len; }
+    size_t capacity() const { return _cap; }
+
+    // Binary output: nothing to terminate; returns ok()
+    bool finish() const { return ok(); }
+
+private:
+    friend struct MeoCborTranscode;
+
+    uint8_t* _buf;
+    size_t   _cap;
+    size_t   _len = 0;
+    uint32_t _isMap = 0;     // bit d: container at depth d is a map
+    uint8_t  _depth = 0;
+    bool     _afterKey = false;
+    bool     _overflow = false;
+    bool     _invalid  = false;
+
+    void _put(uint8_t b) {
+        if (_len < _cap) _buf[_len] = b; else _overflow = true;
+        _len++;
+    }
+    void _put(const void* p, size_t n);
+    void _head(uint8_t major, uint64_t v);
+    void _item();   // checks a value is allowed here
+    void _open(uint8_t b, bool map);
+    void _close(bool map);
+    void _text(std::string_view s);
+};
+
+enum class MeoCborType : uint8_t {
+    Invalid = 0,
+    Null,
+    Bool,
+    Int,
+    Float,
+    String,
+    Bytes,
+    Map,
+    Array
+};
+
+/**
+ * MeoCborView: một item CBOR nằm ngay trong buffer gốc, tương tự MeoJsonView.
+ * - parse() kiểm tra toàn bộ item (phải chiếm trọn buffer) một lần.
+ * - Chuỗi trả về là view vào buffer: CBOR không escape nên không cần giải mã.
+ * - Tag được bỏ qua (đọc item bên trong); chuỗi chia chunk không được hỗ trợ.
+ */
+class MeoCborView {
+public:
+    MeoCborView() {}
+
+    static MeoCborView parse(const uint8_t* buf, size_t len);
+
+    MeoCborType type() const { return _type; }
+    bool valid()    const { return _type != MeoCborType::Invalid; }
+    bool isNull()   const { return _type == MeoCborType::Null; }
+    bool isBool()   const { return _type == MeoCborType::Bool; }
+    bool isInt()    const { return _type == MeoCborType::Int; }
+    bool isFloat()  const { return _type == MeoCborType::Float; }
+    bool isString() const { return _type == MeoCborType::String; }
+    bool isMap()    const { return _type == MeoCborType::Map; }
+    bool isArray()  const { return _type == MeoCborType::Array; }
+
+    // Encoded bytes of this item (after any tags)
+    const uint8_t* data() const { return _p; }
+    size_t         byteLength() const { return _n; }
+
+    int64_t          asInt(int64_t def = 0) const;
+    double           asDouble(double def = 0.0) const;
+    bool             asBool(bool def = false) const;
+    std::string_view asString() const;   // text or byte string contents
+
+    // Map member with a text key (Invalid if missing / not a map)
+    MeoCborView get(std::string_view key) const;
+    MeoCborView operator[](std::string_view key) const { return get(key); }
+    // Number of map pairs / array elements
+    size_t size() const;
+
+private:
+    friend class MeoCborIterator;
+    friend struct MeoCborScan;
+
+    const uint8_t* _p = nullptr;
+    size_t         _n = 0;
+    MeoCborType    _type = MeoCborType::Invalid;
+};
+
+// Walk a map or an array:
+//   MeoCborIterator it(params);
+//   while (it.next()) { it.key(); it.value(); }
+class MeoCborIterator {
+public:
+    explicit MeoCborIterator(const MeoCborView& container);
+
+    bool next();
+    std::string_view   key()     const { return _key; }      // text keys only, else empty
+    const MeoCborView& keyItem() const { return _keyItem; }  // any key type
+    const MeoCborView& value()   const { return _value; }
+
+private:
+    const uint8_t*   _pos = nullptr;
+    const uint8_t*   _end = nullptr;
+    uint64_t         _left = 0;         // definite length: items left
+    bool             _indefinite = false;
+    bool             _map = false;
+    std::string_view _key;
+    MeoCborView      _keyItem;
+    MeoCborView      _value;
+};
+
+// CBOR -> JSON (byte strings become null); false if the writer failed
+bool meoCborToJson(const MeoCborView& v, MeoJsonWriter& w);
+
+#endif // MEO3_CBOR_H
@@ -0,0 +1,49 @@
+#ifndef MEO3_CODEC_H
+#define MEO3_CODEC_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Meo3_JsonWriter.h"
+#include "Meo3_Cbor.h"
+
+// Wire encoding of events / responses. JSON is the default; the declare tells the
+// gateway which one a device uses. Invokes are accepted in either, by first byte.
+enum class MeoCodec : uint8_t {
+    Json = 0,
+    Cbor
+};
+
+inline const char* meoCodecName(MeoCodec c) {
+    return c == MeoCodec::Cbor ? "cbor" : "json";
+}
+
+inline const char* meoCodecContentType(MeoCodec c) {
+    return c == MeoCodec::Cbor ? "application/cbor" : "application/json";
+}
+
+// CBOR map header (0xa0..0xbf); a JSON object starts with '{' or whitespace
+inline bool meoIsCborMap(const uint8_t* p, size_t len) {
+    return len > 0 && p[0] >= 0xa0 && p[0] <= 0xbf;
+}
+
+/**
+ * Gọi fill(w) với writer của codec, ghi thẳng vào buf. Trả về số byte đã ghi,
+ * 0 nếu không vừa / sai cấu trúc; required (nếu có) nhận số byte message cần.
+ * fill viết một lần cho cả hai writer: [&](auto& w) { w.beginObject()...; }
+ */
+template <typename Fill>
+size_t meoEncode(MeoCodec codec, uint8_t* buf, size_t cap, Fill&& fill, size_t* required = nullptr) {
+    if (codec == MeoCodec::Cbor) {
+        MeoCborWriter w(buf, cap);
+        fill(w);
+        if (required) *required = w.required();
+        return w.ok() ? w.length() : 0;
+    }
+    MeoJsonWriter w((char*)buf, cap);
+    fill(w);
+    if (required) *required = w.required();
+    return w.ok() ? w.length() : 0;
+}
+
+#endif // MEO3_CODEC_H
@@ -0,0 +1,104 @@
+#ifndef MEO3_DISPATCH_H
+#define MEO3_DISPATCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+// FNV-1a 32-bit. constexpr so static names can be hashed at compile time,
+// e.g. `case meoHash("turn_on_led"):` in a user-side switch.
+constexpr uint32_t meoHash(const char* s, size_t n) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < n; ++i) {
+        h ^= (uint8_t)s[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+constexpr uint32_t meoHash(const char* s) {
+    uint32_t h = 2166136261u;
+    while (s && *s) {
+        h ^= (uint8_t)*s++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/**
+ * MeoDispatchTable: bảng tra handler theo tên, open addressing (linear probing).
+ * - Hash được tính một lần lúc add(); find() nhận (ptr, len) nên có thể tra
+ *   trực tiếp trên topic MQTT mà không copy chuỗi.
+ * - Số slot là lũy thừa của 2 >= 2 * Capacity để chuỗi probe luôn ngắn.
+ * - Entry giữ thứ tự thêm vào (dùng cho declare); tên phải sống lâu hơn bảng.
+ */
+template <typename Handler, size_t Capacity>
+class MeoDispatchTable {
+public:
+    struct Entry {
+        const char* name;
+        uint16_t    len;
+        uint32_t    hash;
+        Handler     handler;
+    };
+
+    MeoDispatchTable() {
+        for (size_t i = 0; i < SLOTS; ++i) _slots[i] = EMPTY;
+    }
+
+    // false nếu tên rỗng, trùng, hoặc bảng đầy
+    bool add(const char* name, Handler handler) {
+        if (!name || !*name || _count >= Capacity) return false;
+        size_t len = strlen(name);
+        if (len > UINT16_MAX) return false;
+        uint32_t h = meoHash(name, len);
+
+        size_t i = h & (SLOTS - 1);
+        while (_slots[i] != EMPTY) {
+            const Entry& e = _entries[_slots[i]];
+            if (e.hash == h && e.len == len && memcmp(e.name, name, len) == 0) return false;
+            i = (i + 1) & (SLOTS - 1);
+        }
+
+        _entries[_count] = Entry{ name, (uint16_t)len, h, std::move(handler) };
+        _slots[i] = (Index)_count;
+        _count++;
+        return true;
+    }
+
+    // Chỉ số entry hoặc -1
+    int find(const char* name, size_t len) const {
+        if (!name || len == 0) return -1;
+        uint32_t h = meoHash(name, len);
+        size_t i = h & (SLOTS - 1);
+        while (_slots[i] != EMPTY) {
+            const Entry& e = _entries[_slots[i]];
+            if (e.hash == h && e.len == len && memcmp(e.name, name, len) == 0) return _slots[i];
+            i = (i + 1) & (SLOTS - 1);
+        }
+        return -1;
+    }
+    int find(const char* name) const { return name ? find(name, strlen(name)) : -1; }
+
+    const Entry& operator[](size_t i) const { return _entries[i]; }
+    size_t size() const { return _count; }
+    static constexpr size_t capacity() { return Capacity; }
+
+private:
+    static constexpr size_t _pow2(size_t n) {
+        size_t p = 1;
+        while (p < n) p <<= 1;
+        return p;
+    }
+    static constexpr size_t SLOTS = _pow2(Capacity * 2 < 2 ? 2 : Capacity * 2);
+    using Index = uint16_t;
+    static constexpr Index EMPTY = 0xFFFF;
+    static_assert(Capacity < EMPTY, "MeoDispatchTable: Capacity too large");
+
+    Entry  _entries[Capacity];
+    Index  _slots[SLOTS];
+    size_t _count = 0;
+};
+
+#endif // MEO3_DISPATCH_H
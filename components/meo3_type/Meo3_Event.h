@@ -0,0 +1,210 @@
+#ifndef MEO3_EVENT_H
+#define MEO3_EVENT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+
+#include "Meo3_JsonWriter.h"
+#include "Meo3_Cbor.h"
+
+/**
+ * Event có kiểu: khai báo struct + danh sách field một lần, thư viện sinh serializer
+ * JSON/CBOR, schema cho declare và kích thước buffer tối đa lúc biên dịch.
+ *
+ *   struct HumidTemp { float temperature; float humidity; };
+ *   MEO_EVENT_NAMED(HumidTemp, "humid_temp_update", temperature, humidity)
+ *
+ *   meo.addFeatureEvent<HumidTemp>();          // schema vào declare
+ *   meo.publishEvent(HumidTemp{ 24.5f, 61.0f });
+ *
+ * - Tên key lấy từ tên member: gõ sai tên là lỗi biên dịch, không ra JSON sai.
+ * - Kiểu field: số nguyên, float/double, bool, char[N]. Kiểu khác -> static_assert.
+ * - Macro phải đặt ở global namespace (nó specialize MeoEventTraits), tối đa 16 field.
+ */
+
+// ---- value traits: JSON/CBOR worst case + schema type name per field type
+
+template <typename M, typename = void>
+struct MeoEventValue {
+    static_assert(sizeof(M) == 0, "MEO_EVENT field type not supported (use integers, float, double, bool or char[N])");
+};
+
+template <typename M>
+struct MeoEventValue<M, typename std::enable_if<std::is_integral<M>::value && !std::is_same<M, bool>::value>::type> {
+    static constexpr size_t jsonMax = std::numeric_limits<M>::digits10 + 1 + std::is_signed<M>::value;
+    static constexpr size_t cborMax = 1 + sizeof(M);
+    static constexpr const char* type = "int";
+    template <typename W> static void write(W& w, const M& v) { w.value(v); }
+};
+
+template <>
+struct MeoEventValue<bool> {
+    static constexpr size_t jsonMax = 5;   // false
+    static constexpr size_t cborMax = 1;
+    static constexpr const char* type = "bool";
+    template <typename W> static void write(W& w, bool v) { w.value(v); }
+};
+
+template <>
+struct MeoEventValue<float> {
+    static constexpr size_t jsonMax = 15;  // %.7g: -1.234567e+38
+    static constexpr size_t cborMax = 5;
+    static constexpr const char* type = "float";
+    template <typename W> static void write(W& w, float v) { w.value(v); }
+};
+
+template <>
+struct MeoEventValue<double> {
+    static constexpr size_t jsonMax = 24;  // %.15g: -1.23456789012345e+308
+    static constexpr size_t cborMax = 9;
+    static constexpr const char* type = "float";
+    template <typename W> static void write(W& w, double v) { w.value(v); }
+};
+
+// Fixed char buffer: NUL-terminated or full
+template <size_t N>
+struct MeoEventValue<char[N]> {
+    static constexpr size_t jsonMax = 2 + 6 * N;       // every byte as \u00XX
+    static constexpr size_t cborMax = (N < 24 ? 1 : N < 256 ? 2 : 3) + N;
+    static constexpr const char* type = "string";
+    template <typename W> static void write(W& w, const char (&v)[N]) {
+        const void* end = memchr(v, '\0', N);
+        w.value(std::string_view(v, end ? (size_t)((const char*)end - v) : N));
+    }
+};
+
+// ---- one reflected member
+
+template <typename T, typename M>
+struct MeoEventField {
+    const char* key;
+    size_t      keyLen;
+    M T::*      member;
+
+    using Value = MeoEventValue<M>;
+    constexpr size_t jsonMax() const { return keyLen + 3 + Value::jsonMax; }            // "key":v
+    constexpr size_t cborMax() const { return (keyLen < 24 ? 1 : 2) + keyLen + Value::cborMax; }
+};
+
+template <typename T, typename M, size_t K>
+constexpr MeoEventField<T, M> meoEventField(const char (&key)[K], M T::* member) {
+    return MeoEventField<T, M>{ key, K - 1, member };
+}
+
+// Specialized by MEO_EVENT / MEO_EVENT_NAMED
+template <typename T>
+struct MeoEventTraits {
+    static constexpr bool defined = false;
+};
+
+template <typename T>
+struct MeoEvent {
+    static_assert(MeoEventTraits<T>::defined, "Type is not an event: add MEO_EVENT(Type, fields...)");
+
+    static constexpr const char* name() { return MeoEventTraits<T>::name(); }
+
+    // Exact upper bounds of one serialized event
+    static constexpr size_t maxJson() {
+        return std::apply([](auto... f) {
+            return (size_t)2 + (f.jsonMax() + ... + 0) + (sizeof...(f) ? sizeof...(f) - 1 : 0);
+        }, MeoEventTraits<T>::fields());
+    }
+    static constexpr size_t maxCbor() {
+        return std::apply([](auto... f) { return (size_t)2 + (f.cborMax() + ... + 0); },
+                          MeoEventTraits<T>::fields());
+    }
+    static constexpr size_t maxSize() { return maxJson() > maxCbor() ? maxJson() : maxCbor(); }
+
+    template <typename Writer>
+    static void write(const T& ev, Writer& w) {
+        w.beginObject();
+        std::apply([&](auto... f) {
+            ((w.key(std::string_view(f.key, f.keyLen)),
+              decltype(f)::Value::write(w, ev.*(f.member))), ...);
+        }, MeoEventTraits<T>::fields());
+        w.endObject();
+    }
+
+    // {"field":"type",...}
+    static void schema(MeoJsonWriter& w) {
+        w.beginObject();
+        std::apply([&](auto... f) {
+            (w.field(std::string_view(f.key, f.keyLen), decltype(f)::Value::type), ...);
+        }, MeoEventTraits<T>::fields());
+        w.endObject();
+    }
+};
+
+// Type-erased view of one event type: what MeoDevice keeps in its registry
+struct MeoEventSchema {
+    const char* name;
+    size_t      maxJson;
+    size_t      maxCbor;
+    void (*toJson)(const void* ev, MeoJsonWriter& w);
+    void (*toCbor)(const void* ev, MeoCborWriter& w);
+    void (*schema)(MeoJsonWriter& w);
+
+    void write(const void* ev, MeoJsonWriter& w) const { toJson(ev, w); }
+    void write(const void* ev, MeoCborWriter& w) const { toCbor(ev, w); }
+};
+
+template <typename T>
+const MeoEventSchema& meoEventSchema() {
+    static constexpr MeoEventSchema s = {
+        MeoEvent<T>::name(),
+        MeoEvent<T>::maxJson(),
+        MeoEvent<T>::maxCbor(),
+        [](const void* ev, MeoJsonWriter& w) { MeoEvent<T>::write(*static_cast<const T*>(ev), w); },
+        [](const void* ev, MeoCborWriter& w) { MeoEvent<T>::write(*static_cast<const T*>(ev), w); },
+        &MeoEvent<T>::schema
+    };
+    return s;
+}
+
+// ---- macros
+
+#define MEO_PP_CAT_(a, b) a##b
+#define MEO_PP_CAT(a, b) MEO_PP_CAT_(a, b)
+#define MEO_PP_NARG_(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, N, ...) N
+#define MEO_PP_NARG(...) MEO_PP_NARG_(__VA_ARGS__, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+
+#define MEO_PP_FE_1(m, T, x)       m(T, x)
+#define MEO_PP_FE_2(m, T, x, ...)  m(T, x), MEO_PP_FE_1(m, T, __VA_ARGS__)
+#define MEO_PP_FE_3(m, T, x, ...)  m(T, x), MEO_PP_FE_2(m, T, __VA_ARGS__)
+#define MEO_PP_FE_4(m, T, x, ...)  m(T, x), MEO_PP_FE_3(m, T, __VA_ARGS__)
+#define MEO_PP_FE_5(m, T, x, ...)  m(T, x), MEO_PP_FE_4(m, T, __VA_ARGS__)
+#define MEO_PP_FE_6(m, T, x, ...)  m(T, x), MEO_PP_FE_5(m, T, __VA_ARGS__)
+#define MEO_PP_FE_7(m, T, x, ...)  m(T, x), MEO_PP_FE_6(m, T, __VA_ARGS__)
+#define MEO_PP_FE_8(m, T, x, ...)  m(T, x), MEO_PP_FE_7(m, T, __VA_ARGS__)
+#define MEO_PP_FE_9(m, T, x, ...)  m(T, x), MEO_PP_FE_8(m, T, __VA_ARGS__)
+#define MEO_PP_FE_10(m, T, x, ...) m(T, x), MEO_PP_FE_9(m, T, __VA_ARGS__)
+#define MEO_PP_FE_11(m, T, x, ...) m(T, x), MEO_PP_FE_10(m, T, __VA_ARGS__)
+#define MEO_PP_FE_12(m, T, x, ...) m(T, x), MEO_PP_FE_11(m, T, __VA_ARGS__)
+#define MEO_PP_FE_13(m, T, x, ...) m(T, x), MEO_PP_FE_12(m, T, __VA_ARGS__)
+#define MEO_PP_FE_14(m, T, x, ...) m(T, x), MEO_PP_FE_13(m, T, __VA_ARGS__)
+#define MEO_PP_FE_15(m, T, x, ...) m(T, x), MEO_PP_FE_14(m, T, __VA_ARGS__)
+#define MEO_PP_FE_16(m, T, x, ...) m(T, x), MEO_PP_FE_15(m, T, __VA_ARGS__)
+#define MEO_PP_FOR_EACH(m, T, ...) MEO_PP_CAT(MEO_PP_FE_, MEO_PP_NARG(__VA_ARGS__))(m, T, __VA_ARGS__)
+
+#define MEO_EVENT_FIELD_(T, m) meoEventField<T>(#m, &T::m)
+
+// Event published as meo/{id}/event/<Name>
+#define MEO_EVENT_NAMED(Type, Name, ...)                                                  \
+    template <>                                                                           \
+    struct MeoEventTraits<Type> {                                                         \
+        static constexpr bool defined = true;                                             \
+        static constexpr const char* name() { return Name; }                              \
+        static constexpr auto fields() {                                                  \
+            return std::make_tuple(MEO_PP_FOR_EACH(MEO_EVENT_FIELD_, Type, __VA_ARGS__)); \
+        }                                                                                 \
+    };
+
+// Event named after the struct
+#define MEO_EVENT(Type, ...) MEO_EVENT_NAMED(Type, #Type, __VA_ARGS__)
+
+#endif // MEO3_EVENT_H
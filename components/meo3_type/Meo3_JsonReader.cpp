@@ -0,0 +1,300 @@
+#include "Meo3_JsonReader.h"
+
+#include <cstdlib>
+#include <cstring>
+
+// Scanner shared by parse(), lookups and the iterator. Lookups rescan a
+// document that parse() already validated, so they take the same path.
+struct MeoJsonScan {
+    static const char* ws(const char* p, const char* end) {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) ++p;
+        return p;
+    }
+
+    static int hexVal(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+
+    // p at the opening quote; returns past the closing quote
+    static const char* string(const char* p, const char* end) {
+        ++p;
+        while (p < end) {
+            unsigned char c = (unsigned char)*p;
+            if (c == '"') return p + 1;
+            if (c < 0x20) return nullptr;
+            if (c == '\\') {
+                if (++p >= end) return nullptr;
+                switch (*p) {
+                    case '"': case '\\': case '/': case 'b':
+                    case 'f': case 'n': case 'r': case 't':
+                        break;
+                    case 'u':
+                        if (end - p < 5) return nullptr;
+                        for (int i = 1; i <= 4; ++i) {
+                            if (hexVal(p[i]) < 0) return nullptr;
+                        }
+                        p += 4;
+                        break;
+                    default:
+                        return nullptr;
+                }
+            }
+            ++p;
+        }
+        return nullptr;
+    }
+
+    static const char* digits(const char* p, const char* end) {
+        const char* s = p;
+        while (p < end && *p >= '0' && *p <= '9') ++p;
+        return p == s ? nullptr : p;
+    }
+
+    static const char* number(const char* p, const char* end) {
+        if (p < end && *p == '-') ++p;
+        if (p < end && *p == '0') ++p;
+        else if (!(p = digits(p, end))) return nullptr;
+        if (p < end && *p == '.') {
+            if (!(p = digits(p + 1, end))) return nullptr;
+        }
+        if (p < end && (*p == 'e' || *p == 'E')) {
+            ++p;
+            if (p < end && (*p == '+' || *p == '-')) ++p;
+            if (!(p = digits(p, end))) return nullptr;
+        }
+        return p;
+    }
+
+    static const char* literal(const char* p, const char* end, const char* word, size_t n) {
+        return ((size_t)(end - p) >= n && memcmp(p, word, n) == 0) ? p + n : nullptr;
+    }
+
+    // Scan one value starting at p (no leading whitespace); fills out, returns past it
+    static const char* value(const char* p, const char* end, int depth, MeoJsonView& out) {
+        if (p >= end) return nullptr;
+        const char* q = nullptr;
+        MeoJsonType t = MeoJsonType::Invalid;
+        switch (*p) {
+            case '"': q = string(p, end);                   t = MeoJsonType::String; break;
+            case 't': q = literal(p, end, "true", 4);       t = MeoJsonType::Bool;   break;
+            case 'f': q = literal(p, end, "false", 5);      t = MeoJsonType::Bool;   break;
+            case 'n': q = literal(p, end, "null", 4);       t = MeoJsonType::Null;   break;
+            case '{': q = container(p, end, depth, true);   t = MeoJsonType::Object; break;
+            case '[': q = container(p, end, depth, false);  t = MeoJsonType::Array;  break;
+            default:
+                if (*p == '-' || (*p >= '0' && *p <= '9')) {
+                    q = number(p, end);
+                    t = MeoJsonType::Number;
+                }
+        }
+        if (!q) return nullptr;
+        out._p = p;
+        out._n = (size_t)(q - p);
+        out._type = t;
+        return q;
+    }
+
+    static const char* container(const char* p, const char* end, int depth, bool object) {
+        if (depth >= MEO_JSON_MAX_DEPTH) return nullptr;
+        const char close = object ? '}' : ']';
+        p = ws(p + 1, end);
+        if (p < end && *p == close) return p + 1;
+        MeoJsonView v;
+        for (;;) {
+            if (object) {
+                if (p >= end || *p != '"' || !(p = string(p, end))) return nullptr;
+                p = ws(p, end);
+                if (p >= end || *p != ':') return nullptr;
+                p = ws(p + 1, end);
+            }
+            if (!(p = value(p, end, depth + 1, v))) return nullptr;
+            p = ws(p, end);
+            if (p >= end) return nullptr;
+            if (*p == close) return p + 1;
+            if (*p != ',') return nullptr;
+            p = ws(p + 1, end);
+        }
+    }
+};
+
+// --- MeoJsonView ---
+
+MeoJsonView MeoJsonView::parse(const char* json, size_t len) {
+    MeoJsonView root;
+    if (!json) return root;
+    const char* end = json + len;
+    const char* p = MeoJsonScan::ws(json, end);
+    p = MeoJsonScan::value(p, end, 0, root);
+    // Trailing garbage (other than whitespace / a NUL terminator) invalidates the document
+    if (!p) return MeoJsonView();
+    p = MeoJsonScan::ws(p, end);
+    if (p != end && !(*p == '\0' && p + 1 == end)) return MeoJsonView();
+    return root;
+}
+
+bool MeoJsonView::isInteger() const {
+    if (_type != MeoJsonType::Number) return false;
+    for (size_t i = 0; i < _n; ++i) {
+        char c = _p[i];
+        if (c == '.' || c == 'e' || c == 'E') return false;
+    }
+    return true;
+}
+
+int64_t MeoJsonView::asInt(int64_t def) const {
+    if (_type == MeoJsonType::Bool) return _p[0] == 't' ? 1 : 0;
+    if (_type != MeoJsonType::Number) return def;
+    if (!isInteger()) return (int64_t)asDouble((double)def);
+    // Integer fast path: no copy, no strtoll
+    size_t i = 0;
+    bool neg = (_p[0] == '-');
+    if (neg) i = 1;
+    uint64_t v = 0;
+    for (; i < _n; ++i) {
+        uint64_t d = (uint64_t)(_p[i] - '0');
+        if (v > (UINT64_MAX - d) / 10) return def;  // overflow
+        v = v * 10 + d;
+    }
+    if (v > (uint64_t)INT64_MAX + (neg ? 1 : 0)) return def;
+    return neg ? (int64_t)(0 - v) : (int64_t)v;
+}
+
+double MeoJsonView::asDouble(double def) const {
+    if (_type == MeoJsonType::Bool) return _p[0] == 't' ? 1.0 : 0.0;
+    if (_type != MeoJsonType::Number) return def;
+    char buf[40];
+    if (_n >= sizeof(buf)) return def;
+    memcpy(buf, _p, _n);
+    buf[_n] = '\0';
+    return strtod(buf, nullptr);
+}
+
+bool MeoJsonView::asBool(bool def) const {
+    if (_type == MeoJsonType::Bool)   return _p[0] == 't';
+    if (_type == MeoJsonType::Number) return asDouble(0.0) != 0.0;
+    return def;
+}
+
+std::string_view MeoJsonView::asString() const {
+    if (_type != MeoJsonType::String || _n < 2) return std::string_view();
+    return std::string_view(_p + 1, _n - 2);
+}
+
+bool MeoJsonView::needsUnescape() const {
+    std::string_view s = asString();
+    return !s.empty() && memchr(s.data(), '\\', s.size()) != nullptr;
+}
+
+bool MeoJsonView::unescape(char* out, size_t cap, size_t& outLen) const {
+    std::string_view s = asString();
+    size_t o = 0;
+    for (size_t i = 0; i < s.size(); ++i) {
+        char c = s[i];
+        if (c != '\\') {
+            if (o >= cap) return false;
+            out[o++] = c;
+            continue;
+        }
+        c = s[++i];
+        uint32_t cp = 0;
+        switch (c) {
+            case 'b': cp = '\b'; break;
+            case 'f': cp = '\f'; break;
+            case 'n': cp = '\n'; break;
+            case 'r': cp = '\r'; break;
+            case 't': cp = '\t'; break;
+            case 'u':
+                for (int k = 1; k <= 4; ++k) cp = (cp << 4) | (uint32_t)MeoJsonScan::hexVal(s[i + k]);
+                i += 4;
+                // Surrogate pair
+                if (cp >= 0xD800 && cp < 0xDC00 && i + 6 < s.size() && s[i + 1] == '\\' && s[i + 2] == 'u') {
+                    uint32_t lo = 0;
+                    for (int k = 3; k <= 6; ++k) lo = (lo << 4) | (uint32_t)MeoJsonScan::hexVal(s[i + k]);
+                    if (lo >= 0xDC00 && lo < 0xE000) {
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                        i += 6;
+                    }
+                }
+                break;
+            default: cp = (uint8_t)c;  // \" \\ \/
+        }
+        // UTF-8 encode
+        char u[4];
+        size_t n;
+        if (cp < 0x80)         { u[0] = (char)cp; n = 1; }
+        else if (cp < 0x800)   { u[0] = (char)(0xC0 | (cp >> 6));  u[1] = (char)(0x80 | (cp & 0x3F)); n = 2; }
+        else if (cp < 0x10000) { u[0] = (char)(0xE0 | (cp >> 12)); u[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+                                 u[2] = (char)(0x80 | (cp & 0x3F)); n = 3; }
+        else                   { u[0] = (char)(0xF0 | (cp >> 18)); u[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+                                 u[2] = (char)(0x80 | ((cp >> 6) & 0x3F)); u[3] = (char)(0x80 | (cp & 0x3F)); n = 4; }
+        if (o + n > cap) return false;
+        memcpy(out + o, u, n);
+        o += n;
+    }
+    outLen = o;
+    return true;
+}
+
+MeoJsonView MeoJsonView::get(std::string_view key) const {
+    if (_type != MeoJsonType::Object) return MeoJsonView();
+    MeoJsonIterator it(*this);
+    while (it.next()) {
+        if (it.key() == key) return it.value();
+    }
+    return MeoJsonView();
+}
+
+MeoJsonView MeoJsonView::at(size_t index) const {
+    if (_type != MeoJsonType::Array) return MeoJsonView();
+    MeoJsonIterator it(*this);
+    for (size_t i = 0; it.next(); ++i) {
+        if (i == index) return it.value();
+    }
+    return MeoJsonView();
+}
+
+size_t MeoJsonView::size() const {
+    if (_type != MeoJsonType::Object && _type != MeoJsonType::Array) return 0;
+    MeoJsonIterator it(*this);
+    size_t n = 0;
+    while (it.next()) ++n;
+    return n;
+}
+
+// --- MeoJsonIterator ---
+
+MeoJsonIterator::MeoJsonIterator(const MeoJsonView& c) {
+    if (c._type != MeoJsonType::Object && c._type != MeoJsonType::Array) return;
+    _object = (c._type == MeoJsonType::Object);
+    _pos = c._p + 1;          // past '{' / '['
+    _end = c._p + c._n - 1;   // at '}' / ']'
+}
+
+bool MeoJsonIterator::next() {
+    if (!_pos) return false;
+    const char* p = MeoJsonScan::ws(_pos, _end);
+    if (!_first) {
+        if (p >= _end || *p != ',') { _pos = nullptr; return false; }
+        p = MeoJsonScan::ws(p + 1, _end);
+    }
+    if (p >= _end) { _pos = nullptr; return false; }
+    _first = false;
+
+    if (_object) {
+        const char* k = p;
+        p = MeoJsonScan::string(p, _end);
+        if (!p) { _pos = nullptr; return false; }
+        _key = std::string_view(k + 1, (size_t)(p - k - 2));
+        p = MeoJsonScan::ws(p, _end);
+        if (p >= _end || *p != ':') { _pos = nullptr; return false; }
+        p = MeoJsonScan::ws(p + 1, _end);
+    }
+    // Depth was checked by parse(); a view taken from a valid document cannot exceed it
+    p = MeoJsonScan::value(p, _end, 0, _value);
+    if (!p) { _pos = nullptr; return false; }
+    _pos = p;
+    return true;
+}
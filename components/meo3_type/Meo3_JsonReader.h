@@ -0,0 +1,99 @@
+#ifndef MEO3_JSON_READER_H
+#define MEO3_JSON_READER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Deepest object/array nesting accepted by the reader
+#ifndef MEO_JSON_MAX_DEPTH
+#define MEO_JSON_MAX_DEPTH 16
+#endif
+
+enum class MeoJsonType : uint8_t {
+    Invalid = 0,
+    Null,
+    Bool,
+    Number,
+    String,
+    Object,
+    Array
+};
+
+/**
+ * MeoJsonView: một giá trị JSON nằm ngay trong buffer gốc (vd. data của esp-mqtt).
+ * - Không malloc, không copy, không cần '\0' cuối buffer.
+ * - parse() kiểm tra toàn bộ tài liệu một lần; các lần tra cứu sau chỉ quét lại
+ *   đoạn cần thiết. View chỉ hợp lệ khi buffer gốc còn sống.
+ * - Chuỗi trả về dạng view thô (chưa unescape); dùng unescape() nếu cần.
+ */
+class MeoJsonView {
+public:
+    MeoJsonView() {}
+
+    // Validate `json` and return its root value (Invalid on any syntax error)
+    static MeoJsonView parse(const char* json, size_t len);
+
+    MeoJsonType type() const { return _type; }
+    bool valid()    const { return _type != MeoJsonType::Invalid; }
+    bool isNull()   const { return _type == MeoJsonType::Null; }
+    bool isBool()   const { return _type == MeoJsonType::Bool; }
+    bool isNumber() const { return _type == MeoJsonType::Number; }
+    bool isString() const { return _type == MeoJsonType::String; }
+    bool isObject() const { return _type == MeoJsonType::Object; }
+    bool isArray()  const { return _type == MeoJsonType::Array; }
+    // Number without fraction/exponent
+    bool isInteger() const;
+
+    // Exact source text of this value (strings keep their quotes)
+    std::string_view raw() const { return std::string_view(_p, _n); }
+
+    // Typed accessors; `def` when the value has another type
+    int64_t          asInt(int64_t def = 0) const;
+    double           asDouble(double def = 0.0) const;
+    bool             asBool(bool def = false) const;
+    std::string_view asString() const;   // contents without quotes, still escaped
+
+    // Strings: true if asString() contains backslash escapes
+    bool needsUnescape() const;
+    // Decode escapes into out; false if it does not fit. \uXXXX becomes UTF-8.
+    bool unescape(char* out, size_t cap, size_t& outLen) const;
+
+    // Object member (Invalid if missing / not an object). Keys compare raw.
+    MeoJsonView get(std::string_view key) const;
+    MeoJsonView operator[](std::string_view key) const { return get(key); }
+    // Array element (Invalid if out of range / not an array)
+    MeoJsonView at(size_t index) const;
+    // Number of members / elements
+    size_t size() const;
+
+private:
+    friend class MeoJsonIterator;
+    friend struct MeoJsonScan;
+
+    const char* _p = nullptr;
+    size_t      _n = 0;
+    MeoJsonType _type = MeoJsonType::Invalid;
+};
+
+// Walk the members of an object or the elements of an array:
+//   MeoJsonIterator it(params);
+//   while (it.next()) { it.key(); it.value(); }
+class MeoJsonIterator {
+public:
+    explicit MeoJsonIterator(const MeoJsonView& container);
+
+    bool next();
+    std::string_view   key()   const { return _key; }   // objects only; raw, no quotes
+    const MeoJsonView& value() const { return _value; }
+
+private:
+    const char*      _pos = nullptr;
+    const char*      _end = nullptr;
+    bool             _object = false;
+    bool             _first  = true;
+    std::string_view _key;
+    MeoJsonView      _value;
+};
+
+#endif // MEO3_JSON_READER_H
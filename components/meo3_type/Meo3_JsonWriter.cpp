@@ -0,0 +1,143 @@
+#include "Meo3_JsonWriter.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+static_assert(MEO_JSON_MAX_DEPTH <= 32, "MeoJsonWriter tracks depth in a 32-bit mask");
+
+void MeoJsonWriter::_put(const char* s, size_t n) {
+    if (n == 0) return;
+    if (_len + n <= _cap) {
+        memcpy(_buf + _len, s, n);
+    } else {
+        if (_len < _cap) memcpy(_buf + _len, s, _cap - _len);
+        _overflow = true;
+    }
+    _len += n;
+}
+
+// Comma before every element except the first; nothing right after a key
+void MeoJsonWriter::_sep() {
+    if (_afterKey) {
+        _afterKey = false;
+        return;
+    }
+    if (_depth == 0) {
+        if (_len > 0) _invalid = true;  // second top-level value
+        return;
+    }
+    uint32_t bit = 1u << (_depth - 1);
+    if (_hasItem & bit) _put(',');
+    _hasItem |= bit;
+}
+
+void MeoJsonWriter::_open(char c) {
+    _sep();
+    if (_depth >= MEO_JSON_MAX_DEPTH) {
+        _invalid = true;
+        return;
+    }
+    _put(c);
+    _depth++;
+    _hasItem &= ~(1u << (_depth - 1));
+}
+
+void MeoJsonWriter::_close(char c) {
+    if (_depth == 0 || _afterKey) {
+        _invalid = true;
+        return;
+    }
+    _put(c);
+    _depth--;
+}
+
+MeoJsonWriter& MeoJsonWriter::key(std::string_view k) {
+    if (_afterKey || _depth == 0) _invalid = true;
+    _sep();
+    _string(k);
+    _put(':');
+    _afterKey = true;
+    return *this;
+}
+
+MeoJsonWriter& MeoJsonWriter::value(std::string_view v) {
+    _sep();
+    _string(v);
+    return *this;
+}
+
+MeoJsonWriter& MeoJsonWriter::value(bool v) {
+    _sep();
+    if (v) _put("true", 4); else _put("false", 5);
+    return *this;
+}
+
+MeoJsonWriter& MeoJsonWriter::null() {
+    _sep();
+    _put("null", 4);
+    return *this;
+}
+
+MeoJsonWriter& MeoJsonWriter::raw(const char* json, size_t len) {
+    if (!json || len == 0) return null();
+    _sep();
+    _put(json, len);
+    return *this;
+}
+
+MeoJsonWriter& MeoJsonWriter::_int(int64_t v) {
+    char num[24];
+    int n = snprintf(num, sizeof(num), "%lld", (long long)v);
+    _sep();
+    _put(num, (size_t)n);
+    return *this;
+}
+
+MeoJsonWriter& MeoJsonWriter::_uint(uint64_t v) {
+    char num[24];
+    int n = snprintf(num, sizeof(num), "%llu", (unsigned long long)v);
+    _sep();
+    _put(num, (size_t)n);
+    return *this;
+}
+
+MeoJsonWriter& MeoJsonWriter::_float(double v, int precision) {
+    if (!std::isfinite(v)) return null();  // JSON has no NaN/Inf
+    char num[32];
+    int n = snprintf(num, sizeof(num), "%.*g", precision, v);
+    _sep();
+    _put(num, (size_t)n);
+    return *this;
+}
+
+void MeoJsonWriter::_string(std::string_view s) {
+    static const char hex[] = "0123456789abcdef";
+    _put('"');
+    // Copy unescaped runs in one go
+    size_t run = 0;
+    for (size_t i = 0; i < s.size(); ++i) {
+        unsigned char c = (unsigned char)s[i];
+        if (c >= 0x20 && c != '"' && c != '\\') continue;
+        _put(s.data() + run, i - run);
+        run = i + 1;
+        switch (c) {
+            case '"':  _put("\\\"", 2); break;
+            case '\\': _put("\\\\", 2); break;
+            case '\n': _put("\\n", 2);  break;
+            case '\r': _put("\\r", 2);  break;
+            case '\t': _put("\\t", 2);  break;
+            default: {
+                char u[6] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xF] };
+                _put(u, 6);
+            }
+        }
+    }
+    _put(s.data() + run, s.size() - run);
+    _put('"');
+}
+
+bool MeoJsonWriter::finish() {
+    if (_len < _cap) _buf[_len] = '\0';
+    return ok();
+}
@@ -0,0 +1,89 @@
+#ifndef MEO3_JSON_WRITER_H
+#define MEO3_JSON_WRITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+
+// Deepest object/array nesting the writer tracks
+#ifndef MEO_JSON_MAX_DEPTH
+#define MEO_JSON_MAX_DEPTH 16
+#endif
+
+/**
+ * MeoJsonWriter: ghi JSON tuần tự thẳng vào buffer của caller (không DOM, không malloc).
+ * - Dấu phẩy / ':' được tự chèn theo ngữ cảnh object/array.
+ * - Khi tràn buffer, writer ngừng ghi nhưng vẫn đếm: required() cho biết số byte
+ *   cần thiết, ok() trả false để caller báo lỗi thay vì gửi JSON cụt.
+ */
+class MeoJsonWriter {
+public:
+    MeoJsonWriter(char* buf, size_t cap) : _buf(buf), _cap(buf ? cap : 0) {}
+
+    MeoJsonWriter& beginObject() { _open('{'); return *this; }
+    MeoJsonWriter& endObject()   { _close('}'); return *this; }
+    MeoJsonWriter& beginArray()  { _open('['); return *this; }
+    MeoJsonWriter& endArray()    { _close(']'); return *this; }
+
+    MeoJsonWriter& key(std::string_view k);
+
+    MeoJsonWriter& value(std::string_view v);
+    MeoJsonWriter& value(const char* v) { return v ? value(std::string_view(v)) : null(); }
+    MeoJsonWriter& value(bool v);
+    MeoJsonWriter& value(float v)  { return _float((double)v, 7); }
+    MeoJsonWriter& value(double v) { return _float(v, 15); }
+
+    template <typename T,
+              typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value, int>::type = 0>
+    MeoJsonWriter& value(T v) {
+        if (std::is_signed<T>::value) return _int((int64_t)v);
+        return _uint((uint64_t)v);
+    }
+
+    MeoJsonWriter& null();
+
+    // Pre-serialized JSON value, copied verbatim
+    MeoJsonWriter& raw(const char* json, size_t len);
+
+    // key + value shorthand
+    template <typename T>
+    MeoJsonWriter& field(std::string_view k, const T& v) { return key(k).value(v); }
+
+    // Nothing was cut and every container is closed
+    bool   ok()       const { return !_overflow && !_invalid && _depth == 0 && _len > 0; }
+    bool   overflow() const { return _overflow; }
+    // Bytes written (<= capacity)
+    size_t length()   const { return _overflow ? 0 : _len; }
+    // Bytes the whole document needs, even after overflow
+    size_t required() const { return _len; }
+    size_t capacity() const { return _cap; }
+
+    // NUL-terminates when there is a spare byte; returns ok()
+    bool finish();
+
+private:
+    char*    _buf;
+    size_t   _cap;
+    size_t   _len = 0;
+    uint32_t _hasItem = 0;   // bit d: container at depth d already has an element
+    uint8_t  _depth = 0;
+    bool     _afterKey = false;
+    bool     _overflow = false;
+    bool     _invalid  = false;  // unbalanced / too deep
+
+    void _put(char c) {
+        if (_len < _cap) _buf[_len] = c; else _overflow = true;
+        _len++;
+    }
+    void _put(const char* s, size_t n);
+    void _sep();
+    void _open(char c);
+    void _close(char c);
+    void _string(std::string_view s);
+    MeoJsonWriter& _int(int64_t v);
+    MeoJsonWriter& _uint(uint64_t v);
+    MeoJsonWriter& _float(double v, int precision);
+};
+
+#endif // MEO3_JSON_WRITER_H
@@ -0,0 +1,110 @@
+#ifndef MEO3_METRICS_H
+#define MEO3_METRICS_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Dung lượng mặc định của MeoMetrics (MeoDevice tự tính theo số feature method)
+#ifndef MEO_METRICS_MAX
+#define MEO_METRICS_MAX 32
+#endif
+
+template <size_t Capacity> class MeoMetricsTable;
+
+// Một counter / gauge 32-bit. Cập nhật bằng atomic relaxed: đủ rẻ để để bật trong
+// production, đọc được từ bất kỳ task nào.
+class MeoMetric {
+public:
+    void     inc(uint32_t n = 1) { _v.fetch_add(n, std::memory_order_relaxed); }
+    void     set(uint32_t v)     { _v.store(v, std::memory_order_relaxed); }
+    uint32_t value() const       { return _v.load(std::memory_order_relaxed); }
+
+    const char* name()  const { return _name; }
+    const char* group() const { return _group; }
+
+private:
+    template <size_t> friend class MeoMetricsTable;
+
+    std::atomic<uint32_t> _v{0};
+    const char* _name  = nullptr;
+    const char* _group = nullptr;
+};
+
+/**
+ * MeoMetricsTable: bảng metric có tên, dung lượng cố định, không cấp phát.
+ * - metric() tìm hoặc thêm (lúc setup, từ một task); hot path giữ lại tham chiếu
+ *   và chỉ còn một phép cộng atomic.
+ * - Bảng đầy: metric() trả về một metric dự phòng không được báo cáo, nên call site
+ *   không bao giờ phải kiểm tra nullptr; số tên không có chỗ được đếm trong overflow()
+ *   và báo cáo là "metrics_overflow".
+ * - writeFields() ghi "name":value vào object đang mở; metric cùng group được gom
+ *   vào object con "group":{...}. Writer là MeoJsonWriter hoặc MeoCborWriter.
+ * - Tên / group phải sống lâu hơn bảng (chuỗi hằng, tên feature đã đăng ký).
+ */
+template <size_t Capacity>
+class MeoMetricsTable {
+public:
+    static_assert(Capacity > 0 && Capacity <= 0xFFFF, "metric count must fit the uint16_t index");
+
+    MeoMetric& metric(const char* name, const char* group = nullptr) {
+        if (!name || !*name) return _spare;
+        size_t n = size();
+        for (size_t i = 0; i < n; ++i) {
+            if (_same(_m[i]._name, name) && _same(_m[i]._group, group)) return _m[i];
+        }
+        if (n >= Capacity) {
+            _overflow.fetch_add(1, std::memory_order_relaxed);
+            return _spare;
+        }
+        _m[n]._name  = name;
+        _m[n]._group = group;
+        _count.store((uint16_t)(n + 1), std::memory_order_release);  // entry visible to readers
+        return _m[n];
+    }
+
+    size_t size() const { return _count.load(std::memory_order_acquire); }
+    static constexpr size_t capacity() { return Capacity; }
+    // Số lần metric() phải trả về metric dự phòng vì bảng đầy
+    uint32_t overflow() const { return _overflow.load(std::memory_order_relaxed); }
+    const MeoMetric& operator[](size_t i) const { return _m[i]; }
+
+    template <typename Writer>
+    void writeFields(Writer& w) const {
+        const size_t n = size();
+        for (size_t i = 0; i < n; ++i) {
+            if (!_m[i]._group) w.field(_m[i]._name, _m[i].value());
+        }
+        for (size_t i = 0; i < n; ++i) {
+            const char* g = _m[i]._group;
+            if (!g || _seenGroup(g, i)) continue;
+            w.key(g).beginObject();
+            for (size_t j = i; j < n; ++j) {
+                if (_same(_m[j]._group, g)) w.field(_m[j]._name, _m[j].value());
+            }
+            w.endObject();
+        }
+        if (overflow()) w.field("metrics_overflow", overflow());
+    }
+
+private:
+    MeoMetric             _m[Capacity];
+    MeoMetric             _spare;
+    std::atomic<uint16_t> _count{0};
+    std::atomic<uint32_t> _overflow{0};
+
+    static bool _same(const char* a, const char* b) {
+        return a == b || (a && b && strcmp(a, b) == 0);
+    }
+    bool _seenGroup(const char* g, size_t before) const {
+        for (size_t i = 0; i < before; ++i) {
+            if (_same(_m[i]._group, g)) return true;
+        }
+        return false;
+    }
+};
+
+using MeoMetrics = MeoMetricsTable<MEO_METRICS_MAX>;
+
+#endif // MEO3_METRICS_H
@@ -0,0 +1,221 @@
+#include "Meo3_Payload.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+// --- MeoValue ---
+
+namespace {
+// Views are not NUL-terminated: copy short numeric text before strto*
+bool viewToBuf(const char* p, uint32_t n, char (&buf)[32]) {
+    if (!p || n == 0 || n >= sizeof(buf)) return false;
+    memcpy(buf, p, n);
+    buf[n] = '\0';
+    return true;
+}
+}
+
+int64_t MeoValue::asInt(int64_t def) const {
+    switch (type) {
+        case MeoValueType::Int:   return i;
+        case MeoValueType::Float: return (int64_t)f;
+        case MeoValueType::Bool:  return b ? 1 : 0;
+        case MeoValueType::String: {
+            char buf[32];
+            if (!viewToBuf(s.ptr, s.len, buf)) return def;
+            char* end = nullptr;
+            long long v = strtoll(buf, &end, 10);
+            return (end && end != buf) ? (int64_t)v : def;
+        }
+        default: return def;
+    }
+}
+
+float MeoValue::asFloat(float def) const {
+    switch (type) {
+        case MeoValueType::Int:   return (float)i;
+        case MeoValueType::Float: return f;
+        case MeoValueType::Bool:  return b ? 1.0f : 0.0f;
+        case MeoValueType::String: {
+            char buf[32];
+            if (!viewToBuf(s.ptr, s.len, buf)) return def;
+            char* end = nullptr;
+            float v = strtof(buf, &end);
+            return (end && end != buf) ? v : def;
+        }
+        default: return def;
+    }
+}
+
+bool MeoValue::asBool(bool def) const {
+    switch (type) {
+        case MeoValueType::Int:   return i != 0;
+        case MeoValueType::Float: return f != 0.0f;
+        case MeoValueType::Bool:  return b;
+        case MeoValueType::String: {
+            std::string_view v(s.ptr, s.len);
+            if (v == "true"  || v == "1" || v == "on")  return true;
+            if (v == "false" || v == "0" || v == "off") return false;
+            return def;
+        }
+        default: return def;
+    }
+}
+
+// --- MeoPayload ---
+
+MeoPayload::~MeoPayload() {
+    delete[] _heap;
+}
+
+MeoPayload::MeoPayload(const MeoPayload& other) {
+    _copyFrom(other);
+}
+
+MeoPayload& MeoPayload::operator=(const MeoPayload& other) {
+    if (this != &other) {
+        _count = 0;
+        _copyFrom(other);
+    }
+    return *this;
+}
+
+MeoPayload::MeoPayload(MeoPayload&& other) noexcept {
+    *this = static_cast<MeoPayload&&>(other);
+}
+
+MeoPayload& MeoPayload::operator=(MeoPayload&& other) noexcept {
+    if (this == &other) return *this;
+    delete[] _heap;
+    _heap = nullptr;
+    _cap  = MEO_PAYLOAD_INLINE_FIELDS;
+    if (other._heap) {
+        // Steal the heap block
+        _heap = other._heap;
+        _cap  = other._cap;
+        other._heap = nullptr;
+        other._cap  = MEO_PAYLOAD_INLINE_FIELDS;
+    } else {
+        memcpy(_inline, other._inline, other._count * sizeof(Field));
+    }
+    _count = other._count;
+    other._count = 0;
+    return *this;
+}
+
+MeoPayload::MeoPayload(const std::map<std::string, std::string>& m) {
+    for (const auto& kv : m) {
+        set(std::string_view(kv.first), std::string_view(kv.second));
+    }
+}
+
+void MeoPayload::_copyFrom(const MeoPayload& other) {
+    while (_cap < other._count) {
+        if (!_grow()) break;
+    }
+    size_t n = other._count < _cap ? other._count : _cap;
+    memcpy(_data(), other._data(), n * sizeof(Field));
+    _count = n;
+}
+
+bool MeoPayload::_grow() {
+    size_t cap = _cap * 2;
+    Field* p = new (std::nothrow) Field[cap];
+    if (!p) return false;
+    memcpy(p, _data(), _count * sizeof(Field));
+    delete[] _heap;
+    _heap = p;
+    _cap  = cap;
+    return true;
+}
+
+bool MeoPayload::_set(std::string_view key, const MeoValue& val) {
+    if (key.empty() || key.size() > UINT16_MAX) return false;
+    Field* d = _data();
+    for (size_t i = 0; i < _count; ++i) {
+        if (d[i].name() == key) { d[i].value = val; return true; }
+    }
+    if (_count == _cap) {
+        if (!_grow()) return false;
+        d = _data();
+    }
+    d[_count].key    = key.data();
+    d[_count].keyLen = (uint16_t)key.size();
+    d[_count].value  = val;
+    _count++;
+    return true;
+}
+
+const MeoValue* MeoPayload::get(std::string_view key) const {
+    const Field* d = _data();
+    for (size_t i = 0; i < _count; ++i) {
+        if (d[i].name() == key) return &d[i].value;
+    }
+    return nullptr;
+}
+
+// --- JSON ---
+
+size_t MeoPayload::toJson(char* out, size_t cap) const {
+    MeoJsonWriter w(out, cap);
+    toJson(w);
+    return w.finish() ? w.length() : 0;
+}
+
+bool MeoPayload::copyOwned(MeoPayload& out, std::vector<char>& store) const {
+    size_t bytes = 0;
+    for (const Field& f : *this) {
+        bytes += f.keyLen;
+        if (f.value.type == MeoValueType::String || f.value.type == MeoValueType::Raw) bytes += f.value.s.len;
+    }
+    std::vector<char> owned(bytes);
+    MeoPayload copy;   // out may be this
+    char* p = owned.data();
+    bool ok = true;
+    for (const Field& f : *this) {
+        memcpy(p, f.key, f.keyLen);
+        std::string_view key(p, f.keyLen);
+        p += f.keyLen;
+        MeoValue v = f.value;
+        if (v.type == MeoValueType::String || v.type == MeoValueType::Raw) {
+            memcpy(p, v.s.ptr, v.s.len);
+            v.s.ptr = p;
+            p += v.s.len;
+        }
+        ok = copy._set(key, v) && ok;
+    }
+    out = static_cast<MeoPayload&&>(copy);
+    // The vector's block moves with it, so views stay valid when store is moved
+    store.swap(owned);
+    return ok;
+}
+
+std::map<std::string, std::string> MeoPayload::toMap() const {
+    std::map<std::string, std::string> m;
+    for (const Field& f : *this) {
+        std::string& dst = m[std::string(f.key, f.keyLen)];
+        char num[32];
+        switch (f.value.type) {
+            case MeoValueType::String:
+            case MeoValueType::Raw:
+                dst.assign(f.value.s.ptr, f.value.s.len);
+                break;
+            case MeoValueType::Int:
+                snprintf(num, sizeof(num), "%lld", (long long)f.value.i);
+                dst = num;
+                break;
+            case MeoValueType::Float:
+                snprintf(num, sizeof(num), "%.7g", (double)f.value.f);
+                dst = num;
+                break;
+            case MeoValueType::Bool:
+                dst = f.value.b ? "true" : "false";
+                break;
+            default:
+                dst.clear();
+        }
+    }
+    return m;
+}
@@ -0,0 +1,190 @@
+#ifndef MEO3_PAYLOAD_H
+#define MEO3_PAYLOAD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "Meo3_JsonWriter.h"
+#include "Meo3_Cbor.h"
+
+// Số field lưu inline (không cấp phát); vượt quá thì chuyển sang heap
+#ifndef MEO_PAYLOAD_INLINE_FIELDS
+#define MEO_PAYLOAD_INLINE_FIELDS 8
+#endif
+
+enum class MeoValueType : uint8_t {
+    None = 0,
+    Int,
+    Float,
+    Bool,
+    String,
+    Raw      // nested JSON (object/array) kept as its source text
+};
+
+// One typed value. Strings are views: the caller keeps the characters alive
+// while the payload is in use (string literals, a parsed message buffer, ...).
+struct MeoValue {
+    MeoValueType type = MeoValueType::None;
+    union {
+        int64_t i;
+        float   f;
+        bool    b;
+        struct { const char* ptr; uint32_t len; } s;
+    };
+
+    MeoValue() : i(0) {}
+
+    bool isNull()   const { return type == MeoValueType::None; }
+    bool isNumber() const { return type == MeoValueType::Int || type == MeoValueType::Float; }
+
+    // Conversions are lenient: "42" reads as 42, true as 1, etc.
+    int64_t          asInt(int64_t def = 0) const;
+    float            asFloat(float def = 0.0f) const;
+    bool             asBool(bool def = false) const;
+    // String contents, or the JSON text of a Raw value
+    std::string_view asString() const {
+        return (type == MeoValueType::String || type == MeoValueType::Raw)
+                   ? std::string_view(s.ptr, s.len) : std::string_view();
+    }
+};
+
+/**
+ * MeoPayload: tập key/value có kiểu, dạng mảng phẳng.
+ * - MEO_PAYLOAD_INLINE_FIELDS field đầu nằm ngay trong object, không malloc.
+ * - Key và chuỗi là view (không copy); dữ liệu gốc phải sống lâu hơn payload.
+ * - set() với key đã có sẽ ghi đè; thứ tự field giữ theo lần set đầu tiên.
+ * - toJson()/toCbor() ghi thẳng object vào buffer của caller, không qua chuỗi trung gian.
+ */
+class MeoPayload {
+public:
+    struct Field {
+        const char* key;
+        uint16_t    keyLen;
+        MeoValue    value;
+
+        std::string_view name() const { return std::string_view(key, keyLen); }
+    };
+
+    MeoPayload() {}
+    ~MeoPayload();
+    MeoPayload(const MeoPayload& other);
+    MeoPayload& operator=(const MeoPayload& other);
+    MeoPayload(MeoPayload&& other) noexcept;
+    MeoPayload& operator=(MeoPayload&& other) noexcept;
+
+    // Compatibility with the std::map payload: views into `m`, which must outlive this
+    explicit MeoPayload(const std::map<std::string, std::string>& m);
+
+    // Setters return false if the field could not be stored (out of memory / key too long)
+    bool set(std::string_view key, bool v) {
+        MeoValue val; val.type = MeoValueType::Bool; val.b = v;
+        return _set(key, val);
+    }
+    bool set(std::string_view key, const char* v) {
+        return v ? set(key, std::string_view(v)) : setNull(key);
+    }
+    bool set(std::string_view key, std::string_view v) {
+        MeoValue val; val.type = MeoValueType::String;
+        val.s.ptr = v.data(); val.s.len = (uint32_t)v.size();
+        return _set(key, val);
+    }
+    bool set(std::string_view key, const std::string& v) { return set(key, std::string_view(v)); }
+    bool set(std::string_view key, std::string&&) = delete;  // would dangle
+
+    template <typename T,
+              typename std::enable_if<std::is_arithmetic<T>::value && !std::is_same<T, bool>::value, int>::type = 0>
+    bool set(std::string_view key, T v) {
+        MeoValue val;
+        if (std::is_floating_point<T>::value) { val.type = MeoValueType::Float; val.f = (float)v; }
+        else                                  { val.type = MeoValueType::Int;   val.i = (int64_t)v; }
+        return _set(key, val);
+    }
+
+    bool setNull(std::string_view key) { return _set(key, MeoValue()); }
+
+    // Pre-serialized JSON (object/array), emitted verbatim by toJson()
+    bool setRaw(std::string_view key, std::string_view json) {
+        MeoValue val; val.type = MeoValueType::Raw;
+        val.s.ptr = json.data(); val.s.len = (uint32_t)json.size();
+        return _set(key, val);
+    }
+
+    // nullptr if the key is absent
+    const MeoValue* get(std::string_view key) const;
+    bool has(std::string_view key) const { return get(key) != nullptr; }
+
+    int64_t getInt(std::string_view key, int64_t def = 0) const {
+        const MeoValue* v = get(key); return v ? v->asInt(def) : def;
+    }
+    float getFloat(std::string_view key, float def = 0.0f) const {
+        const MeoValue* v = get(key); return v ? v->asFloat(def) : def;
+    }
+    bool getBool(std::string_view key, bool def = false) const {
+        const MeoValue* v = get(key); return v ? v->asBool(def) : def;
+    }
+    std::string_view getString(std::string_view key) const {
+        const MeoValue* v = get(key); return v ? v->asString() : std::string_view();
+    }
+
+    size_t size()  const { return _count; }
+    bool   empty() const { return _count == 0; }
+    void   clear() { _count = 0; }
+
+    const Field* begin() const { return _data(); }
+    const Field* end()   const { return _data() + _count; }
+    const Field& operator[](size_t i) const { return _data()[i]; }
+
+    // Serialize as a JSON object into out[0..cap). Returns the length written
+    // (NUL-terminated when there is room), or 0 if it does not fit.
+    size_t toJson(char* out, size_t cap) const;
+    // Append as an object value to a writer (check w.ok() afterwards)
+    void toJson(MeoJsonWriter& w) const { encode(w); }
+    void toCbor(MeoCborWriter& w) const { encode(w); }
+    // Same, for code written against either writer (fill(auto& w))
+    template <typename Writer>
+    void encode(Writer& w) const;
+
+    // Owned copy in the legacy map shape (numbers formatted as text)
+    std::map<std::string, std::string> toMap() const;
+    // Copy into out whose keys and strings live in store (replaced), so it no longer
+    // depends on the buffers this payload views. False if out could not hold every field.
+    bool copyOwned(MeoPayload& out, std::vector<char>& store) const;
+
+private:
+    Field   _inline[MEO_PAYLOAD_INLINE_FIELDS];
+    Field*  _heap  = nullptr;
+    size_t  _cap   = MEO_PAYLOAD_INLINE_FIELDS;
+    size_t  _count = 0;
+
+    Field*       _data()       { return _heap ? _heap : _inline; }
+    const Field* _data() const { return _heap ? _heap : _inline; }
+
+    bool _set(std::string_view key, const MeoValue& val);
+    bool _grow();
+    void _copyFrom(const MeoPayload& other);
+};
+
+template <typename Writer>
+void MeoPayload::encode(Writer& w) const {
+    w.beginObject();
+    for (const Field& f : *this) {
+        w.key(f.name());
+        const MeoValue& v = f.value;
+        switch (v.type) {
+            case MeoValueType::Int:    w.value(v.i); break;
+            case MeoValueType::Float:  w.value(v.f); break;
+            case MeoValueType::Bool:   w.value(v.b); break;
+            case MeoValueType::String: w.value(v.asString()); break;
+            case MeoValueType::Raw:    w.raw(v.s.ptr, v.s.len); break;  // JSON text
+            default:                   w.null();
+        }
+    }
+    w.endObject();
+}
+
+#endif // MEO3_PAYLOAD_H
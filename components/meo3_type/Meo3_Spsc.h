@@ -0,0 +1,77 @@
+#ifndef MEO3_SPSC_H
+#define MEO3_SPSC_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * MeoSpscQueue: hàng đợi vòng lock-free, đúng một task ghi và một task đọc
+ * (vd task esp-mqtt -> loop() của ứng dụng trên core kia).
+ * - N phải là luỹ thừa của 2; bộ nhớ nằm ngay trong object, không cấp phát.
+ * - _head chỉ producer ghi, _tail chỉ consumer ghi: không cần CAS, chỉ acquire/release.
+ * - Đầy: push() trả về false và tăng dropped(), không bao giờ block.
+ * - T phải copy được bằng phép gán; slot được ghi đè tại chỗ, không gọi destructor.
+ */
+template <typename T, size_t N>
+class MeoSpscQueue {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "MeoSpscQueue size must be a power of 2");
+
+public:
+    // Producer
+    bool push(const T& v) {
+        const uint32_t head = _head.load(std::memory_order_relaxed);
+        if (head - _tail.load(std::memory_order_acquire) >= N) {
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        _slots[head & (N - 1)] = v;
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Producer: ghi thẳng vào slot (tránh copy T lớn); publish() sau khi điền xong
+    T* reserve() {
+        const uint32_t head = _head.load(std::memory_order_relaxed);
+        if (head - _tail.load(std::memory_order_acquire) >= N) {
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        return &_slots[head & (N - 1)];
+    }
+    void publish() { _head.store(_head.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+    // Consumer
+    bool pop(T& out) {
+        const uint32_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail == _head.load(std::memory_order_acquire)) return false;
+        out = _slots[tail & (N - 1)];
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer: đọc tại chỗ; release() trả slot cho producer
+    const T* peek() const {
+        const uint32_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail == _head.load(std::memory_order_acquire)) return nullptr;
+        return &_slots[tail & (N - 1)];
+    }
+    void release() { _tail.store(_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+    // Bất kỳ task nào (ảnh chụp, có thể đã cũ ngay khi trả về)
+    size_t size() const {
+        const uint32_t tail = _tail.load(std::memory_order_acquire);  // tail trước: không bao giờ vượt head
+        return (size_t)(_head.load(std::memory_order_acquire) - tail);
+    }
+    bool   empty() const { return size() == 0; }
+    static constexpr size_t capacity() { return N; }
+    uint32_t dropped() const { return _dropped.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint32_t> _head{0};
+    std::atomic<uint32_t> _tail{0};
+    std::atomic<uint32_t> _dropped{0};
+    T                     _slots[N];
+};
+
+#endif // MEO3_SPSC_H
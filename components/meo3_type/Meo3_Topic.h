@@ -0,0 +1,157 @@
+#ifndef MEO3_TOPIC_H
+#define MEO3_TOPIC_H
+
+#include <cstddef>
+#include <cstring>
+
+#ifndef MEO_TOPIC_MAX
+#define MEO_TOPIC_MAX 128
+#endif
+
+// Fixed-capacity topic builder living on the stack: never allocates.
+// On overflow the content is cut and ok() turns false; callers must not publish it.
+template <size_t N = MEO_TOPIC_MAX>
+class MeoTopicBuf {
+public:
+    MeoTopicBuf() { _buf[0] = '\0'; }
+    explicit MeoTopicBuf(const char* s) { _buf[0] = '\0'; append(s); }
+
+    MeoTopicBuf& append(const char* s, size_t n) {
+        if (!s) return *this;
+        if (_len + n >= N) {
+            n = (_len < N - 1) ? (N - 1 - _len) : 0;
+            _overflow = true;
+        }
+        memcpy(_buf + _len, s, n);
+        _len += n;
+        _buf[_len] = '\0';
+        return *this;
+    }
+    MeoTopicBuf& append(const char* s) { return s ? append(s, strlen(s)) : *this; }
+
+    // Cut back to a previous length (reuse a prefix for several topics). The kept
+    // prefix is exact, so an earlier overflow past it no longer counts.
+    void truncate(size_t len) {
+        if (len < _len && len < N) { _len = len; _buf[_len] = '\0'; }
+        if (len <= _len) _overflow = false;
+    }
+
+    const char* c_str()  const { return _buf; }
+    size_t      length() const { return _len; }
+    bool        ok()     const { return !_overflow && _len > 0; }
+
+private:
+    char   _buf[N];
+    size_t _len = 0;
+    bool   _overflow = false;
+};
+
+// Per-device topic set, built once when the device id is known.
+// Layout follows the MEO convention: meo/{device_id}/...
+class MeoTopics {
+public:
+    MeoTopics() { clear(); }
+
+    void clear() {
+        _eventPrefix[0] = _status[0] = _declare[0] = _invoke[0] = _response[0] = _batch[0] = _metrics[0] = _latency[0] = '\0';
+        _eventPrefixLen = 0;
+        _invokeLen = 0;
+        _valid = false;
+    }
+
+    bool setDeviceId(const char* deviceId) {
+        clear();
+        if (!deviceId || !*deviceId) return false;
+        _valid = _build(_eventPrefix, deviceId, "/event/")
+              && _build(_status,      deviceId, "/status")
+              && _build(_declare,     deviceId, "/declare")
+              && _build(_invoke,      deviceId, "/feature/+/invoke")
+              && _build(_response,    deviceId, "/event/feature_response")
+              && _build(_batch,       deviceId, "/event/batch")
+              && _build(_metrics,     deviceId, "/metrics")
+              && _build(_latency,     deviceId, "/latency");
+        if (!_valid) { clear(); return false; }
+        _eventPrefixLen = strlen(_eventPrefix);
+        _invokeLen      = strlen(_invoke);
+        return true;
+    }
+
+    bool valid() const { return _valid; }
+
+    // meo/{id}/event/{name} into a stack buffer
+    template <size_t N>
+    bool event(MeoTopicBuf<N>& out, const char* eventName) const {
+        if (!_valid || !eventName || !*eventName) return false;
+        out.truncate(0);
+        out.append(_eventPrefix, _eventPrefixLen).append(eventName);
+        return out.ok();
+    }
+
+    // Extract {name} from meo/{id}/feature/{name}/invoke without copying.
+    // Only topics addressed to this device id match.
+    bool parseInvoke(const char* topic, size_t topicLen, const char*& name, size_t& nameLen) const {
+        static const size_t kSuffixLen = 7;  // "/invoke"
+        if (!_valid || !topic) return false;
+        const size_t prefixLen = _invokeLen - 8; // invoke filter minus "+/invoke"
+        if (topicLen <= prefixLen + kSuffixLen) return false;
+        if (memcmp(topic, _invoke, prefixLen) != 0) return false;
+        if (memcmp(topic + topicLen - kSuffixLen, "/invoke", kSuffixLen) != 0) return false;
+        name    = topic + prefixLen;
+        nameLen = topicLen - prefixLen - kSuffixLen;
+        return memchr(name, '/', nameLen) == nullptr;
+    }
+
+    // Any device: meo/{id}/feature/{name}/invoke -> id and name as views into topic.
+    // Used by gateway mode, which subscribes invokeFilterAll() for its children.
+    static bool parseAnyInvoke(const char* topic, size_t topicLen,
+                               const char*& id, size_t& idLen, const char*& name, size_t& nameLen) {
+        static const char kFeature[] = "/feature/";
+        static const size_t kFeatureLen = sizeof(kFeature) - 1;
+        static const size_t kSuffixLen = 7;  // "/invoke"
+        if (!topic || topicLen <= 4 + kFeatureLen + kSuffixLen || memcmp(topic, "meo/", 4) != 0) return false;
+        if (memcmp(topic + topicLen - kSuffixLen, "/invoke", kSuffixLen) != 0) return false;
+        id = topic + 4;
+        const char* slash = (const char*)memchr(id, '/', topicLen - 4);
+        if (!slash || slash == id) return false;
+        idLen = (size_t)(slash - id);
+        const size_t rest = topicLen - 4 - idLen;
+        if (rest <= kFeatureLen + kSuffixLen || memcmp(slash, kFeature, kFeatureLen) != 0) return false;
+        name    = slash + kFeatureLen;
+        nameLen = rest - kFeatureLen - kSuffixLen;
+        return memchr(name, '/', nameLen) == nullptr;
+    }
+    static const char* invokeFilterAll() { return "meo/+/feature/+/invoke"; }
+
+    const char* eventPrefix()    const { return _eventPrefix; }  // meo/{id}/event/
+    size_t      eventPrefixLen() const { return _eventPrefixLen; }
+    const char* status()         const { return _status; }       // meo/{id}/status
+    const char* declare()        const { return _declare; }      // meo/{id}/declare
+    const char* invokeFilter()   const { return _invoke; }       // meo/{id}/feature/+/invoke
+    const char* response()       const { return _response; }     // meo/{id}/event/feature_response
+    const char* batch()          const { return _batch; }        // meo/{id}/event/batch
+    const char* metrics()        const { return _metrics; }      // meo/{id}/metrics
+    const char* latency()        const { return _latency; }      // meo/{id}/latency
+
+private:
+    char   _eventPrefix[MEO_TOPIC_MAX];
+    char   _status[MEO_TOPIC_MAX];
+    char   _declare[MEO_TOPIC_MAX];
+    char   _invoke[MEO_TOPIC_MAX];
+    char   _response[MEO_TOPIC_MAX];
+    char   _batch[MEO_TOPIC_MAX];
+    char   _metrics[MEO_TOPIC_MAX];
+    char   _latency[MEO_TOPIC_MAX];
+    size_t _eventPrefixLen = 0;
+    size_t _invokeLen = 0;
+    bool   _valid = false;
+
+    static bool _build(char* dst, const char* deviceId, const char* suffix) {
+        MeoTopicBuf<MEO_TOPIC_MAX> b;
+        b.append("meo/").append(deviceId).append(suffix);
+        if (!b.ok()) return false;
+        memcpy(dst, b.c_str(), b.length() + 1);
+        return true;
+    }
+};
+
+#endif // MEO3_TOPIC_H
@@ -0,0 +1,107 @@
+#ifndef MEO3_TRACE_H
+#define MEO3_TRACE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Bucket i đếm độ trễ < 2^(i + MEO_TRACE_MIN_SHIFT) µs; bucket cuối nhận phần còn lại.
+// Mặc định 16 bucket: < 64 µs ... < 1 s, >= 1 s
+#ifndef MEO_TRACE_BUCKETS
+#define MEO_TRACE_BUCKETS 16
+#endif
+#ifndef MEO_TRACE_MIN_SHIFT
+#define MEO_TRACE_MIN_SHIFT 6
+#endif
+
+// Khoảng đo của một invoke, tính từ MQTT_EVENT_DATA (đã ghép fragment)
+enum class MeoTraceStage : uint8_t {
+    Parse = 0,   // data -> params đã parse (gồm thời gian chờ worker)
+    Handler,     // handler bắt đầu -> handler trả về
+    Response,    // data -> feature_response được đưa vào hàng gửi / outbox
+    Ack,         // data -> PUBACK của feature_response (chỉ QoS > 0)
+    Count
+};
+
+inline const char* meoTraceStageName(MeoTraceStage s) {
+    switch (s) {
+        case MeoTraceStage::Parse:    return "parse";
+        case MeoTraceStage::Handler:  return "handler";
+        case MeoTraceStage::Response: return "response";
+        case MeoTraceStage::Ack:      return "ack";
+        default:                      return "?";
+    }
+}
+
+/**
+ * MeoLatencyHistogram: histogram độ trễ thang log2, bucket cố định.
+ * - record() chỉ là vài phép atomic relaxed: gọi được từ mọi task, không khoá.
+ * - Percentile trả về cận trên của bucket chứa nó (sai số tối đa x2, đủ cho SLA).
+ * - write() cho MeoJsonWriter / MeoCborWriter:
+ *   {"n":..,"p50":..,"p90":..,"p99":..,"max":..,"b":[...]} (đơn vị µs)
+ */
+class MeoLatencyHistogram {
+public:
+    static size_t bucketOf(uint32_t us) {
+        size_t i = 0;
+        uint32_t v = us >> MEO_TRACE_MIN_SHIFT;
+        while (v && i < MEO_TRACE_BUCKETS - 1) { v >>= 1; ++i; }
+        return i;
+    }
+    // Exclusive upper bound of bucket i; UINT32_MAX for the last one
+    static uint32_t bucketLimitUs(size_t i) {
+        return i >= MEO_TRACE_BUCKETS - 1 ? UINT32_MAX : (uint32_t)1 << (i + MEO_TRACE_MIN_SHIFT);
+    }
+
+    void record(uint32_t us) {
+        _b[bucketOf(us)].fetch_add(1, std::memory_order_relaxed);
+        _n.fetch_add(1, std::memory_order_relaxed);
+        uint32_t m = _max.load(std::memory_order_relaxed);
+        while (us > m && !_max.compare_exchange_weak(m, us, std::memory_order_relaxed)) {}
+    }
+
+    uint32_t count()          const { return _n.load(std::memory_order_relaxed); }
+    uint32_t maxUs()          const { return _max.load(std::memory_order_relaxed); }
+    uint32_t bucket(size_t i) const { return _b[i].load(std::memory_order_relaxed); }
+
+    // 0 when empty; the last bucket reports the observed max
+    uint32_t percentileUs(uint8_t pct) const {
+        uint32_t n = count();
+        if (!n) return 0;
+        uint32_t rank = (uint32_t)(((uint64_t)n * pct + 99) / 100);
+        if (!rank) rank = 1;
+        uint32_t seen = 0;
+        for (size_t i = 0; i < MEO_TRACE_BUCKETS; ++i) {
+            seen += bucket(i);
+            if (seen >= rank) return i == MEO_TRACE_BUCKETS - 1 ? maxUs() : bucketLimitUs(i);
+        }
+        return maxUs();
+    }
+
+    void reset() {
+        for (auto& b : _b) b.store(0, std::memory_order_relaxed);
+        _n.store(0, std::memory_order_relaxed);
+        _max.store(0, std::memory_order_relaxed);
+    }
+
+    template <typename Writer>
+    void write(Writer& w) const {
+        w.beginObject();
+        w.field("n", count())
+         .field("p50", percentileUs(50))
+         .field("p90", percentileUs(90))
+         .field("p99", percentileUs(99))
+         .field("max", maxUs());
+        w.key("b").beginArray();
+        for (size_t i = 0; i < MEO_TRACE_BUCKETS; ++i) w.value(bucket(i));
+        w.endArray();
+        w.endObject();
+    }
+
+private:
+    std::atomic<uint32_t> _b[MEO_TRACE_BUCKETS] = {};
+    std::atomic<uint32_t> _n{0};
+    std::atomic<uint32_t> _max{0};
+};
+
+#endif // MEO3_TRACE_H
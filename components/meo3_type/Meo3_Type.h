@@ -7,6 +7,8 @@
 #include <vector>
 #include <cstdint>
 
+#include "Meo3_Payload.h"
+
 // Connection type mirrors org.thingai.meo.define.MConnectionType
 enum class MeoConnectionType : int {
     LAN  = 0,
@@ -23,15 +25,50 @@ struct MeoDeviceInfo {
         : model(""), manufacturer(""), connectionType(MeoConnectionType::LAN) {}
 };
 
-// Simple key-value payload type for events/feature params
-// Using std::string instead of Arduino String
+// Legacy key-value payload (one allocation per field); prefer MeoPayload.
+// Still accepted by MeoDevice::publishEvent and produced by MeoPayload::toMap().
 using MeoEventPayload = std::map<std::string, std::string>;  
 
+// Where an invoke is in its trace (filled by MeoDevice)
+struct MeoInvokeTrace {
+    uint32_t id         = 0;   // 0 = not traced
+    uint16_t method     = 0;
+    int64_t  receivedUs = 0;   // esp_timer time of MQTT_EVENT_DATA
+};
+
 // Represent a feature invocation from the gateway
 struct MeoFeatureCall {
     std::string deviceId;
     std::string featureName;
-    MeoEventPayload params;   // raw string values
+    // Typed values. In the callback they view the invoke message; a copy of the call
+    // owns its keys and strings, so it stays valid after the callback returns.
+    MeoPayload  params;
+    // "cid" of the invoke, echoed in the feature_response so the gateway can
+    // stitch end-to-end traces. Keep a copy of the call to respond later.
+    std::string    correlationId;
+    MeoInvokeTrace trace;
+
+    MeoFeatureCall() {}
+    MeoFeatureCall(const MeoFeatureCall& other) { *this = other; }
+    MeoFeatureCall& operator=(const MeoFeatureCall& other) {
+        if (this == &other) return *this;
+        deviceId      = other.deviceId;
+        featureName   = other.featureName;
+        correlationId = other.correlationId;
+        trace         = other.trace;
+        other.params.copyOwned(params, _paramStore);
+        return *this;
+    }
+    MeoFeatureCall(MeoFeatureCall&&) = default;
+    MeoFeatureCall& operator=(MeoFeatureCall&&) = default;
+
+    // params in its former std::map<std::string, std::string> shape (owned copy,
+    // numbers as text), for handlers written before MeoPayload
+    [[deprecated("use params.getInt() / getString() / ...")]]
+    std::map<std::string, std::string> paramsMap() const { return params.toMap(); }
+
+private:
+    std::vector<char> _paramStore;   // keys and strings of params in a copy
 };
 
 // Callback type for feature handlers
@@ -0,0 +1,225 @@
+#include "Meo3_UartClient.h"
+#include "esp_timer.h"
+#include <cstdio>
+#include <cstring>
+
+namespace {
+struct RouterLock {
+    SemaphoreHandle_t h;
+    explicit RouterLock(SemaphoreHandle_t m) : h(m) { if (h) xSemaphoreTake(h, portMAX_DELAY); }
+    ~RouterLock() { if (h) xSemaphoreGive(h); }
+};
+}
+
+MeoUartClient::MeoUartClient(const MeoUartConfig& cfg) : _link(cfg) {
+    _id[0] = '\0';
+    _routerLock = xSemaphoreCreateMutex();
+}
+
+MeoUartClient::~MeoUartClient() {
+    end();
+    if (_routerLock) vSemaphoreDelete(_routerLock);
+}
+
+bool MeoUartClient::begin(const char* deviceId, uint32_t linkTimeoutMs) {
+    size_t n = deviceId ? strlen(deviceId) : 0;
+    if (n == 0 || n >= sizeof(_id) || !_routerLock) return false;
+    memcpy(_id, deviceId, n + 1);
+    _idLen = n;
+    _linkTimeoutMs = linkTimeoutMs;
+    _lastRxMs.store(0, std::memory_order_relaxed);
+    return _link.begin(&_rxThunk, this);
+}
+
+void MeoUartClient::end() {
+    _link.end();
+}
+
+bool MeoUartClient::isConnected() const {
+    if (!_link.isRunning()) return false;
+    if (_linkTimeoutMs == 0) return true;
+    uint32_t last = _lastRxMs.load(std::memory_order_relaxed);
+    return last != 0 && (uint32_t)(_nowMs() - last) <= _linkTimeoutMs;
+}
+
+// meo/{id}/... của chính thiết bị -> loại frame + tên (view vào topic)
+bool MeoUartClient::_toMessage(const char* topic, MeoChildMessage& msg) const {
+    size_t len = topic ? strlen(topic) : 0;
+    if (len <= 4 + _idLen + 1 || memcmp(topic, "meo/", 4) != 0) return false;
+    if (memcmp(topic + 4, _id, _idLen) != 0 || topic[4 + _idLen] != '/') return false;
+
+    const char* rest = topic + 4 + _idLen + 1;
+    size_t restLen = len - (size_t)(rest - topic);
+    static const char kEvent[] = "event/";
+    static const size_t kEventLen = sizeof(kEvent) - 1;
+
+    msg.deviceId = _id;
+    msg.idLen    = (uint8_t)_idLen;
+    msg.name     = nullptr;
+    msg.nameLen  = 0;
+    if (restLen == 7 && memcmp(rest, "declare", 7) == 0) {
+        msg.type = MeoChildMsgType::Declare;
+    } else if (restLen == 6 && memcmp(rest, "status", 6) == 0) {
+        msg.type = MeoChildMsgType::Status;
+    } else if (restLen > kEventLen && memcmp(rest, kEvent, kEventLen) == 0) {
+        const char* name = rest + kEventLen;
+        size_t nameLen = restLen - kEventLen;
+        if (memchr(name, '/', nameLen) || nameLen > 255) return false;
+        if (nameLen == 16 && memcmp(name, "feature_response", 16) == 0) {
+            msg.type = MeoChildMsgType::Response;
+        } else {
+            msg.type    = MeoChildMsgType::Event;
+            msg.name    = name;
+            msg.nameLen = (uint8_t)nameLen;
+        }
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool MeoUartClient::publish(const char* topic, const uint8_t* payload, size_t len, bool retained, uint8_t qos) {
+    MeoChildMessage msg;
+    if (!_toMessage(topic, msg)) {
+        _rejected.fetch_add(1, std::memory_order_relaxed);
+        MEO_LOGW(_log, UART, "Topic not carried over UART: %s", topic ? topic : "");
+        return false;
+    }
+    msg.payload = payload;
+    msg.len     = len;
+    if (!_link.send(msg)) {
+        _rejected.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    _published.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool MeoUartClient::publish(const char* topic, const char* payload, bool retained, uint8_t qos) {
+    return publish(topic, (const uint8_t*)payload, payload ? strlen(payload) : 0, retained, qos);
+}
+
+bool MeoUartClient::subscribe(const char* filter, OnMessageFn fn, void* ctx, uint8_t qos) {
+    RouterLock g(_routerLock);
+    if (_router.add(filter, fn, ctx, qos) < 0) {
+        MEO_LOGE(_log, UART, "Cannot route %s (invalid filter or router full)", filter ? filter : "");
+        return false;
+    }
+    return true;
+}
+
+bool MeoUartClient::unsubscribe(const char* filter, OnMessageFn fn, void* ctx) {
+    RouterLock g(_routerLock);
+    return _router.remove(filter, fn, ctx);
+}
+
+void MeoUartClient::setMessageHandler(OnMessageFn fn, void* ctx) {
+    RouterLock g(_routerLock);
+    _onMessage = fn;
+    _onMessageCtx = ctx;
+}
+
+void MeoUartClient::setRedeclareHandler(RedeclareFn fn, void* ctx) {
+    RouterLock g(_routerLock);
+    _onRedeclare = fn;
+    _onRedeclareCtx = ctx;
+}
+
+// Static -> instance adapter
+void MeoUartClient::_rxThunk(const MeoChildMessage& msg, void* ctx) {
+    static_cast<MeoUartClient*>(ctx)->_onFrame(msg);
+}
+
+void MeoUartClient::_onFrame(const MeoChildMessage& msg) {
+    // Bus nhiều con: bỏ frame gửi cho id khác; id rỗng = mọi con
+    if (msg.idLen != 0 && (msg.idLen != _idLen || memcmp(msg.deviceId, _id, _idLen) != 0)) {
+        _ignored.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    _lastRxMs.store(_nowMs() | 1u, std::memory_order_relaxed);
+
+    switch (msg.type) {
+    case MeoChildMsgType::Invoke:
+        _deliverInvoke(msg);
+        break;
+    case MeoChildMsgType::Redeclare: {
+        RedeclareFn fn;
+        void* ctx;
+        {
+            RouterLock g(_routerLock);
+            fn  = _onRedeclare;
+            ctx = _onRedeclareCtx;
+        }
+        if (fn) {
+            fn(ctx);
+        } else {
+            MeoChildMessage st;
+            st.type     = MeoChildMsgType::Status;
+            st.deviceId = _id;
+            st.idLen    = (uint8_t)_idLen;
+            st.payload  = (const uint8_t*)"online";
+            st.len      = 6;
+            _link.send(st);
+        }
+        break;
+    }
+    default:
+        // Declare / Event / Response / Status chỉ đi từ con lên gateway
+        _ignored.fetch_add(1, std::memory_order_relaxed);
+        break;
+    }
+}
+
+void MeoUartClient::_deliverInvoke(const MeoChildMessage& msg) {
+    char topic[MEO_TOPIC_MAX];
+    int n = snprintf(topic, sizeof(topic), "meo/%s/feature/%.*s/invoke",
+                     _id, (int)msg.nameLen, msg.name ? msg.name : "");
+    if (msg.nameLen == 0 || n <= 0 || (size_t)n >= sizeof(topic)) {
+        _ignored.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    _invokes.fetch_add(1, std::memory_order_relaxed);
+    MEO_LOGD(_log, UART, "Invoke %.*s len=%u", (int)msg.nameLen, msg.name, (unsigned)msg.len);
+
+    // Lấy handler dưới khóa rồi gọi ngoài khóa, như MeoMqttClient
+    struct Target { OnMessageFn fn; void* ctx; };
+    Target targets[MEO_ROUTER_MAX_ROUTES];
+    Target fallback;
+    size_t count = 0;
+    {
+        RouterLock g(_routerLock);
+        fallback = Target{ _onMessage, _onMessageCtx };
+        int8_t idx[MEO_ROUTER_MAX_ROUTES];
+        size_t found = _router.match(topic, (size_t)n, idx, MEO_ROUTER_MAX_ROUTES);
+        if (found > MEO_ROUTER_MAX_ROUTES) found = MEO_ROUTER_MAX_ROUTES;
+        for (size_t i = 0; i < found; ++i) {
+            const MeoTopicRouter::Route& r = _router.route(idx[i]);
+            OnMessageFn fn = r.fn ? r.fn : _onMessage;
+            void* ctx = r.fn ? r.ctx : _onMessageCtx;
+            bool seen = false;
+            for (size_t j = 0; j < count && !seen; ++j) seen = (targets[j].fn == fn && targets[j].ctx == ctx);
+            if (fn && !seen) targets[count++] = Target{ fn, ctx };
+        }
+    }
+
+    if (count == 0) {
+        if (fallback.fn) fallback.fn(topic, (size_t)n, msg.payload, msg.len, fallback.ctx);
+        return;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        targets[i].fn(topic, (size_t)n, msg.payload, msg.len, targets[i].ctx);
+    }
+}
+
+MeoUartClientStats MeoUartClient::stats() const {
+    MeoUartClientStats s;
+    s.published = _published.load(std::memory_order_relaxed);
+    s.rejected  = _rejected.load(std::memory_order_relaxed);
+    s.invokes   = _invokes.load(std::memory_order_relaxed);
+    s.ignored   = _ignored.load(std::memory_order_relaxed);
+    return s;
+}
+
+uint32_t MeoUartClient::_nowMs() {
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
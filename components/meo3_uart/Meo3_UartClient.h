@@ -0,0 +1,93 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#include "Meo3_UartTransport.h"
+#include "Meo3_TopicRouter.h"   // MeoMessageFn, định tuyến invoke theo filter
+#include "Meo3_Log.h"
+
+#ifndef MEO_UART_ID_MAX
+#define MEO_UART_ID_MAX 40
+#endif
+
+struct MeoUartClientStats {
+    uint32_t published = 0;  // frame đã vào ring TX
+    uint32_t rejected  = 0;  // topic không có trên link UART / frame quá lớn / ring đầy
+    uint32_t invokes   = 0;  // invoke nhận từ gateway
+    uint32_t ignored   = 0;  // invoke cho id khác (bus nhiều con) / message không hợp lệ
+};
+
+/**
+ * MeoUartClient: phía thiết bị con của MeoConnectionType::UART, cùng bề mặt
+ * publish / subscribe / handler với MeoMqttClient, để code thiết bị không phụ thuộc link.
+ * - Topic publish của chính thiết bị được đổi thành frame (gateway dựng lại topic):
+ *     meo/{id}/declare -> Declare, meo/{id}/status -> Status,
+ *     meo/{id}/event/feature_response -> Response, meo/{id}/event/{name} -> Event.
+ *   Topic khác không đi được qua gateway -> false. retained / qos do gateway quyết định.
+ * - Frame Invoke tới với topic meo/{id}/feature/{name}/invoke, qua cùng MeoTopicRouter
+ *   (route khớp, nếu không có thì handler mặc định), trên task RX của transport.
+ * - Redeclare: gọi handler riêng; không có thì tự gửi lại Status "online".
+ * - Không có phiên: isConnected() = link đang chạy và gateway đã nói gì đó trong
+ *   khoảng linkTimeoutMs (0 = chỉ cần link chạy).
+ * - Gateway coi con im lặng quá childTimeoutMs là offline: publish status định kỳ.
+ */
+class MeoUartClient {
+public:
+    typedef MeoMessageFn OnMessageFn;
+    typedef void (*RedeclareFn)(void* ctx);
+
+    explicit MeoUartClient(const MeoUartConfig& cfg = MeoUartConfig());
+    ~MeoUartClient();
+
+    void setLog(const MeoLog& log) { _log = log; _link.setLog(log); }
+
+    bool begin(const char* deviceId, uint32_t linkTimeoutMs = 0);
+    void end();
+
+    bool isConnected() const;
+
+    bool publish(const char* topic, const uint8_t* payload, size_t len, bool retained = false, uint8_t qos = 0);
+    bool publish(const char* topic, const char* payload, bool retained = false, uint8_t qos = 0);
+
+    bool subscribe(const char* filter, OnMessageFn fn, void* ctx, uint8_t qos = 0);
+    bool unsubscribe(const char* filter, OnMessageFn fn = nullptr, void* ctx = nullptr);
+    void setMessageHandler(OnMessageFn fn, void* ctx);
+    void setRedeclareHandler(RedeclareFn fn, void* ctx);
+
+    MeoUartClientStats stats() const;
+    MeoUartStats linkStats() const { return _link.stats(); }
+
+private:
+    MeoUartTransport  _link;
+    char              _id[MEO_UART_ID_MAX];
+    size_t            _idLen = 0;
+    uint32_t          _linkTimeoutMs = 0;
+    std::atomic<uint32_t> _lastRxMs{0};
+
+    MeoTopicRouter    _router;
+    SemaphoreHandle_t _routerLock = nullptr;
+    OnMessageFn       _onMessage = nullptr;
+    void*             _onMessageCtx = nullptr;
+    RedeclareFn       _onRedeclare = nullptr;
+    void*             _onRedeclareCtx = nullptr;
+
+    std::atomic<uint32_t> _published{0};
+    std::atomic<uint32_t> _rejected{0};
+    std::atomic<uint32_t> _invokes{0};
+    std::atomic<uint32_t> _ignored{0};
+
+    MeoLog _log;
+
+    // Static -> instance adapter (task RX của transport)
+    static void _rxThunk(const MeoChildMessage& msg, void* ctx);
+    void _onFrame(const MeoChildMessage& msg);
+    void _deliverInvoke(const MeoChildMessage& msg);
+    bool _toMessage(const char* topic, MeoChildMessage& msg) const;
+
+    static uint32_t _nowMs();
+};
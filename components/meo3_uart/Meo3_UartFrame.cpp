@@ -0,0 +1,175 @@
+#include "Meo3_UartFrame.h"
+#include <cstring>
+
+namespace {
+// Bảng CRC-16/CCITT (poly 0x1021) sinh lúc compile
+struct Crc16Table {
+    uint16_t v[256];
+    constexpr Crc16Table() : v() {
+        for (int i = 0; i < 256; ++i) {
+            uint16_t c = (uint16_t)(i << 8);
+            for (int b = 0; b < 8; ++b) c = (c & 0x8000) ? (uint16_t)((c << 1) ^ 0x1021) : (uint16_t)(c << 1);
+            v[i] = c;
+        }
+    }
+};
+constexpr Crc16Table kCrc16;
+
+bool typeOk(uint8_t t) {
+    return t >= (uint8_t)MeoChildMsgType::Declare && t <= (uint8_t)MeoChildMsgType::Redeclare;
+}
+}
+
+uint16_t meoCrc16(const uint8_t* data, size_t len, uint16_t crc) {
+    for (size_t i = 0; i < len; ++i) {
+        crc = (uint16_t)((crc << 8) ^ kCrc16.v[(uint8_t)((crc >> 8) ^ data[i])]);
+    }
+    return crc;
+}
+
+size_t meoFrameSize(const MeoChildMessage& msg) {
+    size_t body = 2 + msg.idLen + msg.nameLen + msg.len;
+    if (body > MEO_UART_FRAME_MAX) return 0;
+    return body + MEO_UART_OVERHEAD;
+}
+
+size_t meoFrameEncode(const MeoChildMessage& msg, uint8_t* out, size_t cap) {
+    size_t total = meoFrameSize(msg);
+    if (total == 0 || total > cap || !typeOk((uint8_t)msg.type)) return 0;
+    size_t body = total - MEO_UART_OVERHEAD;
+
+    uint8_t* p = out;
+    *p++ = MEO_UART_SYNC;
+    *p++ = (uint8_t)msg.type;
+    *p++ = (uint8_t)(body & 0xFF);
+    *p++ = (uint8_t)(body >> 8);
+    *p++ = msg.idLen;
+    if (msg.idLen) { memcpy(p, msg.deviceId, msg.idLen); p += msg.idLen; }
+    *p++ = msg.nameLen;
+    if (msg.nameLen) { memcpy(p, msg.name, msg.nameLen); p += msg.nameLen; }
+    if (msg.len) { memcpy(p, msg.payload, msg.len); p += msg.len; }
+
+    uint16_t crc = meoCrc16(out + 1, (size_t)(p - out - 1));
+    *p++ = (uint8_t)(crc & 0xFF);
+    *p++ = (uint8_t)(crc >> 8);
+    return total;
+}
+
+// ===================== MeoFrameDecoder =====================
+
+bool MeoFrameDecoder::_headerOk() const {
+    size_t len = (size_t)_raw[1] | ((size_t)_raw[2] << 8);
+    return typeOk(_raw[0]) && len >= 2 && len <= MEO_UART_FRAME_MAX;
+}
+
+// Header bị loại: sync kế tiếp có thể nằm ngay trong 3 byte header
+void MeoFrameDecoder::_rescanHeader() {
+    _stats.badHeader++;
+    for (size_t i = 0; i < kHdr; ++i) {
+        if (_raw[i] != MEO_UART_SYNC) { _stats.skipped++; continue; }
+        _got = kHdr - i - 1;
+        memmove(_raw, _raw + i + 1, _got);
+        _state = State::Header;
+        return;
+    }
+    _got   = 0;
+    _state = State::Sync;
+}
+
+// CRC sai: đưa các byte sau sync giả lên đầu _replay, trước phần chưa đọc của nó.
+// Frame hỏng bắt đầu sau lần requeue trước nên nếu _replay còn dư thì frame nằm
+// trọn trong phần đã đọc của _replay: tổng không vượt kRawMax.
+void MeoFrameDecoder::_requeue() {
+    size_t n    = kHdr + _len + 2;
+    size_t rest = _replayLen - _replayPos;
+    memmove(_replay + n, _replay + _replayPos, rest);
+    memcpy(_replay, _raw, n);
+    _replayPos = 0;
+    _replayLen = n + rest;
+}
+
+void MeoFrameDecoder::feed(const uint8_t* data, size_t len, FrameFn fn, void* ctx) {
+    size_t i = 0;
+    for (;;) {
+        bool crcFailed = false;
+        if (_replayPos < _replayLen) {
+            _replayPos += _run(_replay + _replayPos, _replayLen - _replayPos, fn, ctx, crcFailed);
+            if (_replayPos == _replayLen) _replayPos = _replayLen = 0;
+        } else if (i < len) {
+            i += _run(data + i, len - i, fn, ctx, crcFailed);
+        } else {
+            return;
+        }
+        if (crcFailed) _requeue();
+    }
+}
+
+// Chạy máy trạng thái tới hết data, hoặc dừng ngay sau một frame CRC sai; trả về số byte đã đọc
+size_t MeoFrameDecoder::_run(const uint8_t* data, size_t len, FrameFn fn, void* ctx, bool& crcFailed) {
+    size_t i = 0;
+    while (i < len) {
+        switch (_state) {
+        case State::Sync: {
+            const void* s = memchr(data + i, MEO_UART_SYNC, len - i);
+            if (!s) { _stats.skipped += (uint32_t)(len - i); return len; }
+            size_t at = (size_t)((const uint8_t*)s - data);
+            _stats.skipped += (uint32_t)(at - i);
+            i = at + 1;
+            _got   = 0;
+            _state = State::Header;
+            break;
+        }
+        case State::Header:
+            _raw[_got++] = data[i++];
+            if (_got < kHdr) break;
+            if (!_headerOk()) { _rescanHeader(); break; }
+            _len   = (size_t)_raw[1] | ((size_t)_raw[2] << 8);
+            _state = State::Body;
+            break;
+        case State::Body: {
+            // body + crc cùng một lần copy
+            size_t want = kHdr + _len + 2;
+            size_t n = len - i;
+            if (n > want - _got) n = want - _got;
+            memcpy(_raw + _got, data + i, n);
+            _got += n;
+            i    += n;
+            if (_got < want) break;
+            _got   = 0;
+            _state = State::Sync;
+            if (!_deliver(fn, ctx)) { crcFailed = true; return i; }
+            break;
+        }
+        }
+    }
+    return i;
+}
+
+// false chỉ khi CRC sai (frame CRC đúng nhưng sai cấu trúc vẫn là frame thật: bỏ qua)
+bool MeoFrameDecoder::_deliver(FrameFn fn, void* ctx) {
+    const uint8_t* body = _raw + kHdr;
+    uint16_t crc = meoCrc16(_raw, kHdr + _len);
+    if (crc != (uint16_t)(body[_len] | (body[_len + 1] << 8))) {
+        _stats.crcErrors++;
+        return false;
+    }
+
+    // idLen | id | nameLen | name | payload
+    size_t idLen = body[0];
+    if (1 + idLen + 1 > _len) { _stats.malformed++; return true; }
+    size_t nameLen = body[1 + idLen];
+    size_t off = 2 + idLen + nameLen;
+    if (off > _len) { _stats.malformed++; return true; }
+
+    MeoChildMessage msg;
+    msg.type     = (MeoChildMsgType)_raw[0];
+    msg.deviceId = (const char*)body + 1;
+    msg.idLen    = (uint8_t)idLen;
+    msg.name     = (const char*)body + 2 + idLen;
+    msg.nameLen  = (uint8_t)nameLen;
+    msg.payload  = body + off;
+    msg.len      = _len - off;
+    _stats.frames++;
+    if (fn) fn(msg, ctx);
+    return true;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Meo3_ChildTransport.h"   // MeoChildMessage, MeoChildMsgType
+
+// Body lớn nhất của một frame (id + tên + payload + 2 byte độ dài)
+#ifndef MEO_UART_FRAME_MAX
+#define MEO_UART_FRAME_MAX 1024
+#endif
+
+/**
+ * Frame nhị phân trên UART (little-endian):
+ *
+ *   0xA5 | type | len lo | len hi | idLen | id.. | nameLen | name.. | payload.. | crc lo | crc hi
+ *          \___________________ CRC-16/CCITT-FALSE ______________________/
+ *
+ * - len = số byte body (idLen .. hết payload), tối đa MEO_UART_FRAME_MAX.
+ * - Không phụ thuộc ESP-IDF: build và test được trên host (pipe / pty loopback).
+ */
+static const uint8_t MEO_UART_SYNC = 0xA5;
+static const size_t  MEO_UART_OVERHEAD = 6;   // sync + type + len(2) + crc(2)
+
+uint16_t meoCrc16(const uint8_t* data, size_t len, uint16_t crc = 0xFFFF);
+
+// Số byte frame của msg (0 nếu không biểu diễn được)
+size_t meoFrameSize(const MeoChildMessage& msg);
+// Ghi frame vào out; trả về số byte, 0 nếu không vừa / quá lớn
+size_t meoFrameEncode(const MeoChildMessage& msg, uint8_t* out, size_t cap);
+
+struct MeoFrameStats {
+    uint32_t frames    = 0;  // frame hợp lệ đã giao
+    uint32_t crcErrors = 0;
+    uint32_t badHeader = 0;  // type lạ hoặc len ngoài [2, MEO_UART_FRAME_MAX]
+    uint32_t malformed = 0;  // CRC đúng nhưng body sai cấu trúc
+    uint32_t skipped   = 0;  // byte bị bỏ khi tìm sync
+};
+
+/**
+ * MeoFrameDecoder: máy trạng thái nhận từng đoạn byte (bất kỳ cách chia nào).
+ * - Body được copy thẳng vào buffer nội bộ theo từng đoạn, không xử lý từng byte.
+ * - Header được kiểm (type + len) trước khi nhận body: một byte 0xA5 rác gần như luôn
+ *   bị loại sau 3 byte và việc tìm sync tiếp tục ngay trong các byte header đó.
+ * - CRC sai (thường là 0xA5 rác có header trông hợp lệ): các byte sau sync giả được
+ *   giữ nguyên và quét lại từ byte ngay sau nó, trước dữ liệu mới, nên frame thật
+ *   nằm trong phần "body" giả không bị nuốt. Tốn thêm một buffer frame (~1 KB).
+ * - Message trả cho callback là view vào buffer nội bộ, hợp lệ trong lúc gọi.
+ */
+class MeoFrameDecoder {
+public:
+    typedef void (*FrameFn)(const MeoChildMessage& msg, void* ctx);
+
+    void feed(const uint8_t* data, size_t len, FrameFn fn, void* ctx);
+    void reset() { _state = State::Sync; _got = 0; _replayLen = _replayPos = 0; }
+    const MeoFrameStats& stats() const { return _stats; }
+
+private:
+    enum class State : uint8_t { Sync, Header, Body };
+
+    // Byte sau sync: type + len(2) | body | crc(2)
+    static const size_t kHdr = 3;
+    static const size_t kRawMax = kHdr + MEO_UART_FRAME_MAX + 2;
+
+    State    _state = State::Sync;
+    size_t   _got = 0;         // byte đã có trong _raw
+    size_t   _len = 0;         // body
+    uint8_t  _raw[kRawMax];
+    // Byte chờ quét lại sau CRC sai; luôn được đọc trước dữ liệu mới
+    uint8_t  _replay[kRawMax];
+    size_t   _replayLen = 0;
+    size_t   _replayPos = 0;
+    MeoFrameStats _stats;
+
+    size_t _run(const uint8_t* data, size_t len, FrameFn fn, void* ctx, bool& crcFailed);
+    bool _headerOk() const;
+    void _rescanHeader();
+    void _requeue();
+    bool _deliver(FrameFn fn, void* ctx);
+};
@@ -0,0 +1,216 @@
+#include "Meo3_UartTransport.h"
+#include "driver/uart.h"
+#include <new>
+
+// Event giả đẩy vào queue của driver để đánh thức và dừng task RX
+static const uart_event_type_t kStopEvent = UART_EVENT_MAX;
+static const size_t kRxChunk = 256;
+
+namespace {
+struct TxLock {
+    SemaphoreHandle_t h;
+    explicit TxLock(SemaphoreHandle_t m) : h(m) { xSemaphoreTake(h, portMAX_DELAY); }
+    ~TxLock() { xSemaphoreGive(h); }
+};
+}
+
+MeoUartTransport::MeoUartTransport(const MeoUartConfig& cfg) : _cfg(cfg) {}
+
+MeoUartTransport::~MeoUartTransport() {
+    end();
+}
+
+bool MeoUartTransport::begin(ReceiveFn rx, void* ctx) {
+    if (_taskAlive.load(std::memory_order_acquire)) return true;
+    if (!rx) return false;
+
+    const uart_port_t port = (uart_port_t)_cfg.port;
+    _rx  = rx;
+    _ctx = ctx;
+
+    _txLock  = xSemaphoreCreateMutex();
+    _txBuf   = new (std::nothrow) uint8_t[MEO_UART_FRAME_MAX + MEO_UART_OVERHEAD];
+    _rxBuf   = new (std::nothrow) uint8_t[kRxChunk];
+    _decoder = new (std::nothrow) MeoFrameDecoder();
+    if (!_txLock || !_txBuf || !_rxBuf || !_decoder) {
+        MEO_LOGE(_log, UART, "Out of memory");
+        _release();
+        return false;
+    }
+
+    // Ring TX phải chứa được frame lớn nhất, nếu không send() sẽ luôn bị từ chối
+    size_t txRing = _cfg.txBuffer;
+    if (txRing < MEO_UART_FRAME_MAX + MEO_UART_OVERHEAD) txRing = MEO_UART_FRAME_MAX + MEO_UART_OVERHEAD;
+
+    uart_config_t uc = {};
+    uc.baud_rate  = (int)_cfg.baud;
+    uc.data_bits  = UART_DATA_8_BITS;
+    uc.parity     = UART_PARITY_DISABLE;
+    uc.stop_bits  = UART_STOP_BITS_1;
+    uc.flow_ctrl  = _cfg.flowControl ? UART_HW_FLOWCTRL_CTS_RTS : UART_HW_FLOWCTRL_DISABLE;
+    uc.rx_flow_ctrl_thresh = 100;
+    uc.source_clk = UART_SCLK_DEFAULT;
+
+    esp_err_t err = uart_driver_install(port, (int)_cfg.rxBuffer, (int)txRing, 16, &_events, 0);
+    if (err != ESP_OK) {
+        MEO_LOGE(_log, UART, "uart_driver_install(%d) failed: %s", _cfg.port, esp_err_to_name(err));
+        _release();
+        return false;
+    }
+    _installed = true;
+
+    err = uart_param_config(port, &uc);
+    if (err == ESP_OK) {
+        err = uart_set_pin(port,
+                           _cfg.txPin  < 0 ? UART_PIN_NO_CHANGE : _cfg.txPin,
+                           _cfg.rxPin  < 0 ? UART_PIN_NO_CHANGE : _cfg.rxPin,
+                           _cfg.rtsPin < 0 ? UART_PIN_NO_CHANGE : _cfg.rtsPin,
+                           _cfg.ctsPin < 0 ? UART_PIN_NO_CHANGE : _cfg.ctsPin);
+    }
+    if (err == ESP_OK) err = uart_set_rx_timeout(port, _cfg.rxTimeout);
+    if (err != ESP_OK) {
+        MEO_LOGE(_log, UART, "UART%d config failed: %s", _cfg.port, esp_err_to_name(err));
+        _release();
+        return false;
+    }
+
+    _taskAlive.store(true, std::memory_order_release);
+    if (xTaskCreatePinnedToCore(&MeoUartTransport::_taskEntry, "meo_uart", _cfg.stackSize,
+                                this, _cfg.priority, &_task, _cfg.core) != pdPASS) {
+        _taskAlive.store(false, std::memory_order_release);
+        _task = nullptr;
+        _release();
+        return false;
+    }
+    _running.store(true, std::memory_order_release);
+    MEO_LOGI(_log, UART, "UART%d up at %lu baud (frame<=%u)",
+             _cfg.port, (unsigned long)_cfg.baud, (unsigned)MEO_UART_FRAME_MAX);
+    return true;
+}
+
+void MeoUartTransport::end() {
+    if (_taskAlive.load(std::memory_order_acquire)) {
+        // send() có thể đang chạy trên task khác (MeoGateway::routeInvoke): chờ nó rời đi
+        // trước khi xoá _txLock / _txBuf và gỡ driver
+        _running.store(false, std::memory_order_seq_cst);
+        while (_inFlight.load(std::memory_order_seq_cst) > 0) {
+            vTaskDelay(pdMS_TO_TICKS(1));
+        }
+        uart_event_t stop = {};
+        stop.type = kStopEvent;
+        // Gửi lại cho tới khi task thoát: overrun có thể xQueueReset mất event dừng
+        while (_taskAlive.load(std::memory_order_acquire)) {
+            xQueueSend(_events, &stop, 0);
+            vTaskDelay(pdMS_TO_TICKS(5));
+        }
+        _task = nullptr;
+    }
+    _release();
+}
+
+void MeoUartTransport::_release() {
+    if (_installed) {
+        uart_driver_delete((uart_port_t)_cfg.port);   // xoá luôn _events
+        _installed = false;
+    }
+    _events = nullptr;
+    if (_txLock) { vSemaphoreDelete(_txLock); _txLock = nullptr; }
+    delete[] _txBuf;  _txBuf  = nullptr;
+    delete[] _rxBuf;  _rxBuf  = nullptr;
+    delete _decoder;  _decoder = nullptr;
+}
+
+bool MeoUartTransport::send(const MeoChildMessage& msg) {
+    // Cặp seq_cst với end(): hoặc end() thấy _inFlight > 0 và chờ, hoặc ta thấy _running == false
+    _inFlight.fetch_add(1, std::memory_order_seq_cst);
+    bool ok = _running.load(std::memory_order_seq_cst) && _send(msg);
+    _inFlight.fetch_sub(1, std::memory_order_release);
+    return ok;
+}
+
+bool MeoUartTransport::_send(const MeoChildMessage& msg) {
+    TxLock lock(_txLock);
+    size_t n = meoFrameEncode(msg, _txBuf, MEO_UART_FRAME_MAX + MEO_UART_OVERHEAD);
+    if (n == 0) return false;
+
+    const uart_port_t port = (uart_port_t)_cfg.port;
+    size_t room = 0;
+    if (uart_get_tx_buffer_free_size(port, &room) != ESP_OK || room < n) {
+        _txFull.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    int w = uart_write_bytes(port, _txBuf, n);
+    if (w != (int)n) return false;
+
+    _framesOut.fetch_add(1, std::memory_order_relaxed);
+    _bytesOut.fetch_add((uint32_t)n, std::memory_order_relaxed);
+    return true;
+}
+
+// Static -> instance adapter
+void MeoUartTransport::_taskEntry(void* arg) {
+    static_cast<MeoUartTransport*>(arg)->_taskLoop();
+}
+
+void MeoUartTransport::_taskLoop() {
+    const uart_port_t port = (uart_port_t)_cfg.port;
+    uart_event_t ev;
+
+    for (;;) {
+        if (xQueueReceive(_events, &ev, portMAX_DELAY) != pdTRUE) continue;
+        if (ev.type == kStopEvent) break;
+
+        switch (ev.type) {
+        case UART_DATA: {
+            // Đọc hết những gì đang có trong ring, không chờ thêm
+            size_t avail = 0;
+            uart_get_buffered_data_len(port, &avail);
+            while (avail > 0) {
+                size_t want = avail < kRxChunk ? avail : kRxChunk;
+                int r = uart_read_bytes(port, _rxBuf, (uint32_t)want, 0);
+                if (r <= 0) break;
+                _bytesIn.fetch_add((uint32_t)r, std::memory_order_relaxed);
+                _decoder->feed(_rxBuf, (size_t)r, _rx, _ctx);
+                avail -= (size_t)r;
+            }
+            _publishRxStats();
+            break;
+        }
+        case UART_FIFO_OVF:
+        case UART_BUFFER_FULL:
+            // Đã mất byte: frame đang nhận chắc chắn hỏng
+            uart_flush_input(port);
+            xQueueReset(_events);
+            _decoder->reset();
+            _overruns.fetch_add(1, std::memory_order_relaxed);
+            MEO_LOGW(_log, UART, "UART%d RX overrun, input flushed", _cfg.port);
+            break;
+        default:
+            break;
+        }
+    }
+
+    _taskAlive.store(false, std::memory_order_release);
+    vTaskDelete(nullptr);
+}
+
+// Bộ đếm của decoder chỉ task RX ghi; chép sang atomic cho stats()
+void MeoUartTransport::_publishRxStats() {
+    const MeoFrameStats& s = _decoder->stats();
+    _framesIn.store(s.frames, std::memory_order_relaxed);
+    _crcErrors.store(s.crcErrors, std::memory_order_relaxed);
+    _badFrames.store(s.badHeader + s.malformed, std::memory_order_relaxed);
+}
+
+MeoUartStats MeoUartTransport::stats() const {
+    MeoUartStats s;
+    s.framesIn  = _framesIn.load(std::memory_order_relaxed);
+    s.framesOut = _framesOut.load(std::memory_order_relaxed);
+    s.crcErrors = _crcErrors.load(std::memory_order_relaxed);
+    s.badFrames = _badFrames.load(std::memory_order_relaxed);
+    s.overruns  = _overruns.load(std::memory_order_relaxed);
+    s.txFull    = _txFull.load(std::memory_order_relaxed);
+    s.bytesIn   = _bytesIn.load(std::memory_order_relaxed);
+    s.bytesOut  = _bytesOut.load(std::memory_order_relaxed);
+    return s;
+}
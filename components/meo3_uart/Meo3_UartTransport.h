@@ -0,0 +1,104 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include "Meo3_ChildTransport.h"
+#include "Meo3_UartFrame.h"
+#include "Meo3_Log.h"
+
+#ifndef MEO_UART_TASK_STACK
+#define MEO_UART_TASK_STACK 4096
+#endif
+
+struct MeoUartConfig {
+    int      port      = 1;        // uart_port_t (UART0 thường là console)
+    int      txPin     = -1;       // -1 = giữ chân mặc định của port
+    int      rxPin     = -1;
+    int      rtsPin    = -1;
+    int      ctsPin    = -1;
+    uint32_t baud      = 921600;
+    bool     flowControl = false;  // RTS/CTS phần cứng (cần rtsPin + ctsPin)
+    size_t   rxBuffer  = 4096;     // ring buffer RX của driver (ISR đổ FIFO vào đây)
+    size_t   txBuffer  = 4096;     // ring buffer TX; send() không chờ khi ring đầy
+    uint8_t  rxTimeout = 4;        // số ký tự im lặng trước khi driver báo UART_DATA
+    UBaseType_t priority = 12;     // task RX: cao hơn loop để độ trễ ổn định
+    BaseType_t  core     = tskNO_AFFINITY;
+    uint32_t    stackSize = MEO_UART_TASK_STACK;
+};
+
+struct MeoUartStats {
+    uint32_t framesIn  = 0;  // frame hợp lệ đã giao cho rx
+    uint32_t framesOut = 0;
+    uint32_t crcErrors = 0;
+    uint32_t badFrames = 0;  // header / body sai cấu trúc
+    uint32_t overruns  = 0;  // FIFO / ring RX tràn: dữ liệu bị xoá, decoder reset
+    uint32_t txFull    = 0;  // send() bị từ chối vì ring TX không đủ chỗ
+    uint32_t bytesIn   = 0;
+    uint32_t bytesOut  = 0;
+};
+
+/**
+ * MeoUartTransport: MeoChildTransport trên một UART của ESP-IDF, dùng frame của Meo3_UartFrame.
+ * - RX: ISR của driver chuyển FIFO vào ring buffer; task riêng chờ event queue của driver,
+ *   đọc theo khối và đưa vào MeoFrameDecoder, rx được gọi trên task đó.
+ * - TX: send() encode vào buffer riêng dưới mutex rồi copy vào ring TX, không chờ dây:
+ *   ring không đủ chỗ cho cả frame -> false (không ghi nửa frame).
+ * - Dùng được ở cả hai đầu: gateway (qua MeoGateway) và thiết bị con (qua MeoUartClient).
+ */
+class MeoUartTransport : public MeoChildTransport {
+public:
+    explicit MeoUartTransport(const MeoUartConfig& cfg = MeoUartConfig());
+    ~MeoUartTransport() override;
+
+    void setLog(const MeoLog& log) { _log = log; }
+
+    bool begin(ReceiveFn rx, void* ctx) override;
+    // Dừng task RX (không còn callback sau khi trả về), chờ send() đang chạy xong và gỡ driver
+    void end() override;
+    bool send(const MeoChildMessage& msg) override;
+
+    bool isRunning() const { return _running.load(std::memory_order_acquire); }
+    MeoUartStats stats() const;
+
+private:
+    MeoUartConfig     _cfg;
+    ReceiveFn         _rx  = nullptr;
+    void*             _ctx = nullptr;
+
+    QueueHandle_t     _events = nullptr;   // event queue của driver UART
+    TaskHandle_t      _task   = nullptr;
+    std::atomic<bool> _taskAlive{false};
+    std::atomic<bool> _running{false};
+    std::atomic<uint16_t> _inFlight{0};  // send() đang dùng _txLock / _txBuf
+    bool              _installed = false;
+
+    SemaphoreHandle_t _txLock = nullptr;
+    uint8_t*          _txBuf  = nullptr;
+    uint8_t*          _rxBuf  = nullptr;   // khối đọc từ ring RX
+    MeoFrameDecoder*  _decoder = nullptr;  // ~2 KB: cấp phát trong begin()
+
+    std::atomic<uint32_t> _framesIn{0};
+    std::atomic<uint32_t> _framesOut{0};
+    std::atomic<uint32_t> _crcErrors{0};
+    std::atomic<uint32_t> _badFrames{0};
+    std::atomic<uint32_t> _overruns{0};
+    std::atomic<uint32_t> _txFull{0};
+    std::atomic<uint32_t> _bytesIn{0};
+    std::atomic<uint32_t> _bytesOut{0};
+
+    MeoLog _log;
+
+    // Static -> instance adapter
+    static void _taskEntry(void* arg);
+    void _taskLoop();
+    bool _send(const MeoChildMessage& msg);
+    void _publishRxStats();
+    void _release();
+};
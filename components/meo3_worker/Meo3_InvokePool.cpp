@@ -0,0 +1,159 @@
+#include "Meo3_InvokePool.h"
+#include "esp_timer.h"
+#include <cstring>
+#include <new>
+
+MeoInvokePool::MeoInvokePool() {}
+
+MeoInvokePool::~MeoInvokePool() {
+    end();
+}
+
+bool MeoInvokePool::begin(RunFn fn, void* ctx, uint8_t workers, uint8_t depth,
+                          UBaseType_t priority, uint32_t stackSize) {
+    if (_alive.load(std::memory_order_acquire)) return true;
+    if (!fn || workers == 0 || depth == 0 || depth >= STOP_TOKEN) return false;
+    if (workers > MEO_INVOKE_MAX_WORKERS) workers = MEO_INVOKE_MAX_WORKERS;
+
+    _fn = fn;
+    _ctx = ctx;
+    _depth = depth;
+    _workerCount = workers;
+
+    _slots = new (std::nothrow) Slot[depth];
+    _freeQ = xQueueCreate(depth, sizeof(uint8_t));
+    if (!_slots || !_freeQ) {
+        _release();
+        return false;
+    }
+    for (uint8_t i = 0; i < depth; ++i) {
+        xQueueSend(_freeQ, &i, 0);
+    }
+
+    for (uint8_t w = 0; w < workers; ++w) {
+        // Mỗi hàng đợi chứa được mọi slot + STOP_TOKEN, nên xQueueSend không bao giờ phải chờ
+        _workers[w].pool  = this;
+        _workers[w].queue = xQueueCreate(depth + 1, sizeof(uint8_t));
+        if (!_workers[w].queue) {
+            end();
+            return false;
+        }
+        _alive.fetch_add(1, std::memory_order_acq_rel);
+        if (xTaskCreatePinnedToCore(&MeoInvokePool::_taskEntry, "meo_invoke", stackSize,
+                                    &_workers[w], priority, &_workers[w].task,
+                                    tskNO_AFFINITY) != pdPASS) {
+            _alive.fetch_sub(1, std::memory_order_acq_rel);
+            _workers[w].task = nullptr;
+            end();
+            return false;
+        }
+    }
+
+    _running.store(true, std::memory_order_release);
+    return true;
+}
+
+void MeoInvokePool::end() {
+    // submit() chạy trên task esp-mqtt: chờ nó rời đi trước khi gửi STOP_TOKEN và xoá slot
+    _running.store(false, std::memory_order_seq_cst);
+    while (_inFlight.load(std::memory_order_seq_cst) > 0) {
+        vTaskDelay(pdMS_TO_TICKS(1));
+    }
+    uint8_t stop = STOP_TOKEN;
+    for (uint8_t w = 0; w < _workerCount; ++w) {
+        if (_workers[w].task && _workers[w].queue) {
+            xQueueSend(_workers[w].queue, &stop, portMAX_DELAY);
+        }
+    }
+    while (_alive.load(std::memory_order_acquire) > 0) {
+        vTaskDelay(pdMS_TO_TICKS(5));
+    }
+    _release();
+}
+
+MeoSubmitResult MeoInvokePool::submit(uint16_t method, const uint8_t* payload, size_t len, uint32_t tag) {
+    // Cặp seq_cst với end(): hoặc end() thấy _inFlight > 0 và chờ, hoặc ta thấy _running == false
+    _inFlight.fetch_add(1, std::memory_order_seq_cst);
+    MeoSubmitResult r = _running.load(std::memory_order_seq_cst)
+        ? _submit(method, payload, len, tag) : MeoSubmitResult::NotRunning;
+    _inFlight.fetch_sub(1, std::memory_order_release);
+    return r;
+}
+
+MeoSubmitResult MeoInvokePool::_submit(uint16_t method, const uint8_t* payload, size_t len, uint32_t tag) {
+    if (len > MEO_INVOKE_PAYLOAD_MAX) {
+        _rejected.fetch_add(1, std::memory_order_relaxed);
+        return MeoSubmitResult::TooLarge;
+    }
+
+    uint8_t idx;
+    if (xQueueReceive(_freeQ, &idx, 0) != pdTRUE) {
+        _rejected.fetch_add(1, std::memory_order_relaxed);
+        return MeoSubmitResult::Full;
+    }
+
+    Slot& s = _slots[idx];
+    s.method = method;
+    s.len = (uint16_t)len;
+    s.tag = tag;
+    if (len) memcpy(s.payload, payload, len);
+    s.enqueuedUs = esp_timer_get_time();
+
+    // Cùng method -> cùng worker: tuần tự theo feature
+    xQueueSend(_workers[method % _workerCount].queue, &idx, 0);
+    _queued.fetch_add(1, std::memory_order_relaxed);
+    return MeoSubmitResult::Queued;
+}
+
+MeoInvokePoolStats MeoInvokePool::stats() const {
+    MeoInvokePoolStats st;
+    st.queued     = _queued.load(std::memory_order_relaxed);
+    st.executed   = _executed.load(std::memory_order_relaxed);
+    st.rejected   = _rejected.load(std::memory_order_relaxed);
+    st.lastWaitUs = _lastWaitUs.load(std::memory_order_relaxed);
+    st.maxWaitUs  = _maxWaitUs.load(std::memory_order_relaxed);
+    st.avgWaitUs  = _avgWaitUs.load(std::memory_order_relaxed);
+    return st;
+}
+
+// Static -> instance adapter
+void MeoInvokePool::_taskEntry(void* arg) {
+    Worker* w = reinterpret_cast<Worker*>(arg);
+    w->pool->_run(*w);
+}
+
+void MeoInvokePool::_run(Worker& w) {
+    uint8_t idx;
+    for (;;) {
+        if (xQueueReceive(w.queue, &idx, portMAX_DELAY) != pdTRUE) continue;
+        if (idx == STOP_TOKEN) break;
+
+        Slot& s = _slots[idx];
+        uint32_t wait = (uint32_t)(esp_timer_get_time() - s.enqueuedUs);
+        _lastWaitUs.store(wait, std::memory_order_relaxed);
+        uint32_t mx = _maxWaitUs.load(std::memory_order_relaxed);
+        while (wait > mx && !_maxWaitUs.compare_exchange_weak(mx, wait, std::memory_order_relaxed)) {}
+        uint32_t avg = _avgWaitUs.load(std::memory_order_relaxed);
+        _avgWaitUs.store(avg - avg / 8 + wait / 8, std::memory_order_relaxed);
+
+        _fn(s.method, s.payload, s.len, s.tag, _ctx);
+        _executed.fetch_add(1, std::memory_order_relaxed);
+
+        xQueueSend(_freeQ, &idx, 0);
+    }
+
+    _alive.fetch_sub(1, std::memory_order_acq_rel);
+    vTaskDelete(NULL);
+}
+
+void MeoInvokePool::_release() {
+    for (uint8_t w = 0; w < MEO_INVOKE_MAX_WORKERS; ++w) {
+        if (_workers[w].queue) vQueueDelete(_workers[w].queue);
+        _workers[w] = Worker{};
+    }
+    if (_freeQ) { vQueueDelete(_freeQ); _freeQ = nullptr; }
+    delete[] _slots;
+    _slots = nullptr;
+    _depth = 0;
+    _workerCount = 0;
+}
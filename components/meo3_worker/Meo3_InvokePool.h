@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+
+#ifndef MEO_INVOKE_PAYLOAD_MAX
+#define MEO_INVOKE_PAYLOAD_MAX 1024
+#endif
+#ifndef MEO_INVOKE_MAX_WORKERS
+#define MEO_INVOKE_MAX_WORKERS 4
+#endif
+#ifndef MEO_INVOKE_TASK_STACK
+#define MEO_INVOKE_TASK_STACK 6144
+#endif
+
+enum class MeoSubmitResult : uint8_t {
+    Queued = 0,
+    Full,        // Không còn slot trống -> caller gửi feature_response âm
+    TooLarge,    // Payload lớn hơn MEO_INVOKE_PAYLOAD_MAX
+    NotRunning
+};
+
+struct MeoInvokePoolStats {
+    uint32_t queued     = 0;
+    uint32_t executed   = 0;
+    uint32_t rejected   = 0;  // Full + TooLarge
+    uint32_t lastWaitUs = 0;  // Thời gian chờ trong hàng đợi (submit -> worker bắt đầu chạy)
+    uint32_t maxWaitUs  = 0;
+    uint32_t avgWaitUs  = 0;  // Trung bình trượt (EWMA 1/8)
+};
+
+/**
+ * MeoInvokePool: chạy feature handler ngoài task esp-mqtt.
+ * - Slot payload được cấp phát sẵn trong begin(); submit() chỉ copy rồi trả về ngay.
+ * - Mỗi worker có hàng đợi riêng; job của cùng một method luôn vào cùng worker
+ *   (method % workers) nên các invoke của một feature chạy tuần tự, đúng thứ tự.
+ */
+class MeoInvokePool {
+public:
+    // Chạy trên worker task; payload chỉ hợp lệ trong lúc gọi. tag = giá trị truyền vào submit()
+    typedef void (*RunFn)(uint16_t method, const uint8_t* payload, size_t len, uint32_t tag, void* ctx);
+
+    MeoInvokePool();
+    ~MeoInvokePool();
+
+    bool begin(RunFn fn, void* ctx,
+               uint8_t workers = 2,
+               uint8_t depth = 8,
+               UBaseType_t priority = 5,
+               uint32_t stackSize = MEO_INVOKE_TASK_STACK);
+    // Ngừng nhận job, chờ submit() đang chạy xong, chạy nốt job đã nhận rồi giải phóng slot
+    void end();
+    bool isRunning() const { return _running.load(std::memory_order_acquire); }
+
+    MeoSubmitResult submit(uint16_t method, const uint8_t* payload, size_t len, uint32_t tag = 0);
+
+    MeoInvokePoolStats stats() const;
+
+private:
+    struct Slot {
+        uint16_t method;
+        uint16_t len;
+        uint32_t tag;
+        int64_t  enqueuedUs;
+        uint8_t  payload[MEO_INVOKE_PAYLOAD_MAX];
+    };
+    struct Worker {
+        MeoInvokePool* pool;
+        QueueHandle_t  queue;
+        TaskHandle_t   task;
+    };
+
+    static const uint8_t STOP_TOKEN = 0xFF;
+
+    RunFn   _fn  = nullptr;
+    void*   _ctx = nullptr;
+    Slot*   _slots = nullptr;
+    uint8_t _depth = 0;
+    uint8_t _workerCount = 0;
+    Worker  _workers[MEO_INVOKE_MAX_WORKERS] = {};
+    QueueHandle_t _freeQ = nullptr;
+
+    std::atomic<bool>     _running{false};
+    std::atomic<uint8_t>  _alive{0};
+    std::atomic<uint16_t> _inFlight{0};   // submit() đang chạy (task esp-mqtt)
+    std::atomic<uint32_t> _queued{0};
+    std::atomic<uint32_t> _executed{0};
+    std::atomic<uint32_t> _rejected{0};
+    std::atomic<uint32_t> _lastWaitUs{0};
+    std::atomic<uint32_t> _maxWaitUs{0};
+    std::atomic<uint32_t> _avgWaitUs{0};
+
+    MeoSubmitResult _submit(uint16_t method, const uint8_t* payload, size_t len, uint32_t tag);
+    static void _taskEntry(void* arg);
+    void _run(Worker& w);
+    void _release();
+};
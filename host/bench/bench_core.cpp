@@ -0,0 +1,154 @@
+// Đo các đường nóng của core trên host: ns/op cho topic, JSON / CBOR, dispatch,
+// router, storage và invoke feature (MeoMqttClient + esp-mqtt shim).
+//   ./meo3_bench [số vòng] [lọc theo tên]
+// Chạy bản build không sanitizer để số liệu có ý nghĩa; so sánh tương đối giữa các commit.
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "Meo3_Topic.h"
+#include "Meo3_Dispatch.h"
+#include "Meo3_JsonWriter.h"
+#include "Meo3_JsonReader.h"
+#include "Meo3_Cbor.h"
+#include "Meo3_TopicRouter.h"
+#include "Meo3_Storage.h"
+#include "Meo3_Mqtt.h"
+#include "Meo3_Feature.h"
+#include "mqtt_host.h"
+
+namespace {
+
+long        g_iters  = 200000;
+const char* g_filter = nullptr;
+uint64_t    g_sink = 0;         // in ra cuối cùng để compiler không bỏ vòng lặp
+
+template <typename Fn>
+void bench(const char* name, long iters, Fn&& fn) {
+    if (g_filter && !strstr(name, g_filter)) return;
+    for (long i = 0; i < iters / 100 + 1; ++i) fn(i);   // làm nóng cache
+    auto t0 = std::chrono::steady_clock::now();
+    for (long i = 0; i < iters; ++i) fn(i);
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count();
+    printf("%-28s %10ld ops %10.1f ns/op\n", name, iters, (double)ns / (double)iters);
+}
+
+const char kInvoke[] = "{\"params\":{\"speed\":7,\"mode\":\"eco\",\"on\":true,\"ratio\":0.5}}";
+
+int  g_invokes = 0;
+void onFeature(const char*, const char*, const MeoJsonView& p, void*) {
+    g_invokes++;
+    g_sink += (uint64_t)p["speed"].asInt();
+}
+
+void onRoute(const char*, size_t, const uint8_t*, size_t, void*) {}
+
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1) g_iters = atol(argv[1]) > 0 ? atol(argv[1]) : g_iters;
+    if (argc > 2) g_filter = argv[2];
+
+    MeoTopics topics;
+    topics.setDeviceId("a1b2c3d4e5f6");
+
+    bench("topic.event", g_iters, [&](long) {
+        MeoTopicBuf<> t;
+        topics.event(t, "temperature");
+        g_sink += t.length();
+    });
+
+    const char invTopic[] = "meo/a1b2c3d4e5f6/feature/turn_on_led/invoke";
+    bench("topic.parseInvoke", g_iters, [&](long) {
+        const char* name;
+        size_t nameLen;
+        g_sink += topics.parseInvoke(invTopic, sizeof(invTopic) - 1, name, nameLen) ? nameLen : 0;
+    });
+
+    bench("json.write", g_iters, [&](long i) {
+        char buf[128];
+        MeoJsonWriter w(buf, sizeof(buf));
+        w.beginObject().field("feature_name", "fan").field("device_id", "a1b2c3d4e5f6")
+         .field("value", (int)i).field("ratio", 0.5).field("success", true).endObject();
+        g_sink += w.length();
+    });
+
+    bench("json.parse+get", g_iters, [&](long) {
+        MeoJsonView root = MeoJsonView::parse(kInvoke, sizeof(kInvoke) - 1);
+        g_sink += (uint64_t)root["params"]["speed"].asInt();
+    });
+
+    uint8_t cbor[128];
+    size_t cborLen = 0;
+    bench("cbor.write", g_iters, [&](long i) {
+        MeoCborWriter w(cbor, sizeof(cbor));
+        w.beginObject().key("params").beginObject().field("speed", (int)(i & 7)).field("mode", "eco")
+         .field("on", true).field("ratio", 0.5).endObject().endObject();
+        cborLen = w.length();
+        g_sink += cborLen;
+    });
+
+    bench("cbor.parse+get", g_iters, [&](long) {
+        MeoCborView root = MeoCborView::parse(cbor, cborLen);
+        g_sink += (uint64_t)root["params"]["speed"].asInt();
+    });
+
+    bench("cbor.toJson", g_iters, [&](long) {
+        char json[128];
+        MeoJsonWriter w(json, sizeof(json));
+        meoCborToJson(MeoCborView::parse(cbor, cborLen)["params"], w);
+        g_sink += w.length();
+    });
+
+    static const char* names[] = { "turn_on_led", "turn_off_led", "set_speed", "set_mode",
+                                   "reboot", "ota", "identify", "calibrate" };
+    MeoDispatchTable<int, 16> table;
+    for (int i = 0; i < 8; ++i) table.add(names[i], i);
+    bench("dispatch.find", g_iters, [&](long i) {
+        const char* n = names[i & 7];
+        g_sink += (uint64_t)table.find(n, strlen(n));
+    });
+
+    MeoTopicRouter router;
+    router.add("meo/a1b2c3d4e5f6/feature/+/invoke", onRoute, nullptr, 0);
+    router.add("meo/+/feature/+/invoke", onRoute, nullptr, 0);
+    router.add("meo/a1b2c3d4e5f6/config/#", onRoute, nullptr, 0);
+    bench("router.match", g_iters, [&](long) {
+        int8_t idx[MEO_ROUTER_MAX_ROUTES];
+        g_sink += router.match(invTopic, sizeof(invTopic) - 1, idx, MEO_ROUTER_MAX_ROUTES);
+    });
+
+    MeoStorage storage;
+    storage.begin("meobench");
+    bench("storage.save+loadShort", g_iters / 10, [&](long i) {
+        int16_t v = 0;
+        storage.saveShort("n", (int16_t)i);
+        storage.loadShort("n", v);
+        g_sink += (uint64_t)v;
+    });
+
+    MeoMqttClient mq;
+    mq.configure("broker");
+    mq.setCredentials("a1b2c3d4e5f6", "key");
+    mq.connect();
+    esp_mqtt_client_handle_t c = esp_mqtt_host_last_client();
+    MeoFeature f;
+    f.attach(&mq, "a1b2c3d4e5f6");
+    f.beginFeatureSubscribe(onFeature, nullptr);
+    esp_mqtt_host_connect(c);
+    bench("feature.invoke(json)", g_iters / 2, [&](long) {
+        esp_mqtt_host_deliver(c, invTopic, (const uint8_t*)kInvoke, sizeof(kInvoke) - 1);
+    });
+    bench("feature.invoke(cbor)", g_iters / 2, [&](long) {
+        esp_mqtt_host_deliver(c, invTopic, cbor, cborLen);
+    });
+    bench("feature.response", g_iters / 2, [&](long) {
+        g_sink += f.sendFeatureResponse("turn_on_led", true, "ok");
+    });
+    esp_mqtt_host_disconnect(c);
+
+    printf("invokes=%d sink=%llu\n", g_invokes, (unsigned long long)g_sink);
+    return 0;
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstdint>
+#include "esp_err.h"
+
+// Shim host: chỉ kiểu dữ liệu; esp-mqtt shim gọi handler trực tiếp, không có event loop
+typedef const char* esp_event_base_t;
+typedef void (*esp_event_handler_t)(void* handler_args, esp_event_base_t base,
+                                    int32_t event_id, void* event_data);
+
+#define ESP_EVENT_ANY_ID -1
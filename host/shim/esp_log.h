@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdio>
+
+// Shim host: ESP_LOGx in ra stderr. Mặc định bỏ DEBUG (thêm -DMEO_HOST_LOG_DEBUG để bật).
+#define ESP_HOST_LOG_(letter, tag, fmt, ...) \
+    fprintf(stderr, letter " (%s) " fmt "\n", tag, ##__VA_ARGS__)
+
+#define ESP_LOGE(tag, fmt, ...) ESP_HOST_LOG_("E", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) ESP_HOST_LOG_("W", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGI(tag, fmt, ...) ESP_HOST_LOG_("I", tag, fmt, ##__VA_ARGS__)
+#ifdef MEO_HOST_LOG_DEBUG
+#define ESP_LOGD(tag, fmt, ...) ESP_HOST_LOG_("D", tag, fmt, ##__VA_ARGS__)
+#else
+#define ESP_LOGD(tag, fmt, ...) ((void)0)
+#endif
+#define ESP_LOGV(tag, fmt, ...) ((void)0)
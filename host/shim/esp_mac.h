@@ -0,0 +1,7 @@
+#pragma once
+
+#include <cstdint>
+#include "esp_err.h"
+
+// Shim host: MAC cố định 02:4d:45:4f:00:01 (địa chỉ quản lý cục bộ)
+esp_err_t esp_efuse_mac_get_default(uint8_t* mac);
@@ -0,0 +1,6 @@
+#pragma once
+
+#include <cstdint>
+
+// Shim host: micro giây từ lần gọi đầu tiên (steady clock)
+int64_t esp_timer_get_time(void);
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+
+// Shim host: FreeRTOS trên std::thread / std::mutex. Tick = 1 ms.
+typedef int32_t  BaseType_t;
+typedef uint32_t UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdFALSE 0
+#define pdTRUE  1
+#define pdFAIL  pdFALSE
+#define pdPASS  pdTRUE
+
+#define configTICK_RATE_HZ    1000
+#define configMAX_PRIORITIES  25
+#define portMAX_DELAY         ((TickType_t)0xffffffffUL)
+#define portTICK_PERIOD_MS    ((TickType_t)1)
+#define pdMS_TO_TICKS(ms)     ((TickType_t)(ms))
+#define tskIDLE_PRIORITY      ((UBaseType_t)0)
+#define tskNO_AFFINITY        ((BaseType_t)0x7FFFFFFF)
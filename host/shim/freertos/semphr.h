@@ -0,0 +1,12 @@
+#pragma once
+
+#include "FreeRTOS.h"
+#include "queue.h"
+
+typedef struct MeoHostMutex* SemaphoreHandle_t;
+
+// Mutex không đệ quy, có timeout (std::timed_mutex)
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+BaseType_t        xSemaphoreTake(SemaphoreHandle_t m, TickType_t wait);
+BaseType_t        xSemaphoreGive(SemaphoreHandle_t m);
+void              vSemaphoreDelete(SemaphoreHandle_t m);
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "FreeRTOS.h"
+
+typedef struct MeoHostTask* TaskHandle_t;
+typedef void (*TaskFunction_t)(void* arg);
+
+// Task chạy trên một std::thread tách rời; priority / core / stack bị bỏ qua
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t stackDepth,
+                                   void* arg, UBaseType_t priority, TaskHandle_t* created,
+                                   BaseType_t core);
+// Host không huỷ được thread từ ngoài: task của core luôn gọi vTaskDelete(nullptr)
+// ở cuối hàm, nên ở đây chỉ đánh dấu kết thúc và để hàm task tự trả về.
+void       vTaskDelete(TaskHandle_t task);
+void       vTaskDelay(TickType_t ticks);
@@ -0,0 +1,156 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+struct MeoHostTask {
+    TaskFunction_t fn;
+    void*          arg;
+};
+
+struct MeoHostMutex {
+    std::timed_mutex m;
+};
+
+// Ring buffer cố định: itemSize * length, copy theo giá trị
+struct MeoHostQueue {
+    std::mutex              m;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+    std::vector<uint8_t>    buf;
+    size_t                  itemSize;
+    size_t                  length;
+    size_t                  head  = 0;
+    size_t                  count = 0;
+};
+
+namespace {
+// Chờ tới hạn (portMAX_DELAY = vô hạn) cho tới khi pred đúng
+template <typename Pred>
+bool waitFor(std::condition_variable& cv, std::unique_lock<std::mutex>& lock, TickType_t wait, Pred pred) {
+    if (wait == portMAX_DELAY) {
+        cv.wait(lock, pred);
+        return true;
+    }
+    return cv.wait_for(lock, std::chrono::milliseconds(wait), pred);
+}
+}
+
+// ===================== Task =====================
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t stackDepth,
+                                   void* arg, UBaseType_t priority, TaskHandle_t* created,
+                                   BaseType_t core) {
+    (void)name; (void)stackDepth; (void)priority; (void)core;
+    MeoHostTask* t = new (std::nothrow) MeoHostTask{ fn, arg };
+    if (!t) return pdFAIL;
+    if (created) *created = t;
+    std::thread([t]() {
+        t->fn(t->arg);
+        delete t;
+    }).detach();
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    // Handle được giải phóng khi hàm task trả về (xem task.h)
+    (void)task;
+}
+
+void vTaskDelay(TickType_t ticks) {
+    if (ticks == 0) std::this_thread::yield();
+    else std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+// ===================== Mutex =====================
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+    return new (std::nothrow) MeoHostMutex();
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t m, TickType_t wait) {
+    if (!m) return pdFALSE;
+    if (wait == portMAX_DELAY) { m->m.lock(); return pdTRUE; }
+    return m->m.try_lock_for(std::chrono::milliseconds(wait)) ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t m) {
+    if (!m) return pdFALSE;
+    m->m.unlock();
+    return pdTRUE;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t m) {
+    delete m;
+}
+
+// ===================== Queue =====================
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+    if (length == 0 || itemSize == 0) return nullptr;
+    MeoHostQueue* q = new (std::nothrow) MeoHostQueue();
+    if (!q) return nullptr;
+    q->itemSize = itemSize;
+    q->length   = length;
+    q->buf.resize((size_t)length * itemSize);
+    return q;
+}
+
+void vQueueDelete(QueueHandle_t q) {
+    delete q;
+}
+
+BaseType_t xQueueSend(QueueHandle_t q, const void* item, TickType_t wait) {
+    if (!q) return pdFALSE;
+    std::unique_lock<std::mutex> lock(q->m);
+    if (!waitFor(q->notFull, lock, wait, [q] { return q->count < q->length; })) return pdFALSE;
+    size_t tail = (q->head + q->count) % q->length;
+    memcpy(q->buf.data() + tail * q->itemSize, item, q->itemSize);
+    q->count++;
+    lock.unlock();
+    q->notEmpty.notify_one();
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void* item, TickType_t wait) {
+    if (!q) return pdFALSE;
+    std::unique_lock<std::mutex> lock(q->m);
+    if (!waitFor(q->notEmpty, lock, wait, [q] { return q->count > 0; })) return pdFALSE;
+    memcpy(item, q->buf.data() + q->head * q->itemSize, q->itemSize);
+    q->head = (q->head + 1) % q->length;
+    q->count--;
+    lock.unlock();
+    q->notFull.notify_one();
+    return pdTRUE;
+}
+
+BaseType_t xQueueReset(QueueHandle_t q) {
+    if (!q) return pdFALSE;
+    {
+        std::lock_guard<std::mutex> lock(q->m);
+        q->head  = 0;
+        q->count = 0;
+    }
+    q->notFull.notify_all();
+    return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q) {
+    if (!q) return 0;
+    std::lock_guard<std::mutex> lock(q->m);
+    return (UBaseType_t)q->count;
+}
+
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t q) {
+    if (!q) return 0;
+    std::lock_guard<std::mutex> lock(q->m);
+    return (UBaseType_t)(q->length - q->count);
+}
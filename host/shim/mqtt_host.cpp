@@ -0,0 +1,269 @@
+#include "mqtt_client.h"
+#include "mqtt_host.h"
+
+#include <atomic>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <new>
+#include <string>
+#include <vector>
+
+struct esp_mqtt_client {
+    struct Message {
+        std::string          topic;
+        std::vector<uint8_t> data;
+        int                  qos;
+        int                  retain;
+        int                  msgId;
+    };
+
+    std::mutex               lock;
+    esp_event_handler_t      handler = nullptr;
+    void*                    handlerArgs = nullptr;
+    esp_mqtt_host_publish_fn onPublish = nullptr;
+    void*                    onPublishCtx = nullptr;
+    bool                     connected = false;
+    int                      nextId = 0;
+    uint64_t                 outboxLimit = 0;   // 0 = không giới hạn
+    size_t                   outboxBytes = 0;
+    std::deque<Message>      outbox;            // giữ khi mất kết nối
+    std::vector<int>         unacked;           // QoS>0 chờ MQTT_EVENT_PUBLISHED
+};
+
+namespace {
+std::atomic<esp_mqtt_client_handle_t> gLast{nullptr};
+const char kBase[] = "MQTT_EVENTS";
+
+// Gọi handler ngoài khóa: handler được phép publish / subscribe
+void fire(esp_mqtt_client_handle_t c, esp_mqtt_event_t& ev) {
+    esp_event_handler_t h;
+    void* args;
+    {
+        std::lock_guard<std::mutex> g(c->lock);
+        h    = c->handler;
+        args = c->handlerArgs;
+    }
+    ev.client = c;
+    if (h) h(args, kBase, (int32_t)ev.event_id, &ev);
+}
+
+void fireSimple(esp_mqtt_client_handle_t c, esp_mqtt_event_id_t id, int msgId = 0) {
+    esp_mqtt_event_t ev = {};
+    ev.event_id = id;
+    ev.msg_id   = msgId;
+    fire(c, ev);
+}
+
+// Message rời client: báo hook, ghi nhớ msg_id chờ ack. Gọi khi không giữ khóa.
+void emit(esp_mqtt_client_handle_t c, const esp_mqtt_client::Message& m) {
+    esp_mqtt_host_publish_fn fn;
+    void* ctx;
+    {
+        std::lock_guard<std::mutex> g(c->lock);
+        if (m.qos > 0) c->unacked.push_back(m.msgId);
+        fn  = c->onPublish;
+        ctx = c->onPublishCtx;
+    }
+    if (fn) fn(m.topic.c_str(), m.data.data(), m.data.size(), m.qos, m.retain, ctx);
+}
+
+int nextMsgId(esp_mqtt_client_handle_t c) {
+    c->nextId = (c->nextId % 65535) + 1;
+    return c->nextId;
+}
+}
+
+esp_mqtt_client_handle_t esp_mqtt_client_init(const esp_mqtt_client_config_t* config) {
+    esp_mqtt_client_handle_t c = new (std::nothrow) esp_mqtt_client();
+    if (!c) return nullptr;
+    if (config) c->outboxLimit = config->outbox.limit;
+    gLast.store(c);
+    return c;
+}
+
+esp_err_t esp_mqtt_set_config(esp_mqtt_client_handle_t client, const esp_mqtt_client_config_t* config) {
+    if (!client || !config) return ESP_ERR_INVALID_ARG;
+    std::lock_guard<std::mutex> g(client->lock);
+    client->outboxLimit = config->outbox.limit;
+    return ESP_OK;
+}
+
+esp_err_t esp_mqtt_client_register_event(esp_mqtt_client_handle_t client, esp_mqtt_event_id_t event,
+                                         esp_event_handler_t handler, void* handler_args) {
+    (void)event;
+    if (!client) return ESP_ERR_INVALID_ARG;
+    std::lock_guard<std::mutex> g(client->lock);
+    client->handler     = handler;
+    client->handlerArgs = handler_args;
+    return ESP_OK;
+}
+
+// Không có broker: kết nối chỉ xảy ra khi gọi esp_mqtt_host_connect()
+esp_err_t esp_mqtt_client_start(esp_mqtt_client_handle_t client) {
+    return client ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t esp_mqtt_client_stop(esp_mqtt_client_handle_t client) {
+    if (!client) return ESP_ERR_INVALID_ARG;
+    std::lock_guard<std::mutex> g(client->lock);
+    client->connected = false;
+    return ESP_OK;
+}
+
+esp_err_t esp_mqtt_client_reconnect(esp_mqtt_client_handle_t client) {
+    return client ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t esp_mqtt_client_destroy(esp_mqtt_client_handle_t client) {
+    if (!client) return ESP_ERR_INVALID_ARG;
+    esp_mqtt_client_handle_t self = client;
+    gLast.compare_exchange_strong(self, nullptr);
+    delete client;
+    return ESP_OK;
+}
+
+int esp_mqtt_client_publish(esp_mqtt_client_handle_t client, const char* topic, const char* data,
+                            int len, int qos, int retain) {
+    if (!client || !topic) return -1;
+    esp_mqtt_client::Message m;
+    {
+        std::lock_guard<std::mutex> g(client->lock);
+        if (!client->connected) return -1;
+        m.msgId = qos > 0 ? nextMsgId(client) : 0;
+    }
+    if (len <= 0 && data) len = (int)strlen(data);
+    m.topic.assign(topic);
+    if (len > 0) m.data.assign((const uint8_t*)data, (const uint8_t*)data + len);
+    m.qos    = qos;
+    m.retain = retain;
+    emit(client, m);
+    return m.msgId;
+}
+
+int esp_mqtt_client_enqueue(esp_mqtt_client_handle_t client, const char* topic, const char* data,
+                            int len, int qos, int retain, bool store) {
+    if (!client || !topic) return -1;
+    if (len <= 0 && data) len = (int)strlen(data);
+    {
+        std::lock_guard<std::mutex> g(client->lock);
+        if (!client->connected) {
+            if (!store && qos == 0) return -1;
+            size_t bytes = strlen(topic) + (size_t)(len > 0 ? len : 0);
+            if (client->outboxLimit && client->outboxBytes + bytes > client->outboxLimit) return -2;
+            esp_mqtt_client::Message m;
+            m.topic.assign(topic);
+            if (len > 0) m.data.assign((const uint8_t*)data, (const uint8_t*)data + len);
+            m.qos    = qos;
+            m.retain = retain;
+            m.msgId  = qos > 0 ? nextMsgId(client) : 0;
+            client->outboxBytes += bytes;
+            client->outbox.push_back(std::move(m));
+            return client->outbox.back().msgId;
+        }
+    }
+    return esp_mqtt_client_publish(client, topic, data, len, qos, retain);
+}
+
+int esp_mqtt_client_subscribe(esp_mqtt_client_handle_t client, const char* topic, int qos) {
+    (void)qos;
+    if (!client || !topic) return -1;
+    std::lock_guard<std::mutex> g(client->lock);
+    return client->connected ? nextMsgId(client) : -1;
+}
+
+int esp_mqtt_client_unsubscribe(esp_mqtt_client_handle_t client, const char* topic) {
+    if (!client || !topic) return -1;
+    std::lock_guard<std::mutex> g(client->lock);
+    return client->connected ? nextMsgId(client) : -1;
+}
+
+int esp_mqtt_client_get_outbox_size(esp_mqtt_client_handle_t client) {
+    if (!client) return 0;
+    std::lock_guard<std::mutex> g(client->lock);
+    return (int)client->outboxBytes;
+}
+
+// ===================== Điều khiển từ host =====================
+
+esp_mqtt_client_handle_t esp_mqtt_host_last_client(void) {
+    return gLast.load();
+}
+
+void esp_mqtt_host_connect(esp_mqtt_client_handle_t client) {
+    if (!client) return;
+    std::deque<esp_mqtt_client::Message> pending;
+    {
+        std::lock_guard<std::mutex> g(client->lock);
+        client->connected = true;
+        pending.swap(client->outbox);
+        client->outboxBytes = 0;
+    }
+    esp_mqtt_event_t ev = {};
+    ev.event_id = MQTT_EVENT_CONNECTED;
+    fire(client, ev);
+    for (const esp_mqtt_client::Message& m : pending) emit(client, m);
+}
+
+void esp_mqtt_host_disconnect(esp_mqtt_client_handle_t client) {
+    if (!client) return;
+    {
+        std::lock_guard<std::mutex> g(client->lock);
+        client->connected = false;
+    }
+    fireSimple(client, MQTT_EVENT_DISCONNECTED);
+}
+
+void esp_mqtt_host_refuse(esp_mqtt_client_handle_t client, int returnCode) {
+    if (!client) return;
+    {
+        std::lock_guard<std::mutex> g(client->lock);
+        client->connected = false;
+    }
+    esp_mqtt_error_codes_t err = {};
+    err.error_type          = MQTT_ERROR_TYPE_CONNECTION_REFUSED;
+    err.connect_return_code = returnCode;
+    esp_mqtt_event_t ev = {};
+    ev.event_id     = MQTT_EVENT_ERROR;
+    ev.error_handle = &err;
+    fire(client, ev);
+}
+
+void esp_mqtt_host_deliver(esp_mqtt_client_handle_t client, const char* topic,
+                           const uint8_t* data, size_t len, size_t chunk) {
+    if (!client || !topic) return;
+    if (chunk == 0 || chunk > len) chunk = len;
+    size_t off = 0;
+    do {
+        size_t n = len - off < chunk ? len - off : chunk;
+        esp_mqtt_event_t ev = {};
+        ev.event_id            = MQTT_EVENT_DATA;
+        // Như esp-mqtt: chỉ fragment đầu mang topic
+        ev.topic               = off == 0 ? (char*)topic : nullptr;
+        ev.topic_len           = off == 0 ? (int)strlen(topic) : 0;
+        ev.data                = (char*)data + off;
+        ev.data_len            = (int)n;
+        ev.total_data_len      = (int)len;
+        ev.current_data_offset = (int)off;
+        fire(client, ev);
+        off += n;
+    } while (off < len);
+}
+
+size_t esp_mqtt_host_ack_all(esp_mqtt_client_handle_t client) {
+    if (!client) return 0;
+    std::vector<int> ids;
+    {
+        std::lock_guard<std::mutex> g(client->lock);
+        ids.swap(client->unacked);
+    }
+    for (int id : ids) fireSimple(client, MQTT_EVENT_PUBLISHED, id);
+    return ids.size();
+}
+
+void esp_mqtt_host_on_publish(esp_mqtt_client_handle_t client, esp_mqtt_host_publish_fn fn, void* ctx) {
+    if (!client) return;
+    std::lock_guard<std::mutex> g(client->lock);
+    client->onPublish    = fn;
+    client->onPublishCtx = ctx;
+}
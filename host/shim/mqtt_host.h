@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "mqtt_client.h"
+
+// Điều khiển esp-mqtt shim từ code đo / test trên host (không có trên target).
+
+// Client tạo gần nhất (MeoMqttClient giữ handle riêng tư)
+esp_mqtt_client_handle_t esp_mqtt_host_last_client(void);
+
+// Giả lập broker: CONNECTED (outbox được xả như khi có lại kết nối) / DISCONNECTED /
+// lỗi CONNECTION_REFUSED với mã CONNACK
+void esp_mqtt_host_connect(esp_mqtt_client_handle_t client);
+void esp_mqtt_host_disconnect(esp_mqtt_client_handle_t client);
+void esp_mqtt_host_refuse(esp_mqtt_client_handle_t client, int returnCode);
+
+// MQTT_EVENT_DATA; chunk > 0 chia message thành nhiều fragment như esp-mqtt khi vượt buffer
+void esp_mqtt_host_deliver(esp_mqtt_client_handle_t client, const char* topic,
+                           const uint8_t* data, size_t len, size_t chunk = 0);
+
+// MQTT_EVENT_PUBLISHED cho mọi message QoS>0 đã gửi mà chưa được ack; trả về số ack
+size_t esp_mqtt_host_ack_all(esp_mqtt_client_handle_t client);
+
+// Mỗi message rời client (publish khi đang kết nối, hoặc xả outbox khi kết nối lại)
+typedef void (*esp_mqtt_host_publish_fn)(const char* topic, const uint8_t* data, size_t len,
+                                         int qos, int retain, void* ctx);
+void esp_mqtt_host_on_publish(esp_mqtt_client_handle_t client, esp_mqtt_host_publish_fn fn, void* ctx);
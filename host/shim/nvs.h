@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "esp_err.h"
+
+// Shim host: NVS trong RAM (namespace -> key -> giá trị có kiểu), mất khi thoát process.
+// Ngữ nghĩa theo NVS thật: key tối đa 15 ký tự, kiểu là một phần của key,
+// get với out == NULL trả về kích thước cần, buffer nhỏ -> ESP_ERR_NVS_INVALID_LENGTH.
+typedef uint32_t nvs_handle_t;
+
+typedef enum {
+    NVS_READONLY,
+    NVS_READWRITE
+} nvs_open_mode_t;
+
+esp_err_t nvs_open(const char* name, nvs_open_mode_t mode, nvs_handle_t* out);
+void      nvs_close(nvs_handle_t handle);
+esp_err_t nvs_commit(nvs_handle_t handle);
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char* key, void* out, size_t* length);
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char* key, const void* value, size_t length);
+esp_err_t nvs_get_str(nvs_handle_t handle, const char* key, char* out, size_t* length);
+esp_err_t nvs_set_str(nvs_handle_t handle, const char* key, const char* value);
+esp_err_t nvs_get_i16(nvs_handle_t handle, const char* key, int16_t* out);
+esp_err_t nvs_set_i16(nvs_handle_t handle, const char* key, int16_t value);
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char* key);
+esp_err_t nvs_erase_all(nvs_handle_t handle);
@@ -0,0 +1,7 @@
+#pragma once
+
+#include "esp_err.h"
+
+// Shim host: init luôn thành công; erase xoá mọi namespace (dùng để reset giữa các lần đo)
+esp_err_t nvs_flash_init(void);
+esp_err_t nvs_flash_erase(void);
@@ -0,0 +1,155 @@
+#include "nvs.h"
+#include "nvs_flash.h"
+
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace {
+enum class Type : uint8_t { I16, Str, Blob };
+
+struct Entry {
+    Type                 type;
+    std::vector<uint8_t> data;   // Str: kèm '\0'
+};
+
+struct Handle {
+    std::string     ns;
+    nvs_open_mode_t mode;
+};
+
+const size_t kNameMax = 15;   // NVS_KEY_NAME_MAX_SIZE - 1
+
+std::mutex                                          gLock;
+bool                                                gInit = false;
+std::map<std::string, std::map<std::string, Entry>> gStore;
+std::map<nvs_handle_t, Handle>                      gHandles;
+nvs_handle_t                                        gNextHandle = 1;
+
+bool validName(const char* s) {
+    return s && s[0] && strlen(s) <= kNameMax;
+}
+
+// Tra handle + key; gọi khi đang giữ gLock
+esp_err_t lookup(nvs_handle_t h, const char* key, bool write, Handle*& out) {
+    auto it = gHandles.find(h);
+    if (it == gHandles.end()) return ESP_ERR_NVS_INVALID_HANDLE;
+    if (!validName(key)) return ESP_ERR_NVS_INVALID_NAME;
+    if (write && it->second.mode == NVS_READONLY) return ESP_ERR_NVS_READ_ONLY;
+    out = &it->second;
+    return ESP_OK;
+}
+
+esp_err_t setEntry(nvs_handle_t h, const char* key, Type type, const void* data, size_t len) {
+    std::lock_guard<std::mutex> g(gLock);
+    Handle* hd;
+    esp_err_t err = lookup(h, key, true, hd);
+    if (err != ESP_OK) return err;
+    Entry& e = gStore[hd->ns][key];
+    e.type = type;
+    e.data.assign((const uint8_t*)data, (const uint8_t*)data + len);
+    return ESP_OK;
+}
+
+// out == NULL: chỉ trả kích thước; kiểu khác -> NOT_FOUND như NVS thật
+esp_err_t getEntry(nvs_handle_t h, const char* key, Type type, void* out, size_t* len) {
+    std::lock_guard<std::mutex> g(gLock);
+    Handle* hd;
+    esp_err_t err = lookup(h, key, false, hd);
+    if (err != ESP_OK) return err;
+    auto ns = gStore.find(hd->ns);
+    if (ns == gStore.end()) return ESP_ERR_NVS_NOT_FOUND;
+    auto it = ns->second.find(key);
+    if (it == ns->second.end() || it->second.type != type) return ESP_ERR_NVS_NOT_FOUND;
+
+    const std::vector<uint8_t>& d = it->second.data;
+    if (!out) { *len = d.size(); return ESP_OK; }
+    if (*len < d.size()) { *len = d.size(); return ESP_ERR_NVS_INVALID_LENGTH; }
+    if (!d.empty()) memcpy(out, d.data(), d.size());
+    *len = d.size();
+    return ESP_OK;
+}
+}
+
+esp_err_t nvs_flash_init(void) {
+    std::lock_guard<std::mutex> g(gLock);
+    gInit = true;
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_erase(void) {
+    std::lock_guard<std::mutex> g(gLock);
+    gStore.clear();
+    return ESP_OK;
+}
+
+esp_err_t nvs_open(const char* name, nvs_open_mode_t mode, nvs_handle_t* out) {
+    std::lock_guard<std::mutex> g(gLock);
+    if (!gInit) return ESP_ERR_NVS_NOT_INITIALIZED;
+    if (!validName(name) || !out) return ESP_ERR_NVS_INVALID_NAME;
+    nvs_handle_t h = gNextHandle++;
+    gHandles[h] = Handle{ name, mode };
+    *out = h;
+    return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle) {
+    std::lock_guard<std::mutex> g(gLock);
+    gHandles.erase(handle);
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle) {
+    std::lock_guard<std::mutex> g(gLock);
+    return gHandles.count(handle) ? ESP_OK : ESP_ERR_NVS_INVALID_HANDLE;
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char* key, void* out, size_t* length) {
+    if (!length) return ESP_ERR_INVALID_ARG;
+    return getEntry(handle, key, Type::Blob, out, length);
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char* key, const void* value, size_t length) {
+    if (!value && length) return ESP_ERR_INVALID_ARG;
+    return setEntry(handle, key, Type::Blob, value, length);
+}
+
+esp_err_t nvs_get_str(nvs_handle_t handle, const char* key, char* out, size_t* length) {
+    if (!length) return ESP_ERR_INVALID_ARG;
+    return getEntry(handle, key, Type::Str, out, length);
+}
+
+esp_err_t nvs_set_str(nvs_handle_t handle, const char* key, const char* value) {
+    if (!value) return ESP_ERR_INVALID_ARG;
+    return setEntry(handle, key, Type::Str, value, strlen(value) + 1);
+}
+
+esp_err_t nvs_get_i16(nvs_handle_t handle, const char* key, int16_t* out) {
+    if (!out) return ESP_ERR_INVALID_ARG;
+    size_t len = sizeof(*out);
+    return getEntry(handle, key, Type::I16, out, &len);
+}
+
+esp_err_t nvs_set_i16(nvs_handle_t handle, const char* key, int16_t value) {
+    return setEntry(handle, key, Type::I16, &value, sizeof(value));
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char* key) {
+    std::lock_guard<std::mutex> g(gLock);
+    Handle* hd;
+    esp_err_t err = lookup(handle, key, true, hd);
+    if (err != ESP_OK) return err;
+    auto ns = gStore.find(hd->ns);
+    if (ns == gStore.end() || ns->second.erase(key) == 0) return ESP_ERR_NVS_NOT_FOUND;
+    return ESP_OK;
+}
+
+esp_err_t nvs_erase_all(nvs_handle_t handle) {
+    std::lock_guard<std::mutex> g(gLock);
+    auto it = gHandles.find(handle);
+    if (it == gHandles.end()) return ESP_ERR_NVS_INVALID_HANDLE;
+    if (it->second.mode == NVS_READONLY) return ESP_ERR_NVS_READ_ONLY;
+    gStore.erase(it->second.ns);
+    return ESP_OK;
+}
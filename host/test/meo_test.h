@@ -0,0 +1,108 @@
+#pragma once
+
+// Khung test tối thiểu cho build host (không kéo thêm dependency):
+//   MEO_TEST(ten) { MEO_CHECK(a == b); MEO_CHECK_EQ(x, 3); }
+//   int main(int argc, char** argv) { return meoTestMain(argc, argv); }
+// Mỗi file test là một executable đăng ký với ctest; tham số (nếu có) lọc test theo tên con.
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+struct MeoTestCase {
+    const char*  name;
+    void       (*fn)();
+    MeoTestCase* next;
+};
+
+inline MeoTestCase*& meoTestHead() {
+    static MeoTestCase* head = nullptr;
+    return head;
+}
+
+inline int& meoTestFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+struct MeoTestRegistrar {
+    MeoTestRegistrar(MeoTestCase* tc) {
+        // Giữ thứ tự khai báo trong file
+        MeoTestCase** p = &meoTestHead();
+        while (*p) p = &(*p)->next;
+        *p = tc;
+    }
+};
+
+#define MEO_TEST_CAT2(a, b) a##b
+#define MEO_TEST_CAT(a, b)  MEO_TEST_CAT2(a, b)
+
+#define MEO_TEST(name)                                                              \
+    static void MEO_TEST_CAT(meo_test_, name)();                                    \
+    static MeoTestCase MEO_TEST_CAT(meo_case_, name){ #name, &MEO_TEST_CAT(meo_test_, name), nullptr }; \
+    static MeoTestRegistrar MEO_TEST_CAT(meo_reg_, name){ &MEO_TEST_CAT(meo_case_, name) }; \
+    static void MEO_TEST_CAT(meo_test_, name)()
+
+#define MEO_CHECK(cond)                                                             \
+    do {                                                                            \
+        if (!(cond)) {                                                              \
+            ++meoTestFailures();                                                    \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+        }                                                                           \
+    } while (0)
+
+// So sánh hai giá trị in được qua std::to_string / chuỗi
+#define MEO_CHECK_EQ(a, b)                                                          \
+    do {                                                                            \
+        auto&& _meo_a = (a);                                                        \
+        auto&& _meo_b = (b);                                                        \
+        if (!meoTestEq(_meo_a, _meo_b)) {                                                \
+            ++meoTestFailures();                                                    \
+            fprintf(stderr, "%s:%d: CHECK_EQ(%s, %s) failed: %s != %s\n", __FILE__, __LINE__, \
+                    #a, #b, meoTestStr(_meo_a).c_str(), meoTestStr(_meo_b).c_str()); \
+        }                                                                           \
+    } while (0)
+
+// Chuỗi C so theo nội dung, còn lại dùng operator==
+template <typename A, typename B>
+inline bool meoTestEq(const A& a, const B& b) {
+    if constexpr (std::is_convertible_v<A, std::string_view> && std::is_convertible_v<B, std::string_view>) {
+        return std::string_view(a) == std::string_view(b);
+    } else {
+        return a == b;
+    }
+}
+
+template <typename T>
+inline std::string meoTestStr(const T& v) {
+    if constexpr (std::is_convertible_v<T, std::string_view>) {
+        std::string s(1, '"');
+        s.append(std::string_view(v)).push_back('"');
+        return s;
+    } else if constexpr (std::is_enum_v<T>) {
+        return std::to_string((long long)v);
+    } else if constexpr (std::is_same_v<T, bool>) {
+        return v ? "true" : "false";
+    } else {
+        return std::to_string(v);
+    }
+}
+
+inline int meoTestMain(int argc, char** argv) {
+    const char* filter = argc > 1 ? argv[1] : nullptr;
+    int run = 0;
+    int failed = 0;
+    for (MeoTestCase* tc = meoTestHead(); tc; tc = tc->next) {
+        if (filter && !strstr(tc->name, filter)) continue;
+        int before = meoTestFailures();
+        tc->fn();
+        ++run;
+        bool ok = meoTestFailures() == before;
+        if (!ok) ++failed;
+        printf("[%s] %s\n", ok ? " OK " : "FAIL", tc->name);
+    }
+    printf("%d test(s), %d failed\n", run, failed);
+    return failed == 0 && run > 0 ? 0 : 1;
+}
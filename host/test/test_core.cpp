@@ -0,0 +1,441 @@
+// Hồi quy cho phần core: topic, JSON / CBOR, dispatch, router, storage, feature invoke
+#include "meo_test.h"
+
+#include <string>
+#include <vector>
+
+#include "Meo3_Topic.h"
+#include "Meo3_Dispatch.h"
+#include "Meo3_Metrics.h"
+#include "Meo3_JsonWriter.h"
+#include "Meo3_JsonReader.h"
+#include "Meo3_Cbor.h"
+#include "Meo3_Codec.h"
+#include "Meo3_Type.h"
+#include "Meo3_TopicRouter.h"
+#include "Meo3_Storage.h"
+#include "Meo3_Mqtt.h"
+#include "Meo3_Feature.h"
+#include "mqtt_host.h"
+
+// ---- Topic ----
+
+MEO_TEST(topics_build_and_parse) {
+    MeoTopics t;
+    MEO_CHECK(t.setDeviceId("dev1"));
+    MEO_CHECK_EQ(t.status(), "meo/dev1/status");
+    MEO_CHECK_EQ(t.invokeFilter(), "meo/dev1/feature/+/invoke");
+    MEO_CHECK_EQ(t.response(), "meo/dev1/event/feature_response");
+
+    MeoTopicBuf<> ev;
+    MEO_CHECK(t.event(ev, "temp"));
+    MEO_CHECK_EQ(ev.c_str(), "meo/dev1/event/temp");
+
+    const char* name = nullptr;
+    size_t nameLen = 0;
+    const char topic[] = "meo/dev1/feature/fan/invoke";
+    MEO_CHECK(t.parseInvoke(topic, sizeof(topic) - 1, name, nameLen));
+    MEO_CHECK_EQ(std::string(name, nameLen), "fan");
+
+    const char other[] = "meo/dev2/feature/fan/invoke";
+    MEO_CHECK(!t.parseInvoke(other, sizeof(other) - 1, name, nameLen));
+    const char nested[] = "meo/dev1/feature/a/b/invoke";
+    MEO_CHECK(!t.parseInvoke(nested, sizeof(nested) - 1, name, nameLen));
+
+    const char* id = nullptr;
+    size_t idLen = 0;
+    MEO_CHECK(MeoTopics::parseAnyInvoke(other, sizeof(other) - 1, id, idLen, name, nameLen));
+    MEO_CHECK_EQ(std::string(id, idLen), "dev2");
+    MEO_CHECK_EQ(std::string(name, nameLen), "fan");
+
+    MeoTopics empty;
+    MEO_CHECK(!empty.setDeviceId(""));
+    MEO_CHECK(!empty.valid());
+}
+
+MEO_TEST(topic_buf_overflow) {
+    MeoTopicBuf<8> b;
+    b.append("meo/").append("abc");
+    MEO_CHECK(b.ok());
+    b.append("defgh");
+    MEO_CHECK(!b.ok());
+    MEO_CHECK_EQ(b.length(), (size_t)7);
+    MEO_CHECK_EQ(b.c_str(), "meo/abc");
+
+    // Dùng lại buffer sau khi tràn: truncate về prefix xóa cờ tràn
+    b.truncate(4);
+    MEO_CHECK(b.ok());
+    MEO_CHECK_EQ(b.c_str(), "meo/");
+    b.append("xyz12");
+    MEO_CHECK(!b.ok());
+    b.truncate(0);
+    MEO_CHECK(!b.ok());   // rỗng
+    b.append("a/b");
+    MEO_CHECK(b.ok());
+    b.truncate(10);       // quá độ dài hiện tại: không đổi
+    MEO_CHECK_EQ(b.c_str(), "a/b");
+
+    // MeoTopics::event() dùng lại cùng buffer cho tên dài rồi tên ngắn
+    MeoTopics t;
+    MEO_CHECK(t.setDeviceId("dev1"));
+    MeoTopicBuf<24> e;
+    MEO_CHECK(!t.event(e, "a_very_long_event_name"));
+    MEO_CHECK(t.event(e, "temp"));
+    MEO_CHECK_EQ(e.c_str(), "meo/dev1/event/temp");
+}
+
+// ---- JSON ----
+
+MEO_TEST(json_write_escape_and_read_back) {
+    char buf[128];
+    MeoJsonWriter w(buf, sizeof(buf));
+    w.beginObject()
+     .field("s", "a\"b\\c\n")
+     .field("i", -42)
+     .field("u", (uint32_t)4000000000u)
+     .field("f", 1.5)
+     .field("b", true)
+     .key("arr").beginArray().value(1).value(2).value(3).endArray()
+     .endObject();
+    MEO_CHECK(w.finish());
+    MEO_CHECK_EQ(std::string(buf, w.length()),
+                 "{\"s\":\"a\\\"b\\\\c\\n\",\"i\":-42,\"u\":4000000000,\"f\":1.5,\"b\":true,\"arr\":[1,2,3]}");
+
+    MeoJsonView root = MeoJsonView::parse(buf, w.length());
+    MEO_CHECK(root.isObject());
+    MEO_CHECK_EQ(root.size(), (size_t)6);
+    MEO_CHECK_EQ(root["i"].asInt(), (int64_t)-42);
+    MEO_CHECK_EQ(root["u"].asInt(), (int64_t)4000000000LL);
+    MEO_CHECK_EQ(root["f"].asDouble(), 1.5);
+    MEO_CHECK(root["b"].asBool());
+    MEO_CHECK_EQ(root["arr"].size(), (size_t)3);
+    MEO_CHECK_EQ(root["arr"].at(2).asInt(), (int64_t)3);
+    MEO_CHECK(!root["missing"].valid());
+
+    MeoJsonView s = root["s"];
+    MEO_CHECK(s.needsUnescape());
+    char out[16];
+    size_t outLen = 0;
+    MEO_CHECK(s.unescape(out, sizeof(out), outLen));
+    MEO_CHECK_EQ(std::string(out, outLen), "a\"b\\c\n");
+}
+
+MEO_TEST(json_writer_overflow_reports_required) {
+    char buf[8];
+    MeoJsonWriter w(buf, sizeof(buf));
+    w.beginObject().field("key", "value").endObject();
+    MEO_CHECK(!w.ok());
+    MEO_CHECK(w.overflow());
+    MEO_CHECK_EQ(w.length(), (size_t)0);
+    MEO_CHECK_EQ(w.required(), sizeof("{\"key\":\"value\"}") - 1);
+}
+
+MEO_TEST(json_reader_rejects_malformed) {
+    const char* bad[] = { "", "{", "{\"a\":}", "{\"a\" 1}", "[1,2", "{\"a\":1}x", "\"open" };
+    for (const char* s : bad) {
+        MeoJsonView v = MeoJsonView::parse(s, strlen(s));
+        MEO_CHECK(!v.valid());
+    }
+    MeoJsonIterator it(MeoJsonView::parse("{\"a\":1,\"b\":[2]}", 15));
+    std::vector<std::string> keys;
+    while (it.next()) keys.emplace_back(it.key());
+    MEO_CHECK_EQ(keys.size(), (size_t)2);
+    MEO_CHECK(keys.size() == 2 && keys[0] == "a" && keys[1] == "b");
+}
+
+// ---- CBOR ----
+
+MEO_TEST(cbor_round_trip_and_to_json) {
+    uint8_t buf[128];
+    MeoCborWriter w(buf, sizeof(buf));
+    w.beginObject()
+     .field("name", "fan")
+     .field("speed", 7)
+     .field("neg", -300)
+     .field("ratio", 0.25)
+     .field("on", false)
+     .key("list").beginArray().value(1).value("x").endArray()
+     .endObject();
+    MEO_CHECK(w.ok());
+
+    MeoCborView root = MeoCborView::parse(buf, w.length());
+    MEO_CHECK(root.isMap());
+    MEO_CHECK(meoIsCborMap(buf, w.length()));
+    MEO_CHECK_EQ(root["name"].asString(), "fan");
+    MEO_CHECK_EQ(root["speed"].asInt(), (int64_t)7);
+    MEO_CHECK_EQ(root["neg"].asInt(), (int64_t)-300);
+    MEO_CHECK_EQ(root["ratio"].asDouble(), 0.25);
+    MEO_CHECK(root["on"].isBool() && !root["on"].asBool(true));
+    MEO_CHECK_EQ(root["list"].size(), (size_t)2);
+
+    char json[128];
+    MeoJsonWriter jw(json, sizeof(json));
+    MEO_CHECK(meoCborToJson(root, jw));
+    MEO_CHECK(jw.ok());
+    MEO_CHECK_EQ(std::string(json, jw.length()),
+                 "{\"name\":\"fan\",\"speed\":7,\"neg\":-300,\"ratio\":0.25,\"on\":false,\"list\":[1,\"x\"]}");
+
+    // Cắt cụt: parse phải từ chối, không đọc quá buffer
+    for (size_t n = 0; n < w.length(); ++n) {
+        MEO_CHECK(!MeoCborView::parse(buf, n).valid());
+    }
+}
+
+MEO_TEST(cbor_tag_runs_inside_containers) {
+    // {"x": <n × tag 0> 1}: tag không được đệ quy theo số lượng (trước đây tràn stack)
+    for (size_t n : { (size_t)1, (size_t)400, (size_t)100000 }) {
+        std::vector<uint8_t> b = { 0xa1, 0x61, 'x' };
+        b.insert(b.end(), n, 0xc0);
+        b.push_back(0x01);
+        MeoCborView root = MeoCborView::parse(b.data(), b.size());
+        MEO_CHECK(root.isMap());
+        MEO_CHECK_EQ(root["x"].asInt(), (int64_t)1);
+
+        // Cùng chuỗi tag trước mỗi phần tử của mảng lồng nhau (indefinite)
+        std::vector<uint8_t> a = { 0x9f };
+        for (int i = 0; i < 3; ++i) {
+            for (size_t k = 0; k < n; ++k) {
+                a.push_back(0xd8);   // tag 32 (argument 1 byte)
+                a.push_back(0x20);
+            }
+            a.push_back(0x80);       // []
+        }
+        a.push_back(0xff);
+        MEO_CHECK(MeoCborView::parse(a.data(), a.size()).valid());
+
+        // Tag ở cuối buffer / theo sau là break: không hợp lệ
+        b.resize(3 + n);
+        MEO_CHECK(!MeoCborView::parse(b.data(), b.size()).valid());
+    }
+    // Độ sâu map/array vẫn bị giới hạn
+    std::vector<uint8_t> deep((size_t)MEO_CBOR_MAX_DEPTH + 1, 0x81);
+    deep.push_back(0x00);
+    MEO_CHECK(!MeoCborView::parse(deep.data(), deep.size()).valid());
+}
+
+MEO_TEST(codec_encode_same_fill_both_writers) {
+    auto fill = [](auto& w) { w.beginObject().field("k", 1).endObject(); };
+    uint8_t buf[32];
+    size_t need = 0;
+    size_t n = meoEncode(MeoCodec::Json, buf, sizeof(buf), fill, &need);
+    MEO_CHECK_EQ(std::string((const char*)buf, n), "{\"k\":1}");
+    n = meoEncode(MeoCodec::Cbor, buf, sizeof(buf), fill, &need);
+    MEO_CHECK_EQ(n, (size_t)5);   // bf 61 'k' 01 ff
+    MEO_CHECK_EQ(meoEncode(MeoCodec::Json, buf, 4, fill, &need), (size_t)0);
+    MEO_CHECK_EQ(need, (size_t)7);
+}
+
+MEO_TEST(feature_call_copy_owns_params) {
+    // Params của call là view vào message invoke; bản copy phải tự giữ key / chuỗi
+    MeoFeatureCall copy;
+    {
+        std::string msg = "speedmodeecocfg{\"a\":[1,2]}";
+        MeoFeatureCall call;
+        call.featureName   = "fan";
+        call.correlationId = "c-42";
+        call.params.set(std::string_view(msg.data(), 5), 7);
+        call.params.set(std::string_view(msg.data() + 5, 4), std::string_view(msg.data() + 9, 3));
+        call.params.setRaw(std::string_view(msg.data() + 12, 3), std::string_view(msg.data() + 15, 11));
+        call.params.set("on", true);
+        copy = call;
+        MeoFeatureCall again(call);
+        MEO_CHECK_EQ(again.params.size(), (size_t)4);
+        msg.assign(msg.size(), '#');   // message cũ bị ghi đè / giải phóng
+    }
+    MEO_CHECK_EQ(copy.featureName, "fan");
+    MEO_CHECK_EQ(copy.correlationId, "c-42");
+    MEO_CHECK_EQ(copy.params.size(), (size_t)4);
+    MEO_CHECK_EQ(copy.params.getInt("speed"), (int64_t)7);
+    MEO_CHECK(copy.params.getString("mode") == "eco");
+    MEO_CHECK(copy.params.getString("cfg") == "{\"a\":[1,2]}");
+    MEO_CHECK(copy.params.getBool("on"));
+
+    // Move giữ nguyên view vào buffer của bản copy
+    MeoFeatureCall moved(static_cast<MeoFeatureCall&&>(copy));
+    MEO_CHECK(moved.params.getString("mode") == "eco");
+    copy = moved;
+    copy = copy;
+    MEO_CHECK(copy.params.getString("cfg") == "{\"a\":[1,2]}");
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+    std::map<std::string, std::string> m = moved.paramsMap();
+#pragma GCC diagnostic pop
+    MEO_CHECK_EQ(m.size(), (size_t)4);
+    MEO_CHECK_EQ(m["speed"], "7");
+    MEO_CHECK_EQ(m["on"], "true");
+}
+
+// ---- Dispatch / router ----
+
+MEO_TEST(dispatch_table_find_by_view) {
+    MeoDispatchTable<int, 4> t;
+    MEO_CHECK(t.add("on", 1));
+    MEO_CHECK(t.add("off", 2));
+    MEO_CHECK(!t.add("on", 3));
+    MEO_CHECK(!t.add("", 3));
+    MEO_CHECK(t.add("a", 3));
+    MEO_CHECK(t.add("b", 4));
+    MEO_CHECK(!t.add("c", 5));   // đầy
+
+    const char topic[] = "offline";
+    int i = t.find(topic, 3);
+    MEO_CHECK(i >= 0 && t[(size_t)i].handler == 2);
+    MEO_CHECK_EQ(t.find(topic, 2), -1);
+    MEO_CHECK_EQ(t.find("on"), 0);
+    MEO_CHECK_EQ(meoHash("on"), meoHash("on", 2));
+}
+
+MEO_TEST(metrics_table_overflow_is_reported) {
+    MeoMetricsTable<3> m;
+    m.metric("pub").set(5);
+    m.metric("fan", "invoke").inc();
+    m.metric("heat", "invoke").inc(2);
+    MeoMetric& spare = m.metric("light", "invoke");   // đầy: metric dự phòng
+    spare.inc();
+    MEO_CHECK_EQ(m.size(), (size_t)3);
+    MEO_CHECK_EQ(m.overflow(), (uint32_t)1);
+    MEO_CHECK(&m.metric("fan", "invoke") == &m[1]);   // tìm lại không tính là tràn
+    MEO_CHECK_EQ(m.overflow(), (uint32_t)1);
+
+    char buf[128];
+    MeoJsonWriter w(buf, sizeof(buf));
+    w.beginObject();
+    m.writeFields(w);
+    w.endObject();
+    MEO_CHECK(w.finish());
+    MEO_CHECK_EQ(buf, "{\"pub\":5,\"invoke\":{\"fan\":1,\"heat\":2},\"metrics_overflow\":1}");
+}
+
+MEO_TEST(topic_router_wildcards) {
+    MeoTopicRouter r;
+    int a = 0, b = 0;
+    MEO_CHECK(r.add("meo/+/feature/+/invoke", nullptr, &a, 0) >= 0);
+    MEO_CHECK(r.add("meo/dev1/#", nullptr, &b, 0) >= 0);
+    MEO_CHECK(r.add("meo/a+/x", nullptr, &b, 0) < 0);
+    MEO_CHECK(!MeoTopicRouter::validFilter("meo/#/x"));
+
+    int8_t idx[MEO_ROUTER_MAX_ROUTES];
+    const char t1[] = "meo/dev1/feature/fan/invoke";
+    MEO_CHECK_EQ(r.match(t1, sizeof(t1) - 1, idx, MEO_ROUTER_MAX_ROUTES), (size_t)2);
+    const char t2[] = "meo/dev2/feature/fan/invoke";
+    MEO_CHECK_EQ(r.match(t2, sizeof(t2) - 1, idx, MEO_ROUTER_MAX_ROUTES), (size_t)1);
+    MEO_CHECK(r.route(idx[0]).ctx == &a);
+    const char t3[] = "$SYS/meo/dev1";
+    MEO_CHECK_EQ(r.match(t3, sizeof(t3) - 1, idx, MEO_ROUTER_MAX_ROUTES), (size_t)0);
+
+    MEO_CHECK(r.remove("meo/dev1/#", nullptr, &b));
+    MEO_CHECK_EQ(r.match(t1, sizeof(t1) - 1, idx, MEO_ROUTER_MAX_ROUTES), (size_t)1);
+}
+
+// ---- Storage (NVS shim) ----
+
+MEO_TEST(storage_typed_values) {
+    MeoStorage st;
+    MEO_CHECK(st.begin("meotest"));
+    MEO_CHECK(st.saveString("ssid", "home"));
+    MEO_CHECK(st.saveShort("n", -42));
+    const uint8_t blob[3] = { 1, 2, 3 };
+    MEO_CHECK(st.saveBytes("blob", blob, sizeof(blob)));
+
+    std::string s;
+    int16_t v = 0;
+    uint8_t out[3] = {};
+    char cs[8];
+    MEO_CHECK(st.loadString("ssid", s));
+    MEO_CHECK_EQ(s, "home");
+    MEO_CHECK(st.loadShort("n", v));
+    MEO_CHECK_EQ(v, (int16_t)-42);
+    MEO_CHECK(st.loadBytes("blob", out, sizeof(out)));
+    MEO_CHECK(memcmp(out, blob, sizeof(blob)) == 0);
+    MEO_CHECK(st.loadCString("ssid", cs, sizeof(cs)));
+    MEO_CHECK_EQ(cs, "home");
+
+    MEO_CHECK(!st.loadShort("ssid", v));        // sai kiểu
+    MEO_CHECK(!st.loadCString("ssid", cs, 3));  // không vừa
+    MEO_CHECK(st.clearKey("ssid"));
+    MEO_CHECK(!st.loadString("ssid", s));
+    MEO_CHECK(st.clearAll());
+    MEO_CHECK(!st.loadShort("n", v));
+}
+
+// ---- Feature invoke qua MeoMqttClient + esp-mqtt shim ----
+
+namespace {
+struct FeatureProbe {
+    MeoFeature* feature = nullptr;
+    int         invokes = 0;
+    std::string name;
+    int64_t     speed = 0;
+    std::string mode;
+    std::vector<std::string> out;
+};
+
+void onFeature(const char* f, const char* id, const MeoJsonView& p, void* ctx) {
+    FeatureProbe* pr = static_cast<FeatureProbe*>(ctx);
+    pr->invokes++;
+    pr->name  = f;
+    pr->speed = p["speed"].asInt(-1);
+    pr->mode  = std::string(p["mode"].asString());
+    pr->feature->sendFeatureResponse(f, true, "ok");
+}
+
+void onPublish(const char* t, const uint8_t* d, size_t n, int, int, void* ctx) {
+    static_cast<FeatureProbe*>(ctx)->out.push_back(std::string(t) + " " + std::string((const char*)d, n));
+}
+}
+
+MEO_TEST(feature_invoke_json_and_cbor) {
+    MeoMqttClient mq;
+    mq.configure("broker");
+    mq.setCredentials("dev1", "key");
+    MEO_CHECK(mq.connect());
+    esp_mqtt_client_handle_t c = esp_mqtt_host_last_client();
+
+    FeatureProbe pr;
+    MeoFeature f;
+    pr.feature = &f;
+    esp_mqtt_host_on_publish(c, onPublish, &pr);
+    f.attach(&mq, "dev1");
+    MEO_CHECK(f.beginFeatureSubscribe(onFeature, &pr));
+    esp_mqtt_host_connect(c);
+    MEO_CHECK(mq.isConnected());
+    uint32_t gen = 0;
+    MEO_CHECK(mq.linkState(gen));
+    MEO_CHECK(gen != 0 && gen == mq.generation());
+
+    // JSON, chia fragment như khi vượt buffer của esp-mqtt
+    const char inv[] = "{\"params\":{\"speed\":7,\"mode\":\"eco\"}}";
+    esp_mqtt_host_deliver(c, "meo/dev1/feature/fan/invoke", (const uint8_t*)inv, sizeof(inv) - 1, 5);
+    MEO_CHECK_EQ(pr.invokes, 1);
+    MEO_CHECK_EQ(pr.name, "fan");
+    MEO_CHECK_EQ(pr.speed, (int64_t)7);
+    MEO_CHECK_EQ(pr.mode, "eco");
+    MEO_CHECK_EQ(pr.out.size(), (size_t)1);
+    if (!pr.out.empty()) {
+        MEO_CHECK_EQ(pr.out.back(), "meo/dev1/event/feature_response "
+                     "{\"feature_name\":\"fan\",\"device_id\":\"dev1\",\"success\":true,\"message\":\"ok\"}");
+    }
+
+    // CBOR: params được chuyển sang JSON cho callback
+    uint8_t cb[64];
+    MeoCborWriter w(cb, sizeof(cb));
+    w.beginObject().key("params").beginObject().field("speed", 3).field("mode", "turbo").endObject().endObject();
+    MEO_CHECK(w.ok());
+    esp_mqtt_host_deliver(c, "meo/dev1/feature/heat/invoke", cb, w.length());
+    MEO_CHECK_EQ(pr.invokes, 2);
+    MEO_CHECK_EQ(pr.name, "heat");
+    MEO_CHECK_EQ(pr.speed, (int64_t)3);
+    MEO_CHECK_EQ(pr.mode, "turbo");
+
+    // Không phải của thiết bị này / payload hỏng: bỏ qua
+    esp_mqtt_host_deliver(c, "meo/dev2/feature/fan/invoke", (const uint8_t*)inv, sizeof(inv) - 1);
+    esp_mqtt_host_deliver(c, "meo/dev1/feature/fan/invoke", (const uint8_t*)"{\"params\":", 10);
+    MEO_CHECK_EQ(pr.invokes, 2);
+
+    esp_mqtt_host_disconnect(c);
+    MEO_CHECK(!mq.isConnected());
+    MEO_CHECK(!mq.linkState(gen));
+}
+
+int main(int argc, char** argv) { return meoTestMain(argc, argv); }
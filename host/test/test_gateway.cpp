@@ -0,0 +1,358 @@
+// MeoGateway với transport giả: định tuyến invoke, gom batch, timeout status, phản hồi âm
+#include "meo_test.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Meo3_Gateway.h"
+#include "Meo3_JsonReader.h"
+
+namespace {
+
+// Transport giả: inject() gọi rx trên thread của người gọi như task RX thật
+class FakeTransport : public MeoChildTransport {
+public:
+    struct Sent { int type; std::string id, name, payload; };
+
+    bool begin(ReceiveFn rx, void* ctx) override { _rx = rx; _ctx = ctx; return true; }
+    void end() override { _rx = nullptr; }
+    bool send(const MeoChildMessage& m) override {
+        std::lock_guard<std::mutex> g(lock);
+        sent.push_back(Sent{ (int)m.type, std::string(m.deviceId ? m.deviceId : "", m.idLen),
+                             std::string(m.name ? m.name : "", m.nameLen),
+                             std::string((const char*)m.payload, m.payload ? m.len : 0) });
+        return accept;
+    }
+
+    void inject(MeoChildMsgType type, const std::string& id, const std::string& name = "",
+                const std::string& payload = "") {
+        MeoChildMessage m;
+        m.type     = type;
+        m.deviceId = id.data();
+        m.idLen    = (uint8_t)id.size();
+        m.name     = name.data();
+        m.nameLen  = (uint8_t)name.size();
+        m.payload  = (const uint8_t*)payload.data();
+        m.len      = payload.size();
+        if (_rx) _rx(m, _ctx);
+    }
+
+    std::mutex        lock;
+    std::vector<Sent> sent;
+    std::atomic<bool> accept{true};
+
+private:
+    ReceiveFn _rx = nullptr;
+    void*     _ctx = nullptr;
+};
+
+struct Pub {
+    MeoGatewayPub kind;
+    std::string   topic, payload;
+};
+
+struct Broker {
+    std::mutex       lock;
+    std::vector<Pub> pubs;
+    std::recursive_mutex* api = nullptr;   // khóa API của esp-mqtt (đệ quy như bản thật)
+
+    std::vector<Pub> take() {
+        std::lock_guard<std::mutex> g(lock);
+        std::vector<Pub> out;
+        out.swap(pubs);
+        return out;
+    }
+};
+
+bool publish(MeoGatewayPub kind, const char* topic, const uint8_t* payload, size_t len, void* ctx) {
+    Broker* b = static_cast<Broker*>(ctx);
+    std::unique_lock<std::recursive_mutex> api;
+    if (b->api) api = std::unique_lock<std::recursive_mutex>(*b->api);
+    std::lock_guard<std::mutex> g(b->lock);
+    b->pubs.push_back(Pub{ kind, topic, std::string((const char*)payload, len) });
+    return true;
+}
+
+// Gom (event, payload) của một con từ các message đã publish, theo thứ tự
+std::vector<std::string> eventsOf(const std::vector<Pub>& pubs, const std::string& id) {
+    std::vector<std::string> out;
+    const std::string single = "meo/" + id + "/event/";
+    const std::string batch  = single + "batch";
+    for (const Pub& p : pubs) {
+        if (p.kind != MeoGatewayPub::Event) continue;
+        if (p.topic == batch) {
+            MeoJsonView arr = MeoJsonView::parse(p.payload.data(), p.payload.size());
+            MEO_CHECK(arr.isArray());
+            MEO_CHECK(arr.size() > 1);
+            for (size_t i = 0; i < arr.size(); ++i) {
+                MeoJsonView it = arr.at(i);
+                MEO_CHECK(it["ts"].isNumber());
+                char name[64];
+                size_t n = 0;
+                MEO_CHECK(it["event"].unescape(name, sizeof(name), n));
+                out.push_back(std::string(name, n) + "=" + std::string(it["payload"].raw()));
+            }
+        } else if (p.topic.compare(0, single.size(), single) == 0) {
+            out.push_back(p.topic.substr(single.size()) + "=" + p.payload);
+        }
+    }
+    return out;
+}
+
+const Pub* find(const std::vector<Pub>& pubs, const std::string& topic) {
+    for (const Pub& p : pubs) if (p.topic == topic) return &p;
+    return nullptr;
+}
+
+}
+
+MEO_TEST(routes_invoke_to_known_online_child) {
+    FakeTransport tr;
+    Broker br;
+    MeoGateway gw;
+    gw.setSelfId("gw");
+    MeoGatewayConfig cfg;
+    cfg.batchWindowMs = 0;
+    MEO_CHECK(gw.begin(tr, publish, &br, cfg));
+
+    tr.inject(MeoChildMsgType::Status, "c1", "", "online");
+    tr.inject(MeoChildMsgType::Declare, "c1", "", "{\"events\":[]}");
+    auto pubs = br.take();
+    MEO_CHECK_EQ(pubs.size(), (size_t)2);
+    if (pubs.size() == 2) {
+        // Status trước declare
+        MEO_CHECK(pubs[0].kind == MeoGatewayPub::Status);
+        MEO_CHECK_EQ(pubs[0].topic, "meo/c1/status");
+        MEO_CHECK_EQ(pubs[0].payload, "online");
+        MEO_CHECK(pubs[1].kind == MeoGatewayPub::Declare);
+        MEO_CHECK_EQ(pubs[1].topic, "meo/c1/declare");
+    }
+
+    const char* inv = "{\"params\":{\"on\":true}}";
+    gw.routeInvoke("c1", 2, "led", 3, (const uint8_t*)inv, strlen(inv));
+    MEO_CHECK_EQ(tr.sent.size(), (size_t)1);
+    if (!tr.sent.empty()) {
+        MEO_CHECK_EQ(tr.sent[0].type, (int)MeoChildMsgType::Invoke);
+        MEO_CHECK_EQ(tr.sent[0].id, "c1");
+        MEO_CHECK_EQ(tr.sent[0].name, "led");
+        MEO_CHECK_EQ(tr.sent[0].payload, inv);
+    }
+
+    // Con chưa từng thấy: không gửi, không trả lời thay (có thể thuộc gateway khác)
+    gw.routeInvoke("c9", 2, "led", 3, (const uint8_t*)inv, strlen(inv));
+    MEO_CHECK_EQ(tr.sent.size(), (size_t)1);
+    MEO_CHECK(br.take().empty());
+
+    // Id của chính gateway / id có ký tự wildcard: từ chối
+    tr.inject(MeoChildMsgType::Status, "gw", "", "online");
+    tr.inject(MeoChildMsgType::Status, "a/b", "", "online");
+    MEO_CHECK(br.take().empty());
+
+    // Response của con đi lên topic của nó
+    tr.inject(MeoChildMsgType::Response, "c1", "", "{\"success\":true}");
+    pubs = br.take();
+    MEO_CHECK(pubs.size() == 1 && pubs[0].topic == "meo/c1/event/feature_response");
+
+    MeoGatewayStats st = gw.stats();
+    MEO_CHECK_EQ(st.children, 1u);
+    MEO_CHECK_EQ(st.online, 1u);
+    MEO_CHECK_EQ(st.invokesRouted, 1u);
+    MEO_CHECK_EQ(st.rejected, 2u);
+    gw.end();
+}
+
+MEO_TEST(negative_response_when_child_cannot_take_invoke) {
+    FakeTransport tr;
+    Broker br;
+    MeoGateway gw;
+    MeoGatewayConfig cfg;
+    cfg.batchWindowMs = 0;
+    MEO_CHECK(gw.begin(tr, publish, &br, cfg));
+
+    tr.inject(MeoChildMsgType::Status, "c1", "", "online");
+    tr.inject(MeoChildMsgType::Status, "c2", "", "offline");
+    br.take();
+
+    // Offline
+    gw.routeInvoke("c2", 2, "fan", 3, (const uint8_t*)"{}", 2);
+    auto pubs = br.take();
+    MEO_CHECK_EQ(pubs.size(), (size_t)1);
+    if (pubs.size() == 1) {
+        MEO_CHECK(pubs[0].kind == MeoGatewayPub::Response);
+        MEO_CHECK_EQ(pubs[0].topic, "meo/c2/event/feature_response");
+        MeoJsonView r = MeoJsonView::parse(pubs[0].payload.data(), pubs[0].payload.size());
+        MEO_CHECK(!r["success"].asBool(true));
+        MEO_CHECK_EQ(r["feature_name"].asString(), "fan");
+        MEO_CHECK_EQ(r["device_id"].asString(), "c2");
+        MEO_CHECK_EQ(r["message"].asString(), "Device offline");
+    }
+
+    // Link tới con từ chối
+    tr.accept = false;
+    gw.routeInvoke("c1", 2, "fan", 3, (const uint8_t*)"{}", 2);
+    pubs = br.take();
+    MEO_CHECK_EQ(pubs.size(), (size_t)1);
+    if (pubs.size() == 1) {
+        MeoJsonView r = MeoJsonView::parse(pubs[0].payload.data(), pubs[0].payload.size());
+        MEO_CHECK(!r["success"].asBool(true));
+        MEO_CHECK_EQ(r["message"].asString(), "Busy: child link");
+    }
+    MEO_CHECK_EQ(gw.stats().invokesFailed, 2u);
+    gw.end();
+}
+
+MEO_TEST(batches_events_per_child_in_order) {
+    FakeTransport tr;
+    Broker br;
+    MeoGateway gw;
+    MeoGatewayConfig cfg;
+    cfg.batchWindowMs = 60000;   // chỉ flush() tay
+    MEO_CHECK(gw.begin(tr, publish, &br, cfg));
+
+    tr.inject(MeoChildMsgType::Event, "c1", "t", "{\"v\":1}");
+    tr.inject(MeoChildMsgType::Event, "c2", "h", "{\"v\":2}");
+    tr.inject(MeoChildMsgType::Event, "c1", "t", "{\"v\":3}");
+    tr.inject(MeoChildMsgType::Event, "c1", "door", "{\"open\":true}");
+    auto pubs = br.take();
+    // Con mới nói -> online (status), event thì nằm chờ
+    MEO_CHECK_EQ(pubs.size(), (size_t)2);
+    MEO_CHECK(find(pubs, "meo/c1/status") && find(pubs, "meo/c2/status"));
+
+    MEO_CHECK(gw.flush());
+    pubs = br.take();
+    MEO_CHECK_EQ(pubs.size(), (size_t)2);
+    const Pub* b = find(pubs, "meo/c1/event/batch");
+    MEO_CHECK(b != nullptr);
+    MEO_CHECK(find(pubs, "meo/c2/event/h") != nullptr);   // một event: topic riêng
+    auto c1 = eventsOf(pubs, "c1");
+    MEO_CHECK_EQ(c1.size(), (size_t)3);
+    if (c1.size() == 3) {
+        MEO_CHECK_EQ(c1[0], "t={\"v\":1}");
+        MEO_CHECK_EQ(c1[1], "t={\"v\":3}");
+        MEO_CHECK_EQ(c1[2], "door={\"open\":true}");
+    }
+    MEO_CHECK_EQ(gw.stats().batches, 1u);
+    MEO_CHECK_EQ(gw.stats().eventsIn, 4u);
+
+    MEO_CHECK(gw.flush());   // rỗng
+    MEO_CHECK(br.take().empty());
+    gw.end();
+}
+
+MEO_TEST(batch_size_limit_never_drops_events) {
+    // Buffer nhỏ nhất và tên cần escape: mọi event phải ra đúng một lần, đúng thứ tự,
+    // dù message batch bị cắt ở đâu
+    for (size_t bytes : { (size_t)128, (size_t)200, (size_t)333 }) {
+        FakeTransport tr;
+        Broker br;
+        MeoGateway gw;
+        MeoGatewayConfig cfg;
+        cfg.batchWindowMs = 60000;
+        cfg.batchBytes    = bytes;
+        MEO_CHECK(gw.begin(tr, publish, &br, cfg));
+
+        std::vector<std::string> expected;
+        for (int i = 0; i < 60; ++i) {
+            std::string name = (i % 3 == 0) ? "q\"\\\"" : "ev" + std::to_string(i % 7);
+            std::string payload = "{\"i\":" + std::to_string(i) + ",\"pad\":\"" +
+                                  std::string((size_t)(i * 7) % 40, 'x') + "\"}";
+            tr.inject(MeoChildMsgType::Event, "c1", name, payload);
+            expected.push_back(name + "=" + payload);
+        }
+        MEO_CHECK(gw.flush());
+        auto got = eventsOf(br.take(), "c1");
+        MEO_CHECK_EQ(got.size(), expected.size());
+        MEO_CHECK(got == expected);
+        MEO_CHECK_EQ(gw.stats().rejected, 0u);
+        gw.end();
+    }
+}
+
+MEO_TEST(status_timeout_marks_child_offline) {
+    FakeTransport tr;
+    Broker br;
+    MeoGateway gw;
+    MeoGatewayConfig cfg;
+    cfg.batchWindowMs  = 0;
+    cfg.childTimeoutMs = 30;
+    MEO_CHECK(gw.begin(tr, publish, &br, cfg));
+
+    tr.inject(MeoChildMsgType::Status, "c1", "", "online");
+    tr.inject(MeoChildMsgType::Status, "c2", "", "online");
+    br.take();
+
+    gw.loop();
+    MEO_CHECK(br.take().empty());
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    tr.inject(MeoChildMsgType::Status, "c2", "", "online");   // heartbeat
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    gw.loop();
+    auto pubs = br.take();
+    MEO_CHECK_EQ(pubs.size(), (size_t)1);
+    if (pubs.size() == 1) {
+        MEO_CHECK_EQ(pubs[0].topic, "meo/c1/status");
+        MEO_CHECK_EQ(pubs[0].payload, "offline");
+    }
+    MEO_CHECK_EQ(gw.stats().online, 1u);
+
+    // Phiên MQTT mới: status của con còn online được publish lại, con được yêu cầu declare lại
+    gw.onConnected();
+    pubs = br.take();
+    MEO_CHECK(pubs.size() == 1 && pubs[0].topic == "meo/c2/status" && pubs[0].payload == "online");
+    MEO_CHECK(!tr.sent.empty() && tr.sent.back().type == (int)MeoChildMsgType::Redeclare);
+
+    // Con nói lại -> online
+    tr.inject(MeoChildMsgType::Event, "c1", "t", "{}");
+    pubs = br.take();
+    MEO_CHECK(find(pubs, "meo/c1/status") && find(pubs, "meo/c1/status")->payload == "online");
+    MEO_CHECK(find(pubs, "meo/c1/event/t") != nullptr);
+    gw.end();
+}
+
+MEO_TEST(no_publish_under_gateway_lock) {
+    // Task esp-mqtt giữ khóa API khi gọi routeInvoke; publish (cần khóa API) từ task
+    // transport / loop không được giữ khóa của gateway, nếu không hai bên chờ nhau mãi
+    FakeTransport tr;
+    Broker br;
+    std::recursive_mutex api;
+    br.api = &api;
+    MeoGateway gw;
+    MeoGatewayConfig cfg;
+    cfg.batchWindowMs  = 1;
+    cfg.batchBytes     = 256;
+    cfg.childTimeoutMs = 1;
+    MEO_CHECK(gw.begin(tr, publish, &br, cfg));
+    tr.inject(MeoChildMsgType::Status, "c1", "", "online");
+
+    std::atomic<bool> stop{false};
+    std::thread mqtt([&]() {
+        while (!stop.load()) {
+            {
+                std::lock_guard<std::recursive_mutex> g(api);
+                gw.routeInvoke("c1", 2, "led", 3, (const uint8_t*)"{}", 2);
+            }
+            std::this_thread::yield();   // mutex không công bằng: để thread khác lấy khóa API
+        }
+    });
+    std::thread loop([&]() {
+        while (!stop.load()) gw.loop();
+    });
+    auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds(200);
+    int i = 0;
+    while (std::chrono::steady_clock::now() < until) {
+        tr.inject(MeoChildMsgType::Event, "c1", "t", "{\"i\":" + std::to_string(i++) + "}");
+        if (i % 16 == 0) tr.inject(MeoChildMsgType::Status, "c1", "", "online");
+    }
+    stop = true;
+    mqtt.join();
+    loop.join();
+    gw.end();
+    MEO_CHECK(i > 0);
+    MEO_CHECK(!br.take().empty());
+}
+
+int main(int argc, char** argv) { return meoTestMain(argc, argv); }
@@ -0,0 +1,169 @@
+// MeoLogRing: chụp tham số lúc push và định dạng lại ở task log phải ra đúng như printf
+#include "meo_test.h"
+
+#include <chrono>
+#include <cstdarg>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Meo3_Log.h"
+#include "Meo3_LogRing.h"
+
+namespace {
+std::mutex               g_lock;
+std::vector<std::string> g_lines;
+
+void sink(const char* level, const char* line) {
+    std::lock_guard<std::mutex> g(g_lock);
+    g_lines.emplace_back(line);
+}
+
+// Phần message sau "(ms) [TAG] "
+std::string body(const std::string& line) {
+    size_t p = line.find("] ");
+    return p == std::string::npos ? line : line.substr(p + 2);
+}
+
+std::string expect(const char* fmt, ...) __attribute__((format(printf, 1, 2)));
+std::string expect(const char* fmt, ...) {
+    char buf[MEO_LOG_LINE_MAX];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    return buf;
+}
+
+// Push qua ring rồi end() để task ghi nốt; trả về các message theo thứ tự
+template <typename Fn>
+std::vector<std::string> drain(Fn&& fn) {
+    {
+        std::lock_guard<std::mutex> g(g_lock);
+        g_lines.clear();
+    }
+    MeoLogRing ring;
+    MEO_CHECK(ring.begin(sink));
+    fn(ring);
+    ring.end();
+    std::lock_guard<std::mutex> g(g_lock);
+    std::vector<std::string> out;
+    for (const std::string& l : g_lines) out.push_back(body(l));
+    return out;
+}
+}
+
+MEO_TEST(string_view_with_precision_is_not_read_past_len) {
+    // View không có NUL, cấp phát vừa khít: đọc quá là ASan báo heap-buffer-overflow
+    std::unique_ptr<char[]> view(new char[4]);
+    memcpy(view.get(), "fan1", 4);
+    std::unique_ptr<char[]> name(new char[3]);
+    memcpy(name.get(), "abc", 3);
+
+    auto out = drain([&](MeoLogRing& r) {
+        r.push(MEO_LOG_LEVEL_INFO, (uint8_t)MeoLogTag::GATEWAY, "Invoke %.*s len=%u", 3, view.get(), 4u);
+        r.push(MEO_LOG_LEVEL_INFO, (uint8_t)MeoLogTag::GATEWAY, "%.3s/%-6.*s|", name.get(), 2, view.get());
+        r.push(MEO_LOG_LEVEL_INFO, (uint8_t)MeoLogTag::GATEWAY, "%*d %.*s", 4, 7, 0, view.get());
+        r.push(MEO_LOG_LEVEL_INFO, (uint8_t)MeoLogTag::GATEWAY, "%s %.2s", "full", "x");
+    });
+    MEO_CHECK_EQ(out.size(), (size_t)4);
+    if (out.size() == 4) {
+        MEO_CHECK_EQ(out[0], "Invoke fan len=4");
+        MEO_CHECK_EQ(out[1], "abc/fa    |");
+        MEO_CHECK_EQ(out[2], "   7 ");
+        MEO_CHECK_EQ(out[3], "full x");
+    }
+}
+
+MEO_TEST(integers_print_at_their_captured_width) {
+    int neg = -2;
+    int8_t b = -1;
+    int64_t big = -5000000000LL;
+    uint64_t ubig = 18000000000000000000ULL;
+    auto out = drain([&](MeoLogRing& r) {
+        r.push(MEO_LOG_LEVEL_INFO, (uint8_t)MeoLogTag::DEVICE, "%x %u %X %o", neg, neg, neg, neg);
+        r.push(MEO_LOG_LEVEL_INFO, (uint8_t)MeoLogTag::DEVICE, "%hhx %hd %d %i", b, (short)-3, neg, neg);
+        r.push(MEO_LOG_LEVEL_INFO, (uint8_t)MeoLogTag::DEVICE, "%lld %llu %llx",
+               (long long)big, (unsigned long long)ubig, (unsigned long long)ubig);
+        r.push(MEO_LOG_LEVEL_INFO, (uint8_t)MeoLogTag::DEVICE, "%08x|%-5d|%+d|%c|%.2f",
+               255u, 42, 5, 'z', 1.005);
+    });
+    MEO_CHECK_EQ(out.size(), (size_t)4);
+    if (out.size() == 4) {
+        MEO_CHECK_EQ(out[0], expect("%x %u %X %o", neg, neg, neg, neg));
+        MEO_CHECK_EQ(out[1], expect("%hhx %hd %d %i", b, (short)-3, neg, neg));
+        MEO_CHECK_EQ(out[2], expect("%lld %llu %llx", (long long)big, (unsigned long long)ubig,
+                                    (unsigned long long)ubig));
+        MEO_CHECK_EQ(out[3], expect("%08x|%-5d|%+d|%c|%.2f", 255u, 42, 5, 'z', 1.005));
+    }
+}
+
+MEO_TEST(record_overflow_is_marked) {
+    auto out = drain([&](MeoLogRing& r) {
+        r.push(MEO_LOG_LEVEL_INFO, (uint8_t)MeoLogTag::DEVICE, "%d %d %d %d %d %d %d %d %d %d",
+               1, 2, 3, 4, 5, 6, 7, 8, 9, 10);
+        r.push(MEO_LOG_LEVEL_INFO, (uint8_t)MeoLogTag::DEVICE, "%s",
+               "a string longer than the forty-eight byte argument area of a record");
+    });
+    MEO_CHECK_EQ(out.size(), (size_t)2);
+    if (out.size() == 2) {
+        MEO_CHECK_EQ(out[0], "1 2 3 4 5 6 7 8 ? ? ...");
+        MEO_CHECK(out[1].rfind("a string longer", 0) == 0);
+        MEO_CHECK(out[1].size() >= 4 && out[1].compare(out[1].size() - 4, 4, " ...") == 0);
+    }
+}
+
+MEO_TEST(scan_precision_per_argument) {
+    int16_t p[MEO_LOG_RECORD_MAX_ARGC];
+    MeoLogRecord::scanPrecision("%d %.*s %s %.5s %% %*.*s", p);
+    MEO_CHECK_EQ(p[0], MeoLogRecord::kNoPrec);     // %d
+    MEO_CHECK_EQ(p[1], MeoLogRecord::kNoPrec);     // '*' của %.*s
+    MEO_CHECK_EQ(p[2], MeoLogRecord::kStarPrec);   // chuỗi của %.*s
+    MEO_CHECK_EQ(p[3], MeoLogRecord::kNoPrec);     // %s
+    MEO_CHECK_EQ(p[4], (int16_t)5);                // %.5s
+    MEO_CHECK_EQ(p[7], MeoLogRecord::kStarPrec);   // %*.*s: width, prec, chuỗi
+}
+
+// disableDeferredLog() trên task khác trong lúc các task vẫn log: không chạm ring đã giải phóng,
+// không mất dòng nào (ring đã dừng thì MeoLog ghi đồng bộ)
+MEO_TEST(ring_end_while_logging) {
+    {
+        std::lock_guard<std::mutex> g(g_lock);
+        g_lines.clear();
+    }
+    MeoLogRing ring;
+    MeoLog log;
+    log.setSink(sink);
+    log.setRing(&ring);
+    MEO_CHECK(ring.begin(log.sink(), 256));
+
+    const int kThreads = 3, kLines = 2000;
+    std::vector<std::thread> writers;
+    for (int t = 0; t < kThreads; ++t) {
+        writers.emplace_back([&, t] {
+            for (int i = 0; i < kLines; ++i) {
+                log.write(MEO_LOG_LEVEL_INFO, MeoLogTag::DEVICE, "t%d line %d", t, i);
+                if (i % 64 == 0) std::this_thread::yield();
+            }
+        });
+    }
+    for (int cycle = 0; cycle < 20; ++cycle) {
+        std::this_thread::sleep_for(std::chrono::microseconds(300));
+        ring.end();
+        ring.begin(log.sink(), 256);
+    }
+    for (auto& w : writers) w.join();
+    ring.end();
+
+    MeoLogRingStats st = ring.stats();
+    size_t lines = 0;
+    {
+        std::lock_guard<std::mutex> g(g_lock);
+        for (const std::string& l : g_lines) lines += l.find("] t") != std::string::npos;
+    }
+    MEO_CHECK_EQ(lines + st.dropped, (size_t)(kThreads * kLines));
+}
+
+int main(int argc, char** argv) { return meoTestMain(argc, argv); }
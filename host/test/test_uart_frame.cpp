@@ -0,0 +1,242 @@
+// Codec frame UART: encode -> pipe / pty -> MeoFrameDecoder với cách chia đoạn ngẫu nhiên
+#include "meo_test.h"
+
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Meo3_UartFrame.h"
+
+namespace {
+
+struct Got {
+    int         type;
+    std::string id, name, payload;
+    bool operator==(const Got& o) const {
+        return type == o.type && id == o.id && name == o.name && payload == o.payload;
+    }
+};
+
+void collect(const MeoChildMessage& m, void* ctx) {
+    static_cast<std::vector<Got>*>(ctx)->push_back(Got{ (int)m.type,
+        std::string(m.deviceId, m.idLen), std::string(m.name, m.nameLen),
+        std::string((const char*)m.payload, m.len) });
+}
+
+void append(std::vector<uint8_t>& wire, const Got& g) {
+    MeoChildMessage m;
+    m.type     = (MeoChildMsgType)g.type;
+    m.deviceId = g.id.data();
+    m.idLen    = (uint8_t)g.id.size();
+    m.name     = g.name.data();
+    m.nameLen  = (uint8_t)g.name.size();
+    m.payload  = (const uint8_t*)g.payload.data();
+    m.len      = g.payload.size();
+    uint8_t buf[MEO_UART_FRAME_MAX + MEO_UART_OVERHEAD];
+    size_t n = meoFrameEncode(m, buf, sizeof(buf));
+    MEO_CHECK(n != 0 && n == meoFrameSize(m));
+    wire.insert(wire.end(), buf, buf + n);
+}
+
+Got event(int i) {
+    return Got{ (int)MeoChildMsgType::Event, "child" + std::to_string(i), "temp",
+                "{\"v\":" + std::to_string(i) + "}" };
+}
+
+// Luồng thử: rác, 0xA5 lạc, frame hợp lệ, một frame hỏng CRC, frame lớn nhất, redeclare
+struct Stream {
+    std::vector<uint8_t> wire;
+    std::vector<Got>     expected;
+};
+
+Stream makeStream() {
+    Stream s;
+    s.wire = { 0x00, 0xA5, 0xA5, 0x09, 0xFF, 0x13 };
+    for (int i = 0; i < 40; ++i) {
+        Got g = event(i);
+        if (i == 10) {
+            // Sửa byte cuối payload sau khi encode: CRC sai, frame bị bỏ
+            append(s.wire, g);
+            s.wire[s.wire.size() - 3] ^= 0x40;
+            continue;
+        }
+        append(s.wire, g);
+        s.expected.push_back(g);
+        if (i == 20) s.wire.push_back(MEO_UART_SYNC);
+    }
+    Got big{ (int)MeoChildMsgType::Invoke, "abc", "", std::string(MEO_UART_FRAME_MAX - 2 - 3, 'x') };
+    append(s.wire, big);
+    s.expected.push_back(big);
+    Got rd{ (int)MeoChildMsgType::Redeclare, "", "", "" };
+    append(s.wire, rd);
+    s.expected.push_back(rd);
+    return s;
+}
+
+// Ghi wire vào wfd theo đoạn ngẫu nhiên trên thread riêng, đọc rfd theo đoạn ngẫu nhiên
+std::vector<Got> loopback(int wfd, int rfd, const std::vector<uint8_t>& wire, unsigned seed,
+                          MeoFrameDecoder& d, size_t expectBytes) {
+    std::thread writer([&]() {
+        std::mt19937 rng(seed);
+        size_t off = 0;
+        while (off < wire.size()) {
+            size_t k = 1 + rng() % 97;
+            if (k > wire.size() - off) k = wire.size() - off;
+            ssize_t w = write(wfd, wire.data() + off, k);
+            if (w <= 0) break;
+            off += (size_t)w;
+        }
+    });
+    std::vector<Got> got;
+    std::mt19937 rng(seed ^ 0x5a5a);
+    uint8_t buf[64];
+    size_t total = 0;
+    while (total < expectBytes) {
+        size_t k = 1 + rng() % sizeof(buf);
+        ssize_t r = read(rfd, buf, k);
+        if (r <= 0) break;
+        total += (size_t)r;
+        d.feed(buf, (size_t)r, collect, &got);
+    }
+    writer.join();
+    return got;
+}
+
+bool sameStats(const MeoFrameStats& a, const MeoFrameStats& b) {
+    return a.frames == b.frames && a.crcErrors == b.crcErrors && a.badHeader == b.badHeader
+        && a.malformed == b.malformed && a.skipped == b.skipped;
+}
+
+}
+
+MEO_TEST(crc16_ccitt_false_vector) {
+    MEO_CHECK_EQ(meoCrc16((const uint8_t*)"123456789", 9), (uint16_t)0x29B1);
+}
+
+MEO_TEST(encode_limits) {
+    std::string pl(MEO_UART_FRAME_MAX - 2 - 3, 'x');
+    MeoChildMessage m;
+    m.type     = MeoChildMsgType::Invoke;
+    m.deviceId = "abc";
+    m.idLen    = 3;
+    m.payload  = (const uint8_t*)pl.data();
+    m.len      = pl.size();
+    uint8_t buf[MEO_UART_FRAME_MAX + MEO_UART_OVERHEAD];
+    MEO_CHECK_EQ(meoFrameEncode(m, buf, sizeof(buf)), (size_t)(MEO_UART_FRAME_MAX + MEO_UART_OVERHEAD));
+    MEO_CHECK_EQ(meoFrameEncode(m, buf, sizeof(buf) - 1), (size_t)0);   // không vừa
+    m.len++;
+    MEO_CHECK_EQ(meoFrameSize(m), (size_t)0);                             // body quá lớn
+    m.len = 0;
+    m.type = (MeoChildMsgType)9;
+    MEO_CHECK_EQ(meoFrameEncode(m, buf, sizeof(buf)), (size_t)0);         // type lạ
+}
+
+MEO_TEST(pipe_random_chunks) {
+    Stream s = makeStream();
+    MeoFrameStats first;
+    for (unsigned seed = 1; seed <= 20; ++seed) {
+        int fds[2];
+        MEO_CHECK(pipe(fds) == 0);
+        MeoFrameDecoder d;
+        std::vector<Got> got = loopback(fds[1], fds[0], s.wire, seed, d, s.wire.size());
+        close(fds[0]);
+        close(fds[1]);
+
+        MEO_CHECK_EQ(got.size(), s.expected.size());
+        MEO_CHECK(got == s.expected);
+        const MeoFrameStats& st = d.stats();
+        MEO_CHECK_EQ(st.frames, (uint32_t)s.expected.size());
+        MEO_CHECK_EQ(st.crcErrors, 1u);
+        MEO_CHECK(st.badHeader >= 3);   // 2 trong rác đầu luồng + 0xA5 lạc sau frame 20
+        MEO_CHECK_EQ(st.malformed, 0u);
+        // Kết quả không phụ thuộc cách chia đoạn
+        if (seed == 1) first = st;
+        else MEO_CHECK(sameStats(st, first));
+    }
+}
+
+MEO_TEST(pty_random_chunks) {
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    MEO_CHECK(master >= 0);
+    if (master < 0) return;
+    MEO_CHECK(grantpt(master) == 0 && unlockpt(master) == 0);
+    int slave = open(ptsname(master), O_RDWR | O_NOCTTY);
+    MEO_CHECK(slave >= 0);
+    if (slave < 0) { close(master); return; }
+    // Raw như một UART: không echo, không đổi CR/LF, không coi 0x03 / 0x11 là ký tự điều khiển
+    termios tio;
+    tcgetattr(slave, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(slave, TCSANOW, &tio);
+
+    Stream s = makeStream();
+    MeoFrameDecoder d;
+    std::vector<Got> got = loopback(master, slave, s.wire, 7, d, s.wire.size());
+    close(slave);
+    close(master);
+
+    MEO_CHECK(got == s.expected);
+    MEO_CHECK_EQ(d.stats().frames, (uint32_t)s.expected.size());
+    MEO_CHECK_EQ(d.stats().crcErrors, 1u);
+}
+
+MEO_TEST(false_header_does_not_swallow_frames) {
+    // 0xA5 lạc theo sau là type / len trông hợp lệ (len 600): trước đây decoder nhận
+    // 600 byte "body", CRC sai và mất mọi frame thật nằm trong đó
+    std::vector<uint8_t> wire = { MEO_UART_SYNC, (uint8_t)MeoChildMsgType::Event, 0x58, 0x02 };
+    std::vector<Got> expected;
+    for (int i = 0; i < 30; ++i) {
+        expected.push_back(event(i));
+        append(wire, expected.back());
+    }
+    MEO_CHECK(wire.size() > 600);
+
+    for (size_t chunk : { (size_t)1, (size_t)7, (size_t)64, wire.size() }) {
+        MeoFrameDecoder d;
+        std::vector<Got> got;
+        for (size_t off = 0; off < wire.size(); off += chunk) {
+            size_t n = chunk < wire.size() - off ? chunk : wire.size() - off;
+            d.feed(wire.data() + off, n, collect, &got);
+        }
+        MEO_CHECK_EQ(got.size(), expected.size());
+        MEO_CHECK(got == expected);
+        MEO_CHECK_EQ(d.stats().crcErrors, 1u);
+        MEO_CHECK_EQ(d.stats().frames, (uint32_t)expected.size());
+    }
+}
+
+MEO_TEST(nested_false_headers_and_corrupt_crc_bytes) {
+    // Hai header giả lồng nhau, rồi frame có byte CRC hỏng, rồi frame tốt
+    std::vector<uint8_t> wire = { MEO_UART_SYNC, 2, 0x40, 0x00, MEO_UART_SYNC, 3, 0x20, 0x00 };
+    std::vector<Got> expected;
+    for (int i = 0; i < 8; ++i) {
+        expected.push_back(event(i));
+        append(wire, expected.back());
+    }
+    append(wire, event(100));
+    wire.back() ^= 0xFF;
+    expected.push_back(event(101));
+    append(wire, expected.back());
+
+    MeoFrameDecoder d;
+    std::vector<Got> got;
+    d.feed(wire.data(), wire.size(), collect, &got);
+    MEO_CHECK(got == expected);
+    MEO_CHECK_EQ(d.stats().frames, (uint32_t)expected.size());
+    MEO_CHECK(d.stats().crcErrors >= 3);
+
+    // reset() bỏ cả phần đang chờ quét lại
+    d.feed(wire.data(), 20, collect, &got);
+    d.reset();
+    got.clear();
+    d.feed(wire.data() + 8, wire.size() - 8, collect, &got);
+    MEO_CHECK(got == expected);
+}
+
+int main(int argc, char** argv) { return meoTestMain(argc, argv); }
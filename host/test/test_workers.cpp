@@ -0,0 +1,134 @@
+// Hàng đợi publish / invoke pool: end() chạy song song với producer không được
+// giải phóng slot mà producer còn đang dùng, và message đã nhận thì không bị mất
+#include "meo_test.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "Meo3_InvokePool.h"
+#include "Meo3_PublishQueue.h"
+#include "mqtt_host.h"
+
+namespace {
+
+void countPublish(const char*, const uint8_t*, size_t, int, int, void* ctx) {
+    static_cast<std::atomic<uint32_t>*>(ctx)->fetch_add(1);
+}
+
+void countRun(uint16_t, const uint8_t* payload, size_t len, uint32_t, void* ctx) {
+    MEO_CHECK(len == 16 && payload[0] == 'p' && payload[len - 1] == 'p');
+    static_cast<std::atomic<uint32_t>*>(ctx)->fetch_add(1);
+}
+
+}
+
+MEO_TEST(publish_queue_end_waits_for_producers) {
+    MeoMqttClient mq;
+    mq.configure("broker");
+    mq.setCredentials("dev1", "key");
+    MEO_CHECK(mq.connect());
+    esp_mqtt_client_handle_t c = esp_mqtt_host_last_client();
+    std::atomic<uint32_t> published{0};
+    esp_mqtt_host_on_publish(c, countPublish, &published);
+    esp_mqtt_host_connect(c);
+
+    for (int round = 0; round < 20; ++round) {
+        const uint32_t before = published.load();
+        MeoPublishQueue q;
+        MEO_CHECK(q.begin(&mq, 4));
+        std::atomic<uint32_t> accepted{0};
+
+        std::vector<std::thread> producers;
+        for (int t = 0; t < 4; ++t) {
+            producers.emplace_back([&, t] {
+                MeoPublishOptions opt;
+                for (;;) {
+                    MeoEnqueueResult r;
+                    if (t % 2) {
+                        r = q.enqueue("meo/dev1/event/a", (const uint8_t*)"{}", 2, opt);
+                    } else {
+                        // Serialize chậm vào slot đã reserve trong lúc end() có thể đang chạy
+                        uint8_t slot; size_t cap = 0;
+                        uint8_t* dst = q.reserve(slot, cap, &r);
+                        if (dst) {
+                            std::this_thread::sleep_for(std::chrono::microseconds(200));
+                            memset(dst, 'x', cap);
+                            memcpy(dst, "{}", 2);
+                            r = q.commit(slot, "meo/dev1/event/b", 2, opt);
+                        }
+                    }
+                    if (r == MeoEnqueueResult::Queued) accepted.fetch_add(1);
+                    if (r == MeoEnqueueResult::NotRunning) return;
+                    std::this_thread::yield();
+                }
+            });
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        q.end();
+        for (auto& p : producers) p.join();
+
+        // Mọi message đã Queued đều được sender gửi trước khi end() trả về
+        MeoPublishStats st = q.stats();
+        MEO_CHECK_EQ(st.enqueued, accepted.load());
+        MEO_CHECK_EQ(st.sent + st.failed, st.enqueued);
+        MEO_CHECK_EQ(published.load() - before, st.sent);
+        MEO_CHECK(!q.isRunning());
+    }
+
+    esp_mqtt_host_disconnect(c);
+}
+
+MEO_TEST(invoke_pool_end_waits_for_submit) {
+    for (int round = 0; round < 20; ++round) {
+        std::atomic<uint32_t> ran{0}, accepted{0};
+        MeoInvokePool pool;
+        MEO_CHECK(pool.begin(countRun, &ran, 2, 4));
+
+        // Giả task esp-mqtt: submit liên tục trong lúc end() chạy
+        std::thread mqttTask([&] {
+            uint8_t payload[16];
+            memset(payload, 'p', sizeof(payload));
+            for (uint16_t m = 0;; ++m) {
+                MeoSubmitResult r = pool.submit(m, payload, sizeof(payload));
+                if (r == MeoSubmitResult::Queued) accepted.fetch_add(1);
+                if (r == MeoSubmitResult::NotRunning) return;
+                std::this_thread::yield();
+            }
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        pool.end();
+        mqttTask.join();
+
+        MeoInvokePoolStats st = pool.stats();
+        MEO_CHECK_EQ(st.queued, accepted.load());
+        MEO_CHECK_EQ(st.executed, st.queued);
+        MEO_CHECK_EQ(ran.load(), st.executed);
+    }
+}
+
+MEO_TEST(publish_queue_drop_counts_reserved_slot) {
+    MeoMqttClient mq;
+    mq.configure("broker");
+    mq.setCredentials("dev1", "key");
+    MeoPublishQueue q;
+    MEO_CHECK(q.begin(&mq, 2));
+
+    // Serialize không vừa slot: trả slot, tính là drop như TooLarge của commit()
+    uint8_t slot; size_t cap = 0;
+    MEO_CHECK(q.reserve(slot, cap) != nullptr);
+    q.drop(slot);
+    MEO_CHECK(q.reserve(slot, cap) != nullptr);
+    q.cancel(slot);
+    MEO_CHECK(q.reserve(slot, cap) != nullptr);
+    MEO_CHECK(q.commit(slot, "", 0, MeoPublishOptions()) == MeoEnqueueResult::TooLarge);
+
+    MeoPublishStats st = q.stats();
+    MEO_CHECK_EQ(st.dropped, (uint32_t)2);
+    MEO_CHECK_EQ(st.enqueued, (uint32_t)0);
+    q.end();   // mọi slot đã trả: không chờ mãi
+}
+
+int main(int argc, char** argv) { return meoTestMain(argc, argv); }
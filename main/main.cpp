@@ -5,17 +5,21 @@
 
 MeoDevice meo;
 
+// Typed event: keys come from the member names, checked at compile time
+struct HumidTemp {
+    float temperature;
+    float humidity;
+};
+MEO_EVENT_NAMED(HumidTemp, "humid_temp_update", temperature, humidity)
+
 // Example feature callback
 void onTurnOn(const MeoFeatureCall& call) {
     Serial.println("Feature 'turn_on_led' invoked");
     digitalWrite(LED_BUILTIN, HIGH);
 
-    int first = 0, second = 0;
-    for (const auto& kv : call.params) {
-        Serial.printf("  %s = %s\n", kv.first.c_str(), kv.second.c_str());
-        if (kv.first == "first")  first  = String(kv.second.c_str()).toInt();
-        if (kv.first == "second") second = String(kv.second.c_str()).toInt();
-    }
+    // Param có kiểu: số nhận cả dạng 5 lẫn "5"
+    int first  = (int)call.params.getInt("first");
+    int second = (int)call.params.getInt("second");
     char msg[64];
     snprintf(msg, sizeof(msg), "LED on, sum=%d", first + second);
     meo.sendFeatureResponse(call, true, msg);
@@ -39,9 +43,18 @@ void setup() {
     meo.setGateway("meo-open-service.local", 1883);
     meo.setLogger(meoLogger);
     meo.setDebugTags("DEVICE,MQTT,PROV");
+    // Log ghi vào ring, task ưu tiên thấp mới in ra Serial: UART không làm chậm MQTT
+    meo.enableDeferredLog();
 
     meo.addFeatureMethod("turn_on_led", onTurnOn);
-    meo.addFeatureEvent("humid_temp_update");
+    meo.addFeatureEvent<HumidTemp>();
+
+    // Publish từ loop() không bị block bởi mạng: sender task riêng trên core 0
+    meo.enableAsyncPublish(8, 0);
+    // Giữ event khi mất WiFi/MQTT và phát lại sau khi kết nối lại
+    meo.enableOfflineBuffer();
+    // Feature handler chạy trên worker riêng, không chặn task esp-mqtt
+    meo.enableInvokeWorkers(2, 8);
 
     meo.start();
 }
@@ -52,10 +65,10 @@ void loop() {
     static uint32_t last = 0;
     if (millis() - last > 5000 && meo.isMqttConnected()) {
         last = millis();
-        MeoEventPayload p;
-        p["temperature"] = String(random(200, 300) / 10).c_str();
-        p["humidity"]    = String(random(400, 600) / 10).c_str();
-        bool success = meo.publishEvent("humid_temp_update", p);
+        HumidTemp ev;
+        ev.temperature = random(200, 300) / 10.0f;
+        ev.humidity    = random(400, 600) / 10.0f;
+        bool success = meo.publishEvent(ev);
         meoLogger("INFO", success ? "Published humid_temp_update event" : "Failed to publish event");
     }
 }